@@ -0,0 +1,364 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	ACCELERATION LIMITER
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:		2019-11-17
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Rate limiter of a signed speed reference.
+**	Output moving away from zero is an acceleration, limited by g_acc.
+**	Output moving toward zero is a deceleration, limited by g_dec.
+**	A reversal decelerates down to zero, then accelerates on the next tick.
+**	On hold the input is clipped between zero and the output, so it can only decelerate.
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include "global.h"
+//Class Header
+#include "accel_limiter.h"
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+namespace OrangeBot
+{
+
+/****************************************************************************
+**	GLOBAL VARIABILES
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	CONSTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Constructor
+//!	Accel_limiter | void
+/***************************************************************************/
+// @param
+//! @return no return
+//!	@details
+//! Empty constructor. No limit, output at rest on 0
+/***************************************************************************/
+
+Accel_limiter::Accel_limiter( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//No limit
+	this -> g_acc = (int32_t)0;
+	this -> g_dec = (int32_t)0;
+	//At rest
+	this -> g_ref = (int32_t)0;
+	//Acceleration allowed
+	this -> g_f_hold = false;
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end constructor:
+
+/****************************************************************************
+*****************************************************************************
+**	DESTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Destructor
+//!	Accel_limiter | void
+/***************************************************************************/
+// @param
+//! @return no return
+//!	@details
+//! Empty destructor
+/***************************************************************************/
+
+Accel_limiter::~Accel_limiter( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end destructor:
+
+/****************************************************************************
+*****************************************************************************
+**	OPERATORS
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	SETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	set_limits | uint32_t, uint32_t
+/***************************************************************************/
+//! @param acc | maximum change per tick away from zero. Fixed point ACCEL_LIMITER_FRAC. 0 = no limit
+//! @param dec | maximum change per tick toward zero. Fixed point ACCEL_LIMITER_FRAC. 0 = no limit
+//! @return false: OK | true: fail
+//!	@details
+//! Output is not changed
+/***************************************************************************/
+
+bool Accel_limiter::set_limits( uint32_t acc, uint32_t dec )
+{
+	//Trace Enter
+	DENTER_ARG("acc: %d, dec: %d\n", acc, dec);
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//if: limits are out of range
+	if ((acc > ACCEL_LIMITER_MAX) || (dec > ACCEL_LIMITER_MAX))
+	{
+		//Trace Return
+		DRETURN_ARG("ERR: bad limits\n");
+		return true;	//fail
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	this -> g_acc = (int32_t)acc;
+	this -> g_dec = (int32_t)dec;
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return false;	//OK
+}	//end method: set_limits | uint32_t, uint32_t
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	reset | int32_t
+/***************************************************************************/
+//! @param ref | reference the output jumps on
+//! @return no return
+/***************************************************************************/
+
+void Accel_limiter::reset( int32_t ref )
+{
+	this -> g_ref = ref << ACCEL_LIMITER_FRAC;
+
+	return;	//OK
+}	//end method: reset | int32_t
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	set_hold | bool
+/***************************************************************************/
+//! @param f_hold | true = output can only move toward zero | false = acceleration allowed
+//! @return no return
+/***************************************************************************/
+
+void Accel_limiter::set_hold( bool f_hold )
+{
+	this -> g_f_hold = f_hold;
+
+	return;	//OK
+}	//end method: set_hold | bool
+
+/****************************************************************************
+*****************************************************************************
+**	GETTERS
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	REFERENCES
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	TESTERS
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	exe | int32_t
+/***************************************************************************/
+//! @param ref | input reference
+//! @return int32_t | limited reference. Same units as the input, fractional bits are truncated
+/***************************************************************************/
+
+int32_t Accel_limiter::exe( int32_t ref )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Input reference. Fixed point
+	int32_t target;
+	//Maximum change allowed this tick
+	int32_t step;
+	//Output before the limit on zero crossing
+	int32_t out;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	target = ref << ACCEL_LIMITER_FRAC;
+	//if: acceleration is on hold
+	if (this -> g_f_hold == true)
+	{
+		//Clip the input between zero and the output
+		target = (this -> g_ref >= 0)?(AT_SAT( target, this -> g_ref, 0 )):(AT_SAT( target, 0, this -> g_ref ));
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//if: output has to increase
+	if (target > this -> g_ref)
+	{
+		//Negative output moves toward zero
+		step = (this -> g_ref < 0)?(this -> g_dec):(this -> g_acc);
+		//if: limited
+		if ((step > 0) && (target -this -> g_ref > step))
+		{
+			out = this -> g_ref +step;
+			//if: crossing zero. Stop on zero, accelerate from the next tick
+			if ((this -> g_ref < 0) && (out > 0))
+			{
+				out = (int32_t)0;
+			}
+			this -> g_ref = out;
+		}
+		//if: target is within reach
+		else
+		{
+			this -> g_ref = target;
+		}
+	}
+	//if: output has to decrease
+	else if (target < this -> g_ref)
+	{
+		//Positive output moves toward zero
+		step = (this -> g_ref > 0)?(this -> g_dec):(this -> g_acc);
+		//if: limited
+		if ((step > 0) && (this -> g_ref -target > step))
+		{
+			out = this -> g_ref -step;
+			//if: crossing zero. Stop on zero, accelerate from the next tick
+			if ((this -> g_ref > 0) && (out < 0))
+			{
+				out = (int32_t)0;
+			}
+			this -> g_ref = out;
+		}
+		//if: target is within reach
+		else
+		{
+			this -> g_ref = target;
+		}
+	}
+	//if: output is on target
+	else
+	{
+		//do nothing
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return (this -> g_ref >> ACCEL_LIMITER_FRAC);
+}	//end method: exe | int32_t
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+} //End Namespace
@@ -0,0 +1,172 @@
+/**********************************************************************************
+**	ENVIROMENT VARIABILE
+**********************************************************************************/
+
+#ifndef ACCEL_LIMITER_H_
+	#define ACCEL_LIMITER_H_
+
+/**********************************************************************************
+**	GLOBAL INCLUDES
+**********************************************************************************/
+
+/**********************************************************************************
+**	DEFINES
+**********************************************************************************/
+
+//Fractional bits added to the reference by the limiter
+#define ACCEL_LIMITER_FRAC		8
+//Maximum change per tick. Fixed point ACCEL_LIMITER_FRAC
+#define ACCEL_LIMITER_MAX		((uint32_t)1 << 24)
+
+/**********************************************************************************
+**	MACROS
+**********************************************************************************/
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+//! @namespace OrangeBot
+namespace OrangeBot
+{
+
+/**********************************************************************************
+**	TYPEDEFS
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: STRUCTURES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: GLOBAL VARIABILES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: CLASS
+**********************************************************************************/
+
+/************************************************************************************/
+//! @class 		Accel_limiter
+/************************************************************************************/
+//!	@author		Orso Eric
+//! @version	0.1 alpha
+//! @date		2019-11-17
+//! @brief		Limit the rate of change of a speed reference
+//! @details
+//!	Output follows the input, changing by at most the limit each tick \n
+//! FEATURES:	\n
+//!		Acceleration and deceleration	\n
+//! Moving away from zero uses the acceleration limit, moving toward zero uses the deceleration limit.
+//! Crossing zero stops on zero for one tick \n
+//!		Fixed point	\n
+//! Output keeps ACCEL_LIMITER_FRAC bits more than the input, so limits below one unit per tick accumulate exactly \n
+//!		Hold	\n
+//! Acceleration can be suspended, for example by a current limit. Deceleration is still allowed \n
+//! @pre		None
+//! @bug		None
+//! @warning	Limits are per tick. Convert them again when the tick rate changes
+//! @copyright	License ?
+//! @todo		todo list
+/************************************************************************************/
+
+class Accel_limiter
+{
+	//Visible to all
+	public:
+		//--------------------------------------------------------------------------
+		//	CONSTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//! Default constructor
+		Accel_limiter( void );
+
+		//--------------------------------------------------------------------------
+		//	DESTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//!Default destructor
+		~Accel_limiter( void );
+
+		//--------------------------------------------------------------------------
+		//	OPERATORS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	SETTERS
+		//--------------------------------------------------------------------------
+
+		//Set the maximum change per tick away from and toward zero. 0 = no limit. false=OK
+		bool set_limits( uint32_t acc, uint32_t dec );
+		//Output jumps on the given reference
+		void reset( int32_t ref );
+		//true = output can only move toward zero
+		void set_hold( bool f_hold );
+
+		//--------------------------------------------------------------------------
+		//	GETTERS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	REFERENCES
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	TESTERS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC METHODS
+		//--------------------------------------------------------------------------
+
+		//Move the output toward the input by at most one step
+		int32_t exe( int32_t ref );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC STATIC METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC VARS
+		//--------------------------------------------------------------------------
+
+	//Visible to derived classes
+	protected:
+		//--------------------------------------------------------------------------
+		//	PROTECTED METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PROTECTED VARS
+		//--------------------------------------------------------------------------
+
+	//Visible only inside the class
+	private:
+		//--------------------------------------------------------------------------
+		//	PRIVATE METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PRIVATE VARS
+		//--------------------------------------------------------------------------
+
+		//Maximum change per tick away from zero. Fixed point ACCEL_LIMITER_FRAC
+		int32_t g_acc;
+		//Maximum change per tick toward zero. Fixed point ACCEL_LIMITER_FRAC
+		int32_t g_dec;
+		//Output. Fixed point ACCEL_LIMITER_FRAC
+		int32_t g_ref;
+		//true = output can only move toward zero
+		bool g_f_hold;
+
+};	//End Class: Accel_limiter
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
+
+#else
+    #warning "Multiple inclusion of hader file"
+#endif
@@ -235,7 +235,7 @@ uint8_t u16_to_str( uint16_t num, uint8_t *str )
 			index++;
 		}
 		//If: The base is smaller then the number, and I have yet to find a non zero digit, and I'm not to the last digit
-		else if ( (flag == false) && (t != (MAX_DIGIT16 -1)) )
+		else if ( (flag == true) && (t != (MAX_DIGIT16 -1)) )
 		{
 			//do nothing
 		}
@@ -0,0 +1,380 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	CYCLE BENCHMARK
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:		2019-11-18
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	AVR image that measures the CPU cycles of the hot paths of the firmware.
+**	Linked with the firmware sources and compiled with the same flags. main() of the
+**	firmware is renamed, its peripherals are initialized by the same init()
+**	TCA0 is reprogrammed to count CPU clocks with interrupts disabled. A call is timed
+**	by the counter before and after it, minus the cost of timing an empty call.
+**	Each hot path runs on a fixed sequence of inputs like the ones the robot sees:
+**		Pid_s16::exe			triangle of errors, saturation included
+**		quad_encoder_decoder	four encoders: forward, backward, double events, still
+**		Uniparser::exe			a stream of commands of the RPI, one byte per call
+**		s32_to_str				numbers of every length and sign
+**		update_pwm				open loop targets with reversals and brakes
+**	Results stay in g_cycle_stat for a debugger or a simulator, and are sent on USART3:
+**		CYC <name> <calls> <min> <avg> <max>
+**		END
+**	Counts are exact on the board and on a simulator that models TCA0.
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include "global.h"
+#include "uniparser.h"
+#include "at_string.h"
+#include "pid_s16.h"
+
+/****************************************************************************
+**	DEFINES
+****************************************************************************/
+
+//Calls of each hot path
+#define CYCLE_BENCH_CALLS		256
+
+/****************************************************************************
+**	MACROS
+****************************************************************************/
+
+//Keep the compiler from moving memory accesses across the timestamps
+#define CYCLE_BENCH_BARRIER()	\
+	__asm__ __volatile__( "" ::: "memory" )
+
+//Time a call and add it to a statistic
+#define CYCLE_BENCH( stat, call )					\
+{													\
+	uint16_t cycle_start;							\
+	uint16_t cycle_stop;							\
+	CYCLE_BENCH_BARRIER();							\
+	cycle_start = TCA0.SINGLE.CNT;					\
+	CYCLE_BENCH_BARRIER();							\
+	call;											\
+	CYCLE_BENCH_BARRIER();							\
+	cycle_stop = TCA0.SINGLE.CNT;					\
+	CYCLE_BENCH_BARRIER();							\
+	cycle_stat_add( stat, cycle_stop -cycle_start );	\
+}
+
+/****************************************************************************
+**	ENUM
+****************************************************************************/
+
+//Hot paths
+typedef enum _Cycle_path
+{
+	CYCLE_PID		= 0,
+	CYCLE_ENC		= 1,
+	CYCLE_PARSER	= 2,
+	CYCLE_S32_STR	= 3,
+	CYCLE_PWM		= 4,
+	CYCLE_NUM		= 5
+} Cycle_path;
+
+/****************************************************************************
+**	STRUCTURES
+****************************************************************************/
+
+//Cycles of a hot path
+typedef struct _Cycle_stat
+{
+	const char *name;
+	uint16_t cnt;
+	uint16_t min;
+	uint16_t max;
+	uint32_t sum;
+} Cycle_stat;
+
+/****************************************************************************
+**	PROTOTYPES
+****************************************************************************/
+
+//Defined in main.cpp
+extern void update_pwm( void );
+
+/****************************************************************************
+**	GLOBAL VARIABILES
+****************************************************************************/
+
+//Cost of timing an empty call [cycles]
+static uint16_t g_cycle_overhead = 0;
+//Results. Read them here with a debugger
+volatile Cycle_stat g_cycle_stat[ CYCLE_NUM ] =
+{
+	{ "Pid_s16::exe", 0, 0xFFFF, 0, 0 },
+	{ "quad_encoder_decoder", 0, 0xFFFF, 0, 0 },
+	{ "Uniparser::exe", 0, 0xFFFF, 0, 0 },
+	{ "s32_to_str", 0, 0xFFFF, 0, 0 },
+	{ "update_pwm", 0, 0xFFFF, 0, 0 },
+};
+//Stream of commands of the RPI. Terminators included
+static const char g_cycle_cmd[] = "P\0SPDR100L-100\0PID0SPD-25\0ENCSPD\0PWMR255L-255\0CISR1\0";
+//Numbers to convert
+static const int32_t g_cycle_num[] = { 0, 7, -42, 1234, -56789, 1234567, -2147483647, 2147483647 };
+//Level of the A/B pins for each quarter of an encoder cycle
+static const uint8_t g_cycle_quad[4] = { 0x00, 0x02, 0x03, 0x01 };
+
+/****************************************************************************
+**	FUNCTIONS
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Function
+//!	cycle_stat_add | Cycle_path, uint16_t
+/***************************************************************************/
+//! @param path | hot path
+//! @param cycles | timed cycles, overhead included
+//! @return void
+/***************************************************************************/
+
+static void cycle_stat_add( Cycle_path path, uint16_t cycles )
+{
+	//if: the empty call is being timed
+	if (path == CYCLE_NUM)
+	{
+		g_cycle_overhead = cycles;
+		return;
+	}
+	cycles -= g_cycle_overhead;
+	g_cycle_stat[path].cnt++;
+	g_cycle_stat[path].sum += cycles;
+	g_cycle_stat[path].min = (cycles < g_cycle_stat[path].min)?(cycles):(g_cycle_stat[path].min);
+	g_cycle_stat[path].max = (cycles > g_cycle_stat[path].max)?(cycles):(g_cycle_stat[path].max);
+
+	return;
+}	//end function: cycle_stat_add | Cycle_path, uint16_t
+
+/***************************************************************************/
+//!	@brief Function
+//!	cycle_send | const char *
+/***************************************************************************/
+//! @param str | string to send on USART3. Busy wait, interrupts are off
+//! @return void
+/***************************************************************************/
+
+static void cycle_send( const char *str )
+{
+	//While: characters
+	while (*str != '\0')
+	{
+		//Wait for the TX buffer
+		while (IS_BIT_ZERO( USART3.STATUS, USART_DREIF_bp ));
+		USART3.TXDATAL = (uint8_t)*str++;
+	}
+
+	return;
+}	//end function: cycle_send | const char *
+
+/***************************************************************************/
+//!	@brief Function
+//!	cycle_send_u32 | uint32_t
+/***************************************************************************/
+//! @param num | number to send on USART3, preceded by a space
+//! @return void
+/***************************************************************************/
+
+static void cycle_send_u32( uint32_t num )
+{
+	uint8_t str[ MAX_DIGIT32 +2 ];
+
+	str[0] = ' ';
+	u32_to_str( num, &str[1] );
+	cycle_send( (const char *)str );
+
+	return;
+}	//end function: cycle_send_u32 | uint32_t
+
+	///----------------------------------------------------------------------
+	///	PARSER HANDLERS
+	///----------------------------------------------------------------------
+	//	Same signatures as the handlers of the firmware. They do nothing, the dispatch is timed
+
+static void cycle_handler_void( void )
+{
+	return;
+}
+
+static void cycle_handler_s16_s16( int16_t a, int16_t b )
+{
+	(void)a;
+	(void)b;
+	return;
+}
+
+static void cycle_handler_u8( uint8_t a )
+{
+	(void)a;
+	return;
+}
+
+/***************************************************************************/
+//!	@brief Function
+//!	main | void
+/***************************************************************************/
+//! @return int | never returns
+/***************************************************************************/
+
+int main( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//PID with the gains of the firmware
+	OrangeBot::Pid_s16 pid;
+	//Parser with the commands of the stream, in the order the firmware adds them
+	Orangebot::Uniparser parser = Orangebot::Uniparser();
+	//Error of the PID
+	int16_t err;
+	int16_t err_step;
+	//Position of each encoder [quarters of cycle]
+	uint8_t enc_pos[ ENC_NUM ];
+	uint8_t enc_in;
+	//Index in the command stream
+	uint16_t cmd_index;
+	//Converted number
+	uint8_t str[ MAX_DIGIT32 +2 ];
+	//counters
+	uint16_t t;
+	uint8_t ti;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Same peripherals as the firmware
+	init();
+	//Timing with interrupts off. Nothing else runs
+	cli();
+	//TCA0 counts CPU clocks up to 0xFFFF
+	TCA0.SINGLE.CTRLA = 0;
+	TCA0.SINGLE.INTCTRL = 0;
+	TCA0.SINGLE.PER = 0xFFFF;
+	TCA0.SINGLE.CNT = 0;
+	TCA0.SINGLE.CTRLA = TCA_SINGLE_CLKSEL_DIV1_gc | MASK( TCA_SINGLE_ENABLE_bp );
+
+	pid.limit_cmd_max() = +DC_MOTOR_MAX_PWM;
+	pid.limit_cmd_min() = -DC_MOTOR_MAX_PWM;
+	pid.gain_kp() = SPD_PID_KP << DC_MOTOR_PWM_SHIFT;
+	pid.gain_ki() = SPD_PID_KI << DC_MOTOR_PWM_SHIFT;
+	pid.gain_kd() = SPD_PID_KD << DC_MOTOR_PWM_SHIFT;
+	pid.limit_sat_th() = POS_PID_SAT_TH;
+
+	parser.add_cmd( "P", (void *)&cycle_handler_void );
+	parser.add_cmd( "PWMR%SL%S", (void *)&cycle_handler_s16_s16 );
+	parser.add_cmd( "PID%SSPD%S", (void *)&cycle_handler_s16_s16 );
+	parser.add_cmd( "SPDR%SL%S", (void *)&cycle_handler_s16_s16 );
+	parser.add_cmd( "ENC", (void *)&cycle_handler_void );
+	parser.add_cmd( "ENCSPD", (void *)&cycle_handler_void );
+	parser.add_cmd( "CISR%u", (void *)&cycle_handler_u8 );
+
+	//Cost of the timing itself
+	CYCLE_BENCH( CYCLE_NUM, CYCLE_BENCH_BARRIER() );
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Triangle of errors, beyond the saturation of the command
+	err = 0;
+	err_step = 37;
+	//For: each call
+	for (t = 0;t < CYCLE_BENCH_CALLS;t++)
+	{
+		CYCLE_BENCH( CYCLE_PID, pid.exe( err ) );
+		err += err_step;
+		err_step = ((err > 2000) || (err < -2000))?(-err_step):(err_step);
+	}
+
+	//Encoder 0 forward, 1 backward, 2 forward by two quarters: double event, 3 still
+	enc_pos[0] = enc_pos[1] = enc_pos[2] = enc_pos[3] = 0;
+	//For: each call
+	for (t = 0;t < CYCLE_BENCH_CALLS;t++)
+	{
+		enc_pos[0]++;
+		enc_pos[1]--;
+		enc_pos[2] += 2;
+		enc_in = 0;
+		//For: each encoder
+		for (ti = 0;ti < ENC_NUM;ti++)
+		{
+			enc_in |= g_cycle_quad[ enc_pos[ti] & 0x03 ] << (2*ti);
+		}
+		CYCLE_BENCH( CYCLE_ENC, quad_encoder_decoder( enc_in ) );
+	}
+
+	//Command stream over and over
+	cmd_index = 0;
+	//For: each byte
+	for (t = 0;t < CYCLE_BENCH_CALLS;t++)
+	{
+		CYCLE_BENCH( CYCLE_PARSER, parser.exe( (uint8_t)g_cycle_cmd[ cmd_index ] ) );
+		cmd_index++;
+		cmd_index = (cmd_index < sizeof( g_cycle_cmd ) -1)?(cmd_index):(0);
+	}
+
+	//Numbers over and over
+	//For: each call
+	for (t = 0;t < CYCLE_BENCH_CALLS;t++)
+	{
+		CYCLE_BENCH( CYCLE_S32_STR, s32_to_str( g_cycle_num[ t % (sizeof( g_cycle_num ) /sizeof( g_cycle_num[0] )) ], str ) );
+	}
+
+	//Open loop, the slew rate limiter and the brake of the reversals run
+	g_control_mode = CONTROL_PWM;
+	//For: each call
+	for (t = 0;t < CYCLE_BENCH_CALLS;t++)
+	{
+		//Every 64 calls the targets swap direction
+		//For: each motor
+		for (ti = 0;ti < DC_MOTOR_NUM;ti++)
+		{
+			g_dc_motor_target[ti].pwm = (ti & 0x01)?(DC_MOTOR_MAX_PWM):(DC_MOTOR_MAX_PWM >> 1);
+			g_dc_motor_target[ti].f_dir = (uint8_t)(((t >> 6) ^ ti) & 0x01);
+		}
+		CYCLE_BENCH( CYCLE_PWM, update_pwm() );
+	}
+
+	//Send the results
+	//For: each hot path
+	for (ti = 0;ti < CYCLE_NUM;ti++)
+	{
+		cycle_send( "CYC " );
+		cycle_send( g_cycle_stat[ti].name );
+		cycle_send_u32( g_cycle_stat[ti].cnt );
+		cycle_send_u32( g_cycle_stat[ti].min );
+		cycle_send_u32( g_cycle_stat[ti].sum /g_cycle_stat[ti].cnt );
+		cycle_send_u32( g_cycle_stat[ti].max );
+		cycle_send( "\r\n" );
+	}
+	cycle_send( "END\r\n" );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	//Done
+	for (;;);
+
+	return 0;
+}	//end function: main | void
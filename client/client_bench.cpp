@@ -0,0 +1,567 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	CLIENT BENCHMARK
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:		2019-11-18
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Throughput of the client library against the board, or the link emulator.
+**	First the decoder alone, then a run of requests for each window size,
+**	then the same counts sent by the telemetry stream of the board, as text and compressed,
+**	while the platform moves.
+**	ob_client_bench [-n <requests>] [-w <window>] [-t <ms>] [-k <kind>] [-d <ticks>] (-s <command> | <device>)
+**		-n	requests per window size, and frames of the stream. Default 1000
+**		-w	window size. Default 1, 2, 4, 8 and 16
+**		-t	time a request waits for its reply. Default 100
+**		-k	message asked for: ENC ENCSPD CUR VBAT QSTAT ODOM SUBSTAT LOGSTAT. Default ENC
+**		-d	base ticks between frames of the stream. 0 = no stream run. Default 2
+**		-s	start the link emulator with this command and use its pty, e.g. "ob_pty -p"
+**	One JSON line for the decoder, one for each window size:
+**		cmd_per_s		requests answered per second
+**		lat_avg_us		time from the request to the reply
+**		lat_max_us
+**		timeout			requests whose reply didn't come. The board drops replies
+**						when they overflow its TX buffer
+**		host_ns_per_msg	host time to read, decode and dispatch a message, system calls included
+**	The stream lines have the counts of the encoders every <ticks> base ticks, CNT as text, CNT_DELTA compressed:
+**		frame_per_s		frames received per second
+**		rx_bytes_per_frame	bytes on the line from the board for each set of counts.
+**						Compare with the bytes of a request and its reply
+**		tx_bytes		bytes sent to the board for the whole run
+**		skip			frames the board skipped because its TX buffer was busy
+**		lost			compressed frames lost on the line, or dropped waiting for a keyframe
+**	With -s the emulator adds its own line with the statistics of the serial line.
+**	EXAMPLE: ob_client_bench -s "ob_pty -p"
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "client/ob_client.h"
+
+/****************************************************************************
+**	DEFINES
+****************************************************************************/
+
+//Default requests per window size
+#define BENCH_DEFAULT_REQ		1000
+//Default time a request waits for its reply [ms]
+#define BENCH_DEFAULT_TIMEOUT	100
+//Messages decoded to time the decoder
+#define BENCH_DECODE_NUM		1000000
+//Default base ticks between frames of the stream
+#define BENCH_DEFAULT_DECIM		2
+//Counts of the encoders. STREAM_CNT of the firmware
+#define BENCH_STREAM_CNT		0x01
+//Compressed frames. STREAM_DELTA of the firmware
+#define BENCH_STREAM_DELTA		0x80
+//Speed of the platform during the stream runs, so that the counts change
+#define BENCH_STREAM_SPD		20
+//Time between speed commands. Keeps the communication timeout of the board from stopping the platform [ms]
+#define BENCH_KEEPALIVE			500
+
+/****************************************************************************
+**	GLOBAL VARIABILES
+****************************************************************************/
+
+//Name of the messages, indexed by kind
+static const char *g_kind_name[ OrangeBot::CLIENT_MSG_NUM ] = { "ENC", "ENCSPD", "CUR", "VBAT", "QSTAT", "ODOM", "SUBSTAT", "LOGSTAT", "LOGR", "STREAM", "DELTA" };
+//Window sizes of the default run
+static const uint8_t g_window[] = { 1, 2, 4, 8, 16 };
+//Link emulator started by the benchmark. 0 = none
+static pid_t g_emu_pid = 0;
+
+/****************************************************************************
+**	FUNCTIONS
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Function
+//!	bench_ns | void
+/***************************************************************************/
+//! @return uint64_t | monotonic time [ns]
+/***************************************************************************/
+
+static uint64_t bench_ns( void )
+{
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return (uint64_t)ts.tv_sec *1000000000ULL +(uint64_t)ts.tv_nsec;
+}	//end function: bench_ns | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	bench_decode | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! Host time of the decoder alone, on a worst case encoder message
+/***************************************************************************/
+
+static void bench_decode( void )
+{
+	//Encoder counts of four wheels far from zero
+	static const char frame[] = "ENCE0N+1234567E1N-2345678E2N+3456789E3N-4567890";
+	OrangeBot::Client_msg msg;
+	//Sum of the values, so the decode isn't optimized away
+	int64_t sum = 0;
+	uint64_t start_ns;
+	//counter
+	uint32_t t;
+
+	start_ns = bench_ns();
+	//For: each decode
+	for (t = 0;t < BENCH_DECODE_NUM;t++)
+	{
+		OrangeBot::Client::decode( (const uint8_t *)frame, (uint8_t)(sizeof( frame ) -1), msg );
+		sum += msg.val[ t % msg.num ];
+	}
+	printf( "{\"decode_ns_per_msg\":%.1f,\"check\":%lld}\n", (double)(bench_ns() -start_ns) /BENCH_DECODE_NUM, (long long)sum );
+
+	return;
+}	//end function: bench_decode | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	bench_spawn | const char *
+/***************************************************************************/
+//! @param command | link emulator. Its first line on stdout is the pty
+//! @param device | pty of the emulator
+//! @param size | room of device
+//! @return int | stdout of the emulator | -1 = fail
+/***************************************************************************/
+
+static int bench_spawn( const char *command, char *device, size_t size )
+{
+	//Pipe from the stdout of the emulator
+	int fd[2];
+	//Bytes of the name of the pty
+	size_t num = 0;
+	char c;
+	//The shell becomes the emulator, so the signal reaches it
+	char shell[1024];
+
+	snprintf( shell, sizeof( shell ), "exec %s", command );
+
+	//if: no pipe or no process
+	if ((pipe( fd ) != 0) || ((g_emu_pid = fork()) < 0))
+	{
+		perror( "spawn" );
+		return -1;
+	}
+	//if: emulator
+	if (g_emu_pid == 0)
+	{
+		dup2( fd[1], STDOUT_FILENO );
+		close( fd[0] );
+		close( fd[1] );
+		execl( "/bin/sh", "sh", "-c", shell, (char *)0 );
+		_exit( 127 );
+	}
+	close( fd[1] );
+	//While: name of the pty
+	while ((num < size -1) && (read( fd[0], &c, 1 ) == 1) && (c != '\n'))
+	{
+		device[ num++ ] = c;
+	}
+	device[ num ] = '\0';
+	//if: the emulator didn't start
+	if (num == 0)
+	{
+		fprintf( stderr, "%s: no pty\n", command );
+		return -1;
+	}
+
+	return fd[0];
+}	//end function: bench_spawn | const char *
+
+/***************************************************************************/
+//!	@brief Function
+//!	bench_run | const char *, uint8_t, uint32_t, uint32_t, OrangeBot::Client_msg_kind
+/***************************************************************************/
+//! @param device | link
+//! @param window | requests waiting for a reply at the same time
+//! @param req_num | requests
+//! @param timeout_ms | time a request waits for its reply
+//! @param kind | message asked for
+//! @return bool | false = OK | true = link error
+/***************************************************************************/
+
+static bool bench_run( const char *device, uint8_t window, uint32_t req_num, uint32_t timeout_ms, OrangeBot::Client_msg_kind kind )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	OrangeBot::Client client;
+	OrangeBot::Client_stat stat;
+	//Requests sent
+	uint32_t sent = 0;
+	uint64_t start_ns, run_ns;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//if: no link
+	if (client.open( device ) == true)
+	{
+		return true;	//fail
+	}
+	client.set_window( window );
+	client.set_timeout( timeout_ms );
+	//Drain what the board sent before
+	client.poll( 10 );
+	start_ns = bench_ns();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//While: requests left or waiting
+	while ((sent < req_num) || (client.get_inflight() > 0))
+	{
+		//While: the window takes more
+		while ((sent < req_num) && (client.request( kind ) != 0))
+		{
+			sent++;
+		}
+		//if: link broken
+		if (client.poll( 1 ) < 0)
+		{
+			return true;	//fail
+		}
+	}
+	run_ns = bench_ns() -start_ns;
+	client.get_stat( stat );
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	printf
+	(
+		"{\"window\":%u,\"cmd\":\"%s\",\"req\":%u,\"reply\":%u,\"timeout\":%u,\"unsolicited\":%u,\"bad\":%u,"
+		"\"cmd_per_s\":%.1f,\"lat_avg_us\":%.1f,\"lat_max_us\":%.1f,\"host_ns_per_msg\":%.1f}\n",
+		window, g_kind_name[ kind ], stat.req, stat.reply, stat.timeout, stat.unsolicited, stat.bad,
+		stat.reply *1e9 /run_ns, (stat.reply > 0)?(stat.lat_sum_ns /1e3 /stat.reply):(0.0), stat.lat_max_ns /1e3,
+		(stat.reply +stat.unsolicited > 0)?((double)stat.decode_ns /(stat.reply +stat.unsolicited)):(0.0)
+	);
+	fflush( stdout );
+
+	return false;	//OK
+}	//end function: bench_run | const char *, uint8_t, uint32_t, uint32_t, OrangeBot::Client_msg_kind
+
+/***************************************************************************/
+//!	@brief Function
+//!	bench_stream_msg | const OrangeBot::Client_msg &, void *
+/***************************************************************************/
+//! @param msg | decoded message
+//! @param user | status of the stream run
+//! @return void
+/***************************************************************************/
+
+static void bench_stream_msg( const OrangeBot::Client_msg &msg, void *user )
+{
+	//Frames received, and skipped frames of the last SUBSTAT
+	uint32_t *cnt = (uint32_t *)user;
+
+	//if: frame
+	if (msg.kind == OrangeBot::CLIENT_MSG_STREAM)
+	{
+		cnt[0]++;
+	}
+	//if: status. SUB<mask>D<decim>K<skip>
+	else if ((msg.kind == OrangeBot::CLIENT_MSG_SUB) && (msg.num >= 3))
+	{
+		cnt[1] = (uint32_t)msg.val[2];
+	}
+
+	return;
+}	//end function: bench_stream_msg | const OrangeBot::Client_msg &, void *
+
+/***************************************************************************/
+//!	@brief Function
+//!	bench_stream | const char *, uint8_t, uint32_t, uint16_t
+/***************************************************************************/
+//! @param device | link
+//! @param mask | signals of the stream and compression. BENCH_STREAM_xxx
+//! @param frame_num | frames to receive
+//! @param decim | base ticks between frames
+//! @return bool | false = OK | true = link error, or the board refused the stream
+/***************************************************************************/
+
+static bool bench_stream( const char *device, uint8_t mask, uint32_t frame_num, uint16_t decim )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	OrangeBot::Client client;
+	OrangeBot::Client_stat stat;
+	//Frames received, skipped frames
+	uint32_t cnt[2] = { 0, 0 };
+	//Bytes received before the first frame
+	uint32_t rx_start;
+	//Frames received or lost before a poll
+	uint32_t frame_cnt;
+	//Time of the last frame [ns]
+	uint64_t last_ns;
+	//Time of the last speed command [ns]
+	uint64_t spd_ns;
+	uint64_t start_ns, run_ns;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//if: no link
+	if (client.open( device ) == true)
+	{
+		return true;	//fail
+	}
+	client.set_msg_callback( &bench_stream_msg, cnt );
+	client.poll( 10 );
+	client.set_platform_speed( BENCH_STREAM_SPD, BENCH_STREAM_SPD );
+	client.subscribe( mask, decim );
+	last_ns = bench_ns();
+	spd_ns = last_ns;
+	//While: first frame. Reads can end in the middle of a frame
+	while ((cnt[0] == 0) && (bench_ns() -last_ns < BENCH_DEFAULT_TIMEOUT *1000000ULL) && (client.poll( 10 ) >= 0))
+	{
+		//Nothing
+	}
+	//if: no stream
+	if (cnt[0] == 0)
+	{
+		fprintf( stderr, "%s: no stream\n", device );
+		return true;	//fail
+	}
+	client.get_stat( stat );
+	rx_start = stat.rx_bytes;
+	cnt[0] = 0;
+	start_ns = bench_ns();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	last_ns = start_ns;
+	//While: frames left
+	while (cnt[0] < frame_num)
+	{
+		frame_cnt = cnt[0] +stat.lost;
+		//if: link broken
+		if (client.poll( 10 ) < 0)
+		{
+			return true;	//fail
+		}
+		client.get_stat( stat );
+		//if: keep the platform moving
+		if (bench_ns() -spd_ns > BENCH_KEEPALIVE *1000000ULL)
+		{
+			client.set_platform_speed( BENCH_STREAM_SPD, BENCH_STREAM_SPD );
+			spd_ns = bench_ns();
+		}
+		//if: frames came, or were dropped waiting for a keyframe
+		if (cnt[0] +stat.lost != frame_cnt)
+		{
+			last_ns = bench_ns();
+		}
+		//if: the stream stopped
+		else if (bench_ns() -last_ns > BENCH_DEFAULT_TIMEOUT *1000000ULL)
+		{
+			fprintf( stderr, "%s: stream stopped after %u frames\n", device, cnt[0] );
+			return true;	//fail
+		}
+	}
+	run_ns = bench_ns() -start_ns;
+	client.get_stat( stat );
+	//Stop the platform and the stream, and ask how many frames the board skipped
+	client.set_platform_speed( 0, 0 );
+	client.subscribe( 0, 0 );
+	client.request( OrangeBot::CLIENT_MSG_SUB );
+	//While: status
+	while ((client.get_inflight() > 0) && (client.poll( 100 ) >= 0))
+	{
+		//Nothing
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	printf
+	(
+		"{\"stream\":\"%s\",\"decim\":%u,\"frame\":%u,\"frame_per_s\":%.1f,\"rx_bytes_per_frame\":%.1f,\"tx_bytes\":%u,\"skip\":%u,\"lost\":%u}\n",
+		((mask & BENCH_STREAM_DELTA) != 0)?("CNT_DELTA"):("CNT"), decim, frame_num, frame_num *1e9 /run_ns,
+		(double)(stat.rx_bytes -rx_start) /frame_num, stat.tx_bytes, cnt[1], stat.lost
+	);
+	fflush( stdout );
+
+	return false;	//OK
+}	//end function: bench_stream | const char *, uint8_t, uint32_t, uint16_t
+
+/***************************************************************************/
+//!	@brief Function
+//!	main | int, char **
+/***************************************************************************/
+//! @return int | 0 = OK | 1 = bad arguments | 2 = link error
+/***************************************************************************/
+
+int main( int argc, char *argv[] )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Link
+	const char *device = 0;
+	//Pty of the emulator
+	char emu_device[256];
+	//Command of the emulator. 0 = none
+	const char *emu_cmd = 0;
+	//stdout of the emulator
+	int emu_fd = -1;
+	uint32_t req_num = BENCH_DEFAULT_REQ;
+	uint32_t timeout_ms = BENCH_DEFAULT_TIMEOUT;
+	uint16_t decim = BENCH_DEFAULT_DECIM;
+	//Window size. 0 = all the default ones
+	uint8_t window = 0;
+	OrangeBot::Client_msg_kind kind = OrangeBot::CLIENT_MSG_ENC;
+	//Output of the emulator
+	char line[1024];
+	ssize_t ret;
+	bool f_fail = false;
+	//counter
+	int t;
+	unsigned int ti;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//For: each argument
+	for (t = 1;t < argc;t++)
+	{
+		//if: option with a value
+		if ((argv[t][0] == '-') && (strchr( "nwtksd", argv[t][1] ) != 0) && (argv[t][2] == '\0') && (t +1 < argc))
+		{
+			t++;
+			switch (argv[t -1][1])
+			{
+				case 'n': req_num = (uint32_t)strtoul( argv[t], 0, 10 ); break;
+				case 'w': window = (uint8_t)strtoul( argv[t], 0, 10 ); break;
+				case 't': timeout_ms = (uint32_t)strtoul( argv[t], 0, 10 ); break;
+				case 's': emu_cmd = argv[t]; break;
+				case 'd': decim = (uint16_t)strtoul( argv[t], 0, 10 ); break;
+				default:
+					//Search the message by name
+					for (ti = 0;(ti < OrangeBot::CLIENT_MSG_NUM) && (strcmp( argv[t], g_kind_name[ti] ) != 0);ti++)
+					{
+						//Nothing
+					}
+					kind = (OrangeBot::Client_msg_kind)ti;
+					break;
+			}
+		}
+		//if: device
+		else if ((argv[t][0] != '-') && (device == 0))
+		{
+			device = argv[t];
+		}
+		else
+		{
+			device = emu_cmd = 0;
+			break;
+		}
+	}
+	//if: no link, bad message or bad window. Records of the capture and frames of the stream can't be asked for by kind
+	if (((device == 0) == (emu_cmd == 0)) || (kind >= OrangeBot::CLIENT_MSG_LOGR) || (window > CLIENT_INFLIGHT_SIZE))
+	{
+		fprintf( stderr, "usage: %s [-n <requests>] [-w <window>] [-t <ms>] [-k <kind>] [-d <ticks>] (-s <command> | <device>)\n", argv[0] );
+		return 1;
+	}
+	//if: start the emulator
+	if (emu_cmd != 0)
+	{
+		emu_fd = bench_spawn( emu_cmd, emu_device, sizeof( emu_device ) );
+		device = emu_device;
+		//if: no emulator
+		if (emu_fd < 0)
+		{
+			return 2;
+		}
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	bench_decode();
+	//For: each window size
+	for (ti = 0;(ti < sizeof( g_window )) && (f_fail == false);ti++)
+	{
+		//if: only one window size
+		if ((window == 0) || (window == g_window[ti]))
+		{
+			f_fail = bench_run( device, g_window[ti], req_num, timeout_ms, kind );
+		}
+	}
+	//if: window size not in the default ones
+	if ((window > 0) && (memchr( g_window, window, sizeof( g_window ) ) == 0) && (f_fail == false))
+	{
+		f_fail = bench_run( device, window, req_num, timeout_ms, kind );
+	}
+	//if: stream runs. Text, then compressed
+	if ((decim > 0) && (f_fail == false))
+	{
+		f_fail = bench_stream( device, BENCH_STREAM_CNT, req_num, decim );
+	}
+	if ((decim > 0) && (f_fail == false))
+	{
+		f_fail = bench_stream( device, BENCH_STREAM_CNT | BENCH_STREAM_DELTA, req_num, decim );
+	}
+	//if: emulator to stop
+	if (g_emu_pid > 0)
+	{
+		kill( g_emu_pid, SIGINT );
+		//While: statistics of the line
+		while ((ret = read( emu_fd, line, sizeof( line ) )) > 0)
+		{
+			fwrite( line, 1, (size_t)ret, stdout );
+		}
+		waitpid( g_emu_pid, 0, 0 );
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return (f_fail == true)?(2):(0);
+}	//end function: main | int, char **
@@ -0,0 +1,1103 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	CLIENT
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:		2019-11-18
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Host side of the RPI serial protocol. Runs on the RPI, not on the board.
+**	Commands and messages are ASCII, terminated by '\0'. Numbers follow a letter:
+**		ENCE0N+12E1N-3E2N+0E3N+7		channel after 'E', value after 'N'
+**		QUEUE3U0S12						depth, 'U' underruns, 'S' segments
+**		T1-120+4+118-3					stream frame. Signals, then their values
+**	Set commands only answer when they fail, with an 'E' and no terminator.
+**	The 'E' ends up in front of the next message and is counted there.
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+//Class Header
+#include "client/ob_client.h"
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+namespace OrangeBot
+{
+
+/****************************************************************************
+**	GLOBAL VARIABILES
+****************************************************************************/
+
+//Messages of the board. Longer prefixes first
+static const struct
+{
+	Client_msg_kind kind;
+	//Preamble of the message
+	const char *prefix;
+	uint8_t prefix_len;
+	//Command that asks for it. 0 = only sent unsolicited
+	const char *cmd;
+	//Values follow this letter. 0 = values follow every letter
+	char mark;
+} g_msg_table[] =
+{
+	{ CLIENT_MSG_ENCSPD,	"ENCSPD",	6,	"ENCSPD",	'N' },
+	{ CLIENT_MSG_ENC,		"ENC",		3,	"ENC",		'N' },
+	{ CLIENT_MSG_CUR,		"CUR",		3,	"CUR",		'N' },
+	{ CLIENT_MSG_VBAT,		"VBAT",		4,	"VBAT",		'N' },
+	{ CLIENT_MSG_QUEUE,		"QUEUE",	5,	"QSTAT",	0 },
+	{ CLIENT_MSG_ODOM,		"ODOM",		4,	"ODOM",		0 },
+	{ CLIENT_MSG_SUB,		"SUB",		3,	"SUBSTAT",	0 },
+	{ CLIENT_MSG_LOGR,		"LOGR",		4,	0,			0 },
+	{ CLIENT_MSG_LOG,		"LOG",		3,	"LOGSTAT",	0 },
+	{ CLIENT_MSG_STREAM,	"T",		1,	0,			0 },
+	{ CLIENT_MSG_DELTA,		"Z",		1,	0,			0 },
+};
+
+//Entries of the message table
+#define CLIENT_TABLE_NUM	(sizeof( g_msg_table ) /sizeof( g_msg_table[0] ))
+
+/****************************************************************************
+**	FUNCTIONS
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Function
+//!	client_ns | void
+/***************************************************************************/
+//! @return uint64_t | monotonic time [ns]
+/***************************************************************************/
+
+static uint64_t client_ns( void )
+{
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return (uint64_t)ts.tv_sec *1000000000ULL +(uint64_t)ts.tv_nsec;
+}	//end function: client_ns | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	client_match | const uint8_t *, uint8_t
+/***************************************************************************/
+//! @param frame | message
+//! @param len | bytes of the message
+//! @return int | entry of the message table | -1 = unknown
+/***************************************************************************/
+
+static int client_match( const uint8_t *frame, uint8_t len )
+{
+	//counter
+	unsigned int t;
+
+	//For: each message
+	for (t = 0;t < CLIENT_TABLE_NUM;t++)
+	{
+		//if: preamble found
+		if ((len >= g_msg_table[t].prefix_len) && (memcmp( frame, g_msg_table[t].prefix, g_msg_table[t].prefix_len ) == 0))
+		{
+			return (int)t;
+		}
+	}
+
+	return -1;
+}	//end function: client_match | const uint8_t *, uint8_t
+
+/***************************************************************************/
+//!	@brief Function
+//!	client_decode_delta | const uint8_t *, uint8_t, Client_msg &
+/***************************************************************************/
+//! @param frame | compressed frame after its preamble
+//! @param len | bytes of the frame
+//! @param msg | header, signals of keyframes, then the values of the varints
+//! @return bool | false = OK | true = bad header, or a varint is cut or too long
+//!	@details
+//! Varints are zig-zag plus one, seven bits per byte, least significant first,
+//!	bit 7 set on all but the last byte. Up to 33b
+/***************************************************************************/
+
+static bool client_decode_delta( const uint8_t *frame, uint8_t len, Client_msg &msg )
+{
+	//Position in the frame
+	uint8_t index;
+	//Varint being decoded
+	uint64_t code = 0;
+	uint8_t shift = 0;
+
+	//if: no header, or not a header
+	if ((len == 0) || ((frame[0] & 0x40) == 0))
+	{
+		return true;	//fail
+	}
+	msg.val[ msg.num++ ] = frame[0];
+	index = 1;
+	//if: keyframe carries the signals
+	if ((frame[0] & 0x80) != 0)
+	{
+		//if: no signals
+		if (len < 2)
+		{
+			return true;	//fail
+		}
+		msg.val[ msg.num++ ] = frame[1];
+		index = 2;
+	}
+	//While: bytes left
+	while (index < len)
+	{
+		//if: longer than 33b
+		if (shift > 28)
+		{
+			return true;	//fail
+		}
+		code |= (uint64_t)(frame[ index ] & 0x7F) << shift;
+		//if: more bytes
+		if ((frame[ index ] & 0x80) != 0)
+		{
+			shift += 7;
+		}
+		else
+		{
+			code--;
+			//if: room for the value
+			if (msg.num < CLIENT_MSG_VAL)
+			{
+				msg.val[ msg.num++ ] = (int32_t)(((uint32_t)code >> 1) ^ (0 -((uint32_t)code & 1)));
+			}
+			code = 0;
+			shift = 0;
+		}
+		index++;
+	}
+
+	//if: last varint is cut
+	return (shift != 0);
+}	//end function: client_decode_delta | const uint8_t *, uint8_t, Client_msg &
+
+/****************************************************************************
+*****************************************************************************
+**	CONSTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Constructor
+//!	Client | void
+/***************************************************************************/
+// @param
+//! @return no return
+//!	@details
+//! Empty constructor. No link, default window and timeout
+/***************************************************************************/
+
+Client::Client( void )
+{
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//No link
+	this -> g_fd				= -1;
+	this -> g_f_own				= false;
+	//Empty pipeline
+	this -> g_inflight_head		= 0;
+	this -> g_inflight_num		= 0;
+	this -> g_window			= CLIENT_DEFAULT_WINDOW;
+	this -> g_timeout_ns		= (uint64_t)CLIENT_DEFAULT_TIMEOUT *1000000ULL;
+	this -> g_tag				= 0;
+	//Empty buffers
+	this -> g_tx_num			= 0;
+	this -> g_frame_num			= 0;
+	this -> g_f_frame_ovf		= false;
+	//Compressed stream waits for a keyframe
+	this -> g_delta_num			= 0;
+	this -> g_delta_seq			= 0;
+	this -> g_f_delta_sync		= false;
+	//No callbacks
+	this -> g_msg_callback		= 0;
+	this -> g_msg_user			= 0;
+	this -> g_timeout_callback	= 0;
+	this -> g_timeout_user		= 0;
+	memset( &this -> g_stat, 0, sizeof( Client_stat ) );
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return;	//OK
+}	//end constructor:
+
+/****************************************************************************
+*****************************************************************************
+**	DESTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Destructor
+//!	Client | void
+/***************************************************************************/
+// @param
+//! @return no return
+//!	@details
+//! Close the link if opened by the client
+/***************************************************************************/
+
+Client::~Client( void )
+{
+	//if: link opened by the client
+	if ((this -> g_f_own == true) && (this -> g_fd >= 0))
+	{
+		close( this -> g_fd );
+	}
+
+	return;	//OK
+}	//end destructor:
+
+/****************************************************************************
+*****************************************************************************
+**	SETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	open | const char *
+/***************************************************************************/
+//! @param device | serial device, e.g. /dev/ttyS0
+//! @return false: OK | true: fail
+//!	@details
+//! Raw mode, non blocking. The baud rate of the device is left as configured
+/***************************************************************************/
+
+bool Client::open( const char *device )
+{
+	//Configuration of the device
+	struct termios tio;
+	int fd;
+
+	fd = ::open( device, O_RDWR | O_NOCTTY | O_NONBLOCK );
+	//if: can't open
+	if (fd < 0)
+	{
+		perror( device );
+		return true;	//fail
+	}
+	//if: a terminal
+	if (tcgetattr( fd, &tio ) == 0)
+	{
+		cfmakeraw( &tio );
+		tcsetattr( fd, TCSANOW, &tio );
+	}
+	this -> attach( fd );
+	this -> g_f_own = true;
+
+	return false;	//OK
+}	//end public method: open | const char *
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	attach | int
+/***************************************************************************/
+//! @param fd | file descriptor of the link, e.g. a socket or a pty
+//! @return void
+//!	@details
+//! The descriptor is made non blocking
+/***************************************************************************/
+
+void Client::attach( int fd )
+{
+	fcntl( fd, F_SETFL, fcntl( fd, F_GETFL ) | O_NONBLOCK );
+	this -> g_fd = fd;
+	this -> g_f_own = false;
+
+	return;
+}	//end public method: attach | int
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	set_window | uint8_t
+/***************************************************************************/
+//! @param window | commands that can wait for a reply at the same time
+//! @return false: OK | true: fail
+/***************************************************************************/
+
+bool Client::set_window( uint8_t window )
+{
+	//if: bad window
+	if ((window < 1) || (window > CLIENT_INFLIGHT_SIZE))
+	{
+		return true;	//fail
+	}
+	this -> g_window = window;
+
+	return false;	//OK
+}	//end public method: set_window | uint8_t
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	set_timeout | uint32_t
+/***************************************************************************/
+//! @param ms | time a command waits for its reply
+//! @return void
+/***************************************************************************/
+
+void Client::set_timeout( uint32_t ms )
+{
+	this -> g_timeout_ns = (uint64_t)ms *1000000ULL;
+
+	return;
+}	//end public method: set_timeout | uint32_t
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	set_msg_callback | void (*)( const Client_msg &, void * ), void *
+/***************************************************************************/
+//! @param callback | called for each decoded message. 0 = none
+//! @param user | passed to the callback
+//! @return void
+/***************************************************************************/
+
+void Client::set_msg_callback( void (*callback)( const Client_msg &msg, void *user ), void *user )
+{
+	this -> g_msg_callback = callback;
+	this -> g_msg_user = user;
+
+	return;
+}	//end public method: set_msg_callback | void (*)( const Client_msg &, void * ), void *
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	set_timeout_callback | void (*)( uint32_t, Client_msg_kind, void * ), void *
+/***************************************************************************/
+//! @param callback | called for each command whose reply didn't come. 0 = none
+//! @param user | passed to the callback
+//! @return void
+/***************************************************************************/
+
+void Client::set_timeout_callback( void (*callback)( uint32_t tag, Client_msg_kind kind, void *user ), void *user )
+{
+	this -> g_timeout_callback = callback;
+	this -> g_timeout_user = user;
+
+	return;
+}	//end public method: set_timeout_callback | void (*)( uint32_t, Client_msg_kind, void * ), void *
+
+/****************************************************************************
+*****************************************************************************
+**	GETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Getter
+//!	get_inflight | void
+/***************************************************************************/
+//! @return uint8_t | commands waiting for a reply
+/***************************************************************************/
+
+uint8_t Client::get_inflight( void )
+{
+	return this -> g_inflight_num;
+}	//end getter: get_inflight | void
+
+/***************************************************************************/
+//!	@brief Public Getter
+//!	get_stat | Client_stat &
+/***************************************************************************/
+//! @param stat | statistics since the client was created
+//! @return void
+/***************************************************************************/
+
+void Client::get_stat( Client_stat &stat )
+{
+	stat = this -> g_stat;
+
+	return;
+}	//end getter: get_stat | Client_stat &
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	ping | void
+/***************************************************************************/
+//! @return false: OK | true: TX buffer full
+/***************************************************************************/
+
+bool Client::ping( void )
+{
+	return this -> queue( "P", 0, 0 );
+}	//end public method: ping | void
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	set_platform_speed | int16_t, int16_t
+/***************************************************************************/
+//! @param right | speed of the right side [counts per tick]
+//! @param left | speed of the left side [counts per tick]
+//! @return false: OK | true: TX buffer full
+/***************************************************************************/
+
+bool Client::set_platform_speed( int16_t right, int16_t left )
+{
+	return this -> queue( "SPDR%dL%d", right, left );
+}	//end public method: set_platform_speed | int16_t, int16_t
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	set_pid_speed | uint8_t, int16_t
+/***************************************************************************/
+//! @param index | motor
+//! @param spd | speed [counts per tick]
+//! @return false: OK | true: TX buffer full
+/***************************************************************************/
+
+bool Client::set_pid_speed( uint8_t index, int16_t spd )
+{
+	return this -> queue( "PID%dSPD%d", index, spd );
+}	//end public method: set_pid_speed | uint8_t, int16_t
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	subscribe | uint8_t, uint16_t
+/***************************************************************************/
+//! @param mask | STREAM_xxx signals. 0 = stop the stream
+//! @param decim | a frame every this many base ticks
+//! @return false: OK | true: TX buffer full
+//!	@details
+//! Frames are unsolicited CLIENT_MSG_STREAM messages. The board answers 'E' if the frame doesn't fit its TX buffer
+/***************************************************************************/
+
+bool Client::subscribe( uint8_t mask, uint16_t decim )
+{
+	return this -> queue( "SUB%dD%d", mask, decim );
+}	//end public method: subscribe | uint8_t, uint16_t
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	send | const char *
+/***************************************************************************/
+//! @param cmd | command without terminator
+//! @return false: OK | true: TX buffer full or too long
+//!	@details
+//! For commands without a reply. Replies to commands sent this way are unsolicited
+/***************************************************************************/
+
+bool Client::send( const char *cmd )
+{
+	//if: command would be taken as a format
+	if (strchr( cmd, '%' ) != 0)
+	{
+		return true;	//fail
+	}
+
+	return this -> queue( cmd, 0, 0 );
+}	//end public method: send | const char *
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	request | Client_msg_kind
+/***************************************************************************/
+//! @param kind | message to ask for
+//! @return uint32_t | tag of the command, in the reply | 0 = window or TX buffer full
+/***************************************************************************/
+
+uint32_t Client::request( Client_msg_kind kind )
+{
+	//Entry of the message table
+	unsigned int t;
+
+	//Search the command of the message
+	for (t = 0;(t < CLIENT_TABLE_NUM) && (g_msg_table[t].kind != kind);t++)
+	{
+		//Nothing
+	}
+	//if: unknown message, or nothing asks for it
+	if ((t >= CLIENT_TABLE_NUM) || (g_msg_table[t].cmd == 0))
+	{
+		return 0;
+	}
+
+	return this -> track( kind, g_msg_table[t].cmd, 0 );
+}	//end public method: request | Client_msg_kind
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	read_log | uint16_t
+/***************************************************************************/
+//! @param index | record of the RAM capture. 0 is the oldest
+//! @return uint32_t | tag of the command, in the reply | 0 = window or TX buffer full
+//!	@details
+//! The reply is a CLIENT_MSG_LOGR message: the index, then the values of the record
+/***************************************************************************/
+
+uint32_t Client::read_log( uint16_t index )
+{
+	return this -> track( CLIENT_MSG_LOGR, "LOGR%d", index );
+}	//end public method: read_log | uint16_t
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	poll | int
+/***************************************************************************/
+//! @param timeout_ms | longest wait for the link. 0 = don't wait | -1 = until something is received
+//! @return int | messages decoded | -1 = link error
+//!	@details
+//! Write what the link takes, then read and decode all that has been received
+/***************************************************************************/
+
+int Client::poll( int timeout_ms )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Wait of the link
+	struct pollfd pfd;
+	//Bytes read in one go
+	uint8_t buf[256];
+	ssize_t ret;
+	//Messages decoded
+	uint32_t msg_cnt;
+	//Start of the decode [ns]
+	uint64_t start_ns;
+	//counter
+	ssize_t t;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//if: no link, or it broke
+	if ((this -> g_fd < 0) || (this -> flush() == true))
+	{
+		return -1;
+	}
+	pfd.fd = this -> g_fd;
+	pfd.events = (short)((this -> g_tx_num > 0)?(POLLIN | POLLOUT):(POLLIN));
+	::poll( &pfd, 1, timeout_ms );
+	msg_cnt = this -> g_stat.reply +this -> g_stat.unsolicited;
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//if: the link takes more
+	if (((pfd.revents & POLLOUT) != 0) && (this -> flush() == true))
+	{
+		return -1;
+	}
+	start_ns = client_ns();
+	//While: bytes received
+	while ((ret = read( this -> g_fd, buf, sizeof( buf ) )) > 0)
+	{
+		this -> g_stat.rx_bytes += (uint32_t)ret;
+		//For: each byte
+		for (t = 0;t < ret;t++)
+		{
+			//if: terminator
+			if (buf[t] == '\0')
+			{
+				this -> dispatch();
+			}
+			//if: room in the message
+			else if (this -> g_frame_num < CLIENT_FRAME_SIZE -1)
+			{
+				this -> g_frame[ this -> g_frame_num++ ] = buf[t];
+			}
+			else
+			{
+				this -> g_f_frame_ovf = true;
+			}
+		}
+	}
+	//if: link closed or broken
+	if ((ret == 0) || ((ret < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK)))
+	{
+		return -1;
+	}
+	this -> check_timeout( client_ns() );
+	this -> g_stat.decode_ns += client_ns() -start_ns;
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return (int)(this -> g_stat.reply +this -> g_stat.unsolicited -msg_cnt);
+}	//end public method: poll | int
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC STATIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Static Method
+//!	decode | const uint8_t *, uint8_t, Client_msg &
+/***************************************************************************/
+//! @param frame | message without its terminator
+//! @param len | bytes of the message
+//! @param msg | decoded message. tag and latency are not touched
+//! @return false: OK | true: unknown message
+//!	@details
+//! Error replies 'E' in front of the message are counted and skipped.
+//!	Values longer than 32b wrap
+/***************************************************************************/
+
+bool Client::decode( const uint8_t *frame, uint8_t len, Client_msg &msg )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Entry of the message table
+	int entry;
+	//Position in the message
+	uint8_t index;
+	//true = the next number is a value
+	bool f_take;
+	//Number being decoded
+	uint32_t num;
+	bool f_neg;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	msg.num = 0;
+	msg.err = 0;
+	//While: error replies in front
+	while ((len > 0) && (frame[0] == 'E') && ((entry = client_match( frame, len )) < 0))
+	{
+		frame++;
+		len--;
+		msg.err++;
+	}
+	//if: unknown message
+	if ((len == 0) || ((entry = client_match( frame, len )) < 0))
+	{
+		return true;	//fail
+	}
+	msg.kind = g_msg_table[ entry ].kind;
+	index = g_msg_table[ entry ].prefix_len;
+	f_take = (g_msg_table[ entry ].mark == 0);
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//if: compressed frame of the stream
+	if (msg.kind == CLIENT_MSG_DELTA)
+	{
+		return client_decode_delta( &frame[ index ], len -index, msg );
+	}
+	//While: bytes left
+	while (index < len)
+	{
+		//if: number
+		if (((frame[ index ] >= '0') && (frame[ index ] <= '9')) || (frame[ index ] == '+') || (frame[ index ] == '-'))
+		{
+			f_neg = (frame[ index ] == '-');
+			index += ((frame[ index ] == '+') || (frame[ index ] == '-'))?(1):(0);
+			num = 0;
+			//While: digits
+			while ((index < len) && (frame[ index ] >= '0') && (frame[ index ] <= '9'))
+			{
+				num = num *10 +(uint32_t)(frame[ index ] -'0');
+				index++;
+			}
+			//if: a value and room for it
+			if ((f_take == true) && (msg.num < CLIENT_MSG_VAL))
+			{
+				msg.val[ msg.num++ ] = (f_neg == true)?(-(int32_t)num):((int32_t)num);
+			}
+			f_take = (g_msg_table[ entry ].mark == 0);
+		}
+		//if: letter
+		else
+		{
+			f_take = (g_msg_table[ entry ].mark == 0) || (frame[ index ] == g_msg_table[ entry ].mark);
+			index++;
+		}
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return false;	//OK
+}	//end public static method: decode | const uint8_t *, uint8_t, Client_msg &
+
+/****************************************************************************
+*****************************************************************************
+**	PRIVATE METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Private Method
+//!	queue | const char *, int, int
+/***************************************************************************/
+//! @param format | command, with up to two %d
+//! @param arg_a | first argument
+//! @param arg_b | second argument
+//! @return false: OK | true: TX buffer full
+/***************************************************************************/
+
+bool Client::queue( const char *format, int arg_a, int arg_b )
+{
+	//Bytes of the command, terminator included
+	int ret;
+
+	ret = snprintf( (char *)&this -> g_tx[ this -> g_tx_num ], CLIENT_TX_SIZE -this -> g_tx_num, format, arg_a, arg_b );
+	//if: no room. snprintf doesn't count its own terminator, that is the one of the command
+	if ((ret < 0) || (ret +1 > CLIENT_TX_SIZE -this -> g_tx_num))
+	{
+		return true;	//fail
+	}
+	this -> g_tx_num = (uint16_t)(this -> g_tx_num +ret +1);
+	this -> g_stat.cmd++;
+
+	return false;	//OK
+}	//end private method: queue | const char *, int, int
+
+/***************************************************************************/
+//!	@brief Private Method
+//!	track | Client_msg_kind, const char *, int
+/***************************************************************************/
+//! @param kind | message that answers the command
+//! @param format | command, with up to one %d
+//! @param arg | argument of the command
+//! @return uint32_t | tag of the command, in the reply | 0 = window or TX buffer full
+/***************************************************************************/
+
+uint32_t Client::track( Client_msg_kind kind, const char *format, int arg )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Slot of the pipeline
+	uint8_t index;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//if: window full, or TX buffer full
+	if ((this -> g_inflight_num >= this -> g_window) || (this -> queue( format, arg, 0 ) == true))
+	{
+		return 0;
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Tag 0 means unsolicited
+	this -> g_tag = (this -> g_tag +1 == 0)?(1):(this -> g_tag +1);
+	index = (this -> g_inflight_head +this -> g_inflight_num) % CLIENT_INFLIGHT_SIZE;
+	this -> g_inflight[ index ].kind = kind;
+	this -> g_inflight[ index ].tag = this -> g_tag;
+	this -> g_inflight[ index ].ns = client_ns();
+	this -> g_inflight[ index ].f_done = false;
+	this -> g_inflight_num++;
+	this -> g_stat.req++;
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return this -> g_tag;
+}	//end private method: track | Client_msg_kind, const char *, int
+
+/***************************************************************************/
+//!	@brief Private Method
+//!	flush | void
+/***************************************************************************/
+//! @return false: OK | true: link error
+/***************************************************************************/
+
+bool Client::flush( void )
+{
+	//Bytes written
+	ssize_t ret;
+
+	//if: nothing to write
+	if (this -> g_tx_num == 0)
+	{
+		return false;	//OK
+	}
+	ret = write( this -> g_fd, this -> g_tx, this -> g_tx_num );
+	//if: link full
+	if ((ret < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+	{
+		return false;	//OK
+	}
+	//if: link broken
+	if (ret < 0)
+	{
+		return true;	//fail
+	}
+	memmove( this -> g_tx, &this -> g_tx[ ret ], this -> g_tx_num -(size_t)ret );
+	this -> g_tx_num = (uint16_t)(this -> g_tx_num -ret);
+	this -> g_stat.tx_bytes += (uint32_t)ret;
+
+	return false;	//OK
+}	//end private method: flush | void
+
+/***************************************************************************/
+//!	@brief Private Method
+//!	dispatch | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! The oldest command waiting for this kind of message is answered
+/***************************************************************************/
+
+void Client::dispatch( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	Client_msg msg;
+	//Slot of the pipeline
+	uint8_t index;
+	//counter
+	uint8_t t;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//if: message too long, or unknown
+	if ((this -> g_f_frame_ovf == true) || (Client::decode( this -> g_frame, this -> g_frame_num, msg ) == true))
+	{
+		this -> g_stat.bad++;
+		this -> g_frame_num = 0;
+		this -> g_f_frame_ovf = false;
+		return;
+	}
+	this -> g_frame_num = 0;
+	this -> g_stat.err += msg.err;
+	msg.tag = 0;
+	msg.latency_ns = 0;
+	//if: compressed frame that can't be expanded
+	if ((msg.kind == CLIENT_MSG_DELTA) && (this -> expand( msg ) == true))
+	{
+		return;
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//For: each command waiting, oldest first
+	for (t = 0;(t < this -> g_inflight_num) && (msg.tag == 0);t++)
+	{
+		index = (this -> g_inflight_head +t) % CLIENT_INFLIGHT_SIZE;
+		//if: waits for this message
+		if ((this -> g_inflight[ index ].f_done == false) && (this -> g_inflight[ index ].kind == msg.kind))
+		{
+			this -> g_inflight[ index ].f_done = true;
+			msg.tag = this -> g_inflight[ index ].tag;
+			msg.latency_ns = client_ns() -this -> g_inflight[ index ].ns;
+		}
+	}
+	//if: reply
+	if (msg.tag != 0)
+	{
+		this -> g_stat.reply++;
+		this -> g_stat.lat_sum_ns += msg.latency_ns;
+		this -> g_stat.lat_max_ns = (msg.latency_ns > this -> g_stat.lat_max_ns)?(msg.latency_ns):(this -> g_stat.lat_max_ns);
+	}
+	else
+	{
+		this -> g_stat.unsolicited++;
+	}
+	//While: answered commands leave the pipeline in order
+	while ((this -> g_inflight_num > 0) && (this -> g_inflight[ this -> g_inflight_head ].f_done == true))
+	{
+		this -> g_inflight_head = (this -> g_inflight_head +1) % CLIENT_INFLIGHT_SIZE;
+		this -> g_inflight_num--;
+	}
+	//if: application listens
+	if (this -> g_msg_callback != 0)
+	{
+		this -> g_msg_callback( msg, this -> g_msg_user );
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return;
+}	//end private method: dispatch | void
+
+/***************************************************************************/
+//!	@brief Private Method
+//!	expand | Client_msg &
+/***************************************************************************/
+//! @param msg | compressed frame. Becomes a frame of the stream
+//! @return false: OK | true: frames were lost, the frame waits for a keyframe
+//!	@details
+//! Keyframes hold the whole values, the other frames the change from the frame before.
+//!	A gap in the sequence numbers means frames were lost, the values are unknown until the next keyframe
+/***************************************************************************/
+
+bool Client::expand( Client_msg &msg )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Sequence number of the frame
+	uint8_t seq;
+	//true = keyframe
+	bool f_key;
+	//counter
+	uint8_t t;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	seq = (uint8_t)(msg.val[0] & 0x3F);
+	f_key = ((msg.val[0] & 0x80) != 0);
+	//if: frames lost since the last one
+	if ((this -> g_f_delta_sync == true) && (seq != this -> g_delta_seq))
+	{
+		this -> g_stat.lost += (seq +CLIENT_DELTA_SEQ -this -> g_delta_seq) % CLIENT_DELTA_SEQ;
+		this -> g_f_delta_sync = false;
+	}
+	this -> g_delta_seq = (seq +1) % CLIENT_DELTA_SEQ;
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//if: keyframe. Signals and whole values
+	if (f_key == true)
+	{
+		for (t = 1;t < msg.num;t++)
+		{
+			this -> g_delta_val[ t -1 ] = msg.val[t];
+		}
+		this -> g_delta_num = msg.num -1;
+		this -> g_f_delta_sync = true;
+	}
+	//if: changes of the values of a frame received
+	else if ((this -> g_f_delta_sync == true) && (msg.num == this -> g_delta_num))
+	{
+		for (t = 1;t < msg.num;t++)
+		{
+			this -> g_delta_val[t] = (int32_t)((uint32_t)this -> g_delta_val[t] +(uint32_t)msg.val[t]);
+		}
+	}
+	//if: frame before it lost, or values don't match the signals
+	else
+	{
+		this -> g_stat.lost++;
+		this -> g_f_delta_sync = false;
+		return true;	//fail
+	}
+	msg.kind = CLIENT_MSG_STREAM;
+	msg.num = this -> g_delta_num;
+	for (t = 0;t < msg.num;t++)
+	{
+		msg.val[t] = this -> g_delta_val[t];
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return false;	//OK
+}	//end private method: expand | Client_msg &
+
+/***************************************************************************/
+//!	@brief Private Method
+//!	check_timeout | uint64_t
+/***************************************************************************/
+//! @param now_ns | current time [ns]
+//! @return void
+/***************************************************************************/
+
+void Client::check_timeout( uint64_t now_ns )
+{
+	//Slot of the pipeline
+	uint8_t index;
+
+	//While: the oldest command is late, or answered
+	while ((this -> g_inflight_num > 0) && ((this -> g_inflight[ this -> g_inflight_head ].f_done == true) || (now_ns -this -> g_inflight[ this -> g_inflight_head ].ns > this -> g_timeout_ns)))
+	{
+		index = this -> g_inflight_head;
+		this -> g_inflight_head = (this -> g_inflight_head +1) % CLIENT_INFLIGHT_SIZE;
+		this -> g_inflight_num--;
+		//if: late
+		if (this -> g_inflight[ index ].f_done == false)
+		{
+			this -> g_stat.timeout++;
+			//if: application listens
+			if (this -> g_timeout_callback != 0)
+			{
+				this -> g_timeout_callback( this -> g_inflight[ index ].tag, this -> g_inflight[ index ].kind, this -> g_timeout_user );
+			}
+		}
+	}
+
+	return;
+}	//end private method: check_timeout | uint64_t
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
@@ -0,0 +1,327 @@
+/**********************************************************************************
+**	ENVIROMENT VARIABILE
+**********************************************************************************/
+
+#ifndef OB_CLIENT_H_
+	#define OB_CLIENT_H_
+
+/**********************************************************************************
+**	GLOBAL INCLUDES
+**********************************************************************************/
+
+#include <stdint.h>
+
+/**********************************************************************************
+**	DEFINES
+**********************************************************************************/
+
+//Commands waiting for a reply
+#define CLIENT_INFLIGHT_SIZE	32
+//Default commands waiting for a reply. Replies and telemetry share the 128 byte TX buffer of the board
+#define CLIENT_DEFAULT_WINDOW	2
+//Default time a command waits for its reply [ms]
+#define CLIENT_DEFAULT_TIMEOUT	100
+//Bytes waiting to be written to the link
+#define CLIENT_TX_SIZE			1024
+//Longest message from the board, terminator included. A stream frame fills most of the 128 byte TX buffer of the board
+#define CLIENT_FRAME_SIZE		128
+//Values of a message. A stream frame with every signal is the longest
+#define CLIENT_MSG_VAL			40
+//Sequence numbers of the compressed stream. STREAM_SEQ_NUM of the board
+#define CLIENT_DELTA_SEQ		64
+
+/**********************************************************************************
+**	MACROS
+**********************************************************************************/
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+//! @namespace OrangeBot
+namespace OrangeBot
+{
+
+/**********************************************************************************
+**	TYPEDEFS
+**********************************************************************************/
+
+//Message from the board, and the command that asks for it
+typedef enum _Client_msg_kind
+{
+	CLIENT_MSG_ENC,			//ENC		32b encoder counts
+	CLIENT_MSG_ENCSPD,		//ENCSPD	16b encoder speeds
+	CLIENT_MSG_CUR,			//CUR		motor currents
+	CLIENT_MSG_VBAT,		//VBAT		battery voltage
+	CLIENT_MSG_QUEUE,		//QSTAT		depth, underruns and completed segments of the motion queue
+	CLIENT_MSG_ODOM,		//ODOM		X, Y and heading
+	CLIENT_MSG_SUB,			//SUBSTAT	signals, decimation and skipped frames of the telemetry stream
+	CLIENT_MSG_LOG,			//LOGSTAT	state, records and pre-trigger records of the RAM capture
+	CLIENT_MSG_LOGR,		//LOGR		index, then the values of a record of the RAM capture. Asked with read_log
+	CLIENT_MSG_STREAM,		//			frame of the telemetry stream. Signals, then the values in the order of the STREAM_xxx bits
+	CLIENT_MSG_DELTA,		//			compressed frame of the telemetry stream. Header, signals of keyframes, then the varints.
+							//			decode only. The client expands it into a CLIENT_MSG_STREAM
+	CLIENT_MSG_NUM
+} Client_msg_kind;
+
+/**********************************************************************************
+**	PROTOTYPE: STRUCTURES
+**********************************************************************************/
+
+//Decoded message
+typedef struct _Client_msg
+{
+	Client_msg_kind kind;
+	//Values, in the order they are sent
+	uint8_t num;
+	int32_t val[ CLIENT_MSG_VAL ];
+	//Error replies 'E' of earlier commands found in front of the message
+	uint8_t err;
+	//Command answered. 0 = unsolicited telemetry
+	uint32_t tag;
+	//Time from the command to the reply. 0 = unsolicited [ns]
+	uint64_t latency_ns;
+} Client_msg;
+
+//Statistics of the client
+typedef struct _Client_stat
+{
+	//Commands written, and those that wait for a reply
+	uint32_t cmd;
+	uint32_t req;
+	//Messages decoded: replies, and telemetry nobody asked for
+	uint32_t reply;
+	uint32_t unsolicited;
+	//Commands whose reply never came
+	uint32_t timeout;
+	//Error replies 'E' of the board
+	uint32_t err;
+	//Messages that can't be decoded, or too long
+	uint32_t bad;
+	//Compressed frames of the stream lost on the link, or dropped waiting for a keyframe
+	uint32_t lost;
+	//Bytes on the link
+	uint32_t tx_bytes;
+	uint32_t rx_bytes;
+	//Time from the command to the reply [ns]
+	uint64_t lat_sum_ns;
+	uint64_t lat_max_ns;
+	//Host time spent reading, decoding and dispatching the received bytes [ns]
+	uint64_t decode_ns;
+} Client_stat;
+
+/**********************************************************************************
+**	PROTOTYPE: GLOBAL VARIABILES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: CLASS
+**********************************************************************************/
+
+/************************************************************************************/
+//! @class 		Client
+/************************************************************************************/
+//!	@author		Orso Eric
+//! @version	0.1 alpha
+//! @date		2019-11-18
+//! @brief		Host side of the RPI serial protocol, pipelined
+//! @details
+//!	Speaks the protocol of the board from the RPI, or any host with a serial port \n
+//! FEATURES:	\n
+//!		Pipeline	\n
+//! Commands are queued and written without waiting. Up to a window of commands wait for a reply \n
+//! Replies come in order, each is matched to the oldest command of its kind still waiting \n
+//!		Telemetry	\n
+//! Every decoded message goes to the callback, replies and unsolicited telemetry alike \n
+//! Unsolicited telemetry of a kind that is waited for completes the command, its data is as fresh \n
+//!		Timeout	\n
+//! Commands whose reply doesn't come in time are dropped and reported to the timeout callback \n
+//!		No allocation	\n
+//! Fixed buffers. Messages are decoded in place into a Client_msg \n
+//! @pre		open or attach a link before use. poll must be called to write and read the link
+//! @bug		The board signature reply has no terminator, F is not supported
+//! @warning	Not thread safe
+//! @copyright	License ?
+//! @todo		todo list
+/************************************************************************************/
+
+class Client
+{
+	//Visible to all
+	public:
+		//--------------------------------------------------------------------------
+		//	CONSTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//! Default constructor
+		Client( void );
+
+		//--------------------------------------------------------------------------
+		//	DESTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//!Default destructor. Close the link if opened by the client
+		~Client( void );
+
+		//--------------------------------------------------------------------------
+		//	OPERATORS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	SETTERS
+		//--------------------------------------------------------------------------
+
+		//Open a serial device in raw mode. false=OK
+		bool open( const char *device );
+		//Use a file descriptor already open. The client doesn't close it
+		void attach( int fd );
+		//Commands that can wait for a reply at the same time. 1 = no pipeline. false=OK
+		bool set_window( uint8_t window );
+		//Time a command waits for its reply [ms]
+		void set_timeout( uint32_t ms );
+		//Called for each decoded message
+		void set_msg_callback( void (*callback)( const Client_msg &msg, void *user ), void *user );
+		//Called for each command whose reply didn't come
+		void set_timeout_callback( void (*callback)( uint32_t tag, Client_msg_kind kind, void *user ), void *user );
+
+		//--------------------------------------------------------------------------
+		//	GETTERS
+		//--------------------------------------------------------------------------
+
+		//Commands waiting for a reply
+		uint8_t get_inflight( void );
+		//Statistics since the client was created
+		void get_stat( Client_stat &stat );
+
+		//--------------------------------------------------------------------------
+		//	REFERENCES
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	TESTERS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC METHODS
+		//--------------------------------------------------------------------------
+
+		//Keep the connection alive. false=OK | true=TX buffer full
+		bool ping( void );
+		//Speed of the right and left side with the speed PID. SPDR. false=OK | true=TX buffer full
+		bool set_platform_speed( int16_t right, int16_t left );
+		//Speed of one motor with the speed PID. PID. false=OK | true=TX buffer full
+		bool set_pid_speed( uint8_t index, int16_t spd );
+		//Telemetry stream of the STREAM_xxx signals every decim base ticks. 0 = stop. SUB. false=OK | true=TX buffer full
+		bool subscribe( uint8_t mask, uint16_t decim );
+		//Command without reply. Terminator is added. false=OK | true=TX buffer full or too long
+		bool send( const char *cmd );
+		//Ask for a message. Tag of the command | 0 = window or TX buffer full, or a message nobody asks for
+		uint32_t request( Client_msg_kind kind );
+		//Ask for a record of the RAM capture. LOGR. Tag of the command | 0 = window or TX buffer full
+		uint32_t read_log( uint16_t index );
+		//Write the queued commands, read and decode the replies, check the timeouts. Messages decoded | -1 = link error
+		int poll( int timeout_ms );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC STATIC METHODS
+		//--------------------------------------------------------------------------
+
+		//Decode a message without its terminator. false=OK | true=unknown message
+		static bool decode( const uint8_t *frame, uint8_t len, Client_msg &msg );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC VARS
+		//--------------------------------------------------------------------------
+
+	//Visible to derived classes
+	protected:
+		//--------------------------------------------------------------------------
+		//	PROTECTED METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PROTECTED VARS
+		//--------------------------------------------------------------------------
+
+	//Visible only inside the class
+	private:
+		//--------------------------------------------------------------------------
+		//	PRIVATE METHODS
+		//--------------------------------------------------------------------------
+
+		//Queue a formatted command. false=OK | true=TX buffer full
+		bool queue( const char *format, int arg_a, int arg_b );
+		//Queue a command and wait for its reply of a kind. Tag of the command | 0 = window or TX buffer full
+		uint32_t track( Client_msg_kind kind, const char *format, int arg );
+		//Write as much of the TX buffer as the link takes. false=OK | true=link error
+		bool flush( void );
+		//Decode a received message and dispatch it
+		void dispatch( void );
+		//Turn a compressed frame of the stream into a frame of the stream. false=OK | true=frames lost, waits for a keyframe
+		bool expand( Client_msg &msg );
+		//Drop the commands whose reply is late
+		void check_timeout( uint64_t now_ns );
+
+		//--------------------------------------------------------------------------
+		//	PRIVATE VARS
+		//--------------------------------------------------------------------------
+
+			///Link
+		int g_fd;
+		//true = the link was opened by the client
+		bool g_f_own;
+
+			///Pipeline
+		//Commands waiting for a reply. Circular buffer
+		struct
+		{
+			Client_msg_kind kind;
+			uint32_t tag;
+			//Time the command was queued [ns]
+			uint64_t ns;
+			//true = answered, waits for the older ones to leave
+			bool f_done;
+		} g_inflight[ CLIENT_INFLIGHT_SIZE ];
+		uint8_t g_inflight_head;
+		uint8_t g_inflight_num;
+		uint8_t g_window;
+		uint64_t g_timeout_ns;
+		//Tag of the last command
+		uint32_t g_tag;
+
+			///Buffers
+		uint8_t g_tx[ CLIENT_TX_SIZE ];
+		uint16_t g_tx_num;
+		uint8_t g_frame[ CLIENT_FRAME_SIZE ];
+		uint8_t g_frame_num;
+		//true = the message being received is too long and is discarded
+		bool g_f_frame_ovf;
+
+			///Compressed stream
+		//Last frame of the stream, signals first
+		int32_t g_delta_val[ CLIENT_MSG_VAL ];
+		uint8_t g_delta_num;
+		//Sequence number of the next frame
+		uint8_t g_delta_seq;
+		//true = a keyframe came, and no frame was lost since
+		bool g_f_delta_sync;
+
+			///Callbacks
+		void (*g_msg_callback)( const Client_msg &msg, void *user );
+		void *g_msg_user;
+		void (*g_timeout_callback)( uint32_t tag, Client_msg_kind kind, void *user );
+		void *g_timeout_user;
+
+		Client_stat g_stat;
+
+};	//End Class: Client
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
+
+#else
+    #warning "Multiple inclusion of hader file"
+#endif
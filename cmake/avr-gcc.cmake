@@ -0,0 +1,33 @@
+#****************************************************************************
+#**	OrangeBot Project
+#****************************************************************************
+#**	Toolchain of the AT4809 target
+#**	AVR_DEVICE_PACK: path of the Microchip ATmega device pack, if avr-gcc doesn't know the atmega4809
+#****************************************************************************
+
+set(CMAKE_SYSTEM_NAME Generic)
+set(CMAKE_SYSTEM_PROCESSOR avr)
+
+set(AVR_MCU atmega4809 CACHE STRING "AVR device")
+set(AVR_DEVICE_PACK "" CACHE PATH "Microchip ATmega device pack")
+
+find_program(CMAKE_C_COMPILER avr-gcc)
+find_program(CMAKE_CXX_COMPILER avr-g++)
+find_program(CMAKE_OBJCOPY avr-objcopy)
+find_program(AVR_SIZE avr-size)
+find_program(AVR_NM avr-nm)
+#Optional. Runs the cycle benchmark if it has a core for AVR_MCU
+find_program(SIMAVR simavr)
+
+set(AVR_FLAGS "-mmcu=${AVR_MCU}")
+#if: device support from the pack
+if (AVR_DEVICE_PACK)
+	set(AVR_FLAGS "${AVR_FLAGS} -B ${AVR_DEVICE_PACK}/gcc/dev/${AVR_MCU} -isystem ${AVR_DEVICE_PACK}/include")
+endif()
+set(CMAKE_C_FLAGS_INIT "${AVR_FLAGS}")
+set(CMAKE_CXX_FLAGS_INIT "${AVR_FLAGS}")
+set(CMAKE_EXE_LINKER_FLAGS_INIT "${AVR_FLAGS}")
+
+#No executable can run on the build machine
+set(CMAKE_TRY_COMPILE_TARGET_TYPE STATIC_LIBRARY)
+set(CMAKE_FIND_ROOT_PATH_MODE_PROGRAM NEVER)
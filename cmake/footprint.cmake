@@ -0,0 +1,69 @@
+#****************************************************************************
+#**	OrangeBot Project
+#****************************************************************************
+#**	Flash and RAM footprint of the hot paths of the firmware
+#**	cmake -DNM=<avr-nm> -DSIZE=<avr-size> -DELF=<elf> -DSU_DIR=<dir> -P footprint.cmake
+#**	flash:	code of the function, from the symbol table
+#**	static:	RAM of the static variables declared inside the function
+#**	stack:	frame of the function, from the .su files of -fstack-usage. Callees not included
+#****************************************************************************
+
+#Hot paths. Regular expressions on the demangled names
+set(HOT_PATHS
+	"OrangeBot::Pid_s16::exe\\("
+	"quad_encoder_decoder\\("
+	"Orangebot::Uniparser::exe\\("
+	"s32_to_str\\("
+	"update_pwm\\("
+)
+
+execute_process(COMMAND ${NM} -C -S --size-sort ${ELF} OUTPUT_VARIABLE NM_OUT RESULT_VARIABLE NM_RET)
+#if: no symbol table
+if (NOT NM_RET EQUAL 0)
+	message(FATAL_ERROR "${NM} failed on ${ELF}")
+endif()
+string(REPLACE "\n" ";" NM_LINES "${NM_OUT}")
+file(GLOB_RECURSE SU_FILES "${SU_DIR}/*.su")
+set(SU_LINES "")
+#For: each .su file
+foreach (su ${SU_FILES})
+	file(STRINGS ${su} lines)
+	list(APPEND SU_LINES ${lines})
+endforeach()
+
+message("function flash static stack")
+#For: each hot path
+foreach (path ${HOT_PATHS})
+	set(flash 0)
+	set(ram 0)
+	set(stack 0)
+	#For: each symbol. <address> <size> <type> <name>
+	foreach (line ${NM_LINES})
+		#if: symbol with a size
+		if (line MATCHES "^[0-9a-fA-F]+ ([0-9a-fA-F]+) ([a-zA-Z]) (.*)$")
+			set(size_hex ${CMAKE_MATCH_1})
+			set(type ${CMAKE_MATCH_2})
+			set(name "${CMAKE_MATCH_3}")
+			math(EXPR size "0x${size_hex}")
+			#if: code of the function
+			if ((type MATCHES "^[tTwW]$") AND (name MATCHES "^${path}"))
+				math(EXPR flash "${flash} +${size}")
+			#if: static variable of the function
+			elseif ((type MATCHES "^[bBdD]$") AND (name MATCHES "^${path}.*::"))
+				math(EXPR ram "${ram} +${size}")
+			endif()
+		endif()
+	endforeach()
+	#For: each frame. <file>:<line>:<column>:<function> <bytes> <qualifier>
+	foreach (line ${SU_LINES})
+		#if: frame of the function, after the return type if any. Largest overload
+		if ((line MATCHES "[: ]${path}[^\t]*\t([0-9]+)\t") AND (CMAKE_MATCH_1 GREATER stack))
+			set(stack ${CMAKE_MATCH_1})
+		endif()
+	endforeach()
+	string(REGEX REPLACE "\\\\\\($" "" name "${path}")
+	message("${name} ${flash} ${ram} ${stack}")
+endforeach()
+
+#Whole image
+execute_process(COMMAND ${SIZE} ${ELF})
@@ -0,0 +1,335 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	CURRENT LOOP
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:		2019-11-18
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	PI regulator of the magnitude of the current of a motor, with feedforward.
+**	duty = (ref*kff + (ref-fbk)*kp + integral) >> CURRENT_LOOP_FP
+**	When the sample is not valid, the proportional term is dropped and the integral holds.
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include "global.h"
+//Class Header
+#include "current_loop.h"
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+namespace OrangeBot
+{
+
+/****************************************************************************
+**	GLOBAL VARIABILES
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	CONSTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Constructor
+//!	Current_loop | void
+/***************************************************************************/
+// @param
+//! @return no return
+//!	@details
+//! Empty constructor. Gains and limit are zero, output is always zero
+/***************************************************************************/
+
+Current_loop::Current_loop( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Loop is open until gains are set
+	this -> g_kff = (int16_t)0;
+	this -> g_kp = (int16_t)0;
+	this -> g_ki = (int16_t)0;
+	//Output stays on zero until a limit is set
+	this -> g_duty_max = (uint16_t)0;
+	//Clear integral
+	this -> g_integ = (int32_t)0;
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end constructor:
+
+/****************************************************************************
+*****************************************************************************
+**	DESTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Destructor
+//!	Current_loop | void
+/***************************************************************************/
+// @param
+//! @return no return
+//!	@details
+//! Empty destructor
+/***************************************************************************/
+
+Current_loop::~Current_loop( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end destructor:
+
+/****************************************************************************
+*****************************************************************************
+**	OPERATORS
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	SETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	set_gains | int16_t, int16_t, int16_t
+/***************************************************************************/
+//! @param kff | feedforward gain. Duty per mA. Fixed point CURRENT_LOOP_FP
+//! @param kp | proportional gain. Duty per mA. Fixed point CURRENT_LOOP_FP
+//! @param ki | integral gain. Duty per mA per sample. Fixed point CURRENT_LOOP_FP
+//! @return false: OK | true: fail
+//!	@details
+//! Integral is not changed
+/***************************************************************************/
+
+bool Current_loop::set_gains( int16_t kff, int16_t kp, int16_t ki )
+{
+	//Trace Enter
+	DENTER_ARG("kff: %d, kp: %d, ki: %d\n", kff, kp, ki);
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//if: gains are out of range
+	if ((kff < 0) || (kp < 0) || (ki < 0) || (kff > CURRENT_LOOP_MAX_GAIN) || (kp > CURRENT_LOOP_MAX_GAIN) || (ki > CURRENT_LOOP_MAX_GAIN))
+	{
+		//Trace Return
+		DRETURN_ARG("ERR: bad gains\n");
+		return true;	//fail
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	this -> g_kff = kff;
+	this -> g_kp = kp;
+	this -> g_ki = ki;
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return false;	//OK
+}	//end method: set_gains | int16_t, int16_t, int16_t
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	set_limit | uint16_t
+/***************************************************************************/
+//! @param duty_max | maximum duty the loop can output
+//! @return no return
+/***************************************************************************/
+
+void Current_loop::set_limit( uint16_t duty_max )
+{
+	this -> g_duty_max = duty_max;
+
+	return;	//OK
+}	//end method: set_limit | uint16_t
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	reset | void
+/***************************************************************************/
+//! @return no return
+//!	@details
+//! Clear the integral. Next output is the feedforward plus the proportional term
+/***************************************************************************/
+
+void Current_loop::reset( void )
+{
+	this -> g_integ = (int32_t)0;
+
+	return;	//OK
+}	//end method: reset | void
+
+/****************************************************************************
+*****************************************************************************
+**	GETTERS
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	REFERENCES
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	TESTERS
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	exe | uint16_t, uint16_t, bool
+/***************************************************************************/
+//! @param ref | current reference. mA
+//! @param fbk | measured current. mA
+//! @param f_valid | true = fbk is a measure | false = on time was too short to measure
+//! @return uint16_t | duty. From 0 to the limit
+/***************************************************************************/
+
+uint16_t Current_loop::exe( uint16_t ref, uint16_t fbk, bool f_valid )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Feedforward term. Fixed point CURRENT_LOOP_FP
+	int32_t ff;
+	//Error
+	int32_t err;
+	//Output. Fixed point CURRENT_LOOP_FP
+	int32_t out;
+	//Maximum output. Fixed point CURRENT_LOOP_FP
+	int32_t out_max;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	ff = (int32_t)ref *this -> g_kff;
+	out_max = (int32_t)this -> g_duty_max << CURRENT_LOOP_FP;
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//if: feedback is a measure
+	if (f_valid == true)
+	{
+		err = (int32_t)ref -fbk;
+		//Accumulate the error
+		this -> g_integ += err *this -> g_ki;
+		//Anti windup. Feedforward plus integral stays inside the output range
+		this -> g_integ = AT_SAT( this -> g_integ, out_max -ff, -ff );
+		//Proportional term
+		out = ff +this -> g_integ +err *this -> g_kp;
+	}
+	//if: feedback is not a measure
+	else
+	{
+		//Hold the integral
+		out = ff +this -> g_integ;
+	}
+	//Saturate the output
+	out = AT_SAT( out, out_max, 0 );
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return (uint16_t)(out >> CURRENT_LOOP_FP);
+}	//end method: exe | uint16_t, uint16_t, bool
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+} //End Namespace
@@ -0,0 +1,172 @@
+/**********************************************************************************
+**	ENVIROMENT VARIABILE
+**********************************************************************************/
+
+#ifndef CURRENT_LOOP_H_
+	#define CURRENT_LOOP_H_
+
+/**********************************************************************************
+**	GLOBAL INCLUDES
+**********************************************************************************/
+
+/**********************************************************************************
+**	DEFINES
+**********************************************************************************/
+
+//Fractional bits of the gains. Gains are duty per mA
+#define CURRENT_LOOP_FP			12
+//Maximum gain
+#define CURRENT_LOOP_MAX_GAIN	((int16_t)16383)
+
+/**********************************************************************************
+**	MACROS
+**********************************************************************************/
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+//! @namespace OrangeBot
+namespace OrangeBot
+{
+
+/**********************************************************************************
+**	TYPEDEFS
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: STRUCTURES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: GLOBAL VARIABILES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: CLASS
+**********************************************************************************/
+
+/************************************************************************************/
+//! @class 		Current_loop
+/************************************************************************************/
+//!	@author		Orso Eric
+//! @version	0.1 alpha
+//! @date		2019-11-18
+//! @brief		PI regulator of the current of one motor
+//! @details
+//!	Inner loop of a cascade. The outer loop sets the current reference, this loop sets the duty \n
+//! FEATURES:	\n
+//!		Feedforward	\n
+//! Duty starts from the reference times kff, so the loop only corrects the error.
+//! Current cannot be measured when the on time is short, there the feedforward alone drives the motor \n
+//!		Unsigned	\n
+//! Current sense only sees the magnitude. The caller handles the direction \n
+//!		Anti windup	\n
+//! Integral is saturated so the output never exceeds the duty limit \n
+//! @pre		None
+//! @bug		None
+//! @warning	ki is per sample. Retune when the sample rate changes, e.g. when a slot is added to the ADC round robin
+//! @copyright	License ?
+//! @todo		todo list
+/************************************************************************************/
+
+class Current_loop
+{
+	//Visible to all
+	public:
+		//--------------------------------------------------------------------------
+		//	CONSTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//! Default constructor
+		Current_loop( void );
+
+		//--------------------------------------------------------------------------
+		//	DESTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//!Default destructor
+		~Current_loop( void );
+
+		//--------------------------------------------------------------------------
+		//	OPERATORS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	SETTERS
+		//--------------------------------------------------------------------------
+
+		//Set feedforward, proportional and integral gains. Fixed point CURRENT_LOOP_FP. false=OK
+		bool set_gains( int16_t kff, int16_t kp, int16_t ki );
+		//Set the maximum duty
+		void set_limit( uint16_t duty_max );
+		//Clear the integral
+		void reset( void );
+
+		//--------------------------------------------------------------------------
+		//	GETTERS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	REFERENCES
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	TESTERS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC METHODS
+		//--------------------------------------------------------------------------
+
+		//Execute one sample. Return the duty
+		uint16_t exe( uint16_t ref, uint16_t fbk, bool f_valid );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC STATIC METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC VARS
+		//--------------------------------------------------------------------------
+
+	//Visible to derived classes
+	protected:
+		//--------------------------------------------------------------------------
+		//	PROTECTED METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PROTECTED VARS
+		//--------------------------------------------------------------------------
+
+	//Visible only inside the class
+	private:
+		//--------------------------------------------------------------------------
+		//	PRIVATE METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PRIVATE VARS
+		//--------------------------------------------------------------------------
+
+		//Gains. Fixed point CURRENT_LOOP_FP
+		int16_t g_kff;
+		int16_t g_kp;
+		int16_t g_ki;
+		//Maximum duty
+		uint16_t g_duty_max;
+		//Integral. Fixed point CURRENT_LOOP_FP
+		int32_t g_integ;
+
+};	//End Class: Current_loop
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
+
+#else
+    #warning "Multiple inclusion of hader file"
+#endif
@@ -0,0 +1,526 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	DATA LOGGER
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:		2019-11-19
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Triggered capture in a RAM ring, like the one of an oscilloscope
+**	The buffer is split in records of rec_len values. With N = DATA_LOGGER_SIZE / rec_len:
+**		ARMED		records are written in the ring, the oldest are overwritten
+**		TRIGGERED	the trigger record is kept with up to pre records before it.
+**					Recording goes on until the ring holds N records
+**		DONE		nothing is written. Records are read in time order
+**	The link can't carry the signals of each control step. The capture costs
+**	nothing on the link while recording, and is read as slowly as the link allows.
+**	add(), is_due() and trigger() are called by the control step.
+**	The caller has to protect the other methods from the control step.
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include "global.h"
+//Class Header
+#include "data_logger.h"
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+namespace OrangeBot
+{
+
+/****************************************************************************
+**	GLOBAL VARIABILES
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	CONSTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Constructor
+//!	Data_logger | void
+/***************************************************************************/
+// @param
+//! @return no return
+//!	@details
+//! Empty constructor. Logger is not set up and can't be armed
+/***************************************************************************/
+
+Data_logger::Data_logger( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//No records
+	this -> g_rec_len	= (uint8_t)0;
+	this -> g_size		= (uint16_t)0;
+	this -> g_pre		= (uint16_t)0;
+	this -> g_decim		= (uint16_t)1;
+	this -> g_pre_num	= (uint16_t)0;
+	this -> g_post_cnt	= (uint16_t)0;
+	this -> g_decim_cnt	= (uint16_t)0;
+	//Not recording
+	this -> stop();
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end constructor:
+
+/****************************************************************************
+*****************************************************************************
+**	DESTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Destructor
+//!	Data_logger | void
+/***************************************************************************/
+// @param
+//! @return no return
+//!	@details
+//! Empty destructor
+/***************************************************************************/
+
+Data_logger::~Data_logger( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end destructor:
+
+/****************************************************************************
+*****************************************************************************
+**	OPERATORS
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	SETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	setup | uint8_t, uint16_t, uint16_t
+/***************************************************************************/
+//! @param rec_len | values of a record
+//! @param pre | records kept before the trigger. Less than the records the buffer holds
+//! @param decim | steps between two records
+//! @return false: OK | true: fail
+//!	@details
+//! Configure the capture. The logger stops and the records are dropped
+/***************************************************************************/
+
+bool Data_logger::setup( uint8_t rec_len, uint16_t pre, uint16_t decim )
+{
+	//Trace Enter
+	DENTER_ARG("rec_len: %d, pre: %d, decim: %d\n", rec_len, pre, decim);
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//if: no values, the history and the trigger record don't fit the buffer, or no decimation
+	if ((rec_len == 0) || ((uint32_t)rec_len *((uint32_t)pre +1) > (uint32_t)DATA_LOGGER_SIZE) || (decim == 0))
+	{
+		//Trace Return
+		DRETURN_ARG("ERR: bad configuration\n");
+		return true;	//fail
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	this -> stop();
+	this -> g_rec_len	= rec_len;
+	this -> g_size		= (uint16_t)(DATA_LOGGER_SIZE /rec_len);
+	this -> g_pre		= pre;
+	this -> g_decim		= decim;
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return false;	//OK
+}	//end method: setup | uint8_t, uint16_t, uint16_t
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	arm | void
+/***************************************************************************/
+//! @return false: OK | true: not set up
+//!	@details
+//! Drop the records and start recording the history before the trigger.
+//!	The first record is saved at the next step
+/***************************************************************************/
+
+bool Data_logger::arm( void )
+{
+	//if: not set up
+	if (this -> g_rec_len == 0)
+	{
+		return true;	//fail
+	}
+	this -> g_head		= (uint16_t)0;
+	this -> g_num		= (uint16_t)0;
+	this -> g_pre_num	= (uint16_t)0;
+	this -> g_decim_cnt	= (uint16_t)(this -> g_decim -1);
+	this -> g_f_trigger	= false;
+	//Recording starts when the logger is ready
+	this -> g_state		= DATA_LOGGER_ARMED;
+
+	return false;	//OK
+}	//end method: arm | void
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	trigger | void
+/***************************************************************************/
+//! @return no return
+//!	@details
+//! The next record is the trigger record. Ignored unless armed
+/***************************************************************************/
+
+void Data_logger::trigger( void )
+{
+	//if: waiting for the trigger
+	if (this -> g_state == DATA_LOGGER_ARMED)
+	{
+		this -> g_f_trigger = true;
+	}
+
+	return;	//OK
+}	//end method: trigger | void
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	stop | void
+/***************************************************************************/
+//! @return no return
+//!	@details
+//! Stop recording and drop the records. Configuration is kept
+/***************************************************************************/
+
+void Data_logger::stop( void )
+{
+	this -> g_state		= DATA_LOGGER_IDLE;
+	this -> g_f_trigger	= false;
+	this -> g_head		= (uint16_t)0;
+	this -> g_num		= (uint16_t)0;
+
+	return;	//OK
+}	//end method: stop | void
+
+/****************************************************************************
+*****************************************************************************
+**	GETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_state | void
+/***************************************************************************/
+//! @return uint8_t | Data_logger_state
+/***************************************************************************/
+
+uint8_t Data_logger::get_state( void )
+{
+	return this -> g_state;
+}	//end getter: get_state | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_rec_len | void
+/***************************************************************************/
+//! @return uint8_t | values of a record. 0 = not set up
+/***************************************************************************/
+
+uint8_t Data_logger::get_rec_len( void )
+{
+	return this -> g_rec_len;
+}	//end getter: get_rec_len | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_num | void
+/***************************************************************************/
+//! @return uint16_t | records in the buffer
+/***************************************************************************/
+
+uint16_t Data_logger::get_num( void )
+{
+	return this -> g_num;
+}	//end getter: get_num | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_pre | void
+/***************************************************************************/
+//! @return uint16_t | records before the trigger record. Valid once triggered
+/***************************************************************************/
+
+uint16_t Data_logger::get_pre( void )
+{
+	return this -> g_pre_num;
+}	//end getter: get_pre | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_size | void
+/***************************************************************************/
+//! @return uint16_t | records the buffer holds
+/***************************************************************************/
+
+uint16_t Data_logger::get_size( void )
+{
+	return this -> g_size;
+}	//end getter: get_size | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	read | uint16_t, int16_t *
+/***************************************************************************/
+//! @param index | record. 0 is the oldest
+//! @param rec | (int16_t *) writeback vector of rec_len values
+//! @return false: OK | true: capture not done or no such record
+/***************************************************************************/
+
+bool Data_logger::read( uint16_t index, int16_t *rec )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//First value of the record
+	uint16_t base;
+	//counter
+	uint8_t t;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//if: still recording, or no such record
+	if ((this -> g_state != DATA_LOGGER_DONE) || (index >= this -> g_num))
+	{
+		return true;	//fail
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Oldest record is the one after the last written when the ring is full
+	base = (uint16_t)(((uint32_t)this -> g_head +this -> g_size -this -> g_num +index) % this -> g_size);
+	base = (uint16_t)(base *this -> g_rec_len);
+	for (t = 0;t < this -> g_rec_len;t++)
+	{
+		rec[t] = this -> g_buf[ base +t ];
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return false;	//OK
+}	//end getter: read | uint16_t, int16_t *
+
+/****************************************************************************
+*****************************************************************************
+**	REFERENCES
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	TESTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Tester
+//!	is_due | void
+/***************************************************************************/
+//! @return bool | true = recording and a record is due this step
+//!	@details
+//! Called once per step. The caller builds and adds the record only when due
+/***************************************************************************/
+
+bool Data_logger::is_due( void )
+{
+	//if: not recording
+	if ((this -> g_state != DATA_LOGGER_ARMED) && (this -> g_state != DATA_LOGGER_TRIGGERED))
+	{
+		return false;
+	}
+	this -> g_decim_cnt++;
+	//if: not yet time for a record
+	if (this -> g_decim_cnt < this -> g_decim)
+	{
+		return false;
+	}
+	this -> g_decim_cnt = 0;
+
+	return true;
+}	//end tester: is_due | void
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	add | const int16_t *
+/***************************************************************************/
+//! @param rec | (const int16_t *) vector of rec_len values
+//! @return no return
+//!	@details
+//! Write the record over the oldest one. A pending trigger makes it the trigger record.
+//!	The capture is done when the records after the trigger fill the ring
+/***************************************************************************/
+
+void Data_logger::add( const int16_t *rec )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//First value of the record
+	uint16_t base;
+	//counter
+	uint8_t t;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//if: not recording
+	if ((this -> g_state != DATA_LOGGER_ARMED) && (this -> g_state != DATA_LOGGER_TRIGGERED))
+	{
+		return;
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Save the record
+	base = (uint16_t)(this -> g_head *this -> g_rec_len);
+	for (t = 0;t < this -> g_rec_len;t++)
+	{
+		this -> g_buf[ base +t ] = rec[t];
+	}
+	this -> g_head = (this -> g_head +1 >= this -> g_size)?(0):(this -> g_head +1);
+	this -> g_num += (this -> g_num < this -> g_size)?(1):(0);
+	//if: this is the trigger record
+	if ((this -> g_state == DATA_LOGGER_ARMED) && (this -> g_f_trigger == true))
+	{
+		this -> g_f_trigger = false;
+		//History is what has been recorded, up to pre records
+		this -> g_pre_num = ((uint16_t)(this -> g_num -1) < this -> g_pre)?((uint16_t)(this -> g_num -1)):(this -> g_pre);
+		this -> g_post_cnt = (uint16_t)(this -> g_size -1 -this -> g_pre_num);
+		this -> g_state = DATA_LOGGER_TRIGGERED;
+	}
+	//if: record after the trigger
+	else if (this -> g_state == DATA_LOGGER_TRIGGERED)
+	{
+		this -> g_post_cnt--;
+	}
+	//if: ring filled after the trigger
+	if ((this -> g_state == DATA_LOGGER_TRIGGERED) && (this -> g_post_cnt == 0))
+	{
+		this -> g_state = DATA_LOGGER_DONE;
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return;	//OK
+}	//end method: add | const int16_t *
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+} //End Namespace
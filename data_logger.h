@@ -0,0 +1,220 @@
+/**********************************************************************************
+**	ENVIROMENT VARIABILE
+**********************************************************************************/
+
+#ifndef DATA_LOGGER_H_
+	#define DATA_LOGGER_H_
+
+/**********************************************************************************
+**	GLOBAL INCLUDES
+**********************************************************************************/
+
+/**********************************************************************************
+**	DEFINES
+**********************************************************************************/
+
+//global.h must be included before this header
+
+//16b values the RAM buffer can hold. Sized by global.h
+#define DATA_LOGGER_SIZE	LOG_BUF_SIZE
+
+/**********************************************************************************
+**	MACROS
+**********************************************************************************/
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+//! @namespace OrangeBot
+namespace OrangeBot
+{
+
+/**********************************************************************************
+**	TYPEDEFS
+**********************************************************************************/
+
+//State of the capture
+typedef enum _Data_logger_state
+{
+	DATA_LOGGER_IDLE		= 0,	//Not recording. Records of an older capture are gone
+	DATA_LOGGER_ARMED		= 1,	//Recording the history before the trigger
+	DATA_LOGGER_TRIGGERED	= 2,	//Recording the records after the trigger
+	DATA_LOGGER_DONE		= 3		//Buffer is full and can be read
+} Data_logger_state;
+
+/**********************************************************************************
+**	PROTOTYPE: STRUCTURES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: GLOBAL VARIABILES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: CLASS
+**********************************************************************************/
+
+/************************************************************************************/
+//! @class 		Data_logger
+/************************************************************************************/
+//!	@author		Orso Eric
+//! @version	0.1 alpha
+//! @date		2019-11-19
+//! @brief		Triggered capture of records of 16b values in a RAM ring
+//! @details
+//!	Record the signals of the control step at full rate, read them later at the pace of the link \n
+//! FEATURES:	\n
+//!		Records	\n
+//! A record is a fixed number of 16b values, one per signal. The buffer holds DATA_LOGGER_SIZE values \n
+//! A record is saved every decimation steps \n
+//!		Trigger	\n
+//! Once armed the logger records continuously, overwriting the oldest records \n
+//! At the trigger it keeps the pre-trigger records before it and fills the rest of the buffer \n
+//! If the trigger comes early, fewer records precede it \n
+//!		Read	\n
+//! When the buffer is full the records can be read in time order, as slowly as needed \n
+//! @pre		global.h included before this header. setup then arm
+//! @bug		None
+//! @warning	add() and trigger() run in the control step. The caller protects the other methods from it
+//! @copyright	License ?
+//! @todo		todo list
+/************************************************************************************/
+
+class Data_logger
+{
+	//Visible to all
+	public:
+		//--------------------------------------------------------------------------
+		//	CONSTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//! Default constructor
+		Data_logger( void );
+
+		//--------------------------------------------------------------------------
+		//	DESTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//!Default destructor
+		~Data_logger( void );
+
+		//--------------------------------------------------------------------------
+		//	OPERATORS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	SETTERS
+		//--------------------------------------------------------------------------
+
+		//Values of a record, records kept before the trigger, steps between records. Stop the logger. false=OK
+		bool setup( uint8_t rec_len, uint16_t pre, uint16_t decim );
+		//Start recording the history before the trigger. false=OK
+		bool arm( void );
+		//Trigger at the next record. Ignored unless armed
+		void trigger( void );
+		//Stop recording and drop the records
+		void stop( void );
+
+		//--------------------------------------------------------------------------
+		//	GETTERS
+		//--------------------------------------------------------------------------
+
+		//State of the capture. Data_logger_state
+		uint8_t get_state( void );
+		//Values of a record
+		uint8_t get_rec_len( void );
+		//Records in the buffer
+		uint16_t get_num( void );
+		//Records before the trigger
+		uint16_t get_pre( void );
+		//Records the buffer holds
+		uint16_t get_size( void );
+		//Copy a record. 0 is the oldest. Only when done. false=OK
+		bool read( uint16_t index, int16_t *rec );
+
+		//--------------------------------------------------------------------------
+		//	REFERENCES
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	TESTERS
+		//--------------------------------------------------------------------------
+
+		//true = a record is due this step. Advance the decimation
+		bool is_due( void );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC METHODS
+		//--------------------------------------------------------------------------
+
+		//Save a record of rec_len values
+		void add( const int16_t *rec );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC STATIC METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC VARS
+		//--------------------------------------------------------------------------
+
+	//Visible to derived classes
+	protected:
+		//--------------------------------------------------------------------------
+		//	PROTECTED METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PROTECTED VARS
+		//--------------------------------------------------------------------------
+
+	//Visible only inside the class
+	private:
+		//--------------------------------------------------------------------------
+		//	PRIVATE METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PRIVATE VARS
+		//--------------------------------------------------------------------------
+
+			///Buffer
+		//Ring of records
+		int16_t g_buf[ DATA_LOGGER_SIZE ];
+		//Next record to write
+		uint16_t g_head;
+		//Records in the ring
+		uint16_t g_num;
+
+			///Configuration
+		uint8_t g_rec_len;
+		//Records the ring holds
+		uint16_t g_size;
+		//Records kept before the trigger
+		uint16_t g_pre;
+		uint16_t g_decim;
+
+			///Capture
+		//Data_logger_state
+		uint8_t g_state;
+		//true = trigger at the next record. Written by the trigger sources
+		volatile bool g_f_trigger;
+		//Steps since the last record
+		uint16_t g_decim_cnt;
+		//Records before the trigger
+		uint16_t g_pre_num;
+		//Records left after the trigger
+		uint16_t g_post_cnt;
+
+};	//End Class: Data_logger
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
+
+#else
+    #warning "Multiple inclusion of hader file"
+#endif
@@ -17,12 +17,8 @@
 
 	//type definition using the bit width and signedness
 	#include <stdint.h>
-	//define the ISR routune, ISR vector, and the sei() cli() function
-	#include <avr/interrupt.h>
-	//name all the register and bit
-	#include <avr/io.h>
-	//hard delay
-	#include <util/delay.h>
+	//Hardware abstraction layer. avr-libc on the target, emulated peripherals on the host
+	#include "hal.h"
 	//General purpose macros
 	#include "at_utils.h"
 	//AT4809 PORT macros definitions
@@ -32,12 +28,23 @@
 	**	DEFINE
 	****************************************************************************/
 
+		///----------------------------------------------------------------------
+		///	SYSTEM TICK
+		///----------------------------------------------------------------------
+		//	The system tick is the overflow of TCA0 and can be changed at runtime
+		//	Speeds and task periods are expressed in base ticks so that they don't depend on the tick rate
+	
+	//Base rate of the system tick [Hz]
+	#define SYS_TICK_BASE_HZ	500
+	//Clock of TCA0 [Hz]. CLK_PER/4
+	#define SYS_TICK_TCA_HZ		(F_CPU /4)
+
 		///----------------------------------------------------------------------
 		///	BUFFERS
 		///----------------------------------------------------------------------
 
 	#define RPI_RX_BUF_SIZE		16
-	#define RPI_TX_BUF_SIZE		64
+	#define RPI_TX_BUF_SIZE		128
 	
 		///----------------------------------------------------------------------
 		///	PARSER
@@ -49,12 +56,122 @@
 		///	MOTORS
 		///----------------------------------------------------------------------
 	
+	//Optional PWM backend. Uncomment for 20KHz PWM with about 10 bit of resolution
+	//TCB count CLK_PER in single shot mode and are triggered by the overflow of TCA0 through the event system
+	//TCA0 overflows at the PWM rate. The system tick is one overflow every SYS_TICK_DIV and the control step can't run in the ISR
+	//#define VNH7040_PWM_HIRES
+
 	//Number of DC motors mounted on the platform
 	#define DC_MOTOR_NUM		4
-	//Maximum slew rate. PWM increment per tick
-	#define DC_MOTOR_SLEW_RATE	1
-	//Maximum PWM setting
-	#define DC_MOTOR_MAX_PWM	255
+	
+	//if: 20KHz single shot PWM backend
+	#ifdef VNH7040_PWM_HIRES
+		//Frequency of the PWM [Hz]
+		#define VNH7040_PWM_HZ		20000
+		//TCB counts in one PWM period -1. TCB are clocked by CLK_PER
+		#define VNH7040_PWM_TOP		((F_CPU /VNH7040_PWM_HZ) -1)
+		//TOP of TCA0. One overflow each PWM period
+		#define VNH7040_PWM_TCA_TOP	((SYS_TICK_TCA_HZ /VNH7040_PWM_HZ) -1)
+		//PWM steps are about 2^SHIFT finer than the 8 bit backend. Host PWM and PID gains are scaled by it
+		#define DC_MOTOR_PWM_SHIFT	2
+		//Maximum PWM setting. Pulse ends before the next trigger
+		#define DC_MOTOR_MAX_PWM	(VNH7040_PWM_TOP -3)
+	//if: 8 bit PWM backend
+	#else
+		//TOP of the TCB in 8 bit PWM mode
+		#define VNH7040_PWM_TOP		255
+		//PWM steps are the same as the host PWM
+		#define DC_MOTOR_PWM_SHIFT	0
+		//Maximum PWM setting
+		#define DC_MOTOR_MAX_PWM	255
+	#endif
+	
+	//Maximum PWM setting of the host commands
+	#define DC_MOTOR_MAX_HOST_PWM	255
+	//Maximum slew rate of the open loop modes. PWM increment per base tick
+	#define DC_MOTOR_SLEW_RATE	(1 << DC_MOTOR_PWM_SHIFT)
+	//A reversal brakes for PWM >> SHIFT base ticks. Below 2^SHIFT the direction flips immediately
+	#define DC_MOTOR_BRAKE_SHIFT	(5 +DC_MOTOR_PWM_SHIFT)
+	//Single shot backend. A pulse shorter than the count of its TCB plus this margin is changed on the next period
+	#define VNH7040_PWM_MARGIN	16
+	
+		///----------------------------------------------------------------------
+		///	CURRENT SENSE
+		///----------------------------------------------------------------------
+		//	ADC converts one MultiSense output at the start of each PWM period, round robin
+		//	Current ratio and sense resistor have to match the board
+	
+	//Valid samples averaged into one current value. 2^SHIFT
+	#define CURRENT_SENSE_DEC_SHIFT	3
+	//Delay from the start of the PWM period to the sample. ADC clocks, 800ns each
+	#define CURRENT_SENSE_SAMPDLY	8
+	//A shorter on time ends before the sample is taken. Sample is skipped
+	#define CURRENT_SENSE_MIN_PWM	(DC_MOTOR_MAX_PWM >> 2)
+	//Skipped samples in a row after which the current of a motor is unknown and reads 0. About 8ms
+	#define CURRENT_SENSE_STALE_NUM	(4 << CURRENT_SENSE_DEC_SHIFT)
+	//ADC reference [mV]
+	#define CURRENT_SENSE_VREF_MV	4340
+	//Ratio between output current and MultiSense current of the VNH7040
+	#define CURRENT_SENSE_K			2870
+	//MultiSense resistor [Ohm]
+	#define CURRENT_SENSE_RES		1000
+	//From ADC counts to mA. Fixed point 8
+	#define CURRENT_SENSE_GAIN		\
+		( ((uint32_t)CURRENT_SENSE_VREF_MV *CURRENT_SENSE_K *256) /((uint32_t)CURRENT_SENSE_RES *1024) )
+	//Speed reference can't move away from zero while the current of the wheel is above this limit [mA]
+	#define CURRENT_LIMIT_MA		3000
+	//A wheel that doesn't turn with a current above this is stalled [mA]
+	#define CURRENT_STALL_MA		4000
+	//Wheel is not turning at or below this speed. Counts per base tick, one encoder edge
+	#define CURRENT_STALL_SPD		(1 << ENC_GAIN)
+	//Stall error after this many base ticks
+	#define CURRENT_STALL_TIME		50
+	
+		///----------------------------------------------------------------------
+		///	CURRENT LOOP
+		///----------------------------------------------------------------------
+		//	Optional inner loop. PIDs output a current reference, the ADC ISR regulates the duty for each sample
+		//	Each wheel is sampled once every VBAT_SENSE_CH +1 PWM periods of the round robin.
+		//	About 3.9KHz with the 8 bit backend, 4KHz with the 20KHz one
+		//	Gains are 8 bit PWM per mA, fixed point CURRENT_LOOP_FP
+	
+	//Feedforward. About 8A of stall current at full PWM
+	#define CURRENT_LOOP_KFF		128
+	//Proportional gain
+	#define CURRENT_LOOP_KP			64
+	//Integral gain. Per sample
+	#define CURRENT_LOOP_KI			4
+	//Maximum current reference of the PIDs [mA]
+	#define CURRENT_LOOP_MAX_MA		8000
+	//PID gains are scaled by 2^SHIFT. About 2^SHIFT mA for each step of 8 bit PWM
+	#define CURRENT_LOOP_PID_SHIFT	5
+	
+		///----------------------------------------------------------------------
+		///	SUPPLY VOLTAGE
+		///----------------------------------------------------------------------
+		//	ADC converts the battery divider after the four MultiSense outputs
+		//	Commands are voltages. DC_MOTOR_MAX_PWM is VBAT_NOMINAL_MV whatever the charge of the battery
+	
+	//Round robin slot of the ADC. AIN4 is PD4
+	#define VBAT_SENSE_CH			DC_MOTOR_NUM
+	//Divider from the battery to the ADC input [Ohm]
+	#define VBAT_SENSE_R_HI			33000
+	#define VBAT_SENSE_R_LO			10000
+	//From ADC counts to mV. Fixed point 8
+	#define VBAT_SENSE_GAIN			\
+		( ((uint32_t)CURRENT_SENSE_VREF_MV *(VBAT_SENSE_R_HI +VBAT_SENSE_R_LO) /VBAT_SENSE_R_LO) *256 /1024 )
+	//Fractional bits of the filtered ADC reading
+	#define VBAT_FILTER_FP			5
+	//Time constant of the low pass filter. 2^SHIFT samples of the battery
+	#define VBAT_FILTER_SHIFT		6
+	//Voltage of a full scale command [mV]
+	#define VBAT_NOMINAL_MV			12000
+	//Below this the supply is not the battery. No compensation [mV]
+	#define VBAT_MIN_MV				6000
+	//Fractional bits of the compensation gain
+	#define VBAT_SCALE_FP			8
+	//Maximum compensation gain. VBAT_NOMINAL_MV /VBAT_MIN_MV
+	#define VBAT_SCALE_MAX			((uint16_t)2 << VBAT_SCALE_FP)
 	
 		///----------------------------------------------------------------------
 		///	ENCODERS
@@ -80,10 +197,201 @@
 	//The PID is allowed this many tick with command saturated before going into emergency
 	#define POS_PID_SAT_TH		200
 	
+		///----------------------------------------------------------------------
+		///	POSITION PROFILE
+		///----------------------------------------------------------------------
+		//	Limits of the trapezoidal profile generated by the CONTROL_POS mode
+		//	Speed is in counts per base tick. Acceleration is in counts per base tick squared
+	
+	//Fractional bits of the acceleration. 256=1.000
+	#define POS_PROFILE_AMAX_FRAC	8
+	//Default maximum speed
+	#define POS_PROFILE_VMAX		64
+	//Default acceleration. 0.5 counts per base tick squared
+	#define POS_PROFILE_AMAX		128
+	
+		///----------------------------------------------------------------------
+		///	MOTION QUEUE
+		///----------------------------------------------------------------------
+		//	Default limits of the segments of the CONTROL_QUEUE mode. Same units as the position profile
+		//	Jerk is in counts per base tick cubed, fixed point POS_PROFILE_AMAX_FRAC. 0 = no jerk limit
+	
+	#define MOTION_QUEUE_VMAX		64
+	#define MOTION_QUEUE_AMAX		128
+	//Acceleration ramps in 16 base ticks
+	#define MOTION_QUEUE_JERK		8
+	
+		///----------------------------------------------------------------------
+		///	SPEED LIMITS
+		///----------------------------------------------------------------------
+		//	Default limits of the speed reference of CONTROL_SPD and CONTROL_SPD_POS. Same units as the position profile
+		//	Acceleration moves the speed away from zero, deceleration toward zero. 0 = no limit
+	
+	//1 count per base tick squared
+	#define SPD_LIMIT_ACC			256
+	//2 counts per base tick squared
+	#define SPD_LIMIT_DEC			512
+	
+		///----------------------------------------------------------------------
+		///	ODOMETRY
+		///----------------------------------------------------------------------
+		//	Geometry of the platform. Distance between the right and left wheels in encoder counts
+		//	Calibrate by spinning the platform in place: track = (right counts + left counts) / (pi * turns)
+	
+	#define ODOM_TRACK_COUNTS		20000
+	
+		///----------------------------------------------------------------------
+		///	SCHEDULER
+		///----------------------------------------------------------------------
+		//	Period and phase of the periodic tasks in base ticks
+		//	Control task runs every system tick whatever the tick rate
+	
+	//Motor control system
+	#define SCHED_CTRL_PERIOD		1
+	#define SCHED_CTRL_PHASE		0
+	//Communication timeout. RPI_COM_TIMEOUT is counted in units of this period
+	#define SCHED_TIMEOUT_PERIOD	5
+	#define SCHED_TIMEOUT_PHASE		1
+	//Activity LED. Blink speed is counted in units of this period
+	#define SCHED_LED_PERIOD		5
+	#define SCHED_LED_PHASE			2
+	//Unsolicited telemetry
+	#define SCHED_TELEMETRY_PERIOD	500
+	#define SCHED_TELEMETRY_PHASE	3
+	//Battery voltage compensation
+	#define SCHED_VBAT_PERIOD		50
+	#define SCHED_VBAT_PHASE		4
+	//Telemetry stream. The decimation is counted in units of this period
+	#define SCHED_STREAM_PERIOD		1
+	#define SCHED_STREAM_PHASE		0
+	
+		///----------------------------------------------------------------------
+		///	TELEMETRY STREAM
+		///----------------------------------------------------------------------
+		//	Signals the host subscribes to with SUB<mask>D<decimation>. Frames are T<mask> followed
+		//	by the values, each starting with its sign, in the order of the bits, one per channel
+		//	With STREAM_DELTA the frames are Z<header>, the mask in keyframes, then one varint for each
+		//	value in the same order. Header is 0x40 | sequence number modulo STREAM_SEQ_NUM, bit 7 set on keyframes
+		//	Varints hold the value in keyframes, the change from the previous frame otherwise. Zig-zag plus one,
+		//	seven bits per byte, least significant first, bit 7 set on all but the last byte. No byte is zero
+	
+	//32b encoder counts
+	#define STREAM_CNT			0x01
+	//Encoder speeds. Counts per base tick
+	#define STREAM_SPD			0x02
+	//Errors of the PIDs
+	#define STREAM_ERR			0x04
+	//Proportional, integral and derivative contributions of the PIDs. Four P, then four I, then four D
+	#define STREAM_PID			0x08
+	//PWM of the motors. Negative is counterclockwise
+	#define STREAM_PWM			0x10
+	//Current of the motors. mA
+	#define STREAM_CUR			0x20
+	//Battery voltage. mV
+	#define STREAM_VBAT			0x40
+	//All the signals
+	#define STREAM_ALL			0x7F
+	//Flag. Compressed frames: changes from the previous frame as varints
+	#define STREAM_DELTA		0x80
+	//Compressed frames from a keyframe to the next. The host that lost a frame waits for a keyframe
+	#define STREAM_KEY_PERIOD	16
+	//Sequence numbers of the compressed frames. A run of this many lost frames goes unnoticed
+	#define STREAM_SEQ_NUM		64
+	//Room of the TX buffer left to the replies. A frame that would take it is skipped
+	#define STREAM_TX_RESERVE	24
+	
+		///----------------------------------------------------------------------
+		///	DATA LOGGER
+		///----------------------------------------------------------------------
+		//	RAM capture of the control step. LOGS<signals>W<wheels>P<pre>D<decimation> sets up the records,
+		//	LOGA<triggers>H<threshold> arms, LOGT triggers, LOGR<index> reads a record once done.
+		//	A record holds the signals of the first wheel in the order of the bits, then those of the next wheel
+	
+	//Reference of the PID. Speed in SPD mode, low 16b of the position target in the position modes
+	#define LOG_SIG_REF			0x0001
+	//Feedback of the PID. Speed in SPD mode, low 16b of the encoder count in the position modes
+	#define LOG_SIG_FB			0x0002
+	//Error of the PID
+	#define LOG_SIG_ERR			0x0004
+	//Proportional, integral and derivative contributions of the PID
+	#define LOG_SIG_P			0x0008
+	#define LOG_SIG_I			0x0010
+	#define LOG_SIG_D			0x0020
+	//Output of the PID. PWM, or current reference of the inner loop
+	#define LOG_SIG_CMD			0x0040
+	//PWM of the motor after the slew rate limiter. Negative is counterclockwise
+	#define LOG_SIG_PWM			0x0080
+	//Current of the motor. mA
+	#define LOG_SIG_CUR			0x0100
+	//All the signals
+	#define LOG_SIG_ALL			0x01FF
+	//Reference of a logged wheel jumps by more than the threshold in one control step
+	#define LOG_TRIG_STEP		0x01
+	//Output of the PID of a logged wheel is at its limit
+	#define LOG_TRIG_SAT		0x02
+	//All the trigger sources. LOGT always triggers
+	#define LOG_TRIG_ALL		0x03
+	//Most values in a record. The reply of LOGR must fit the TX buffer
+	#define LOG_REC_MAX			16
+	//16b values of the RAM capture. 2KB of the 6KB of SRAM.
+	//	Statics of the firmware are about 5.2KB in the host build, which has wider pointers and padding than the AVR.
+	//	What is left is the stack: check the headroom with avr-size on the AVR build before growing this buffer
+	#define LOG_BUF_SIZE		1024
+	
+		///----------------------------------------------------------------------
+		///	PROFILER
+		///----------------------------------------------------------------------
+		//	Width of the first bin of the execution time histograms is 1<<shift timestamp units
+	
+	//Number of profiling channels
+	#define PROF_NUM			6
+	//Main loop iteration. 3.2us
+	#define PROF_LOOP_SHIFT		4
+	//Idle main loop iteration. 3.2us
+	#define PROF_IDLE_SHIFT		4
+	//Control step. 12.8us
+	#define PROF_CTRL_SHIFT		6
+	//Interrupt service routines. 0.8us
+	#define PROF_ISR_SHIFT		2
+	//Latency from system tick to control step. 1.6us
+	#define PROF_CTRL_LAT_SHIFT	3
+	//TCA0 overflow ISR of a system tick. 1.6us
+	#define PROF_TICK_SHIFT		3
+	
 	/****************************************************************************
 	**	ENUM
 	****************************************************************************/
 		
+	//Rate of the system tick. Value is log2 of the number of system ticks in a base tick
+	typedef enum _Tick_rate
+	{
+		TICK_RATE_500HZ	= 0,	//Base rate. 2ms
+		TICK_RATE_1KHZ	= 1,	//1ms
+		TICK_RATE_2KHZ	= 2		//500us
+	} Tick_rate;
+	
+	//Profiling channels
+	typedef enum _Prof_channel
+	{
+		PROF_LOOP	= 0,	//Execution time of each main loop iteration
+		PROF_IDLE	= 1,	//Execution time of the main loop iterations that did nothing
+		PROF_CTRL	= 2,	//Execution time of the control step
+		PROF_ISR	= 3,	//Execution time of the instrumented ISRs, but the one of the system tick
+		PROF_CTRL_LAT	= 4,	//Latency from the system tick to the start of the control step. Its spread is the sampling jitter
+		PROF_TICK	= 5		//Execution time of the TCA0 overflow ISR of a system tick. Control step excluded
+	} Prof_channel;
+	
+	//Index of the periodic tasks inside the scheduler. Tasks must be registered in this order
+	typedef enum _Sched_task
+	{
+		SCHED_TASK_CTRL			= 0,	//Motor control system
+		SCHED_TASK_TIMEOUT		= 1,	//Communication timeout
+		SCHED_TASK_TELEMETRY	= 2,	//Unsolicited telemetry
+		SCHED_TASK_LED			= 3,	//Activity LED
+		SCHED_TASK_VBAT			= 4,	//Battery voltage compensation
+		SCHED_TASK_STREAM		= 5		//Telemetry stream
+	} Sched_task;
+
 	//Control modes
 	typedef enum _Control_mode
 	{
@@ -91,7 +399,8 @@
 		CONTROL_PWM		= 1,	//PWM mode. Feed open loop PWM signals directly
 		CONTROL_POS		= 2,	//POS mode. Feed wheel positions directly
 		CONTROL_SPD		= 3,	//SPD mode. Feed wheel speed directly
-		CONTROL_SPD_POS	= 4		//Hybrid Speed mode. User feed speed reference but PID is closed in position
+		CONTROL_SPD_POS	= 4,	//Hybrid Speed mode. User feed speed reference but PID is closed in position
+		CONTROL_QUEUE	= 5		//QUEUE mode. Platform follows the segments streamed in the motion queue
 		
 	} Control_mode;
 
@@ -101,7 +410,9 @@
 		ERR_CODE_UNDEFINED_CONTROL_SYSTEM,
 		ERR_CODE_BAD_ENCODER_COUNTERS,
 		ERR_CODE_COMMUNICATION_TIMEOUT,
-		ERR_CODE_PID_UNLOCKED				//A PID has been unable to get a lock within the given number of ticks
+		ERR_CODE_PID_UNLOCKED,				//A PID has been unable to get a lock within the given number of ticks
+		ERR_CODE_MOTOR_STALL,				//A wheel has been stalled for CURRENT_STALL_TIME
+		ERR_CODE_CONTROL_OVERRUN			//Control step inside the TCA0 ISR took longer than CTRL_ISR_MAX_TIME
 	} Error_code;
 
 	/****************************************************************************
@@ -114,6 +425,39 @@
 
 	#define LED0_TOGGLE()	\
 		TOGGLE_BIT( PORTB, PB6 )
+	
+		///----------------------------------------------------------------------
+		///	MOTORS
+		///----------------------------------------------------------------------
+	
+	//PWM setting of the backend from the magnitude of a host PWM. Host PWM is 8 bit with both backends
+	#define DC_MOTOR_HOST_PWM( pwm )	\
+		AT_SAT( ((uint16_t)AT_SAT( (pwm), DC_MOTOR_MAX_HOST_PWM, 0 )) << DC_MOTOR_PWM_SHIFT, DC_MOTOR_MAX_PWM, 0 )
+	
+		///----------------------------------------------------------------------
+		///	TIMESTAMP
+		///----------------------------------------------------------------------
+	
+	//Free running 16b timestamp used for profiling. 5MHz, 200ns. Wraps around every 13.1ms
+	#define GET_TIMESTAMP()	\
+		get_timestamp()
+	
+		///----------------------------------------------------------------------
+		///	SYSTEM TICK
+		///----------------------------------------------------------------------
+	
+	//TOP of TCA0 that generates the system tick at a given Tick_rate
+	#define SYS_TICK_TCA_TOP( tick_rate )	\
+		( (SYS_TICK_TCA_HZ /((uint32_t)SYS_TICK_BASE_HZ << (tick_rate))) -1 )
+	
+	//Overflows of TCA0 in one system tick when TCA0 runs at the PWM rate
+	#define SYS_TICK_DIV( tick_rate )	\
+		( (SYS_TICK_TCA_TOP( tick_rate ) +1) /(VNH7040_PWM_TCA_TOP +1) )
+	
+	//Longest control step inside the TCA0 overflow ISR. Timestamp units. 78us
+	//	The step holds the UART RX and encoder ISRs. The RX hardware buffer holds two bytes, 78us at 256Kbaud,
+	//	the encoder LUT recovers a single double event. A longer step moves the control step back to the main loop
+	#define CTRL_ISR_MAX_TIME	390
 
 	/****************************************************************************
 	**	TYPEDEF
@@ -133,19 +477,18 @@
 	struct _Isr_flags
 	{
 		//First byte
-		U8 system_tick		: 1;	//System Tick
 		U8 enc_double_event	: 1;	//true = At least one encoder double event detected
 		U8 enc_sem			: 1;	//true = Encoder ISR is forbidden to write into the 32b encoder counters
 		U8 enc_updt			: 1;	//true = Encoder ISR is forced to update the 32b counters and clear this flag if possible.
-		U8 ctrl_updt		: 1;	//true = Execute the motor control system
 		U8 pid_sat_err		: 1;	//true = A PID wasn't able to lock quickly enough to the reference
-		U8 					: 2;	//unused bits
+		U8 motor_stall		: 1;	//true = A wheel didn't turn with a current above CURRENT_STALL_MA
+		U8 					: 3;	//unused bits
 	};
 
 	//PWM and direction of a DC motor
 	struct _Dc_motor_pwm
 	{
-		uint8_t pwm;			//DC Motor PWM setting. 0x00 = stop | 0xff = maximum
+		uint16_t pwm;			//DC Motor PWM setting. 0 = stop | DC_MOTOR_MAX_PWM = maximum
 		uint8_t f_dir;			//DC Motor direction. false=clockwise | true=counterclockwise
 	};
 
@@ -162,6 +505,8 @@
 	
 	//Error code handler function
 	extern void report_error( Error_code err_code );
+	//Free running 16b timestamp. TCA0 counter extended by the overflows
+	extern uint16_t get_timestamp( void );
 	
 		///----------------------------------------------------------------------
 		///	PARSER
@@ -175,7 +520,7 @@
 	extern void signature_handler( void );
 	//Handler for the motor speed set command
 	extern void set_speed_handler( int16_t motor_index, int16_t pwm );
-	//Handler for the platform speed. Firmware handles logical configuration of the motors. TODO: evolve to forward and turn
+	//Handler for the platform speed. Firmware handles logical configuration of the motors. Forward and turn is set_platform_turn_handler
 	extern void set_platform_speed_handler(int16_t right, int16_t left );
 	//Handler for closed loop speed
 	extern void set_pid_speed_handler( int16_t motor_index, int16_t spd );
@@ -185,13 +530,93 @@
 	extern void get_encoder_cnt_handler( void );
 	//Handler for the get encoder speed message
 	extern void get_encoder_spd_handler( void );
+	//Handler for the get scheduler statistics message
+	extern void get_scheduler_stats_handler( uint8_t index );
+	//Handler for the set system tick rate message
+	extern void set_tick_rate_handler( uint16_t freq );
+	//Handler for the get CPU load message
+	extern void get_load_handler( void );
+	//Handler for the get profiler statistics message
+	extern void get_profiler_handler( uint8_t index );
+	//Handler for the get profiler histogram message
+	extern void get_histogram_handler( uint8_t index );
+	//Handler for the clear profiler message
+	extern void clear_profiler_handler( void );
+	//Handler for the control step execution context message
+	extern void set_control_isr_handler( uint8_t f_enable );
+	//Handler for the absolute position target message
+	extern void set_pos_target_handler( int32_t index, int32_t target );
+	//Handler for the position profile limits message
+	extern void set_pos_limits_handler( int16_t index, int16_t vmax, int16_t amax );
+	//Handler for the motion queue limits message
+	extern void set_queue_limits_handler( int16_t vmax, int16_t amax, int16_t jerk );
+	//Handler for the queue speed segment message
+	extern void queue_speed_handler( int16_t right, int16_t left, int16_t duration );
+	//Handler for the queue position segment message
+	extern void queue_position_handler( int32_t right, int32_t left );
+	//Handler for the motion queue status message
+	extern void get_queue_status_handler( void );
+	//Handler for the abort motion queue message
+	extern void abort_queue_handler( void );
+	//Handler for the platform forward and turn speed message
+	extern void set_platform_turn_handler( int16_t fwd, int16_t turn );
+	//Handler for the get odometry message
+	extern void get_odometry_handler( void );
+	//Handler for the clear odometry message
+	extern void clear_odometry_handler( void );
+	//Handler for the speed setpoint interpolation message
+	extern void set_spd_interp_handler( uint8_t mode );
+	//Handler for the speed reference limits message
+	extern void set_spd_limits_handler( int16_t index, int16_t acc, int16_t dec );
+	//Handler for the stop mode message
+	extern void set_stop_mode_handler( uint8_t f_brake );
+	//Handler for the motor current message
+	extern void get_motor_current_handler( void );
+	//Handler for the inner current loop message
+	extern void set_current_loop_handler( int16_t f_enable, int16_t kff, int16_t kp, int16_t ki );
+	//Handler for the PID gains message
+	extern void set_pid_gains_handler( int16_t kp, int16_t ki, int16_t kd );
+	//Handler for the battery voltage message
+	extern void get_vbat_handler( void );
+	//Handler for the telemetry subscription message
+	extern void set_stream_handler( uint16_t mask, uint16_t decim );
+	//Handler for the telemetry subscription status message
+	extern void get_stream_handler( void );
+	//Set up the signals, wheels, pre-trigger records and decimation of the RAM capture
+	extern void set_log_handler( uint16_t sig, uint16_t wheel, uint16_t pre, uint16_t decim );
+	//Arm the RAM capture with its trigger sources and step threshold
+	extern void arm_log_handler( uint16_t trig, uint16_t step_th );
+	//Trigger the RAM capture
+	extern void trigger_log_handler( void );
+	//State, records and pre-trigger records of the RAM capture
+	extern void get_log_status_handler( void );
+	//Read a record of the RAM capture
+	extern void read_log_handler( uint16_t index );
 		
 		///----------------------------------------------------------------------
 		///	MOTORS
 		///----------------------------------------------------------------------
 		
-	//Set direction and speed setting of the VNH7040 controlled motor
-	extern void set_vnh7040_speed( uint8_t index, bool f_dir, uint8_t speed );
+	//Stage direction and speed setting of the VNH7040 controlled motor
+	extern void set_vnh7040_speed( uint8_t index, bool f_dir, uint16_t speed );
+	//Stage a brake to ground of the VNH7040 controlled motor
+	extern void set_vnh7040_brake( uint8_t index );
+	//Apply the staged settings of all VNH7040 motors at once
+	extern void commit_vnh7040( void );
+	//Duty cycle loaded in the PWM generator of the VNH7040 controlled motor
+	extern uint16_t get_vnh7040_duty( uint8_t index );
+	//true = VNH7040 controlled motor is braked to ground
+	extern bool is_vnh7040_brake( uint8_t index );
+	//Copy the current of all motors. mA. Bit of each motor: 1 = measured | 0 = unknown
+	extern uint8_t get_motor_current( uint16_t *current );
+	//Load the committed settings at the start of a PWM period. Called by the TCA0 overflow ISR
+	extern void load_vnh7040( void );
+	//Execute the inner current loop of a motor. Called by the ADC ISR
+	extern void current_loop_step( uint8_t index, uint16_t current, bool f_valid );
+	//Enable or disable the inner current loop and set its gains
+	extern bool set_current_loop( bool f_enable, int16_t kff, int16_t kp, int16_t ki );
+	//Set the gains of the speed and position PIDs
+	extern bool set_spd_pid_gains( int16_t kp, int16_t ki, int16_t kd );
 	
 		///----------------------------------------------------------------------
 		///	ENCODERS
@@ -208,6 +633,18 @@
 		
 	//This function is automatically called by a PID when it cannot lock quickly enough to the reference
 	extern void pid_saturation_error_handler( void );
+	//Change the rate of the system tick and rescale everything that depends on it
+	extern bool set_tick_rate( Tick_rate rate );
+	//Execute one step of the motor control system
+	extern void control_step( void );
+	//Select whether the control step is executed by the TCA0 overflow ISR or by the main loop
+	extern void set_control_isr( bool f_enable );
+	//Set the speed and acceleration limits of the position profile of a wheel
+	extern bool set_pos_limits( uint8_t index, int16_t vmax, int16_t amax );
+	//Set the acceleration and deceleration limits of the speed reference of a wheel
+	extern bool set_spd_limits( uint8_t index, int16_t acc, int16_t dec );
+	//Add a segment at the end of the motion queue. Switch to queue mode
+	extern bool push_motion_segment( uint8_t type, int32_t right, int32_t left, uint16_t duration );
 	
 	/****************************************************************************
 	**	PROTOTYPE: GLOBAL VARIABILE
@@ -219,6 +656,23 @@
 
 	//Volatile flags used by ISRs
 	extern volatile	Isr_flags g_isr_flags;
+	//Errors reported but not yet sent. Bit n is Error_code n
+	extern volatile uint8_t g_err_pending;
+	
+		///----------------------------------------------------------------------
+		///	TIMESTAMP
+		///----------------------------------------------------------------------
+	
+	//Timestamp at the last TCA0 overflow
+	extern volatile uint16_t g_timestamp_base;
+	//Timestamp at the TCA0 overflow that raised the last system tick
+	extern volatile uint16_t g_timestamp_tick;
+	//TOP of TCA0 for the period in progress. PER is loaded from PERBUF at overflow
+	extern volatile uint16_t g_timestamp_top;
+	//System ticks since reset. Wraps around
+	extern volatile uint32_t g_tick_num;
+	//System ticks raised by the TCA0 ISR and not yet given to the scheduler. Saturates
+	extern volatile uint8_t g_tick_pending;
 	
 		///----------------------------------------------------------------------
 		///	BUFFERS
@@ -253,6 +707,12 @@
 	extern Control_mode g_control_mode;
 	//Target motor control mode
 	extern Control_mode g_control_mode_target;
+	//Rate of the system tick
+	extern Tick_rate g_tick_rate;
+	//true = control step is executed by the TCA0 overflow ISR
+	extern volatile bool g_f_ctrl_isr;
+	//TCA0 overflows in one system tick
+	extern volatile uint8_t g_tick_div;
 	
 		///--------------------------------------------------------------------------
 		///	MOTORS
@@ -262,6 +722,22 @@
 	extern Dc_motor_pwm g_dc_motor_target[DC_MOTOR_NUM];
 	//Two DC Motor channels current setting
 	extern Dc_motor_pwm g_dc_motor[DC_MOTOR_NUM];
+	//true = a motor with zero PWM is braked to ground | false = a motor with zero PWM coasts
+	extern bool g_f_vnh7040_brake;
+	//true = committed settings are waiting for the start of a PWM period
+	extern volatile bool g_f_vnh7040_load;
+	//Current of each motor from its MultiSense output. mA. Written by the ADC ISR
+	extern volatile uint16_t g_motor_current[DC_MOTOR_NUM];
+	//Bit of each motor: 1 = g_motor_current is measured | 0 = skipped samples for too long, unknown
+	extern volatile uint8_t g_motor_current_valid;
+	//true = PID output is a current reference for the inner current loop
+	extern volatile bool g_f_current_loop;
+	//Open loop command of each motor. Voltage, DC_MOTOR_MAX_PWM is VBAT_NOMINAL_MV
+	extern int16_t g_pwm_cmd[DC_MOTOR_NUM];
+	//Filtered ADC reading of the battery divider. Fixed point VBAT_FILTER_FP. Written by the ADC ISR
+	extern volatile uint16_t g_vbat_adc;
+	//Battery voltage. mV
+	extern uint16_t g_vbat_mv;
 	
 		///--------------------------------------------------------------------------
 		///	ENCODERS
@@ -271,11 +747,42 @@
 	extern volatile int32_t g_enc_cnt[ENC_NUM];
 	//Previous encoder reading
 	extern int32_t g_old_enc_cnt[ENC_NUM];
-	//Encoder speed
+	//Encoder speed. Counts per base tick
 	extern int16_t g_enc_spd[ENC_NUM];
-	//Encoder speed reference
+	//Encoder speed reference. Counts per base tick
 	extern int16_t g_pid_spd_target[ENC_NUM];
 	
+		///----------------------------------------------------------------------
+		///	TELEMETRY STREAM
+		///----------------------------------------------------------------------
+
+	//Signals of the stream. STREAM_xxx bits. 0 = no stream
+	extern uint8_t g_stream_mask;
+	//A frame is sent every this many base ticks
+	extern uint16_t g_stream_decim;
+	//Longest frame of the subscribed signals, terminator included
+	extern uint8_t g_stream_len;
+	//Frames skipped for lack of room in the TX buffer. Saturates
+	extern uint16_t g_stream_skip;
+	//Sequence number of the next compressed frame. Multiple of STREAM_KEY_PERIOD = keyframe
+	extern uint8_t g_stream_seq;
+	
+		///----------------------------------------------------------------------
+		///	DATA LOGGER
+		///----------------------------------------------------------------------
+
+	//Signals of a record for each logged wheel. LOG_SIG_xxx bits
+	extern uint16_t g_log_sig;
+	//Wheels in a record. Bit 0 is wheel 0
+	extern uint8_t g_log_wheel;
+	//Trigger sources. LOG_TRIG_xxx bits
+	extern uint8_t g_log_trig;
+	//Smallest jump of the reference that triggers LOG_TRIG_STEP
+	extern uint16_t g_log_step_th;
+	//Reference and feedback of the PID of each wheel in the last closed loop step
+	extern int16_t g_ctrl_ref[ENC_NUM];
+	extern int16_t g_ctrl_fb[ENC_NUM];
+	
 #else
 	#warning "multiple inclusion of the header file global.h"
 #endif
@@ -0,0 +1,53 @@
+/**********************************************************************************
+**	ENVIROMENT VARIABILE
+**********************************************************************************/
+
+#ifndef HAL_H_
+	#define HAL_H_
+
+/**********************************************************************************
+**	DESCRIPTION
+***********************************************************************************
+**	Hardware abstraction layer
+**	Firmware is written against the register names, ISR(), cli(), sei() and _delay_xx()
+**	of avr-libc. On the target they come from avr-libc.
+**	On a host build the same names are provided by host/hal_host.h, that emulates the
+**	peripherals in simulated time so the firmware compiles and runs unmodified
+**	HAL_POLL() is called once per iteration of the main loop. It advances the simulated
+**	time on the host and is empty on the target
+**********************************************************************************/
+
+/**********************************************************************************
+**	GLOBAL INCLUDES
+**********************************************************************************/
+
+//if: AVR target
+#ifdef __AVR__
+	//define the ISR routune, ISR vector, and the sei() cli() function
+	#include <avr/interrupt.h>
+	//name all the register and bit
+	#include <avr/io.h>
+	//hard delay
+	#include <util/delay.h>
+//if: host build
+#else
+	//Register names, ISR and interrupt enable emulated in simulated time
+	#include "host/hal_host.h"
+#endif
+
+/**********************************************************************************
+**	MACROS
+**********************************************************************************/
+
+#ifdef __AVR__
+	//Nothing to emulate on the target
+	#define HAL_POLL()
+#else
+	//Advance the simulated time by one main loop iteration and serve the emulated peripherals
+	#define HAL_POLL()	\
+		hal_host_poll()
+#endif
+
+#else
+    #warning "Multiple inclusion of hader file"
+#endif
@@ -0,0 +1,707 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	CONTROL BENCHMARK
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:		2019-11-18
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Standard scenarios run by the host build of the firmware against the simulated plant.
+**	The bench talks to the firmware through the emulated UART, like the RPI:
+**	it sends the references and a ping to keep the link alive, and moves the load of the wheels.
+**	Wheel 0 is measured once per millisecond, from the plant. Speed is in counts per base tick,
+**	like the references of the firmware. Position is in encoder edges.
+**	Each scenario runs in its own process since the firmware keeps its state in globals.
+**
+**	ob_bench [-l] [-g] [-b <baseline>] [scenario...]
+**		-l	list the scenarios
+**		-g	print a baseline from this run, with a margin, instead of the results
+**		-b	check the results against the thresholds of a baseline file
+**	No scenario runs them all. One JSON object per scenario and line on stdout.
+**	Exit code is 0 when all thresholds are met.
+**
+**	METRICS. All of them are better when lower
+**		rise_ms			10% to 90% of a step
+**		overshoot_pct	peak past the final reference, percent of the step
+**		settle_ms		from the step or disturbance to the last exit from the band
+**		iae				integral of the absolute error [unit s]
+**		itae			integral of time times the absolute error [unit s^2]
+**		max_err			largest absolute error
+**		ss_err			mean absolute error of the last BENCH_SS_MS
+**		tick_ns_avg		host time of the system tick, control step inside it [ns]
+**		tick_ns_max
+**	Host times depend on the machine. Compare them between builds on the same machine.
+**	The default gains of the PIDs have no integral term and don't converge on the plant.
+**	Each scenario sets the gains tuned for its mode, and references are applied as steps (SINT0)
+**	so that the metrics are of the loop and not of the interpolation of the host stream.
+**	All scenarios settle well inside their window: a settle_ms at the window length is a regression.
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "global.h"
+#include "host/sim_plant.h"
+
+/****************************************************************************
+**	DEFINES
+****************************************************************************/
+
+//Longest scenario [ms]
+#define BENCH_MAX_MS		4000
+//Ping period. Below the communication timeout of the firmware [ms]
+#define BENCH_PING_MS		250
+//Minimum time between two reference commands [ms]
+#define BENCH_CMD_MS		10
+//Settling band. Fraction of the step, or of the reference for a disturbance
+#define BENCH_BAND			0.05
+//Minimum settling band. Counts per base tick, or edges
+#define BENCH_BAND_MIN		2.0
+//Steady state error is averaged on the end of the window [ms]
+#define BENCH_SS_MS			100
+//Gains of the PIDs for CONTROL_SPD and for CONTROL_SPD_POS. Fixed point PID_GAIN_FP
+#define BENCH_GAINS_SPD		"GAINP128I16D0"
+#define BENCH_GAINS_POS		"GAINP32I1D0"
+//Maximum number of metrics of a scenario
+#define BENCH_MAX_METRIC	12
+//Margin of a baseline written by -g. Relative and absolute
+#define BENCH_MARGIN_REL	1.25
+#define BENCH_MARGIN_ABS	1.0
+
+/****************************************************************************
+**	ENUM
+****************************************************************************/
+
+//How the reference is sent
+typedef enum _Bench_cmd
+{
+	BENCH_CMD_SPD	= 0,	//PID0SPD. CONTROL_SPD, wheel 0 alone
+	BENCH_CMD_SPDR	= 1		//SPDR. CONTROL_SPD_POS, all wheels
+} Bench_cmd;
+
+//What is measured
+typedef enum _Bench_kind
+{
+	BENCH_STEP		= 0,	//Step or reversal of the speed reference
+	BENCH_TRACK		= 1,	//Speed reference that changes continuously
+	BENCH_REJECT	= 2,	//Speed disturbance
+	BENCH_HOLD		= 3		//Position disturbance
+} Bench_kind;
+
+/****************************************************************************
+**	STRUCTURES
+****************************************************************************/
+
+//Scenario
+typedef struct _Bench_scenario
+{
+	//Name
+	const char *name;
+	//How the reference is sent
+	Bench_cmd cmd;
+	//What is measured
+	Bench_kind kind;
+	//Duration [ms]
+	uint32_t duration_ms;
+	//Start of the measurement window. Step, reversal or disturbance [ms]
+	uint32_t start_ms;
+	//Speed reference of wheel 0 at a given time. Counts per base tick
+	int16_t (*ref)( uint32_t ms );
+	//Load torque of all wheels at a given time [Nm]
+	double (*load)( uint32_t ms );
+} Bench_scenario;
+
+//A measured value
+typedef struct _Bench_metric
+{
+	const char *name;
+	double value;
+} Bench_metric;
+
+/****************************************************************************
+**	PROTOTYPES
+****************************************************************************/
+
+//Firmware entry point. main() of the firmware is renamed by the build
+extern int firmware_main( void );
+
+/****************************************************************************
+**	SCENARIOS
+****************************************************************************/
+
+static int16_t bench_ref_step( uint32_t ms )		{ return (ms < 100)?(0):(100); }
+static int16_t bench_ref_step_low( uint32_t ms )	{ return (ms < 100)?(0):(10); }
+static int16_t bench_ref_reversal( uint32_t ms )	{ return (ms < 600)?(100):(-100); }
+static int16_t bench_ref_ramp( uint32_t ms )		{ return (ms < 100)?(0):((ms < 1100)?((int16_t)((ms -100) /5)):(200)); }
+static int16_t bench_ref_cruise( uint32_t ms )		{ return (ms < 100)?(0):(100); }
+static int16_t bench_ref_zero( uint32_t ms )		{ return (ms == 0)?(0):(0); }
+static double bench_load_none( uint32_t ms )		{ return (ms == 0)?(0.0):(0.0); }
+static double bench_load_step( uint32_t ms )		{ return (ms < 600)?(0.0):(0.3); }
+static double bench_load_hold( uint32_t ms )		{ return (ms < 300)?(0.0):(0.3); }
+
+//Scenarios
+static const Bench_scenario g_bench_scenario[] =
+{
+	{ "spd_step",		BENCH_CMD_SPD,	BENCH_STEP,		1100,	100,	&bench_ref_step,		&bench_load_none },
+	{ "spd_step_low",	BENCH_CMD_SPD,	BENCH_STEP,		1100,	100,	&bench_ref_step_low,	&bench_load_none },
+	{ "spd_reversal",	BENCH_CMD_SPD,	BENCH_STEP,		1600,	600,	&bench_ref_reversal,	&bench_load_none },
+	{ "spd_ramp",		BENCH_CMD_SPD,	BENCH_TRACK,	1600,	100,	&bench_ref_ramp,		&bench_load_none },
+	{ "spd_load_step",	BENCH_CMD_SPD,	BENCH_REJECT,	1600,	600,	&bench_ref_cruise,		&bench_load_step },
+	{ "pos_step",		BENCH_CMD_SPDR,	BENCH_STEP,		1100,	100,	&bench_ref_step,		&bench_load_none },
+	{ "pos_hold",		BENCH_CMD_SPDR,	BENCH_HOLD,		1300,	300,	&bench_ref_zero,		&bench_load_hold },
+};
+//Number of scenarios
+#define BENCH_NUM_SCENARIO	(sizeof( g_bench_scenario ) /sizeof( g_bench_scenario[0] ))
+
+/****************************************************************************
+**	GLOBAL VARIABILES
+****************************************************************************/
+
+//Scenario of this process
+static const Bench_scenario *g_sc = 0;
+//Baseline to check. 0 = none
+static const char *g_baseline = 0;
+//true = print a baseline instead of the results
+static bool g_f_gen = false;
+
+//Reference and measure of wheel 0, one per millisecond
+static double g_ref[ BENCH_MAX_MS ];
+static double g_meas[ BENCH_MAX_MS ];
+//Next sample [ms]
+static uint32_t g_ms = 0;
+//Last reference sent, and when [ms]
+static int16_t g_ref_sent = 0;
+static uint32_t g_ref_sent_ms = 0;
+//Position of wheel 0 at the start of the window [edges]
+static int32_t g_hold_pos = 0;
+
+/****************************************************************************
+**	FUNCTIONS
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Function
+//!	bench_send | const char *
+/***************************************************************************/
+//! @param cmd | command for the firmware. The terminator is sent too
+//! @return void
+/***************************************************************************/
+
+static void bench_send( const char *cmd )
+{
+	//Send the terminator too
+	do
+	{
+		hal_host_uart_rx( (uint8_t)*cmd );
+	}
+	while (*cmd++ != '\0');
+
+	return;
+}	//end function: bench_send | const char *
+
+/***************************************************************************/
+//!	@brief Function
+//!	bench_send_ref | int16_t
+/***************************************************************************/
+//! @param ref | speed reference of wheel 0. Counts per base tick
+//! @return void
+/***************************************************************************/
+
+static void bench_send_ref( int16_t ref )
+{
+	//Command
+	char msg[32];
+
+	//if: CONTROL_SPD
+	if (g_sc -> cmd == BENCH_CMD_SPD)
+	{
+		snprintf( msg, sizeof( msg ), "PID0SPD%d", ref );
+	}
+	//if: CONTROL_SPD_POS. Right side is reversed by the handler
+	else
+	{
+		snprintf( msg, sizeof( msg ), "SPDR%dL%d", -ref, ref );
+	}
+	bench_send( msg );
+
+	return;
+}	//end function: bench_send_ref | int16_t
+
+/***************************************************************************/
+//!	@brief Function
+//!	bench_step | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! Step hook of the plant. Once per millisecond: sample wheel 0, move the load, send the reference
+/***************************************************************************/
+
+static void bench_step( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Reference of this millisecond
+	int16_t ref;
+	//Load of this millisecond
+	double load;
+	//Edges per revolution
+	double cpr;
+	//counter
+	uint8_t t;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//if: not yet the next millisecond
+	if ((hal_host_clk() < (uint64_t)g_ms *(F_CPU /1000)) || (g_ms >= g_sc -> duration_ms))
+	{
+		return;
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	ref = g_sc -> ref( g_ms );
+	load = g_sc -> load( g_ms );
+
+	//if: start. Control step inside the tick so that its host time is measured
+	if (g_ms == 0)
+	{
+		bench_send( "CISR1" );
+		bench_send( "SINT0" );
+		bench_send( (g_sc -> cmd == BENCH_CMD_SPD)?(BENCH_GAINS_SPD):(BENCH_GAINS_POS) );
+		bench_send_ref( ref );
+		g_ref_sent = ref;
+	}
+	//if: reference changed and the link had a rest
+	else if ((ref != g_ref_sent) && (g_ms -g_ref_sent_ms >= BENCH_CMD_MS))
+	{
+		bench_send_ref( ref );
+		g_ref_sent = ref;
+		g_ref_sent_ms = g_ms;
+	}
+	//if: keep the link alive
+	else if ((g_ms % BENCH_PING_MS) == 0)
+	{
+		bench_send( "P" );
+	}
+	//For: each wheel
+	for (t = 0;t < DC_MOTOR_NUM;t++)
+	{
+		sim_plant_motor( t ).set_load( load );
+	}
+
+	//if: start of the window of a position hold
+	if ((g_sc -> kind == BENCH_HOLD) && (g_ms == g_sc -> start_ms))
+	{
+		g_hold_pos = sim_plant_motor( 0 ).get_count();
+	}
+	//if: position is measured
+	if (g_sc -> kind == BENCH_HOLD)
+	{
+		g_ref[ g_ms ] = 0.0;
+		g_meas[ g_ms ] = (g_ms < g_sc -> start_ms)?(0.0):((double)(sim_plant_motor( 0 ).get_count() -g_hold_pos));
+	}
+	//if: speed is measured. Counts per base tick
+	else
+	{
+		cpr = sim_plant_motor( 0 ).get_param().cpr;
+		g_ref[ g_ms ] = (double)g_ref_sent;
+		g_meas[ g_ms ] = sim_plant_motor( 0 ).get_speed() *cpr /(2.0 *M_PI) *(1 << ENC_GAIN) /SYS_TICK_BASE_HZ;
+	}
+	g_ms++;
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return;
+}	//end function: bench_step | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	bench_check | const Bench_metric *, uint8_t
+/***************************************************************************/
+//! @param metric | results of the scenario
+//! @param num | number of results
+//! @return bool | false = all thresholds of the scenario met | true = fail
+//!	@details
+//! Baseline lines are: <scenario> <metric> <maximum>. '#' starts a comment
+/***************************************************************************/
+
+static bool bench_check( const Bench_metric *metric, uint8_t num )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	FILE *f;
+	char line[128];
+	char sc_name[64], metric_name[64];
+	double max;
+	bool f_found;
+	bool f_fail = false;
+	uint8_t t;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	f = fopen( g_baseline, "r" );
+	//if: no baseline
+	if (f == 0)
+	{
+		fprintf( stderr, "%s: can't open baseline %s\n", g_sc -> name, g_baseline );
+		return true;	//fail
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//While: lines
+	while (fgets( line, sizeof( line ), f ) != 0)
+	{
+		//if: comment, blank, or another scenario
+		if ((line[0] == '#') || (sscanf( line, "%63s %63s %lf", sc_name, metric_name, &max ) != 3) || (strcmp( sc_name, g_sc -> name ) != 0))
+		{
+			continue;
+		}
+		f_found = false;
+		//For: each result
+		for (t = 0;t < num;t++)
+		{
+			//if: threshold of this result
+			if (strcmp( metric[t].name, metric_name ) == 0)
+			{
+				f_found = true;
+				//if: regression
+				if (!(metric[t].value <= max))
+				{
+					fprintf( stderr, "%s: %s %g above %g\n", g_sc -> name, metric_name, metric[t].value, max );
+					f_fail = true;
+				}
+			}
+		}
+		//if: threshold of a metric that isn't measured
+		if (f_found == false)
+		{
+			fprintf( stderr, "%s: no metric %s\n", g_sc -> name, metric_name );
+			f_fail = true;
+		}
+	}
+	fclose( f );
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return f_fail;
+}	//end function: bench_check | const Bench_metric *, uint8_t
+
+/***************************************************************************/
+//!	@brief Function
+//!	bench_report | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! Stop hook of the HAL. Compute the metrics on the window, print them and exit
+/***************************************************************************/
+
+static void bench_report( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Results
+	Bench_metric metric[ BENCH_MAX_METRIC ];
+	uint8_t num = 0;
+	//Window [ms]
+	uint32_t start, stop;
+	//Reference before and after the window
+	double y0, y1, step;
+	//Settling band
+	double band;
+	//Error, time from the start of the window [s]
+	double err, ts;
+	//Results
+	double iae = 0.0, itae = 0.0, max_err = 0.0, ss_err = 0.0, peak = 0.0;
+	//Crossing of 10% and 90% of the step, last exit from the band [ms]
+	int32_t t10 = -1, t90 = -1, t_settle = 0;
+	//Host time of the tick
+	uint32_t tick_cnt;
+	uint64_t tick_sum, tick_max;
+	bool f_fail;
+	uint32_t t;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	start = g_sc -> start_ms;
+	stop = g_ms;
+	y0 = (start > 0)?(g_ref[ start -1 ]):(0.0);
+	y1 = g_ref[ stop -1 ];
+	step = y1 -y0;
+	//if: step. Band around the final reference
+	if (g_sc -> kind == BENCH_STEP)
+	{
+		band = BENCH_BAND *fabs( step );
+	}
+	//if: speed disturbance or tracking. Band around the reference
+	else
+	{
+		band = BENCH_BAND *fabs( y1 );
+	}
+	band = (band < BENCH_BAND_MIN)?(BENCH_BAND_MIN):(band);
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//For: each sample of the window
+	for (t = start;t < stop;t++)
+	{
+		err = fabs( g_ref[t] -g_meas[t] );
+		ts = (t -start) /1000.0;
+		iae += err /1000.0;
+		itae += ts *err /1000.0;
+		max_err = (err > max_err)?(err):(max_err);
+		//if: end of the window
+		if (t +BENCH_SS_MS >= stop)
+		{
+			ss_err += err /BENCH_SS_MS;
+		}
+		//if: out of the band
+		if (err > band)
+		{
+			t_settle = (int32_t)(t -start +1);
+		}
+		//if: crossing 10% of the step
+		if ((t10 < 0) && ((g_meas[t] -y0) *step >= 0.1 *step *step))
+		{
+			t10 = (int32_t)(t -start);
+		}
+		//if: crossing 90% of the step
+		if ((t90 < 0) && ((g_meas[t] -y0) *step >= 0.9 *step *step))
+		{
+			t90 = (int32_t)(t -start);
+		}
+		//Past the final reference, in the direction of the step
+		peak = ((g_meas[t] -y1) *step > peak *fabs( step ))?((g_meas[t] -y1) *((step > 0.0)?(1.0):(-1.0))):(peak);
+	}
+
+	//if: step
+	if (g_sc -> kind == BENCH_STEP)
+	{
+		//Never reached is the whole window
+		metric[num].name = "rise_ms";
+		metric[num++].value = ((t10 < 0) || (t90 < 0))?((double)(stop -start)):((double)(t90 -t10));
+		metric[num].name = "overshoot_pct";
+		metric[num++].value = (step != 0.0)?(100.0 *peak /fabs( step )):(0.0);
+	}
+	//if: the response settles after an event
+	if (g_sc -> kind != BENCH_TRACK)
+	{
+		metric[num].name = "settle_ms";
+		metric[num++].value = (double)t_settle;
+	}
+	metric[num].name = "iae";
+	metric[num++].value = iae;
+	metric[num].name = "itae";
+	metric[num++].value = itae;
+	metric[num].name = "max_err";
+	metric[num++].value = max_err;
+	metric[num].name = "ss_err";
+	metric[num++].value = ss_err;
+	hal_host_get_tick_profile( tick_cnt, tick_sum, tick_max );
+	metric[num].name = "tick_ns_avg";
+	metric[num++].value = (tick_cnt > 0)?((double)tick_sum /tick_cnt):(0.0);
+	metric[num].name = "tick_ns_max";
+	metric[num++].value = (double)tick_max;
+
+	//if: print a baseline. Host times are left out, they depend on the machine
+	if (g_f_gen == true)
+	{
+		//For: each result
+		for (t = 0;t < num;t++)
+		{
+			//if: not a host time
+			if (strncmp( metric[t].name, "tick_ns", 7 ) != 0)
+			{
+				printf( "%s %s %.3f\n", g_sc -> name, metric[t].name, metric[t].value *BENCH_MARGIN_REL +BENCH_MARGIN_ABS );
+			}
+		}
+		fflush( stdout );
+		exit( 0 );
+	}
+
+	//One JSON object per line
+	printf( "{\"scenario\":\"%s\"", g_sc -> name );
+	//For: each result
+	for (t = 0;t < num;t++)
+	{
+		printf( ",\"%s\":%.3f", metric[t].name, metric[t].value );
+	}
+	f_fail = (g_baseline != 0)?(bench_check( metric, num )):(false);
+	printf( ",\"pass\":%s}\n", (f_fail == true)?("false"):("true") );
+	fflush( stdout );
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	exit( (f_fail == true)?(1):(0) );
+}	//end function: bench_report | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	bench_run | const Bench_scenario *
+/***************************************************************************/
+//! @param sc | scenario
+//! @return void | never returns. The process exits at the end of the scenario
+/***************************************************************************/
+
+static void bench_run( const Bench_scenario *sc )
+{
+	g_sc = sc;
+	sim_plant_init();
+	sim_plant_set_step_hook( &bench_step );
+	hal_host_set_tick_profile( true );
+	hal_host_set_stop( (uint64_t)sc -> duration_ms *(F_CPU /1000), &bench_report );
+	firmware_main();
+
+	exit( 2 );
+}	//end function: bench_run | const Bench_scenario *
+
+/***************************************************************************/
+//!	@brief Function
+//!	main | int, char **
+/***************************************************************************/
+//! @return int | 0 = all thresholds met | 1 = regression | 2 = error
+/***************************************************************************/
+
+int main( int argc, char *argv[] )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Scenarios to run
+	bool f_run[ BENCH_NUM_SCENARIO ];
+	bool f_all = true;
+	//Worst exit code of the scenarios
+	int ret = 0;
+	int status;
+	pid_t pid;
+	int t;
+	uint8_t ts;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	memset( f_run, 0, sizeof( f_run ) );
+	//For: each argument
+	for (t = 1;t < argc;t++)
+	{
+		//if: list
+		if (strcmp( argv[t], "-l" ) == 0)
+		{
+			//For: each scenario
+			for (ts = 0;ts < BENCH_NUM_SCENARIO;ts++)
+			{
+				printf( "%s\n", g_bench_scenario[ts].name );
+			}
+			return 0;
+		}
+		//if: generate a baseline
+		else if (strcmp( argv[t], "-g" ) == 0)
+		{
+			g_f_gen = true;
+		}
+		//if: baseline
+		else if ((strcmp( argv[t], "-b" ) == 0) && (t +1 < argc))
+		{
+			g_baseline = argv[++t];
+		}
+		//if: scenario
+		else
+		{
+			//For: each scenario
+			for (ts = 0;(ts < BENCH_NUM_SCENARIO) && (strcmp( argv[t], g_bench_scenario[ts].name ) != 0);ts++);
+			//if: unknown
+			if (ts >= BENCH_NUM_SCENARIO)
+			{
+				fprintf( stderr, "usage: %s [-l] [-g] [-b <baseline>] [scenario...]\n", argv[0] );
+				return 2;
+			}
+			f_run[ts] = true;
+			f_all = false;
+		}
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//For: each scenario
+	for (ts = 0;ts < BENCH_NUM_SCENARIO;ts++)
+	{
+		//if: not selected
+		if ((f_all == false) && (f_run[ts] == false))
+		{
+			continue;
+		}
+		fflush( stdout );
+		pid = fork();
+		//if: child. Fresh firmware
+		if (pid == 0)
+		{
+			bench_run( &g_bench_scenario[ts] );
+		}
+		//if: fork failed, or the scenario didn't end
+		if ((pid < 0) || (waitpid( pid, &status, 0 ) != pid) || (!WIFEXITED( status )))
+		{
+			fprintf( stderr, "%s: did not complete\n", g_bench_scenario[ts].name );
+			ret = 2;
+		}
+		//if: regression
+		else if (WEXITSTATUS( status ) > ret)
+		{
+			ret = WEXITSTATUS( status );
+		}
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return ret;
+}	//end function: main | int, char **
@@ -0,0 +1,820 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	HOST HAL
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:		2019-11-18
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Emulation of the ATmega4809 peripherals used by the firmware, in simulated time.
+**	Time only advances when the firmware calls HAL_POLL() or _delay_xx(). Everything
+**	is single threaded, so a simulation is deterministic and runs as fast as the host can.
+**	An ISR is called as soon as its flag is raised, if the I bit of SREG is set.
+**	Otherwise the flag stays pending until sei() or the next advance of time.
+**	ISRs don't consume simulated time.
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**	TCB PWM outputs, RTC and the strobe registers of the ports are not emulated
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include <stdlib.h>
+#include <time.h>
+#include "global.h"
+
+/****************************************************************************
+**	PROTOTYPES
+****************************************************************************/
+
+//ISRs of the firmware served by the emulator
+extern "C" void TCA0_OVF_vect( void );
+extern "C" void ADC0_RESRDY_vect( void );
+extern "C" void USART3_RXC_vect( void );
+extern "C" void PORTC_PORT_vect( void );
+
+//Serve the interrupts whose flag is raised
+static void hal_host_dispatch( void );
+//A generator of the event system fired
+static void hal_host_event( uint8_t generator );
+
+/****************************************************************************
+**	GLOBAL VARIABILES
+****************************************************************************/
+
+	///--------------------------------------------------------------------------
+	///	REGISTERS
+	///--------------------------------------------------------------------------
+
+register8_t SREG;
+register8_t CCP;
+PORT_t PORTA, PORTB, PORTC, PORTD, PORTE, PORTF;
+RTC_t RTC;
+TCA_t TCA0;
+TCB_t TCB0, TCB1, TCB2, TCB3;
+USART_t USART0, USART1, USART2, USART3;
+CLKCTRL_t CLKCTRL;
+PORTMUX_t PORTMUX;
+ADC_t ADC0;
+VREF_t VREF;
+CPUINT_t CPUINT;
+EVSYS_t EVSYS;
+
+	///--------------------------------------------------------------------------
+	///	EMULATOR
+	///--------------------------------------------------------------------------
+
+//Simulated time. CPU clocks since reset
+static uint64_t g_clk = 0;
+//CPU clocks not yet counted by TCA0
+static uint32_t g_tca_pre = 0;
+//Last PERBUF loaded into PER
+static uint16_t g_tca_perbuf = 0;
+//Count of TCB0 in 8 bit PWM mode
+static uint16_t g_tcb0_cnt = 0;
+//true = an ISR is in execution. ISRs don't nest
+static bool g_f_isr = false;
+//Prescaler of TCA0 indexed by CLKSEL
+static const uint16_t g_tca_div[8] = { 1, 2, 4, 8, 16, 64, 256, 1024 };
+
+//Bytes on the RX line of USART3, and the earliest time each one can be received. Circular buffer
+static uint8_t g_rx_line[HAL_HOST_RX_SIZE];
+static uint64_t g_rx_line_clk[HAL_HOST_RX_SIZE];
+static uint16_t g_rx_head = 0;
+static uint16_t g_rx_num = 0;
+//Earliest time the next byte can be received. One frame after the previous one
+static uint64_t g_rx_clk = 0;
+//Time the stop bit of the byte being received ended
+static uint64_t g_rx_end_clk = 0;
+//Time the TX data register of USART3 is empty again
+static uint64_t g_tx_clk = 0;
+//Baud rate of the simulated line. 0 = from the registers of USART3
+static uint32_t g_uart_baud = 0;
+
+//Hooks of the host application
+static uint16_t (*g_adc_hook)( uint8_t muxpos ) = 0;
+static void (*g_tx_hook)( uint8_t data ) = 0;
+static void (*g_rx_hook)( uint8_t data ) = 0;
+static void (*g_model_hook)( void ) = 0;
+static void (*g_stop_hook)( void ) = 0;
+//Time the simulation stops
+static uint64_t g_stop_clk = 0;
+
+//true = host time of the TCA0 overflow ISR is measured
+static bool g_f_tick_prof = false;
+//TCA0 overflow ISRs measured
+static uint32_t g_tick_prof_cnt = 0;
+//Total and maximum host time [ns]
+static uint64_t g_tick_prof_sum = 0;
+static uint64_t g_tick_prof_max = 0;
+
+/****************************************************************************
+*****************************************************************************
+**	REGISTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Operator
+//!	Hal_host_txdata = | uint8_t
+/***************************************************************************/
+//! @param data | byte to send
+//! @return Hal_host_txdata & | this register
+//!	@details
+//! Only USART3 is connected to the simulated line. The data register is full for one frame
+/***************************************************************************/
+
+Hal_host_txdata &Hal_host_txdata::operator =( uint8_t data )
+{
+	//if: not the emulated USART or transmitter off
+	if ((this != &USART3.TXDATAL) || (IS_BIT_ZERO( USART3.CTRLB, USART_TXEN_bp )))
+	{
+		return *this;
+	}
+	//Data register is full until the frame is out
+	CLEAR_BIT( USART3.STATUS, USART_DREIF_bp );
+	g_tx_clk = g_clk +hal_host_uart_frame_clk();
+	//if: application listens to the line
+	if (g_tx_hook != 0)
+	{
+		g_tx_hook( data );
+	}
+
+	return *this;
+}	//end operator: Hal_host_txdata = | uint8_t
+
+/****************************************************************************
+*****************************************************************************
+**	AVR-LIBC
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Function
+//!	cli | void
+/***************************************************************************/
+//! @return void
+/***************************************************************************/
+
+void cli( void )
+{
+	CLEAR_BIT( SREG, CPU_I_bp );
+
+	return;
+}	//end function: cli | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	sei | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! Pending interrupts are served right away, like on the target
+/***************************************************************************/
+
+void sei( void )
+{
+	SET_BIT( SREG, CPU_I_bp );
+	hal_host_dispatch();
+
+	return;
+}	//end function: sei | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	_delay_ms | double
+/***************************************************************************/
+//! @param ms | delay
+//! @return void
+/***************************************************************************/
+
+void _delay_ms( double ms )
+{
+	hal_host_advance( (uint32_t)(ms *(F_CPU /1000)) );
+
+	return;
+}	//end function: _delay_ms | double
+
+/***************************************************************************/
+//!	@brief Function
+//!	_delay_us | double
+/***************************************************************************/
+//! @param us | delay
+//! @return void
+/***************************************************************************/
+
+void _delay_us( double us )
+{
+	hal_host_advance( (uint32_t)(us *(F_CPU /1000000)) );
+
+	return;
+}	//end function: _delay_us | double
+
+/****************************************************************************
+*****************************************************************************
+**	EMULATOR
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Function
+//!	hal_host_poll | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! Called by HAL_POLL() once per iteration of the main loop
+/***************************************************************************/
+
+void hal_host_poll( void )
+{
+	hal_host_advance( HAL_HOST_POLL_CLK );
+
+	return;
+}	//end function: hal_host_poll | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	hal_host_clk | void
+/***************************************************************************/
+//! @return uint64_t | simulated time. CPU clocks since reset
+/***************************************************************************/
+
+uint64_t hal_host_clk( void )
+{
+	return g_clk;
+}	//end function: hal_host_clk | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	hal_host_tca_div | void
+/***************************************************************************/
+//! @return uint16_t | CPU clocks per count of TCA0, from CLKSEL
+/***************************************************************************/
+
+uint16_t hal_host_tca_div( void )
+{
+	return g_tca_div[ (TCA0.SINGLE.CTRLA & TCA_SINGLE_CLKSEL_gm) >> 1 ];
+}	//end function: hal_host_tca_div | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	hal_host_advance | uint32_t
+/***************************************************************************/
+//! @param clk | CPU clocks
+//! @return void
+//!	@details
+//! Time advances in slices of HAL_HOST_POLL_CLK so that events inside a long delay keep their order
+//!	TCA0: counts at CLK_PER divided by CLKSEL. PERBUF is loaded into PER at the overflow
+//!	TCB0: in 8 bit PWM mode clocked by TCA0 the end of each period is an event
+//!	USART3: one byte of the RX line is received each frame, while the receiver is enabled
+/***************************************************************************/
+
+void hal_host_advance( uint32_t clk )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//CPU clocks of this slice
+	uint32_t slice;
+	//TCA0 clocks of this slice
+	uint32_t tca_clk;
+	//Count of TCA0
+	uint32_t cnt;
+	//Divider of TCA0, period of TCB0
+	uint16_t div, period;
+	//Hook of the end of the simulation
+	void (*stop_hook)( void );
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//While: time left
+	while (clk > 0)
+	{
+		slice = (clk > HAL_HOST_POLL_CLK)?(HAL_HOST_POLL_CLK):(clk);
+		clk -= slice;
+		g_clk += slice;
+
+			//! TCA0
+		//if: timer enabled
+		if (IS_BIT_ONE( TCA0.SINGLE.CTRLA, TCA_SINGLE_ENABLE_bp ))
+		{
+			div = hal_host_tca_div();
+			g_tca_pre += slice;
+			tca_clk = g_tca_pre /div;
+			g_tca_pre -= tca_clk *div;
+			cnt = (uint32_t)TCA0.SINGLE.CNT +tca_clk;
+			//While: overflows inside this slice
+			while (cnt > TCA0.SINGLE.PER)
+			{
+				cnt -= (uint32_t)TCA0.SINGLE.PER +1;
+				//if: a new period has been buffered
+				if (TCA0.SINGLE.PERBUF != g_tca_perbuf)
+				{
+					g_tca_perbuf = TCA0.SINGLE.PERBUF;
+					TCA0.SINGLE.PER = g_tca_perbuf;
+				}
+				TCA0.SINGLE.INTFLAGS.raise( TCA_SINGLE_OVF_bm );
+				hal_host_event( EVSYS_GENERATOR_TCA0_OVF_LUNF_gc );
+				hal_host_dispatch();
+			}
+			TCA0.SINGLE.CNT = (uint16_t)cnt;
+
+				//! TCB0
+			//if: 8 bit PWM clocked by TCA0
+			if ((IS_BIT_ONE( TCB0.CTRLA, TCB_ENABLE_bp )) && ((TCB0.CTRLB & TCB_CNTMODE_gm) == TCB_CNTMODE_PWM8_gc) && ((TCB0.CTRLA & TCB_CLKSEL_gm) == TCB_CLKSEL_CLKTCA_gc))
+			{
+				period = (uint16_t)TCB0.CCMPL +1;
+				g_tcb0_cnt += tca_clk;
+				//While: periods ended inside this slice
+				while (g_tcb0_cnt >= period)
+				{
+					g_tcb0_cnt -= period;
+					hal_host_event( EVSYS_GENERATOR_TCB0_CAPT_gc );
+					hal_host_dispatch();
+				}
+				TCB0.CNTL = (uint8_t)g_tcb0_cnt;
+			}
+		}
+
+			//! USART3
+		//While: a byte of the RX line has been received
+		while ((g_rx_num > 0) && (g_clk >= g_rx_clk) && (g_clk >= g_rx_line_clk[ g_rx_head ]) && (IS_BIT_ONE( USART3.CTRLB, USART_RXEN_bp )))
+		{
+			g_rx_end_clk = (g_rx_clk > g_rx_line_clk[ g_rx_head ])?(g_rx_clk):(g_rx_line_clk[ g_rx_head ]);
+			//if: application watches the receiver
+			if (g_rx_hook != 0)
+			{
+				g_rx_hook( g_rx_line[ g_rx_head ] );
+			}
+			USART3.RXDATAL = g_rx_line[ g_rx_head ];
+			SET_BIT( USART3.STATUS, USART_RXCIF_bp );
+			g_rx_clk = g_rx_end_clk +hal_host_uart_frame_clk();
+			g_rx_head = (g_rx_head +1) % HAL_HOST_RX_SIZE;
+			g_rx_num--;
+			hal_host_dispatch();
+		}
+		//if: frame sent. TX data register is empty
+		if (g_clk >= g_tx_clk)
+		{
+			SET_BIT( USART3.STATUS, USART_DREIF_bp );
+		}
+
+			//! Host application
+		//if: model of the world outside the micro
+		if (g_model_hook != 0)
+		{
+			g_model_hook();
+		}
+		//if: end of the simulation
+		if ((g_stop_hook != 0) && (g_clk >= g_stop_clk))
+		{
+			stop_hook = g_stop_hook;
+			g_stop_hook = 0;
+			stop_hook();
+			exit( 0 );
+		}
+	}	//End While: time left
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return;
+}	//end function: hal_host_advance | uint32_t
+
+/***************************************************************************/
+//!	@brief Function
+//!	hal_host_uart_rx | uint8_t
+/***************************************************************************/
+//! @param data | byte sent to the micro
+//! @return bool | false = OK | true = line buffer full, byte dropped
+//!	@details
+//! Bytes are received one per frame. A byte queued on an idle line starts now
+/***************************************************************************/
+
+bool hal_host_uart_rx( uint8_t data )
+{
+	return hal_host_uart_rx_at( data, g_clk +hal_host_uart_frame_clk() );
+}	//end function: hal_host_uart_rx | uint8_t
+
+/***************************************************************************/
+//!	@brief Function
+//!	hal_host_uart_rx_at | uint8_t, uint64_t
+/***************************************************************************/
+//! @param data | byte sent to the micro
+//! @param clk | time the byte is received, stop bit included. CPU clocks
+//! @return bool | false = OK | true = line buffer full, byte dropped
+//!	@details
+//! Byte is received at the end of the first step of the simulation at or after clk,
+//!	and at least one frame after the previous byte. Used to replay a capture
+/***************************************************************************/
+
+bool hal_host_uart_rx_at( uint8_t data, uint64_t clk )
+{
+	//Position in the line
+	uint16_t index;
+
+	//if: line buffer full
+	if (g_rx_num >= HAL_HOST_RX_SIZE)
+	{
+		return true;	//fail
+	}
+	index = (g_rx_head +g_rx_num) % HAL_HOST_RX_SIZE;
+	g_rx_line[ index ] = data;
+	g_rx_line_clk[ index ] = clk;
+	g_rx_num++;
+
+	return false;	//OK
+}	//end function: hal_host_uart_rx_at | uint8_t, uint64_t
+
+/***************************************************************************/
+//!	@brief Function
+//!	hal_host_uart_rx_pending | void
+/***************************************************************************/
+//! @return uint16_t | bytes still on the RX line
+/***************************************************************************/
+
+uint16_t hal_host_uart_rx_pending( void )
+{
+	return g_rx_num;
+}	//end function: hal_host_uart_rx_pending | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	hal_host_uart_rx_clk | void
+/***************************************************************************/
+//! @return uint64_t | time the stop bit of the last byte received ended. CPU clocks
+//!	@details
+//! USART3 sees the byte at the end of the step, this is the time on the line.
+//!	Queued again with hal_host_uart_rx_at, the byte is received at the same time
+/***************************************************************************/
+
+uint64_t hal_host_uart_rx_clk( void )
+{
+	return g_rx_end_clk;
+}	//end function: hal_host_uart_rx_clk | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	hal_host_uart_frame_clk | void
+/***************************************************************************/
+//! @return uint32_t | CPU clocks of one frame of USART3
+//!	@details
+//! Asynchronous mode. Baud = 64 *CLK_PER /(S *BAUD). S = 16, or 8 with CLK2X
+//!	Before the USART is configured a frame is one clock
+//!	A baud rate set by hal_host_set_uart_baud replaces the registers
+/***************************************************************************/
+
+uint32_t hal_host_uart_frame_clk( void )
+{
+	//Samples per bit
+	uint32_t s;
+
+	//if: baud rate of the line is forced
+	if (g_uart_baud > 0)
+	{
+		return (uint32_t)((uint64_t)HAL_HOST_UART_FRAME *F_CPU /g_uart_baud);
+	}
+	//if: baud rate not configured
+	if (USART3.BAUD < 64)
+	{
+		return 1;
+	}
+	s = ((USART3.CTRLB & USART_RXMODE_gm) == USART_RXMODE_CLK2X_gc)?(8):(16);
+
+	return (uint32_t)HAL_HOST_UART_FRAME *s *USART3.BAUD /64;
+}	//end function: hal_host_uart_frame_clk | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	hal_host_set_port_in | PORT_t &, uint8_t
+/***************************************************************************/
+//! @param port | port whose input changes
+//! @param value | new input
+//! @return void
+//!	@details
+//! Pins configured to sense the change raise their flag. Only PORTC has an ISR
+/***************************************************************************/
+
+void hal_host_set_port_in( PORT_t &port, uint8_t value )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Pins that changed
+	uint8_t changed;
+	//Pins whose flag is raised
+	uint8_t flags;
+	//Input sense configuration of a pin
+	uint8_t isc;
+	//counter
+	uint8_t t;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	changed = port.IN ^value;
+	port.IN = value;
+	flags = 0;
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//For: each pin
+	for (t = 0;t < 8;t++)
+	{
+		isc = (&port.PIN0CTRL)[t] & PORT_ISC_gm;
+		//if: this change is sensed
+		if ( ((isc == PORT_ISC_BOTHEDGES_gc) && (IS_BIT_ONE( changed, t ))) ||
+			 ((isc == PORT_ISC_RISING_gc) && (IS_BIT_ONE( changed, t )) && (IS_BIT_ONE( value, t ))) ||
+			 ((isc == PORT_ISC_FALLING_gc) && (IS_BIT_ONE( changed, t )) && (IS_BIT_ZERO( value, t ))) ||
+			 ((isc == PORT_ISC_LEVEL_gc) && (IS_BIT_ZERO( value, t ))) )
+		{
+			SET_BIT( flags, t );
+		}
+	}
+	//if: pin change interrupt
+	if (flags != 0)
+	{
+		port.INTFLAGS.raise( flags );
+		hal_host_dispatch();
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return;
+}	//end function: hal_host_set_port_in | PORT_t &, uint8_t
+
+/***************************************************************************/
+//!	@brief Function
+//!	hal_host_set_adc_hook | uint16_t (*)( uint8_t )
+/***************************************************************************/
+//! @param hook | returns the 10b sample of a MUXPOS channel. 0 = all samples are zero
+//! @return void
+/***************************************************************************/
+
+void hal_host_set_adc_hook( uint16_t (*hook)( uint8_t muxpos ) )
+{
+	g_adc_hook = hook;
+
+	return;
+}	//end function: hal_host_set_adc_hook | uint16_t (*)( uint8_t )
+
+/***************************************************************************/
+//!	@brief Function
+//!	hal_host_set_tx_hook | void (*)( uint8_t )
+/***************************************************************************/
+//! @param hook | receives each byte sent by USART3. 0 = bytes are dropped
+//! @return void
+/***************************************************************************/
+
+void hal_host_set_tx_hook( void (*hook)( uint8_t data ) )
+{
+	g_tx_hook = hook;
+
+	return;
+}	//end function: hal_host_set_tx_hook | void (*)( uint8_t )
+
+/***************************************************************************/
+//!	@brief Function
+//!	hal_host_set_rx_hook | void (*)( uint8_t )
+/***************************************************************************/
+//! @param hook | receives each byte of the RX line as it reaches USART3. 0 = none
+//! @return void
+//!	@details
+//! RXCIF still set means the previous byte hasn't been read yet
+/***************************************************************************/
+
+void hal_host_set_rx_hook( void (*hook)( uint8_t data ) )
+{
+	g_rx_hook = hook;
+
+	return;
+}	//end function: hal_host_set_rx_hook | void (*)( uint8_t )
+
+/***************************************************************************/
+//!	@brief Function
+//!	hal_host_set_uart_baud | uint32_t
+/***************************************************************************/
+//! @param baud | baud rate of the simulated line, both directions. 0 = from the registers of USART3
+//! @return void
+//!	@details
+//! Timing of the link at another baud rate, without changing the firmware
+/***************************************************************************/
+
+void hal_host_set_uart_baud( uint32_t baud )
+{
+	g_uart_baud = baud;
+
+	return;
+}	//end function: hal_host_set_uart_baud | uint32_t
+
+/***************************************************************************/
+//!	@brief Function
+//!	hal_host_set_model_hook | void (*)( void )
+/***************************************************************************/
+//! @param hook | called each slice of simulated time, after the peripherals. 0 = none
+//! @return void
+/***************************************************************************/
+
+void hal_host_set_model_hook( void (*hook)( void ) )
+{
+	g_model_hook = hook;
+
+	return;
+}	//end function: hal_host_set_model_hook | void (*)( void )
+
+/***************************************************************************/
+//!	@brief Function
+//!	hal_host_set_stop | uint64_t, void (*)( void )
+/***************************************************************************/
+//! @param clk | simulated time of the end of the simulation. CPU clocks
+//! @param hook | called at the end. The process exits with 0 if the hook returns
+//! @return void
+/***************************************************************************/
+
+void hal_host_set_stop( uint64_t clk, void (*hook)( void ) )
+{
+	g_stop_clk = clk;
+	g_stop_hook = hook;
+
+	return;
+}	//end function: hal_host_set_stop | uint64_t, void (*)( void )
+
+/***************************************************************************/
+//!	@brief Function
+//!	hal_host_set_tick_profile | bool
+/***************************************************************************/
+//! @param f_enable | true = measure the host time of the TCA0 overflow ISR
+//! @return void
+//!	@details
+//! Host time depends on the machine. It's the cost of the tick relative to other builds on the same machine
+/***************************************************************************/
+
+void hal_host_set_tick_profile( bool f_enable )
+{
+	g_f_tick_prof = f_enable;
+	g_tick_prof_cnt = 0;
+	g_tick_prof_sum = 0;
+	g_tick_prof_max = 0;
+
+	return;
+}	//end function: hal_host_set_tick_profile | bool
+
+/***************************************************************************/
+//!	@brief Function
+//!	hal_host_get_tick_profile | uint32_t &, uint64_t &, uint64_t &
+/***************************************************************************/
+//! @param cnt | TCA0 overflow ISRs measured
+//! @param ns_sum | total host time [ns]
+//! @param ns_max | longest ISR [ns]
+//! @return void
+/***************************************************************************/
+
+void hal_host_get_tick_profile( uint32_t &cnt, uint64_t &ns_sum, uint64_t &ns_max )
+{
+	cnt = g_tick_prof_cnt;
+	ns_sum = g_tick_prof_sum;
+	ns_max = g_tick_prof_max;
+
+	return;
+}	//end function: hal_host_get_tick_profile | uint32_t &, uint64_t &, uint64_t &
+
+/***************************************************************************/
+//!	@brief Static Function
+//!	hal_host_ns | void
+/***************************************************************************/
+//! @return uint64_t | host monotonic time [ns]
+/***************************************************************************/
+
+static uint64_t hal_host_ns( void )
+{
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return (uint64_t)ts.tv_sec *1000000000 +ts.tv_nsec;
+}	//end function: hal_host_ns | void
+
+/***************************************************************************/
+//!	@brief Static Function
+//!	hal_host_event | uint8_t
+/***************************************************************************/
+//! @param generator | EVSYS generator that fired
+//! @return void
+//!	@details
+//! Event channel 0 is the only one in use. Its user is the start of conversion of the ADC
+/***************************************************************************/
+
+static void hal_host_event( uint8_t generator )
+{
+	//if: event doesn't reach the ADC
+	if ((EVSYS.CHANNEL0 != generator) || (EVSYS.USERADC0 != EVSYS_CHANNEL_CHANNEL0_gc))
+	{
+		return;
+	}
+	//if: ADC is not started by events
+	if ((IS_BIT_ZERO( ADC0.CTRLA, ADC_ENABLE_bp )) || (IS_BIT_ZERO( ADC0.EVCTRL, ADC_STARTEI_bp )))
+	{
+		return;
+	}
+	//Conversion. Its duration is not emulated
+	ADC0.RES = (g_adc_hook != 0)?(g_adc_hook( ADC0.MUXPOS ) & 0x03FF):(0);
+	ADC0.INTFLAGS.raise( ADC_RESRDY_bm );
+
+	return;
+}	//end function: hal_host_event | uint8_t
+
+/***************************************************************************/
+//!	@brief Static Function
+//!	hal_host_dispatch | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! Call the ISR of each raised and enabled flag, if interrupts are enabled
+//!	Flags cleared by a read on the target are cleared here before the ISR
+/***************************************************************************/
+
+static void hal_host_dispatch( void )
+{
+	//if: interrupts disabled, or inside an ISR
+	if ((IS_BIT_ZERO( SREG, CPU_I_bp )) || (g_f_isr == true))
+	{
+		return;
+	}
+	g_f_isr = true;
+
+	//if: system tick
+	if ((IS_BIT_ONE( TCA0.SINGLE.INTFLAGS, TCA_SINGLE_OVF_bp )) && (IS_BIT_ONE( TCA0.SINGLE.INTCTRL, TCA_SINGLE_OVF_bp )))
+	{
+		//if: tick is profiled
+		if (g_f_tick_prof == true)
+		{
+			//Host time of the ISR [ns]
+			uint64_t ns = hal_host_ns();
+			TCA0_OVF_vect();
+			ns = hal_host_ns() -ns;
+			g_tick_prof_cnt++;
+			g_tick_prof_sum += ns;
+			g_tick_prof_max = (ns > g_tick_prof_max)?(ns):(g_tick_prof_max);
+		}
+		else
+		{
+			TCA0_OVF_vect();
+		}
+	}
+	//if: byte received
+	if ((IS_BIT_ONE( USART3.STATUS, USART_RXCIF_bp )) && (IS_BIT_ONE( USART3.CTRLA, USART_RXCIE_bp )))
+	{
+		CLEAR_BIT( USART3.STATUS, USART_RXCIF_bp );
+		USART3_RXC_vect();
+	}
+	//if: conversion complete
+	if ((IS_BIT_ONE( ADC0.INTFLAGS, ADC_RESRDY_bp )) && (IS_BIT_ONE( ADC0.INTCTRL, ADC_RESRDY_bp )))
+	{
+		ADC0.INTFLAGS = ADC_RESRDY_bm;
+		ADC0_RESRDY_vect();
+	}
+	//if: encoder edge
+	if (PORTC.INTFLAGS != 0)
+	{
+		PORTC_PORT_vect();
+	}
+
+	g_f_isr = false;
+
+	return;
+}	//end function: hal_host_dispatch | void
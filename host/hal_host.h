@@ -0,0 +1,586 @@
+/**********************************************************************************
+**	ENVIROMENT VARIABILE
+**********************************************************************************/
+
+#ifndef HAL_HOST_H_
+	#define HAL_HOST_H_
+
+/**********************************************************************************
+**	DESCRIPTION
+***********************************************************************************
+**	Host implementation of the hardware abstraction layer
+**	Provides the avr-libc names used by the firmware on a Linux host:
+**		- Registers of the ATmega4809 peripherals as plain memory. Field names match avr/io.h,
+**		the layout doesn't. Strobe registers (OUTSET, OUTCLR...) don't act on other registers
+**		- Bit field constants with the values of avr/io.h
+**		- ISR() defines a C function with the name of the vector, called by the emulator
+**		- cli() and sei() clear and set the I bit of SREG. ISRs are only called with I set
+**	Emulated peripherals, advanced in simulated CPU clocks by hal_host_poll():
+**		- TCA0 counter, buffered period and overflow interrupt
+**		- Event channel 0: TCA0 overflow or TCB0 8 bit PWM period starts an ADC conversion
+**		- ADC0 result ready interrupt. Samples are provided by a hook of the host application
+**		- USART3 RX interrupt and TX data register empty flag, timed by the baud rate
+**		- Pin change interrupt of any port whose input is changed by the host application
+**********************************************************************************/
+
+/**********************************************************************************
+**	GLOBAL INCLUDES
+**********************************************************************************/
+
+#include <stdint.h>
+
+/**********************************************************************************
+**	DEFINES
+**********************************************************************************/
+
+//Simulated CPU clocks spent by one iteration of the main loop
+#define HAL_HOST_POLL_CLK		100
+//Bytes on the host side of the simulated RX line
+#define HAL_HOST_RX_SIZE		4096
+//Bits in a simulated UART frame. 8N1
+#define HAL_HOST_UART_FRAME		10
+
+/**********************************************************************************
+**	TYPEDEFS
+**********************************************************************************/
+
+typedef volatile uint8_t register8_t;
+typedef volatile uint16_t register16_t;
+
+//Interrupt flags. Writing one clears the flag, like on the target
+class Hal_host_flags
+{
+	public:
+		//Clear the flags whose mask is one
+		Hal_host_flags &operator =( uint8_t mask ) { this -> g_flags &= (uint8_t)~mask; return *this; }
+		//Read the flags
+		operator uint8_t( void ) const { return this -> g_flags; }
+		//Raise flags. Emulator only
+		void raise( uint8_t mask ) { this -> g_flags |= mask; }
+	private:
+		volatile uint8_t g_flags;
+};
+
+//USART transmit data. Writing sends the byte on the simulated line
+class Hal_host_txdata
+{
+	public:
+		//Send a byte
+		Hal_host_txdata &operator =( uint8_t data );
+};
+
+//16b register with access to its bytes
+#define HAL_HOST_WORD( name )	\
+	union { register16_t name; struct { register8_t name##L; register8_t name##H; }; }
+
+	///--------------------------------------------------------------------------
+	///	PERIPHERALS
+	///--------------------------------------------------------------------------
+
+typedef struct _PORT_t
+{
+	register8_t DIR, DIRSET, DIRCLR, DIRTGL;
+	register8_t OUT, OUTSET, OUTCLR, OUTTGL;
+	register8_t IN;
+	Hal_host_flags INTFLAGS;
+	register8_t PORTCTRL;
+	register8_t PIN0CTRL, PIN1CTRL, PIN2CTRL, PIN3CTRL, PIN4CTRL, PIN5CTRL, PIN6CTRL, PIN7CTRL;
+} PORT_t;
+
+typedef struct _RTC_t
+{
+	register8_t CTRLA, STATUS, INTCTRL;
+	Hal_host_flags INTFLAGS;
+	register8_t TEMP, DBGCTRL, CALIB, CLKSEL;
+	register16_t CNT, PER, CMP;
+	register8_t PITCTRLA, PITSTATUS, PITINTCTRL;
+	Hal_host_flags PITINTFLAGS;
+	register8_t PITDBGCTRL;
+} RTC_t;
+
+typedef struct _TCA_SINGLE_t
+{
+	register8_t CTRLA, CTRLB, CTRLC, CTRLD, CTRLECLR, CTRLESET, CTRLFCLR, CTRLFSET;
+	register8_t EVCTRL, INTCTRL;
+	Hal_host_flags INTFLAGS;
+	register8_t DBGCTRL, TEMP;
+	register16_t CNT, PER, CMP0, CMP1, CMP2;
+	register16_t PERBUF, CMP0BUF, CMP1BUF, CMP2BUF;
+} TCA_SINGLE_t;
+
+typedef struct _TCA_SPLIT_t
+{
+	register8_t CTRLA, CTRLB, CTRLC, CTRLD, CTRLECLR, CTRLESET;
+	register8_t INTCTRL;
+	Hal_host_flags INTFLAGS;
+	register8_t DBGCTRL;
+	register8_t LCNT, HCNT, LPER, HPER, LCMP0, HCMP0, LCMP1, HCMP1, LCMP2, HCMP2;
+} TCA_SPLIT_t;
+
+typedef union _TCA_t
+{
+	TCA_SINGLE_t SINGLE;
+	TCA_SPLIT_t SPLIT;
+} TCA_t;
+
+typedef struct _TCB_t
+{
+	register8_t CTRLA, CTRLB, EVCTRL, INTCTRL;
+	Hal_host_flags INTFLAGS;
+	register8_t STATUS, DBGCTRL, TEMP;
+	HAL_HOST_WORD( CNT );
+	HAL_HOST_WORD( CCMP );
+} TCB_t;
+
+typedef struct _USART_t
+{
+	register8_t RXDATAL, RXDATAH;
+	Hal_host_txdata TXDATAL;
+	register8_t TXDATAH;
+	register8_t STATUS, CTRLA, CTRLB, CTRLC;
+	register16_t BAUD;
+	register8_t CTRLD, DBGCTRL, EVCTRL, TXPLCTRL, RXPLCTRL;
+} USART_t;
+
+typedef struct _CLKCTRL_t
+{
+	register8_t MCLKCTRLA, MCLKCTRLB, MCLKLOCK, MCLKSTATUS;
+	register8_t OSC20MCTRLA, OSC20MCALIBA, OSC20MCALIBB;
+	register8_t OSC32KCTRLA, XOSC32KCTRLA;
+} CLKCTRL_t;
+
+typedef struct _PORTMUX_t
+{
+	register8_t EVSYSROUTEA, CCLROUTEA, USARTROUTEA, TWISPIROUTEA, TCAROUTEA, TCBROUTEA;
+} PORTMUX_t;
+
+typedef struct _ADC_t
+{
+	register8_t CTRLA, CTRLB, CTRLC, CTRLD, CTRLE, SAMPCTRL, MUXPOS, COMMAND;
+	register8_t EVCTRL, INTCTRL;
+	Hal_host_flags INTFLAGS;
+	register8_t DBGCTRL, TEMP;
+	register16_t RES, WINLT, WINHT;
+	register8_t CALIB;
+} ADC_t;
+
+typedef struct _VREF_t
+{
+	register8_t CTRLA, CTRLB;
+} VREF_t;
+
+typedef struct _CPUINT_t
+{
+	register8_t CTRLA, STATUS, LVL0PRI, LVL1VEC;
+} CPUINT_t;
+
+typedef struct _EVSYS_t
+{
+	register8_t STROBE;
+	register8_t CHANNEL0, CHANNEL1, CHANNEL2, CHANNEL3, CHANNEL4, CHANNEL5, CHANNEL6, CHANNEL7;
+	register8_t USERCCLLUT0A, USERCCLLUT0B, USERCCLLUT1A, USERCCLLUT1B;
+	register8_t USERCCLLUT2A, USERCCLLUT2B, USERCCLLUT3A, USERCCLLUT3B;
+	register8_t USERADC0;
+	register8_t USEREVOUTA, USEREVOUTB, USEREVOUTC, USEREVOUTD, USEREVOUTE, USEREVOUTF;
+	register8_t USERUSART0, USERUSART1, USERUSART2, USERUSART3;
+	register8_t USERTCA0, USERTCB0, USERTCB1, USERTCB2, USERTCB3;
+} EVSYS_t;
+
+typedef uint8_t CLKCTRL_CLKSEL_t;
+typedef uint8_t CLKCTRL_PDIV_t;
+
+/**********************************************************************************
+**	BIT FIELDS
+**********************************************************************************/
+
+	///--------------------------------------------------------------------------
+	///	CPU
+	///--------------------------------------------------------------------------
+
+#define CPU_I_bp						7
+#define CPU_I_bm						0x80
+#define CCP_SPM_gc						0x9D
+#define CCP_IOREG_gc					0xD8
+
+	///--------------------------------------------------------------------------
+	///	CLKCTRL
+	///--------------------------------------------------------------------------
+
+#define CLKCTRL_CLKSEL_gm				0x03
+#define CLKCTRL_CLKSEL_gp				0
+#define CLKCTRL_CLKSEL_OSC20M_gc		0x00
+#define CLKCTRL_CLKSEL_OSCULP32K_gc		0x01
+#define CLKCTRL_CLKSEL_XOSC32K_gc		0x02
+#define CLKCTRL_CLKSEL_EXTCLK_gc		0x03
+#define CLKCTRL_CLKOUT_bp				7
+#define CLKCTRL_CLKOUT_bm				0x80
+#define CLKCTRL_PEN_bp					0
+#define CLKCTRL_PEN_bm					0x01
+#define CLKCTRL_PDIV_gm					0x1E
+#define CLKCTRL_PDIV_gp					1
+#define CLKCTRL_PDIV_2X_gc				0x00
+#define CLKCTRL_PDIV_4X_gc				0x02
+#define CLKCTRL_LOCKEN_bp				0
+#define CLKCTRL_LOCKEN_bm				0x01
+#define CLKCTRL_RUNSTDBY_bp				1
+#define CLKCTRL_RUNSTDBY_bm				0x02
+#define CLKCTRL_LOCK_bp					7
+#define CLKCTRL_LOCK_bm					0x80
+
+	///--------------------------------------------------------------------------
+	///	PORT
+	///--------------------------------------------------------------------------
+
+#define PORT_ISC_gm						0x07
+#define PORT_ISC_INTDISABLE_gc			0x00
+#define PORT_ISC_BOTHEDGES_gc			0x01
+#define PORT_ISC_RISING_gc				0x02
+#define PORT_ISC_FALLING_gc				0x03
+#define PORT_ISC_INPUT_DISABLE_gc		0x04
+#define PORT_ISC_LEVEL_gc				0x05
+#define PORT_PULLUPEN_bp				3
+#define PORT_PULLUPEN_bm				0x08
+#define PORT_INVEN_bp					7
+#define PORT_INVEN_bm					0x80
+
+	///--------------------------------------------------------------------------
+	///	PORTMUX
+	///--------------------------------------------------------------------------
+
+#define PORTMUX_USART0_gm				0x03
+#define PORTMUX_USART0_DEFAULT_gc		0x00
+#define PORTMUX_USART0_ALT1_gc			0x01
+#define PORTMUX_USART0_NONE_gc			0x03
+#define PORTMUX_USART1_gm				0x0C
+#define PORTMUX_USART1_DEFAULT_gc		0x00
+#define PORTMUX_USART1_ALT1_gc			0x04
+#define PORTMUX_USART1_NONE_gc			0x0C
+#define PORTMUX_USART2_gm				0x30
+#define PORTMUX_USART2_DEFAULT_gc		0x00
+#define PORTMUX_USART2_ALT1_gc			0x10
+#define PORTMUX_USART2_NONE_gc			0x30
+#define PORTMUX_USART3_gm				0xC0
+#define PORTMUX_USART3_DEFAULT_gc		0x00
+#define PORTMUX_USART3_ALT1_gc			0x40
+#define PORTMUX_USART3_NONE_gc			0xC0
+#define PORTMUX_TCB0_bp					0
+#define PORTMUX_TCB1_bp					1
+#define PORTMUX_TCB2_bp					2
+#define PORTMUX_TCB3_bp					3
+
+	///--------------------------------------------------------------------------
+	///	RTC
+	///--------------------------------------------------------------------------
+
+#define RTC_RTCEN_bp					0
+#define RTC_RUNSTDBY_bp					7
+#define RTC_PRESCALER_gm				0x78
+#define RTC_PRESCALER_DIV1_gc			0x00
+#define RTC_PRESCALER_DIV2_gc			0x08
+#define RTC_PRESCALER_DIV4_gc			0x10
+#define RTC_PRESCALER_DIV8_gc			0x18
+#define RTC_PRESCALER_DIV16_gc			0x20
+#define RTC_PRESCALER_DIV32_gc			0x28
+#define RTC_PRESCALER_DIV64_gc			0x30
+#define RTC_PRESCALER_DIV128_gc			0x38
+#define RTC_PRESCALER_DIV256_gc			0x40
+#define RTC_PRESCALER_DIV512_gc			0x48
+#define RTC_PRESCALER_DIV1024_gc		0x50
+#define RTC_PRESCALER_DIV2048_gc		0x58
+#define RTC_PRESCALER_DIV4096_gc		0x60
+#define RTC_PRESCALER_DIV8192_gc		0x68
+#define RTC_PRESCALER_DIV16384_gc		0x70
+#define RTC_PRESCALER_DIV32768_gc		0x78
+#define RTC_PERBUSY_bp					2
+#define RTC_OVF_bp						0
+#define RTC_CMP_bp						1
+#define RTC_DBGRUN_bp					0
+#define RTC_CLKSEL_gm					0x03
+#define RTC_CLKSEL_INT32K_gc			0x00
+#define RTC_CLKSEL_INT1K_gc				0x01
+#define RTC_CLKSEL_TOSC32K_gc			0x02
+#define RTC_CLKSEL_EXTCLK_gc			0x03
+#define RTC_PITEN_bp					0
+#define RTC_PERIOD_gm					0x78
+#define RTC_PERIOD_OFF_gc				0x00
+#define RTC_PERIOD_CYC4_gc				0x08
+#define RTC_PERIOD_CYC8_gc				0x10
+#define RTC_PERIOD_CYC16_gc				0x18
+#define RTC_PERIOD_CYC32_gc				0x20
+#define RTC_PERIOD_CYC64_gc				0x28
+#define RTC_PERIOD_CYC128_gc			0x30
+#define RTC_PERIOD_CYC256_gc			0x38
+#define RTC_PERIOD_CYC512_gc			0x40
+#define RTC_PERIOD_CYC1024_gc			0x48
+#define RTC_PERIOD_CYC2048_gc			0x50
+#define RTC_PERIOD_CYC4096_gc			0x58
+#define RTC_PERIOD_CYC8192_gc			0x60
+#define RTC_PERIOD_CYC16384_gc			0x68
+#define RTC_PERIOD_CYC32768_gc			0x70
+#define RTC_PI_bp						0
+
+	///--------------------------------------------------------------------------
+	///	TCA
+	///--------------------------------------------------------------------------
+
+#define TCA_SINGLE_ENABLE_bp			0
+#define TCA_SINGLE_CLKSEL_gm			0x0E
+#define TCA_SINGLE_CLKSEL_DIV1_gc		0x00
+#define TCA_SINGLE_CLKSEL_DIV2_gc		0x02
+#define TCA_SINGLE_CLKSEL_DIV4_gc		0x04
+#define TCA_SINGLE_CLKSEL_DIV8_gc		0x06
+#define TCA_SINGLE_CLKSEL_DIV16_gc		0x08
+#define TCA_SINGLE_CLKSEL_DIV64_gc		0x0A
+#define TCA_SINGLE_CLKSEL_DIV256_gc		0x0C
+#define TCA_SINGLE_CLKSEL_DIV1024_gc	0x0E
+#define TCA_SINGLE_WGMODE_gm			0x07
+#define TCA_SINGLE_WGMODE_NORMAL_gc		0x00
+#define TCA_SINGLE_WGMODE_FRQ_gc		0x01
+#define TCA_SINGLE_WGMODE_SINGLESLOPE_gc	0x03
+#define TCA_SINGLE_CMP0EN_bp			4
+#define TCA_SINGLE_CMP1EN_bp			5
+#define TCA_SINGLE_CMP2EN_bp			6
+#define TCA_SINGLE_SPLITM_bp			0
+#define TCA_SINGLE_OVF_bp				0
+#define TCA_SINGLE_OVF_bm				0x01
+#define TCA_SINGLE_CMP0_bp				4
+#define TCA_SINGLE_CMP1_bp				5
+#define TCA_SINGLE_CMP2_bp				6
+#define TCA_SINGLE_DBGRUN_bp			0
+
+	///--------------------------------------------------------------------------
+	///	TCB
+	///--------------------------------------------------------------------------
+
+#define TCB_ENABLE_bp					0
+#define TCB_CLKSEL_gm					0x06
+#define TCB_CLKSEL_CLKDIV1_gc			0x00
+#define TCB_CLKSEL_CLKDIV2_gc			0x02
+#define TCB_CLKSEL_CLKTCA_gc			0x04
+#define TCB_SYNCUPD_bp					4
+#define TCB_RUNSTDBY_bp					6
+#define TCB_CNTMODE_gm					0x07
+#define TCB_CNTMODE_INT_gc				0x00
+#define TCB_CNTMODE_TIMEOUT_gc			0x01
+#define TCB_CNTMODE_CAPT_gc				0x02
+#define TCB_CNTMODE_FRQ_gc				0x03
+#define TCB_CNTMODE_PW_gc				0x04
+#define TCB_CNTMODE_FRQPW_gc			0x05
+#define TCB_CNTMODE_SINGLE_gc			0x06
+#define TCB_CNTMODE_PWM8_gc				0x07
+#define TCB_CCMPEN_bp					4
+#define TCB_CCMPINIT_bp					5
+#define TCB_ASYNC_bp					6
+#define TCB_CAPTEI_bp					0
+#define TCB_EDGE_bp						4
+#define TCB_FILTER_bp					6
+#define TCB_CAPT_bp						0
+#define TCB_RUN_bp						0
+#define TCB_DBGRUN_bp					0
+
+	///--------------------------------------------------------------------------
+	///	USART
+	///--------------------------------------------------------------------------
+
+#define USART_RXCIF_bp					7
+#define USART_TXCIF_bp					6
+#define USART_DREIF_bp					5
+#define USART_RXCIE_bp					7
+#define USART_TXCIE_bp					6
+#define USART_DREIE_bp					5
+#define USART_RXSIE_bp					4
+#define USART_LBME_bp					3
+#define USART_ABEIE_bp					2
+#define USART_RS485_gm					0x03
+#define USART_RS485_OFF_gc				0x00
+#define USART_RS485_EXT_gc				0x01
+#define USART_RS485_INT_gc				0x02
+#define USART_RXEN_bp					7
+#define USART_TXEN_bp					6
+#define USART_SFDEN_bp					4
+#define USART_ODME_bp					3
+#define USART_RXMODE_gm					0x06
+#define USART_RXMODE_NORMAL_gc			0x00
+#define USART_RXMODE_CLK2X_gc			0x02
+#define USART_RXMODE_GENAUTO_gc			0x04
+#define USART_RXMODE_LINAUTO_gc			0x06
+#define USART_MPCM_bp					0
+#define USART_CMODE_gm					0xC0
+#define USART_CMODE_ASYNCHRONOUS_gc		0x00
+#define USART_CMODE_SYNCHRONOUS_gc		0x40
+#define USART_CMODE_IRCOM_gc			0x80
+#define USART_CMODE_MSPI_gc				0xC0
+#define USART_PMODE_gm					0x30
+#define USART_PMODE_DISABLED_gc			0x00
+#define USART_PMODE_EVEN_gc				0x20
+#define USART_PMODE_ODD_gc				0x30
+#define USART_SBMODE_bp					3
+#define USART_CHSIZE_gm					0x07
+#define USART_CHSIZE_5BIT_gc			0x00
+#define USART_CHSIZE_6BIT_gc			0x01
+#define USART_CHSIZE_7BIT_gc			0x02
+#define USART_CHSIZE_8BIT_gc			0x03
+#define USART_CHSIZE_9BITL_gc			0x06
+#define USART_CHSIZE_9BITH_gc			0x07
+#define USART_UDORD_bp					2
+#define USART_UCPHA_bp					1
+#define USART_DBGRUN_bp					0
+#define USART_IREI_bp					0
+
+	///--------------------------------------------------------------------------
+	///	ADC
+	///--------------------------------------------------------------------------
+
+#define ADC_ENABLE_bp					0
+#define ADC_FREERUN_bp					1
+#define ADC_RESSEL_gm					0x04
+#define ADC_RESSEL_10BIT_gc				0x00
+#define ADC_RESSEL_8BIT_gc				0x04
+#define ADC_SAMPNUM_gm					0x07
+#define ADC_SAMPNUM_ACC1_gc				0x00
+#define ADC_PRESC_gm					0x07
+#define ADC_PRESC_DIV2_gc				0x00
+#define ADC_PRESC_DIV4_gc				0x01
+#define ADC_PRESC_DIV8_gc				0x02
+#define ADC_PRESC_DIV16_gc				0x03
+#define ADC_REFSEL_gm					0x30
+#define ADC_REFSEL_INTREF_gc			0x00
+#define ADC_REFSEL_VDDREF_gc			0x10
+#define ADC_SAMPCAP_bp					6
+#define ADC_INITDLY_gm					0xE0
+#define ADC_INITDLY_DLY0_gc				0x00
+#define ADC_INITDLY_DLY16_gc			0x20
+#define ADC_INITDLY_DLY32_gc			0x40
+#define ADC_INITDLY_DLY64_gc			0x60
+#define ADC_SAMPDLY_gm					0x0F
+#define ADC_SAMPDLY_gp					0
+#define ADC_MUXPOS_AIN0_gc				0x00
+#define ADC_STARTEI_bp					0
+#define ADC_RESRDY_bp					0
+#define ADC_RESRDY_bm					0x01
+#define ADC_WCMP_bp						1
+
+	///--------------------------------------------------------------------------
+	///	VREF
+	///--------------------------------------------------------------------------
+
+#define VREF_ADC0REFSEL_gm				0x70
+#define VREF_ADC0REFSEL_0V55_gc			0x00
+#define VREF_ADC0REFSEL_1V1_gc			0x10
+#define VREF_ADC0REFSEL_2V5_gc			0x20
+#define VREF_ADC0REFSEL_4V34_gc			0x30
+#define VREF_ADC0REFSEL_1V5_gc			0x40
+
+	///--------------------------------------------------------------------------
+	///	EVSYS
+	///--------------------------------------------------------------------------
+
+#define EVSYS_CHANNEL_OFF_gc			0x00
+#define EVSYS_CHANNEL_CHANNEL0_gc		0x01
+#define EVSYS_GENERATOR_OFF_gc			0x00
+#define EVSYS_GENERATOR_TCA0_OVF_LUNF_gc	0x80
+#define EVSYS_GENERATOR_TCB0_CAPT_gc	0xA0
+
+	///--------------------------------------------------------------------------
+	///	INTERRUPT VECTORS
+	///--------------------------------------------------------------------------
+
+#define TCA0_OVF_vect_num				7
+
+/**********************************************************************************
+**	MACROS
+**********************************************************************************/
+
+//An ISR is a C function with the name of its vector. The emulator calls it
+#define ISR( vector )	\
+	extern "C" void vector( void ); extern "C" void vector( void )
+
+/**********************************************************************************
+**	PROTOTYPE: GLOBAL VARIABILES
+**********************************************************************************/
+
+	///--------------------------------------------------------------------------
+	///	REGISTERS
+	///--------------------------------------------------------------------------
+
+extern register8_t SREG;
+extern register8_t CCP;
+extern PORT_t PORTA, PORTB, PORTC, PORTD, PORTE, PORTF;
+//Ports are macros in avr-libc. at4809_port.h tests them
+#define PORTA	PORTA
+#define PORTB	PORTB
+#define PORTC	PORTC
+#define PORTD	PORTD
+#define PORTE	PORTE
+#define PORTF	PORTF
+extern RTC_t RTC;
+extern TCA_t TCA0;
+extern TCB_t TCB0, TCB1, TCB2, TCB3;
+extern USART_t USART0, USART1, USART2, USART3;
+extern CLKCTRL_t CLKCTRL;
+extern PORTMUX_t PORTMUX;
+extern ADC_t ADC0;
+extern VREF_t VREF;
+extern CPUINT_t CPUINT;
+extern EVSYS_t EVSYS;
+
+/**********************************************************************************
+**	PROTOTYPE: FUNCTIONS
+**********************************************************************************/
+
+	///--------------------------------------------------------------------------
+	///	AVR-LIBC
+	///--------------------------------------------------------------------------
+
+//Disable interrupts. Clear the I bit of SREG
+extern void cli( void );
+//Enable interrupts. Set the I bit of SREG
+extern void sei( void );
+//Busy wait. Advances the simulated time
+extern void _delay_ms( double ms );
+extern void _delay_us( double us );
+
+	///--------------------------------------------------------------------------
+	///	EMULATOR
+	///--------------------------------------------------------------------------
+
+//Advance the simulated time by one main loop iteration
+extern void hal_host_poll( void );
+//Advance the simulated time by a number of CPU clocks and serve the peripherals
+extern void hal_host_advance( uint32_t clk );
+//Simulated time. CPU clocks since reset
+extern uint64_t hal_host_clk( void );
+//CPU clocks per count of TCA0
+extern uint16_t hal_host_tca_div( void );
+//Queue a byte on the RX line of USART3. false = OK | true = line buffer full
+extern bool hal_host_uart_rx( uint8_t data );
+//Queue a byte on the RX line of USART3 that is received at a given time. false = OK | true = line buffer full
+extern bool hal_host_uart_rx_at( uint8_t data, uint64_t clk );
+//Bytes still on the RX line of USART3
+extern uint16_t hal_host_uart_rx_pending( void );
+//Time the stop bit of the last byte received by USART3 ended
+extern uint64_t hal_host_uart_rx_clk( void );
+//CPU clocks of one UART frame at the baud rate in use
+extern uint32_t hal_host_uart_frame_clk( void );
+//Change the input of a port. A pin change interrupt is raised when enabled
+extern void hal_host_set_port_in( PORT_t &port, uint8_t value );
+//Hook that provides the ADC sample of a MUXPOS channel. 10b
+extern void hal_host_set_adc_hook( uint16_t (*hook)( uint8_t muxpos ) );
+//Hook that receives the bytes sent by USART3
+extern void hal_host_set_tx_hook( void (*hook)( uint8_t data ) );
+//Hook called when a byte of the RX line reaches USART3, before the RX data register is written
+extern void hal_host_set_rx_hook( void (*hook)( uint8_t data ) );
+//Baud rate of the simulated line. 0 = the one configured in USART3
+extern void hal_host_set_uart_baud( uint32_t baud );
+//Hook called at each advance of the simulated time, after the peripherals are served
+extern void hal_host_set_model_hook( void (*hook)( void ) );
+//Stop the simulation at a given time. The hook is called, then the process exits
+extern void hal_host_set_stop( uint64_t clk, void (*hook)( void ) );
+//Measure the host time spent in the TCA0 overflow ISR. Statistics are cleared when enabled
+extern void hal_host_set_tick_profile( bool f_enable );
+//Number of TCA0 overflow ISRs measured, their total and maximum host time [ns]
+extern void hal_host_get_tick_profile( uint32_t &cnt, uint64_t &ns_sum, uint64_t &ns_max );
+
+#else
+    #warning "Multiple inclusion of hader file"
+#endif
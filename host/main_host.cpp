@@ -0,0 +1,196 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	HOST RUNNER
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:		2019-11-18
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Run the firmware on the host for a given simulated time.
+**	Bytes read from stdin are sent to the UART of the firmware, the answers go to stdout.
+**	ob_host [-t <ms>] [-n] [-p] [-r <capture>]
+**		-t	simulated time in milliseconds. Default 1000
+**		-n	newline in the input is the command terminator '\0'
+**		-p	connect the simulated motors and encoders
+**		-r	record the session in a capture file, see host/uart_capture. ob_replay runs it again
+**	Answers are terminated by '\0', printed as newline.
+**	EXAMPLE: printf 'P\nF\n' | ob_host -n -t 100
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "global.h"
+#include "host/sim_plant.h"
+#include "host/uart_capture.h"
+
+/****************************************************************************
+**	DEFINES
+****************************************************************************/
+
+//Default simulated time [ms]
+#define HOST_DEFAULT_MS		1000
+
+/****************************************************************************
+**	PROTOTYPES
+****************************************************************************/
+
+//Firmware entry point. main() of the firmware is renamed by the build
+extern int firmware_main( void );
+
+/****************************************************************************
+**	FUNCTIONS
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Function
+//!	host_tx | uint8_t
+/***************************************************************************/
+//! @param data | byte sent by the firmware
+//! @return void
+/***************************************************************************/
+
+static void host_tx( uint8_t data )
+{
+	uart_capture_tx( data );
+	putchar( (data == '\0')?('\n'):(data) );
+
+	return;
+}	//end function: host_tx | uint8_t
+
+/***************************************************************************/
+//!	@brief Function
+//!	host_stop | void
+/***************************************************************************/
+//! @return void
+/***************************************************************************/
+
+static void host_stop( void )
+{
+	uart_capture_close();
+	fflush( stdout );
+
+	return;
+}	//end function: host_stop | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	main | int, char **
+/***************************************************************************/
+//! @return int | 0 = OK | 1 = bad arguments | 2 = input too long
+/***************************************************************************/
+
+int main( int argc, char *argv[] )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Simulated time [ms]
+	uint32_t ms = HOST_DEFAULT_MS;
+	//true = newline is the command terminator
+	bool f_newline = false;
+	//true = simulated plant
+	bool f_plant = false;
+	//Capture file. 0 = don't record
+	const char *capture = 0;
+	//Byte from stdin
+	int c;
+	//counter
+	int t;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//For: each argument
+	for (t = 1;t < argc;t++)
+	{
+		//if: simulated time
+		if ((strcmp( argv[t], "-t" ) == 0) && (t +1 < argc))
+		{
+			ms = (uint32_t)strtoul( argv[++t], 0, 10 );
+		}
+		//if: newline terminator
+		else if (strcmp( argv[t], "-n" ) == 0)
+		{
+			f_newline = true;
+		}
+		//if: simulated plant
+		else if (strcmp( argv[t], "-p" ) == 0)
+		{
+			f_plant = true;
+		}
+		//if: record
+		else if ((strcmp( argv[t], "-r" ) == 0) && (t +1 < argc))
+		{
+			capture = argv[++t];
+		}
+		//if: unknown
+		else
+		{
+			fprintf( stderr, "usage: %s [-t <ms>] [-n] [-p] [-r <capture>]\n", argv[0] );
+			return 1;
+		}
+	}
+	//if: can't record
+	if ((capture != 0) && (uart_capture_open( capture, 0, f_plant ) == true))
+	{
+		return 1;
+	}
+
+	//While: input
+	while ((c = getchar()) != EOF)
+	{
+		//if: newline is the terminator
+		if ((f_newline == true) && (c == '\n'))
+		{
+			c = '\0';
+		}
+		//if: line buffer full
+		if (hal_host_uart_rx( (uint8_t)c ) == true)
+		{
+			fprintf( stderr, "input longer than %d bytes\n", HAL_HOST_RX_SIZE );
+			return 2;
+		}
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//if: motors and encoders
+	if (f_plant == true)
+	{
+		sim_plant_init();
+	}
+	hal_host_set_tx_hook( &host_tx );
+	hal_host_set_rx_hook( &uart_capture_rx );
+	hal_host_set_stop( (uint64_t)ms *(F_CPU /1000), &host_stop );
+	//Never returns. The stop hook ends the simulation
+	firmware_main();
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return 0;
+}	//end function: main | int, char **
@@ -0,0 +1,388 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	MOTOR PLANT
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:		2019-11-18
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Brushed DC motor with gearbox, wheel and quadrature encoder, for the host build.
+**	Current is integrated with implicit Euler, speed and position with explicit Euler.
+**	Coulomb friction can stop the motor but never reverse it.
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include <math.h>
+#include "global.h"
+//Class Header
+#include "motor_plant.h"
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+namespace OrangeBot
+{
+
+/****************************************************************************
+**	GLOBAL VARIABILES
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	CONSTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Constructor
+//!	Motor_plant | void
+/***************************************************************************/
+// @param
+//! @return no return
+//!	@details
+//! Empty constructor. 12V gear motor, 64 edges per turn of the motor, 30:1 gearbox
+/***************************************************************************/
+
+Motor_plant::Motor_plant( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//About 6A of stall current and 40 rad/s of no load speed at 12V
+	this -> g_param.r = 2.0;
+	this -> g_param.l = 1.5e-3;
+	this -> g_param.k = 0.3;
+	//About 25ms of mechanical time constant
+	this -> g_param.j = 1.0e-3;
+	this -> g_param.b = 2.0e-3;
+	this -> g_param.tc = 0.02;
+	this -> g_param.cpr = 64.0 *30.0;
+	//No load
+	this -> g_load = 0.0;
+	//At rest
+	this -> reset();
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end constructor:
+
+/****************************************************************************
+*****************************************************************************
+**	DESTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Destructor
+//!	Motor_plant | void
+/***************************************************************************/
+// @param
+//! @return no return
+//!	@details
+//! Empty destructor
+/***************************************************************************/
+
+Motor_plant::~Motor_plant( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end destructor:
+
+/****************************************************************************
+*****************************************************************************
+**	OPERATORS
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	SETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	set_param | const Motor_plant_param &
+/***************************************************************************/
+//! @param param | parameters of the motor
+//! @return false: OK | true: fail
+//!	@details
+//! State of the motor is not changed
+/***************************************************************************/
+
+bool Motor_plant::set_param( const Motor_plant_param &param )
+{
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//if: parameters that divide or can't be negative
+	if ((param.r <= 0.0) || (param.l <= 0.0) || (param.j <= 0.0) || (param.cpr <= 0.0) || (param.k < 0.0) || (param.b < 0.0) || (param.tc < 0.0))
+	{
+		//Trace Return
+		DRETURN_ARG("ERR: bad parameters\n");
+		return true;	//fail
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	this -> g_param = param;
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return false;	//OK
+}	//end method: set_param | const Motor_plant_param &
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	set_load | double
+/***************************************************************************/
+//! @param load | load torque. Positive opposes a positive speed [Nm]
+//! @return no return
+/***************************************************************************/
+
+void Motor_plant::set_load( double load )
+{
+	this -> g_load = load;
+
+	return;	//OK
+}	//end method: set_load | double
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	reset | void
+/***************************************************************************/
+//! @return no return
+/***************************************************************************/
+
+void Motor_plant::reset( void )
+{
+	this -> g_i = 0.0;
+	this -> g_w = 0.0;
+	this -> g_theta = 0.0;
+
+	return;	//OK
+}	//end method: reset | void
+
+/****************************************************************************
+*****************************************************************************
+**	GETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	get_current | void
+/***************************************************************************/
+//! @return double | armature current [A]
+/***************************************************************************/
+
+double Motor_plant::get_current( void )
+{
+	return this -> g_i;
+}	//end method: get_current | void
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	get_speed | void
+/***************************************************************************/
+//! @return double | speed [rad/s]
+/***************************************************************************/
+
+double Motor_plant::get_speed( void )
+{
+	return this -> g_w;
+}	//end method: get_speed | void
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	get_count | void
+/***************************************************************************/
+//! @return int32_t | position [encoder edges]
+/***************************************************************************/
+
+int32_t Motor_plant::get_count( void )
+{
+	return (int32_t)floor( this -> g_theta *this -> g_param.cpr /(2.0 *M_PI) );
+}	//end method: get_count | void
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	get_param | void
+/***************************************************************************/
+//! @return const Motor_plant_param & | parameters of the motor
+/***************************************************************************/
+
+const Motor_plant_param &Motor_plant::get_param( void )
+{
+	return this -> g_param;
+}	//end method: get_param | void
+
+/****************************************************************************
+*****************************************************************************
+**	REFERENCES
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	TESTERS
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	exe | double, double
+/***************************************************************************/
+//! @param v | armature voltage [V]
+//! @param dt | step [s]
+//! @return no return
+/***************************************************************************/
+
+void Motor_plant::exe( double v, double dt )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Torque of the motor minus load and viscous friction [Nm]
+	double torque;
+	//Direction the Coulomb friction opposes
+	double dir;
+	//New speed [rad/s]
+	double w;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//if: no time
+	if (dt <= 0.0)
+	{
+		return;
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Electrical. Implicit in the current, the electrical time constant can be shorter than the step
+	this -> g_i = (this -> g_i *this -> g_param.l +dt *(v -this -> g_param.k *this -> g_w)) /(this -> g_param.l +this -> g_param.r *dt);
+	//Mechanical
+	torque = this -> g_param.k *this -> g_i -this -> g_load -this -> g_param.b *this -> g_w;
+	//if: at rest and the friction holds the motor
+	if ((fabs( this -> g_w ) < MOTOR_PLANT_STICTION_SPD) && (fabs( torque ) <= this -> g_param.tc))
+	{
+		w = 0.0;
+	}
+	//if: moving or breaking away
+	else
+	{
+		dir = (fabs( this -> g_w ) < MOTOR_PLANT_STICTION_SPD)?((torque > 0.0)?(1.0):(-1.0)):((this -> g_w > 0.0)?(1.0):(-1.0));
+		w = this -> g_w +dt *(torque -dir *this -> g_param.tc) /this -> g_param.j;
+		//if: friction would reverse the motor. It stops instead
+		if (w *dir < 0.0)
+		{
+			w = 0.0;
+		}
+	}
+	this -> g_w = w;
+	this -> g_theta += this -> g_w *dt;
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return;
+}	//end method: exe | double, double
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+} //End Namespace
@@ -0,0 +1,199 @@
+/**********************************************************************************
+**	ENVIROMENT VARIABILE
+**********************************************************************************/
+
+#ifndef MOTOR_PLANT_H_
+	#define MOTOR_PLANT_H_
+
+/**********************************************************************************
+**	GLOBAL INCLUDES
+**********************************************************************************/
+
+/**********************************************************************************
+**	DEFINES
+**********************************************************************************/
+
+//Below this speed a motor whose torque can't beat the friction stops [rad/s]
+#define MOTOR_PLANT_STICTION_SPD	1e-3
+
+/**********************************************************************************
+**	MACROS
+**********************************************************************************/
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+//! @namespace OrangeBot
+namespace OrangeBot
+{
+
+/**********************************************************************************
+**	TYPEDEFS
+**********************************************************************************/
+
+//Parameters of a DC motor. Gearbox included, seen from the wheel. SI units
+typedef struct _Motor_plant_param
+{
+	//Armature resistance [Ohm]
+	double r;
+	//Armature inductance [H]
+	double l;
+	//Torque constant [Nm/A], equal to the back EMF constant [V s/rad]
+	double k;
+	//Inertia of motor, gearbox, wheel and share of the platform [kg m^2]
+	double j;
+	//Viscous friction [Nm s/rad]
+	double b;
+	//Coulomb friction [Nm]
+	double tc;
+	//Encoder edges per revolution of the wheel. Four per line of a quadrature encoder
+	double cpr;
+} Motor_plant_param;
+
+/**********************************************************************************
+**	PROTOTYPE: STRUCTURES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: GLOBAL VARIABILES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: CLASS
+**********************************************************************************/
+
+/************************************************************************************/
+//! @class 		Motor_plant
+/************************************************************************************/
+//!	@author		Orso Eric
+//! @version	0.1 alpha
+//! @date		2019-11-18
+//! @brief		Simulated brushed DC motor with a quadrature encoder
+//! @details
+//!	Model of one wheel for the host build. The caller applies the armature voltage and advances time \n
+//! FEATURES:	\n
+//!		Electrical	\n
+//! L di/dt = V -R i -k w. Integrated implicitly, stable for any step \n
+//!		Mechanical	\n
+//! J dw/dt = k i -b w -tc sign(w) -load. A motor at rest stays there until its torque beats the Coulomb friction \n
+//!		Encoder	\n
+//! Position is given in encoder edges \n
+//! @pre		None
+//! @bug		None
+//! @warning	Step must be well below the mechanical time constant J R /k^2
+//! @copyright	License ?
+//! @todo		todo list
+/************************************************************************************/
+
+class Motor_plant
+{
+	//Visible to all
+	public:
+		//--------------------------------------------------------------------------
+		//	CONSTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//! Default constructor
+		Motor_plant( void );
+
+		//--------------------------------------------------------------------------
+		//	DESTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//!Default destructor
+		~Motor_plant( void );
+
+		//--------------------------------------------------------------------------
+		//	OPERATORS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	SETTERS
+		//--------------------------------------------------------------------------
+
+		//Set the parameters of the motor. false=OK
+		bool set_param( const Motor_plant_param &param );
+		//Load torque. Positive opposes a positive speed [Nm]
+		void set_load( double load );
+		//Motor at rest in position zero, no current
+		void reset( void );
+
+		//--------------------------------------------------------------------------
+		//	GETTERS
+		//--------------------------------------------------------------------------
+
+		//Armature current [A]
+		double get_current( void );
+		//Speed [rad/s]
+		double get_speed( void );
+		//Position [encoder edges]
+		int32_t get_count( void );
+		//Parameters
+		const Motor_plant_param &get_param( void );
+
+		//--------------------------------------------------------------------------
+		//	REFERENCES
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	TESTERS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC METHODS
+		//--------------------------------------------------------------------------
+
+		//Advance the motor by dt seconds with the armature voltage v
+		void exe( double v, double dt );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC STATIC METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC VARS
+		//--------------------------------------------------------------------------
+
+	//Visible to derived classes
+	protected:
+		//--------------------------------------------------------------------------
+		//	PROTECTED METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PROTECTED VARS
+		//--------------------------------------------------------------------------
+
+	//Visible only inside the class
+	private:
+		//--------------------------------------------------------------------------
+		//	PRIVATE METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PRIVATE VARS
+		//--------------------------------------------------------------------------
+
+		//Parameters
+		Motor_plant_param g_param;
+		//Load torque [Nm]
+		double g_load;
+		//Armature current [A]
+		double g_i;
+		//Speed [rad/s]
+		double g_w;
+		//Position [rad]
+		double g_theta;
+
+};	//End Class: Motor_plant
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
+
+#else
+    #warning "Multiple inclusion of hader file"
+#endif
@@ -0,0 +1,570 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	PTY LINK EMULATOR
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:		2019-11-18
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Run the host build of the firmware behind a pseudo terminal, in real time.
+**	A client opens the slave side like the /dev/ttyS* of the RPI.
+**	Line: bytes cross the simulated line one frame each, at the baud rate of USART3
+**	or the one given. Bytes the client writes faster than the line wait in the pty,
+**	like in the kernel buffer of a real serial port.
+**	Firmware: unmodified. Its 16 byte RX buffer drops the bytes that don't fit, the
+**	emulator counts them, and counts the bytes that reach USART3 before the previous one was read.
+**	Bit errors: each data bit of each direction is flipped with the given probability.
+**	ob_pty [-b <baud>] [-e <ber>] [-s <seed>] [-x <speed>] [-t <ms>] [-l <path>] [-r <capture>] [-n] [-p]
+**		-b	baud rate of the line. Default from USART3
+**		-e	bit error rate. Default 0
+**		-s	seed of the bit errors. Default 1
+**		-x	simulated time over real time. 0 = as fast as possible. Default 1
+**		-t	stop after a simulated time in milliseconds. Default run until SIGINT
+**		-l	symbolic link to the slave side, e.g. /tmp/ttyOB
+**		-r	record the session in a capture file, see host/uart_capture. ob_replay runs it again
+**		-n	newline is the command terminator '\0' in both directions, for a terminal
+**		-p	connect the simulated motors and encoders
+**	First line on stdout is the path of the slave side. At the end one JSON line with the
+**	statistics of the line. Latency and throughput of the commands are measured by the client.
+**	EXAMPLE: ob_pty -l /tmp/ttyOB -n & screen /tmp/ttyOB
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#define _XOPEN_SOURCE 600
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "global.h"
+#include "host/sim_plant.h"
+#include "host/uart_capture.h"
+
+/****************************************************************************
+**	DEFINES
+****************************************************************************/
+
+//Simulated time between two exchanges with the pty [CPU clocks]. 100us
+#define LINK_IO_CLK			(F_CPU /10000)
+//Bytes sent by the firmware and still on the line
+#define LINK_TX_SIZE		4096
+
+/****************************************************************************
+**	STRUCTURES
+****************************************************************************/
+
+//Byte on the TX line
+typedef struct _Link_byte
+{
+	uint8_t data;
+	//Time its stop bit is over [CPU clocks]
+	uint64_t clk;
+} Link_byte;
+
+//Statistics of one direction of the line
+typedef struct _Link_stat
+{
+	//Bytes that crossed the line
+	uint32_t bytes;
+	//Command terminators on the line
+	uint32_t frames;
+	//Bits flipped
+	uint32_t bit_err;
+	//Bytes lost before the line
+	uint32_t drop;
+} Link_stat;
+
+/****************************************************************************
+**	PROTOTYPES
+****************************************************************************/
+
+//Firmware entry point. main() of the firmware is renamed by the build
+extern int firmware_main( void );
+
+/****************************************************************************
+**	GLOBAL VARIABILES
+****************************************************************************/
+
+//Master side of the pty, and the slave kept open so the link survives the client
+static int g_master = -1;
+static int g_slave = -1;
+//Symbolic link to the slave. 0 = none
+static const char *g_link = 0;
+//Bit error rate
+static double g_ber = 0.0;
+//State of the generator of the bit errors
+static uint32_t g_rng = 1;
+//Simulated time over real time. 0 = as fast as possible
+static double g_speed = 1.0;
+//Real time at the start of the simulation [ns]
+static uint64_t g_wall0 = 0;
+//true = newline is the command terminator
+static bool g_f_newline = false;
+//Next exchange with the pty [CPU clocks]
+static uint64_t g_io_clk = 0;
+//Bytes on the TX line. Circular buffer
+static Link_byte g_tx_line[ LINK_TX_SIZE ];
+static uint16_t g_tx_head = 0;
+static uint16_t g_tx_num = 0;
+//Statistics. RX is toward the firmware
+static Link_stat g_rx_stat;
+static Link_stat g_tx_stat;
+//Bytes dropped by the 16 byte RX buffer of the firmware
+static uint32_t g_fw_drop = 0;
+//Bytes that reached USART3 before the previous one was read
+static uint32_t g_usart_ovf = 0;
+//true = SIGINT, SIGTERM or SIGHUP
+static volatile sig_atomic_t g_f_quit = 0;
+
+/****************************************************************************
+**	FUNCTIONS
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Function
+//!	link_ns | void
+/***************************************************************************/
+//! @return uint64_t | monotonic real time [ns]
+/***************************************************************************/
+
+static uint64_t link_ns( void )
+{
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return (uint64_t)ts.tv_sec *1000000000ULL +(uint64_t)ts.tv_nsec;
+}	//end function: link_ns | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	link_corrupt | uint8_t, Link_stat &
+/***************************************************************************/
+//! @param data | byte crossing the line
+//! @param stat | statistics of the direction
+//! @return uint8_t | byte as received
+//!	@details
+//! Each data bit is flipped with probability g_ber. Xorshift generator, same seed same errors
+/***************************************************************************/
+
+static uint8_t link_corrupt( uint8_t data, Link_stat &stat )
+{
+	//counter
+	uint8_t t;
+
+	//if: clean line
+	if (g_ber <= 0.0)
+	{
+		return data;
+	}
+	//For: each data bit
+	for (t = 0;t < 8;t++)
+	{
+		g_rng ^= g_rng << 13;
+		g_rng ^= g_rng >> 17;
+		g_rng ^= g_rng << 5;
+		//if: bit error
+		if ((double)g_rng /4294967296.0 < g_ber)
+		{
+			data ^= (uint8_t)(1 << t);
+			stat.bit_err++;
+		}
+	}
+
+	return data;
+}	//end function: link_corrupt | uint8_t, Link_stat &
+
+/***************************************************************************/
+//!	@brief Function
+//!	link_rx | uint8_t
+/***************************************************************************/
+//! @param data | byte reaching USART3
+//! @return void
+//!	@details
+//! RX hook of the HAL. The byte is lost if the RX ISR of the firmware can't store it
+/***************************************************************************/
+
+static void link_rx( uint8_t data )
+{
+	//if: previous byte still in the data register
+	if (IS_BIT_ONE( USART3.STATUS, USART_RXCIF_bp ))
+	{
+		g_usart_ovf++;
+	}
+	//if: RX buffer of the firmware full
+	else if (AT_BUF_NUMELEM( rpi_rx_buf ) >= (uint16_t)(rpi_rx_buf.size -1))
+	{
+		g_fw_drop++;
+	}
+	g_rx_stat.bytes++;
+	g_rx_stat.frames += (data == '\0')?(1):(0);
+	uart_capture_rx( data );
+
+	return;
+}	//end function: link_rx | uint8_t
+
+/***************************************************************************/
+//!	@brief Function
+//!	link_tx | uint8_t
+/***************************************************************************/
+//! @param data | byte written by the firmware in the TX data register
+//! @return void
+//!	@details
+//! TX hook of the HAL. The byte reaches the client at the end of its frame
+/***************************************************************************/
+
+static void link_tx( uint8_t data )
+{
+	uart_capture_tx( data );
+	//if: the client doesn't read
+	if (g_tx_num >= LINK_TX_SIZE)
+	{
+		g_tx_stat.drop++;
+		return;
+	}
+	g_tx_line[ (g_tx_head +g_tx_num) % LINK_TX_SIZE ].data = link_corrupt( data, g_tx_stat );
+	g_tx_line[ (g_tx_head +g_tx_num) % LINK_TX_SIZE ].clk = hal_host_clk() +hal_host_uart_frame_clk();
+	g_tx_num++;
+	g_tx_stat.bytes++;
+	g_tx_stat.frames += (data == '\0')?(1):(0);
+
+	return;
+}	//end function: link_tx | uint8_t
+
+/***************************************************************************/
+//!	@brief Function
+//!	link_report | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! Stop hook of the HAL. Statistics of the line on stdout
+/***************************************************************************/
+
+static void link_report( void )
+{
+	//Simulated time [s]
+	double sim_s;
+	//Seconds of line per byte
+	double frame_s;
+
+	uart_capture_close();
+	sim_s = (double)hal_host_clk() /F_CPU;
+	frame_s = (double)hal_host_uart_frame_clk() /F_CPU;
+	printf
+	(
+		"{\"sim_s\":%.3f,\"real_s\":%.3f,\"baud\":%.0f,"
+		"\"rx_bytes\":%u,\"rx_pending\":%u,\"rx_frames\":%u,\"rx_bit_err\":%u,\"rx_line_full\":%u,\"rx_fw_drop\":%u,\"rx_usart_ovf\":%u,\"rx_util\":%.3f,"
+		"\"tx_bytes\":%u,\"tx_frames\":%u,\"tx_bit_err\":%u,\"tx_drop\":%u,\"tx_util\":%.3f}\n",
+		sim_s, (double)(link_ns() -g_wall0) /1e9, HAL_HOST_UART_FRAME /frame_s,
+		g_rx_stat.bytes, hal_host_uart_rx_pending(), g_rx_stat.frames, g_rx_stat.bit_err, g_rx_stat.drop, g_fw_drop, g_usart_ovf, (sim_s > 0.0)?(g_rx_stat.bytes *frame_s /sim_s):(0.0),
+		g_tx_stat.bytes, g_tx_stat.frames, g_tx_stat.bit_err, g_tx_stat.drop, (sim_s > 0.0)?(g_tx_stat.bytes *frame_s /sim_s):(0.0)
+	);
+	fflush( stdout );
+	//if: symbolic link to remove
+	if (g_link != 0)
+	{
+		unlink( g_link );
+	}
+
+	return;
+}	//end function: link_report | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	link_step | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! Called at each step of the simulation. Every LINK_IO_CLK: bytes whose frame is over
+//!	go to the client, bytes of the client go on the RX line, then wait for the real time
+/***************************************************************************/
+
+static void link_step( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Bytes exchanged with the pty
+	uint8_t buf[256];
+	int num;
+	//Room on the RX line
+	uint16_t room;
+	//Real time the simulation should be at [ns]
+	uint64_t wall, now;
+	struct timespec ts;
+	//Byte
+	uint8_t data;
+	//counter
+	int t;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//if: interrupted
+	if (g_f_quit != 0)
+	{
+		link_report();
+		exit( 0 );
+	}
+	//if: not yet time to exchange
+	if (hal_host_clk() < g_io_clk)
+	{
+		return;
+	}
+	g_io_clk = hal_host_clk() +LINK_IO_CLK;
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+		//! TX line
+	//While: frames over
+	while ((g_tx_num > 0) && (g_tx_line[ g_tx_head ].clk <= hal_host_clk()))
+	{
+		data = g_tx_line[ g_tx_head ].data;
+		data = ((g_f_newline == true) && (data == '\0'))?('\n'):(data);
+		//if: pty full, the client doesn't read
+		if (write( g_master, &data, 1 ) != 1)
+		{
+			g_tx_stat.drop++;
+		}
+		g_tx_head = (g_tx_head +1) % LINK_TX_SIZE;
+		g_tx_num--;
+	}
+
+		//! RX line
+	//Bytes the line can still hold. The others wait in the pty
+	room = HAL_HOST_RX_SIZE -hal_host_uart_rx_pending();
+	room = (room > sizeof( buf ))?((uint16_t)sizeof( buf )):(room);
+	num = (room > 0)?((int)read( g_master, buf, room )):(0);
+	//For: each byte of the client
+	for (t = 0;t < num;t++)
+	{
+		data = ((g_f_newline == true) && (buf[t] == '\n'))?('\0'):(buf[t]);
+		//if: line full. Can't happen, room was checked
+		if (hal_host_uart_rx( link_corrupt( data, g_rx_stat ) ) == true)
+		{
+			g_rx_stat.drop++;
+		}
+	}
+
+		//! Real time
+	//if: paced
+	if (g_speed > 0.0)
+	{
+		wall = g_wall0 +(uint64_t)((double)hal_host_clk() *1e9 /F_CPU /g_speed);
+		now = link_ns();
+		//if: simulation ahead of the real time
+		if (wall > now)
+		{
+			ts.tv_sec = (time_t)((wall -now) /1000000000ULL);
+			ts.tv_nsec = (long)((wall -now) %1000000000ULL);
+			nanosleep( &ts, 0 );
+		}
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return;
+}	//end function: link_step | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	link_signal | int
+/***************************************************************************/
+//! @param sig | signal
+//! @return void
+/***************************************************************************/
+
+static void link_signal( int sig )
+{
+	(void)sig;
+	g_f_quit = 1;
+
+	return;
+}	//end function: link_signal | int
+
+/***************************************************************************/
+//!	@brief Function
+//!	link_open | void
+/***************************************************************************/
+//! @return bool | false = OK | true = fail
+//!	@details
+//! Raw pty. Master is non blocking, the slave stays open so a client can come and go
+/***************************************************************************/
+
+static bool link_open( void )
+{
+	//Configuration of the slave
+	struct termios tio;
+	//Name of the slave
+	const char *name;
+
+	g_master = posix_openpt( O_RDWR | O_NOCTTY );
+	//if: no pty
+	if ((g_master < 0) || (grantpt( g_master ) != 0) || (unlockpt( g_master ) != 0) || ((name = ptsname( g_master )) == 0))
+	{
+		perror( "pty" );
+		return true;	//fail
+	}
+	g_slave = open( name, O_RDWR | O_NOCTTY );
+	//if: slave can't be configured
+	if ((g_slave < 0) || (tcgetattr( g_slave, &tio ) != 0))
+	{
+		perror( name );
+		return true;	//fail
+	}
+	cfmakeraw( &tio );
+	tcsetattr( g_slave, TCSANOW, &tio );
+	fcntl( g_master, F_SETFL, fcntl( g_master, F_GETFL ) | O_NONBLOCK );
+	//if: symbolic link
+	if (g_link != 0)
+	{
+		unlink( g_link );
+		//if: can't link
+		if (symlink( name, g_link ) != 0)
+		{
+			perror( g_link );
+			return true;	//fail
+		}
+	}
+	printf( "%s\n", name );
+	fflush( stdout );
+
+	return false;	//OK
+}	//end function: link_open | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	main | int, char **
+/***************************************************************************/
+//! @return int | 0 = OK | 1 = bad arguments | 2 = no pty
+/***************************************************************************/
+
+int main( int argc, char *argv[] )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Baud rate of the line. 0 = from USART3
+	uint32_t baud = 0;
+	//Simulated time. 0 = until a signal [ms]
+	uint32_t ms = 0;
+	//true = simulated plant
+	bool f_plant = false;
+	//Capture file. 0 = don't record
+	const char *capture = 0;
+	//Option with a value
+	char opt;
+	//counter
+	int t;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//For: each argument
+	for (t = 1;t < argc;t++)
+	{
+		//if: option with a value
+		if ((argv[t][0] == '-') && (strchr( "bestxlr", argv[t][1] ) != 0) && (argv[t][2] == '\0') && (t +1 < argc))
+		{
+			opt = argv[t++][1];
+			switch (opt)
+			{
+				case 'b': baud = (uint32_t)strtoul( argv[t], 0, 10 ); break;
+				case 'e': g_ber = strtod( argv[t], 0 ); break;
+				case 's': g_rng = (uint32_t)strtoul( argv[t], 0, 10 ); break;
+				case 't': ms = (uint32_t)strtoul( argv[t], 0, 10 ); break;
+				case 'x': g_speed = strtod( argv[t], 0 ); break;
+				case 'r': capture = argv[t]; break;
+				default: g_link = argv[t]; break;
+			}
+		}
+		//if: newline terminator
+		else if (strcmp( argv[t], "-n" ) == 0)
+		{
+			g_f_newline = true;
+		}
+		//if: simulated plant
+		else if (strcmp( argv[t], "-p" ) == 0)
+		{
+			f_plant = true;
+		}
+		//if: unknown
+		else
+		{
+			fprintf( stderr, "usage: %s [-b <baud>] [-e <ber>] [-s <seed>] [-x <speed>] [-t <ms>] [-l <path>] [-r <capture>] [-n] [-p]\n", argv[0] );
+			return 1;
+		}
+	}
+	//if: can't record
+	if ((capture != 0) && (uart_capture_open( capture, baud, f_plant ) == true))
+	{
+		return 1;
+	}
+	//Xorshift never leaves zero
+	g_rng = (g_rng == 0)?(1):(g_rng);
+	//if: no pty
+	if (link_open() == true)
+	{
+		return 2;
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	signal( SIGINT, &link_signal );
+	signal( SIGTERM, &link_signal );
+	signal( SIGHUP, &link_signal );
+	hal_host_set_uart_baud( baud );
+	hal_host_set_rx_hook( &link_rx );
+	hal_host_set_tx_hook( &link_tx );
+	//if: motors and encoders. The plant owns the model hook
+	if (f_plant == true)
+	{
+		sim_plant_init();
+		sim_plant_set_step_hook( &link_step );
+	}
+	else
+	{
+		hal_host_set_model_hook( &link_step );
+	}
+	hal_host_set_stop( (ms > 0)?((uint64_t)ms *(F_CPU /1000)):(UINT64_MAX), &link_report );
+	g_wall0 = link_ns();
+	//Never returns. The stop hook or a signal ends the simulation
+	firmware_main();
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return 0;
+}	//end function: main | int, char **
@@ -0,0 +1,296 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	REPLAY
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:		2019-11-18
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Run a recorded session of the RPI link again on the host build, in simulated time.
+**	Received bytes of the capture reach USART3 at the time they were recorded.
+**	Bytes sent by the firmware are compared with the capture: a change of the firmware
+**	that changes the answers or their timing shows up as mismatch or skew.
+**	The run is deterministic, two replays of the same capture give the same result.
+**	ob_replay [-o <capture>] <capture>
+**		-o	record the replay in a new capture, to compare with diff
+**	One JSON line on stdout:
+**		sim_s				simulated time, until the end of the capture
+**		ticks				system ticks of the firmware
+**		rx_bytes			bytes fed to USART3
+**		rx_fw_drop			bytes lost because the RX buffer of the firmware was full
+**		rx_usart_ovf		bytes that reached USART3 before the previous one was read
+**		tx_expected			bytes sent in the capture
+**		tx_bytes			bytes sent in the replay
+**		tx_mismatch			bytes of the replay that differ from the capture
+**		tx_first_mismatch_ms time of the first difference. -1 = none
+**		tx_max_skew_us		largest shift in time of a sent byte from the capture
+**		parse_lat_avg_us	time a byte waits in the RX buffer before the parser takes it
+**		parse_lat_max_us
+**		tick_ns_avg			host time spent in the system tick ISR
+**		tick_ns_max
+**	EXAMPLE:
+**		printf 'F\nP\n' | ob_host -n -t 100 -r session.cap
+**		ob_replay session.cap
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "global.h"
+#include "host/sim_plant.h"
+#include "host/uart_capture.h"
+
+/****************************************************************************
+**	DEFINES
+****************************************************************************/
+
+//Bytes waiting in the RX buffer of the firmware. Larger than RPI_RX_BUF_SIZE
+#define REPLAY_WAIT_SIZE	32
+
+/****************************************************************************
+**	PROTOTYPES
+****************************************************************************/
+
+//Firmware entry point. main() of the firmware is renamed by the build
+extern int firmware_main( void );
+
+/****************************************************************************
+**	GLOBAL VARIABILES
+****************************************************************************/
+
+//Time each byte in the RX buffer of the firmware was received [CPU clocks]
+static uint64_t g_wait_clk[ REPLAY_WAIT_SIZE ];
+static uint8_t g_wait_head = 0;
+static uint8_t g_wait_num = 0;
+//Time bytes waited in the RX buffer of the firmware [CPU clocks]
+static uint64_t g_lat_sum = 0;
+static uint64_t g_lat_max = 0;
+static uint32_t g_lat_cnt = 0;
+//Bytes lost by the firmware
+static uint32_t g_fw_drop = 0;
+static uint32_t g_usart_ovf = 0;
+
+/****************************************************************************
+**	FUNCTIONS
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Function
+//!	replay_rx | uint8_t
+/***************************************************************************/
+//! @param data | byte reaching USART3
+//! @return void
+//!	@details
+//! RX hook of the HAL. Bytes the RX ISR of the firmware will store start waiting for the parser
+/***************************************************************************/
+
+static void replay_rx( uint8_t data )
+{
+	uart_capture_rx( data );
+	//if: previous byte still in the data register
+	if (IS_BIT_ONE( USART3.STATUS, USART_RXCIF_bp ))
+	{
+		g_usart_ovf++;
+	}
+	//if: RX buffer of the firmware full
+	else if (AT_BUF_NUMELEM( rpi_rx_buf ) >= (uint16_t)(rpi_rx_buf.size -1))
+	{
+		g_fw_drop++;
+	}
+	//if: stored
+	else if (g_wait_num < REPLAY_WAIT_SIZE)
+	{
+		g_wait_clk[ (g_wait_head +g_wait_num) % REPLAY_WAIT_SIZE ] = hal_host_clk();
+		g_wait_num++;
+	}
+
+	return;
+}	//end function: replay_rx | uint8_t
+
+/***************************************************************************/
+//!	@brief Function
+//!	replay_tx | uint8_t
+/***************************************************************************/
+//! @param data | byte written by the firmware in the TX data register
+//! @return void
+/***************************************************************************/
+
+static void replay_tx( uint8_t data )
+{
+	uart_capture_tx( data );
+	uart_replay_tx( data );
+
+	return;
+}	//end function: replay_tx | uint8_t
+
+/***************************************************************************/
+//!	@brief Function
+//!	replay_step | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! Model hook of the HAL, after the ISR. Bytes the parser took out of the RX buffer stop waiting
+/***************************************************************************/
+
+static void replay_step( void )
+{
+	//Time the byte waited [CPU clocks]
+	uint64_t lat;
+
+	uart_replay_step();
+	//While: the parser took bytes
+	while (g_wait_num > AT_BUF_NUMELEM( rpi_rx_buf ))
+	{
+		lat = hal_host_clk() -g_wait_clk[ g_wait_head ];
+		g_lat_sum += lat;
+		g_lat_max = (lat > g_lat_max)?(lat):(g_lat_max);
+		g_lat_cnt++;
+		g_wait_head = (g_wait_head +1) % REPLAY_WAIT_SIZE;
+		g_wait_num--;
+	}
+
+	return;
+}	//end function: replay_step | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	replay_report | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! Stop hook of the HAL. Result of the replay on stdout
+/***************************************************************************/
+
+static void replay_report( void )
+{
+	//Result of the comparison
+	Uart_replay_stat stat;
+	//Profile of the system tick
+	uint32_t tick_cnt;
+	uint64_t tick_sum, tick_max;
+
+	uart_capture_close();
+	uart_replay_get_stat( stat );
+	hal_host_get_tick_profile( tick_cnt, tick_sum, tick_max );
+	printf
+	(
+		"{\"sim_s\":%.3f,\"ticks\":%lu,\"rx_bytes\":%u,\"rx_fw_drop\":%u,\"rx_usart_ovf\":%u,"
+		"\"tx_expected\":%u,\"tx_bytes\":%u,\"tx_mismatch\":%u,\"tx_first_mismatch_ms\":%.3f,\"tx_max_skew_us\":%.1f,"
+		"\"parse_lat_avg_us\":%.1f,\"parse_lat_max_us\":%.1f,\"tick_ns_avg\":%.0f,\"tick_ns_max\":%llu}\n",
+		(double)hal_host_clk() /F_CPU, (unsigned long)g_tick_num, stat.rx_bytes, g_fw_drop, g_usart_ovf,
+		stat.tx_expected, stat.tx_bytes, stat.tx_mismatch, (stat.tx_mismatch > 0)?(stat.tx_first_mismatch_clk *1e3 /F_CPU):(-1.0), stat.tx_max_skew_clk *1e6 /F_CPU,
+		(g_lat_cnt > 0)?(g_lat_sum *1e6 /F_CPU /g_lat_cnt):(0.0), g_lat_max *1e6 /F_CPU, (tick_cnt > 0)?((double)tick_sum /tick_cnt):(0.0), (unsigned long long)tick_max
+	);
+	fflush( stdout );
+
+	return;
+}	//end function: replay_report | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	main | int, char **
+/***************************************************************************/
+//! @return int | 0 = OK | 1 = bad arguments | 2 = bad capture
+/***************************************************************************/
+
+int main( int argc, char *argv[] )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Capture to replay
+	const char *capture = 0;
+	//Capture of the replay. 0 = don't record
+	const char *output = 0;
+	//counter
+	int t;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//For: each argument
+	for (t = 1;t < argc;t++)
+	{
+		//if: record the replay
+		if ((strcmp( argv[t], "-o" ) == 0) && (t +1 < argc))
+		{
+			output = argv[++t];
+		}
+		//if: capture
+		else if ((argv[t][0] != '-') && (capture == 0))
+		{
+			capture = argv[t];
+		}
+		//if: unknown
+		else
+		{
+			capture = 0;
+			break;
+		}
+	}
+	//if: no capture
+	if (capture == 0)
+	{
+		fprintf( stderr, "usage: %s [-o <capture>] <capture>\n", argv[0] );
+		return 1;
+	}
+	//if: can't load
+	if (uart_replay_open( capture ) == true)
+	{
+		return 2;
+	}
+	//if: can't record
+	if ((output != 0) && (uart_capture_open( output, uart_replay_baud(), uart_replay_plant() ) == true))
+	{
+		return 1;
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	hal_host_set_uart_baud( uart_replay_baud() );
+	hal_host_set_rx_hook( &replay_rx );
+	hal_host_set_tx_hook( &replay_tx );
+	//if: motors and encoders. The plant owns the model hook
+	if (uart_replay_plant() == true)
+	{
+		sim_plant_init();
+		sim_plant_set_step_hook( &replay_step );
+	}
+	else
+	{
+		hal_host_set_model_hook( &replay_step );
+	}
+	hal_host_set_tick_profile( true );
+	hal_host_set_stop( uart_replay_end_clk(), &replay_report );
+	uart_replay_step();
+	//Never returns. The stop hook ends the simulation
+	firmware_main();
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return 0;
+}	//end function: main | int, char **
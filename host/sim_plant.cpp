@@ -0,0 +1,350 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	SIMULATED PLANT
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:		2019-11-18
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Four wheels connected to the emulated peripherals of the host HAL.
+**	Drivers: duty of TCB0-3 and INA/INB pins, as written by commit_vnh7040 and load_vnh7040.
+**	Averaged armature voltage: INB alone drives forward, INA alone backward, both equal brake.
+**	The low side is on while the PWM is low, so the motor always sees a low impedance.
+**	Encoders: position is turned into A/B edges on PORTC, one edge at a time, so the real
+**	quad_encoder_decoder decodes them. Edges raised while interrupts are disabled merge,
+**	like on the target.
+**	MultiSense: magnitude of the current of a driving motor, with the gain of the firmware.
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**	Ripple of the current inside the PWM period is not modelled
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include <math.h>
+#include "global.h"
+#include "host/sim_plant.h"
+
+/****************************************************************************
+**	PROTOTYPES
+****************************************************************************/
+
+//Step the motors, called by the HAL after each slice of time
+static void sim_plant_step( void );
+//Sample of an ADC channel
+static uint16_t sim_plant_adc( uint8_t muxpos );
+
+/****************************************************************************
+**	GLOBAL VARIABILES
+****************************************************************************/
+
+//Motors
+static OrangeBot::Motor_plant g_sim_motor[ DC_MOTOR_NUM ];
+//Voltage applied to each motor [V]
+static double g_sim_voltage[ DC_MOTOR_NUM ];
+//true = driver is sourcing current, MultiSense sees it
+static bool g_sim_f_drive[ DC_MOTOR_NUM ];
+//Position already sent on the encoder pins [edges]
+static int32_t g_sim_enc[ DC_MOTOR_NUM ];
+//Battery [mV]
+static uint16_t g_sim_vbat_mv = SIM_PLANT_VBAT_MV;
+//Time of the last step [CPU clocks]
+static uint64_t g_sim_clk = 0;
+//Hook of the application
+static void (*g_sim_step_hook)( void ) = 0;
+
+//Timer of each driver. Same order as the pin table in main.cpp
+static TCB_t *const g_sim_tcb[ DC_MOTOR_NUM ] = { &TCB0, &TCB1, &TCB2, &TCB3 };
+//Port of the INA and INB pins of each driver
+static PORT_t *const g_sim_port[ DC_MOTOR_NUM ] = { &PORTA, &PORTA, &PORTB, &PORTD };
+static const uint8_t g_sim_ina[ DC_MOTOR_NUM ] = { 0x10, 0x40, 0x04, 0x40 };
+static const uint8_t g_sim_inb[ DC_MOTOR_NUM ] = { 0x20, 0x80, 0x08, 0x80 };
+//Level of the A/B pins for each quarter of an encoder cycle. Sequence decoded as positive by enc_lut
+static const uint8_t g_sim_quad[4] = { 0x00, 0x02, 0x03, 0x01 };
+
+/****************************************************************************
+**	FUNCTIONS
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Function
+//!	sim_plant_init | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! Installs the model and ADC hooks of the HAL. Call before firmware_main()
+/***************************************************************************/
+
+void sim_plant_init( void )
+{
+	//counter
+	uint8_t t;
+
+	//For: each wheel
+	for (t = 0;t < DC_MOTOR_NUM;t++)
+	{
+		g_sim_motor[t].reset();
+		g_sim_voltage[t] = 0.0;
+		g_sim_f_drive[t] = false;
+		g_sim_enc[t] = 0;
+	}
+	g_sim_clk = hal_host_clk();
+	hal_host_set_model_hook( &sim_plant_step );
+	hal_host_set_adc_hook( &sim_plant_adc );
+
+	return;
+}	//end function: sim_plant_init | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	sim_plant_motor | uint8_t
+/***************************************************************************/
+//! @param index | wheel. 0 to DC_MOTOR_NUM -1. Out of range is wheel 0
+//! @return Motor_plant & | motor of the wheel
+/***************************************************************************/
+
+OrangeBot::Motor_plant &sim_plant_motor( uint8_t index )
+{
+	return g_sim_motor[ (index < DC_MOTOR_NUM)?(index):(0) ];
+}	//end function: sim_plant_motor | uint8_t
+
+/***************************************************************************/
+//!	@brief Function
+//!	sim_plant_set_vbat | uint16_t
+/***************************************************************************/
+//! @param mv | battery voltage [mV]
+//! @return void
+/***************************************************************************/
+
+void sim_plant_set_vbat( uint16_t mv )
+{
+	g_sim_vbat_mv = mv;
+
+	return;
+}	//end function: sim_plant_set_vbat | uint16_t
+
+/***************************************************************************/
+//!	@brief Function
+//!	sim_plant_get_voltage | uint8_t
+/***************************************************************************/
+//! @param index | wheel
+//! @return double | voltage applied to the motor in the last step [V]. 0 out of range
+/***************************************************************************/
+
+double sim_plant_get_voltage( uint8_t index )
+{
+	return (index < DC_MOTOR_NUM)?(g_sim_voltage[index]):(0.0);
+}	//end function: sim_plant_get_voltage | uint8_t
+
+/***************************************************************************/
+//!	@brief Function
+//!	sim_plant_set_step_hook | void (*)( void )
+/***************************************************************************/
+//! @param hook | called after each step of the plant. 0 = none
+//! @return void
+/***************************************************************************/
+
+void sim_plant_set_step_hook( void (*hook)( void ) )
+{
+	g_sim_step_hook = hook;
+
+	return;
+}	//end function: sim_plant_set_step_hook | void (*)( void )
+
+/***************************************************************************/
+//!	@brief Static Function
+//!	sim_plant_duty | TCB_t &
+/***************************************************************************/
+//! @param timer | TCB that drives the PWM pin of a driver
+//! @return double | duty cycle. 0 to 1
+//!	@details
+//! 8 bit PWM: CCMPH over a period of CCMPL +1
+//!	Single shot: CCMP over the period of TCA0, only while the trigger is enabled. Counts of the TCB clock
+/***************************************************************************/
+
+static double sim_plant_duty( TCB_t &timer )
+{
+	//Duty cycle
+	double duty;
+	//CPU clocks per count of the TCB
+	uint16_t div;
+
+	//if: timer off
+	if (IS_BIT_ZERO( timer.CTRLA, TCB_ENABLE_bp ))
+	{
+		return 0.0;
+	}
+	//if: 8 bit PWM
+	if ((timer.CTRLB & TCB_CNTMODE_gm) == TCB_CNTMODE_PWM8_gc)
+	{
+		duty = (double)timer.CCMPH /((double)timer.CCMPL +1.0);
+	}
+	//if: single shot started by TCA0
+	else if (((timer.CTRLB & TCB_CNTMODE_gm) == TCB_CNTMODE_SINGLE_gc) && (IS_BIT_ONE( timer.EVCTRL, TCB_CAPTEI_bp )))
+	{
+		div = ((timer.CTRLA & TCB_CLKSEL_gm) == TCB_CLKSEL_CLKTCA_gc)?(hal_host_tca_div()):(((timer.CTRLA & TCB_CLKSEL_gm) == TCB_CLKSEL_CLKDIV2_gc)?(2):(1));
+		duty = (double)timer.CCMP *div /(((double)TCA0.SINGLE.PER +1.0) *hal_host_tca_div());
+	}
+	//if: no pulse
+	else
+	{
+		duty = 0.0;
+	}
+
+	return (duty > 1.0)?(1.0):(duty);
+}	//end function: sim_plant_duty | TCB_t &
+
+/***************************************************************************/
+//!	@brief Static Function
+//!	sim_plant_step | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! Model hook of the HAL. Motors advance by the time since the last step,
+//!	then the encoders catch up one edge at a time, interleaved between wheels
+/***************************************************************************/
+
+static void sim_plant_step( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Step [s]
+	double dt;
+	//Driver pins of a wheel
+	uint8_t pin;
+	//Direction of the armature voltage
+	double dir;
+	//Position of the motor [edges]
+	int32_t cnt;
+	//Level of the encoder pins
+	uint8_t enc_pin;
+	//true = an encoder still has to catch up
+	bool f_edge;
+	//counter
+	uint8_t t;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	dt = (double)(hal_host_clk() -g_sim_clk) /F_CPU;
+	g_sim_clk = hal_host_clk();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//For: each wheel
+	for (t = 0;t < DC_MOTOR_NUM;t++)
+	{
+		pin = g_sim_port[t] -> OUT & (g_sim_ina[t] | g_sim_inb[t]);
+		//INB alone drives forward, INA alone backward, otherwise brake
+		dir = (pin == g_sim_inb[t])?(1.0):((pin == g_sim_ina[t])?(-1.0):(0.0));
+		g_sim_voltage[t] = dir *sim_plant_duty( *g_sim_tcb[t] ) *g_sim_vbat_mv /1000.0;
+		g_sim_f_drive[t] = (g_sim_voltage[t] != 0.0);
+		g_sim_motor[t].exe( g_sim_voltage[t], dt );
+	}
+
+	//Do: one edge per wheel
+	do
+	{
+		f_edge = false;
+		enc_pin = 0;
+		//For: each wheel
+		for (t = 0;t < DC_MOTOR_NUM;t++)
+		{
+			cnt = g_sim_motor[t].get_count();
+			//if: encoder behind
+			if (cnt > g_sim_enc[t])
+			{
+				g_sim_enc[t]++;
+			}
+			//if: encoder ahead
+			else if (cnt < g_sim_enc[t])
+			{
+				g_sim_enc[t]--;
+			}
+			f_edge |= (cnt != g_sim_enc[t]);
+			enc_pin |= g_sim_quad[ g_sim_enc[t] & 0x03 ] << (2*t);
+		}
+		//if: pins changed. Edges go through the sense configuration of PORTC
+		if (enc_pin != PORTC.IN)
+		{
+			hal_host_set_port_in( PORTC, enc_pin );
+		}
+	}
+	while (f_edge == true);
+
+	//if: application listens to the plant
+	if (g_sim_step_hook != 0)
+	{
+		g_sim_step_hook();
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return;
+}	//end function: sim_plant_step | void
+
+/***************************************************************************/
+//!	@brief Static Function
+//!	sim_plant_adc | uint8_t
+/***************************************************************************/
+//! @param muxpos | ADC input
+//! @return uint16_t | 10b sample
+//!	@details
+//! AIN0-3 MultiSense of each driver, AIN4 battery divider. Inverse of the gains of the firmware
+/***************************************************************************/
+
+static uint16_t sim_plant_adc( uint8_t muxpos )
+{
+	//Sample
+	double sample;
+
+	//if: MultiSense of a driving motor
+	if ((muxpos < DC_MOTOR_NUM) && (g_sim_f_drive[muxpos] == true))
+	{
+		sample = fabs( g_sim_motor[muxpos].get_current() ) *1000.0 *256.0 /CURRENT_SENSE_GAIN;
+	}
+	//if: battery divider
+	else if (muxpos == ADC_MUXPOS_AIN0_gc +VBAT_SENSE_CH)
+	{
+		sample = (double)g_sim_vbat_mv *256.0 /VBAT_SENSE_GAIN;
+	}
+	//if: braking motor or unused input
+	else
+	{
+		sample = 0.0;
+	}
+
+	return (sample > 1023.0)?(1023):((uint16_t)sample);
+}	//end function: sim_plant_adc | uint8_t
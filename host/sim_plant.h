@@ -0,0 +1,38 @@
+#ifndef SIM_PLANT_H
+	//header envroiment variabile, is used to detect multiple inclusion
+	//of the same header, and can be used in the c file to detect the
+	//included library
+	#define SIM_PLANT_H
+
+	/****************************************************************************
+	**	GLOBAL INCLUDE
+	**	TIPS: you can put here the library common to all source file
+	****************************************************************************/
+
+	#include "host/motor_plant.h"
+
+	/****************************************************************************
+	**	DEFINE
+	****************************************************************************/
+
+	//Battery voltage at start [mV]
+	#define SIM_PLANT_VBAT_MV		12000
+
+	/****************************************************************************
+	**	PROTOTYPE: FUNCTIONS
+	****************************************************************************/
+
+	//Connect four motors to the emulated VNH7040 drivers, encoders, MultiSense outputs and battery divider
+	extern void sim_plant_init( void );
+	//Motor of a wheel. Parameters and load disturbance can be changed during the simulation
+	extern OrangeBot::Motor_plant &sim_plant_motor( uint8_t index );
+	//Battery voltage [mV]
+	extern void sim_plant_set_vbat( uint16_t mv );
+	//Voltage applied by the driver to a motor in the last step [V]
+	extern double sim_plant_get_voltage( uint8_t index );
+	//Hook called after each step of the plant, e.g. to log it. 0 = none
+	extern void sim_plant_set_step_hook( void (*hook)( void ) );
+
+#else
+	#warning "multiple inclusion of the header file"
+#endif
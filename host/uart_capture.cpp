@@ -0,0 +1,399 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	UART CAPTURE
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:		2019-11-18
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Record and replay of the bytes of the RPI link, with their time.
+**	FORMAT: text, one event per line. '#' starts a comment
+**		#OBCAP <version> F_CPU <hz> BAUD <baud> PLANT <0|1>	header
+**		R <clk> <tick> <hex>	byte received by USART3. clk is the end of its stop bit
+**		T <clk> <tick> <hex>	byte written in the TX data register of USART3
+**		E <clk> <tick>			end of the capture
+**	clk is the simulated time in CPU clocks, tick the system tick of the firmware, g_tick_num.
+**	BAUD 0 is the baud rate configured in USART3.
+**	A logger on the RPI side can write the same format from its own timestamps.
+**	REPLAY: received bytes reach USART3 at the time of the capture, or one frame after the
+**	previous one if later. Bytes sent by the firmware are compared with the capture
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "global.h"
+#include "host/uart_capture.h"
+
+/****************************************************************************
+**	STRUCTURES
+****************************************************************************/
+
+//Event of a capture
+typedef struct _Uart_event
+{
+	//'R' or 'T'
+	char dir;
+	uint8_t data;
+	//Time [CPU clocks]
+	uint64_t clk;
+} Uart_event;
+
+/****************************************************************************
+**	GLOBAL VARIABILES
+****************************************************************************/
+
+//Capture being recorded. 0 = none
+static FILE *g_cap_file = 0;
+
+//Events of the capture being replayed
+static Uart_event *g_rep_event = 0;
+static uint32_t g_rep_num = 0;
+//Next RX event to queue, next TX event to compare
+static uint32_t g_rep_rx = 0;
+static uint32_t g_rep_tx = 0;
+//Header of the capture
+static uint32_t g_rep_baud = 0;
+static bool g_rep_f_plant = false;
+//End of the capture [CPU clocks]
+static uint64_t g_rep_end_clk = 0;
+//Result
+static Uart_replay_stat g_rep_stat;
+
+/****************************************************************************
+**	FUNCTIONS
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Function
+//!	uart_capture_open | const char *, uint32_t, bool
+/***************************************************************************/
+//! @param path | capture file. Overwritten
+//! @param baud | baud rate of the line. 0 = from USART3
+//! @param f_plant | true = the simulated plant is connected
+//! @return bool | false = OK | true = fail
+/***************************************************************************/
+
+bool uart_capture_open( const char *path, uint32_t baud, bool f_plant )
+{
+	g_cap_file = fopen( path, "w" );
+	//if: can't write
+	if (g_cap_file == 0)
+	{
+		perror( path );
+		return true;	//fail
+	}
+	fprintf( g_cap_file, "#OBCAP %d F_CPU %lu BAUD %u PLANT %d\n", UART_CAPTURE_VERSION, (unsigned long)F_CPU, baud, (f_plant == true)?(1):(0) );
+
+	return false;	//OK
+}	//end function: uart_capture_open | const char *, uint32_t, bool
+
+/***************************************************************************/
+//!	@brief Function
+//!	uart_capture_rx | uint8_t
+/***************************************************************************/
+//! @param data | byte reaching USART3
+//! @return void
+/***************************************************************************/
+
+void uart_capture_rx( uint8_t data )
+{
+	//if: recording
+	if (g_cap_file != 0)
+	{
+		fprintf( g_cap_file, "R %llu %lu %02X\n", (unsigned long long)hal_host_uart_rx_clk(), (unsigned long)g_tick_num, data );
+	}
+
+	return;
+}	//end function: uart_capture_rx | uint8_t
+
+/***************************************************************************/
+//!	@brief Function
+//!	uart_capture_tx | uint8_t
+/***************************************************************************/
+//! @param data | byte written in the TX data register of USART3
+//! @return void
+/***************************************************************************/
+
+void uart_capture_tx( uint8_t data )
+{
+	//if: recording
+	if (g_cap_file != 0)
+	{
+		fprintf( g_cap_file, "T %llu %lu %02X\n", (unsigned long long)hal_host_clk(), (unsigned long)g_tick_num, data );
+	}
+
+	return;
+}	//end function: uart_capture_tx | uint8_t
+
+/***************************************************************************/
+//!	@brief Function
+//!	uart_capture_close | void
+/***************************************************************************/
+//! @return void
+/***************************************************************************/
+
+void uart_capture_close( void )
+{
+	//if: recording
+	if (g_cap_file != 0)
+	{
+		fprintf( g_cap_file, "E %llu %lu\n", (unsigned long long)hal_host_clk(), (unsigned long)g_tick_num );
+		fclose( g_cap_file );
+		g_cap_file = 0;
+	}
+
+	return;
+}	//end function: uart_capture_close | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	uart_replay_open | const char *
+/***************************************************************************/
+//! @param path | capture file
+//! @return bool | false = OK | true = fail
+//!	@details
+//! The whole capture is loaded. Events must be in time order
+/***************************************************************************/
+
+bool uart_replay_open( const char *path )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	FILE *f;
+	char line[128];
+	//Fields of a line
+	char dir;
+	unsigned long long clk;
+	unsigned long tick;
+	unsigned int data, version, baud, plant;
+	unsigned long f_cpu;
+	//Room of the event vector
+	uint32_t size = 0;
+	//Line number
+	uint32_t num = 0;
+	bool f_fail = false;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	f = fopen( path, "r" );
+	//if: can't read
+	if (f == 0)
+	{
+		perror( path );
+		return true;	//fail
+	}
+	memset( &g_rep_stat, 0, sizeof( g_rep_stat ) );
+	g_rep_num = g_rep_rx = g_rep_tx = 0;
+	g_rep_end_clk = 0;
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//While: lines
+	while ((f_fail == false) && (fgets( line, sizeof( line ), f ) != 0))
+	{
+		num++;
+		//if: header
+		if (sscanf( line, "#OBCAP %u F_CPU %lu BAUD %u PLANT %u", &version, &f_cpu, &baud, &plant ) == 4)
+		{
+			//if: recorded with another format or clock
+			if ((version != UART_CAPTURE_VERSION) || (f_cpu != F_CPU))
+			{
+				fprintf( stderr, "%s: version %u at %lu Hz, expected %d at %lu Hz\n", path, version, f_cpu, UART_CAPTURE_VERSION, (unsigned long)F_CPU );
+				f_fail = true;
+			}
+			g_rep_baud = baud;
+			g_rep_f_plant = (plant != 0);
+		}
+		//if: byte
+		else if ((sscanf( line, "%c %llu %lu %x", &dir, &clk, &tick, &data ) == 4) && ((dir == 'R') || (dir == 'T')))
+		{
+			//if: vector full
+			if (g_rep_num >= size)
+			{
+				size = (size == 0)?(1024):(2*size);
+				g_rep_event = (Uart_event *)realloc( g_rep_event, size *sizeof( Uart_event ) );
+			}
+			g_rep_event[ g_rep_num ].dir = dir;
+			g_rep_event[ g_rep_num ].data = (uint8_t)data;
+			g_rep_event[ g_rep_num ].clk = clk;
+			g_rep_num++;
+			g_rep_end_clk = clk;
+			g_rep_stat.tx_expected += (dir == 'T')?(1):(0);
+		}
+		//if: end
+		else if (sscanf( line, "E %llu %lu", &clk, &tick ) == 2)
+		{
+			g_rep_end_clk = clk;
+		}
+		//if: not a comment or a blank line
+		else if ((line[0] != '#') && (line[0] != '\n') && (line[0] != '\r'))
+		{
+			fprintf( stderr, "%s:%u: bad event\n", path, num );
+			f_fail = true;
+		}
+	}
+	fclose( f );
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return f_fail;
+}	//end function: uart_replay_open | const char *
+
+/***************************************************************************/
+//!	@brief Function
+//!	uart_replay_baud | void
+/***************************************************************************/
+//! @return uint32_t | baud rate of the line of the capture. 0 = from USART3
+/***************************************************************************/
+
+uint32_t uart_replay_baud( void )
+{
+	return g_rep_baud;
+}	//end function: uart_replay_baud | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	uart_replay_plant | void
+/***************************************************************************/
+//! @return bool | true = the capture ran with the simulated plant
+/***************************************************************************/
+
+bool uart_replay_plant( void )
+{
+	return g_rep_f_plant;
+}	//end function: uart_replay_plant | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	uart_replay_end_clk | void
+/***************************************************************************/
+//! @return uint64_t | time the capture ended [CPU clocks]
+/***************************************************************************/
+
+uint64_t uart_replay_end_clk( void )
+{
+	return g_rep_end_clk;
+}	//end function: uart_replay_end_clk | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	uart_replay_step | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! Received bytes of the capture go on the RX line as long as it has room,
+//!	each one with the time it was received
+/***************************************************************************/
+
+void uart_replay_step( void )
+{
+	//While: received bytes left and room on the line
+	while ((g_rep_rx < g_rep_num) && (hal_host_uart_rx_pending() < HAL_HOST_RX_SIZE))
+	{
+		//if: received byte
+		if (g_rep_event[ g_rep_rx ].dir == 'R')
+		{
+			hal_host_uart_rx_at( g_rep_event[ g_rep_rx ].data, g_rep_event[ g_rep_rx ].clk );
+			g_rep_stat.rx_bytes++;
+		}
+		g_rep_rx++;
+	}
+
+	return;
+}	//end function: uart_replay_step | void
+
+/***************************************************************************/
+//!	@brief Function
+//!	uart_replay_tx | uint8_t
+/***************************************************************************/
+//! @param data | byte written in the TX data register of USART3
+//! @return bool | false = same byte as the capture | true = differs, or beyond the capture
+/***************************************************************************/
+
+bool uart_replay_tx( uint8_t data )
+{
+	//Difference in time from the capture [CPU clocks]
+	uint64_t skew;
+	bool f_mismatch;
+
+	g_rep_stat.tx_bytes++;
+	//Skip to the next sent byte of the capture
+	while ((g_rep_tx < g_rep_num) && (g_rep_event[ g_rep_tx ].dir != 'T'))
+	{
+		g_rep_tx++;
+	}
+	//if: beyond the capture
+	if (g_rep_tx >= g_rep_num)
+	{
+		f_mismatch = true;
+	}
+	else
+	{
+		f_mismatch = (g_rep_event[ g_rep_tx ].data != data);
+		skew = (hal_host_clk() > g_rep_event[ g_rep_tx ].clk)?(hal_host_clk() -g_rep_event[ g_rep_tx ].clk):(g_rep_event[ g_rep_tx ].clk -hal_host_clk());
+		g_rep_stat.tx_max_skew_clk = (skew > g_rep_stat.tx_max_skew_clk)?(skew):(g_rep_stat.tx_max_skew_clk);
+		g_rep_tx++;
+	}
+	//if: first difference
+	if ((f_mismatch == true) && (g_rep_stat.tx_mismatch == 0))
+	{
+		g_rep_stat.tx_first_mismatch_clk = hal_host_clk();
+	}
+	g_rep_stat.tx_mismatch += (f_mismatch == true)?(1):(0);
+
+	return f_mismatch;
+}	//end function: uart_replay_tx | uint8_t
+
+/***************************************************************************/
+//!	@brief Function
+//!	uart_replay_get_stat | Uart_replay_stat &
+/***************************************************************************/
+//! @param stat | result of the replay so far
+//! @return void
+/***************************************************************************/
+
+void uart_replay_get_stat( Uart_replay_stat &stat )
+{
+	stat = g_rep_stat;
+
+	return;
+}	//end function: uart_replay_get_stat | Uart_replay_stat &
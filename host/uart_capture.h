@@ -0,0 +1,71 @@
+#ifndef UART_CAPTURE_H
+	//header envroiment variabile, is used to detect multiple inclusion
+	//of the same header, and can be used in the c file to detect the
+	//included library
+	#define UART_CAPTURE_H
+
+	/****************************************************************************
+	**	GLOBAL INCLUDE
+	**	TIPS: you can put here the library common to all source file
+	****************************************************************************/
+
+	#include <stdint.h>
+
+	/****************************************************************************
+	**	DEFINE
+	****************************************************************************/
+
+	//Version of the capture format
+	#define UART_CAPTURE_VERSION		1
+
+	/****************************************************************************
+	**	STRUCTURES
+	****************************************************************************/
+
+	//Result of a replay
+	typedef struct _Uart_replay_stat
+	{
+		//Bytes fed to the RX line
+		uint32_t rx_bytes;
+		//Bytes sent by the firmware in the capture and in the replay
+		uint32_t tx_expected;
+		uint32_t tx_bytes;
+		//Bytes sent by the replay that differ from the capture, or are beyond it
+		uint32_t tx_mismatch;
+		//Time of the first byte that differs. 0 = none [CPU clocks]
+		uint64_t tx_first_mismatch_clk;
+		//Largest difference in time between a byte of the replay and the same byte of the capture [CPU clocks]
+		uint64_t tx_max_skew_clk;
+	} Uart_replay_stat;
+
+	/****************************************************************************
+	**	PROTOTYPE: FUNCTIONS
+	****************************************************************************/
+
+	//Record the bytes of USART3 in a capture file. false = OK | true = fail
+	extern bool uart_capture_open( const char *path, uint32_t baud, bool f_plant );
+	//Record a byte received by USART3. Call from the RX hook of the HAL
+	extern void uart_capture_rx( uint8_t data );
+	//Record a byte sent by USART3. Call from the TX hook of the HAL
+	extern void uart_capture_tx( uint8_t data );
+	//Mark the end of the capture and close the file
+	extern void uart_capture_close( void );
+
+	//Load a capture to replay. false = OK | true = fail
+	extern bool uart_replay_open( const char *path );
+	//Baud rate of the line of the capture. 0 = from USART3
+	extern uint32_t uart_replay_baud( void );
+	//true = the capture ran with the simulated plant
+	extern bool uart_replay_plant( void );
+	//Time the capture ended [CPU clocks]
+	extern uint64_t uart_replay_end_clk( void );
+	//Queue the bytes of the capture on the RX line. Call at each step of the simulation
+	extern void uart_replay_step( void );
+	//Compare a byte sent by the firmware with the capture. false = same | true = differs
+	extern bool uart_replay_tx( uint8_t data );
+	//Result of the replay so far
+	extern void uart_replay_get_stat( Uart_replay_stat &stat );
+
+#else
+	#warning "multiple inclusion of the header file"
+#endif
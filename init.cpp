@@ -24,12 +24,16 @@ extern void init_fuses( void );
 extern void init_clock( void );
 //Initialize pin map
 extern void init_pin( void );
-//Initialize RTC timer as periodic interrupt
+//Initialize RTC timer as free running timestamp
 extern void init_rtc( void );
-//Initialize timer type A. AT4809 has a single of such timers.
-extern void init_timer0a_split( void );
+//Initialize timer type A as system tick generator. AT4809 has a single of such timers.
+extern void init_timer0a( void );
 //setup one of four timers type B of the AT4809 as PWM generator
 extern void init_timer_b( TCB_t &timer );
+//Route the start of the PWM period to the ADC and, in single shot mode, to the four TCB
+extern void init_evsys( void );
+//Initialize the ADC to sample the MultiSense outputs of the drivers
+extern void init_adc( void );
 //Initialize one of four USART transceivers
 extern void init_uart( USART_t &usart );
 //Initialize port multiplexer for alternate functions
@@ -74,17 +78,30 @@ void init(void)
 	//Initialize port multiplexer to set alternate pin functions
 	init_mux();
 	
-	//Initialize RTC timer as Periodic interrupt source: RTC_PIT_vect
+	//Initialize RTC timer as free running timestamp
 	init_rtc();
 	
-	//Initialize timer type A
-	init_timer0a_split();
+	//Initialize timer type A as system tick source: TCA0_OVF_vect
+	init_timer0a();
 	
 	//Initialize four timers type B as 20KHz 8bit PWM generators for the VNH7040 Motor drivers
 	init_timer_b( TCB0 );
 	init_timer_b( TCB1 );
 	init_timer_b( TCB2 );
 	init_timer_b( TCB3 );
+#ifndef VNH7040_PWM_HIRES
+	//Start the four PWM periods together. Commits only restart them on a change of direction
+	TCB0.CNT = VNH7040_PWM_TOP;
+	TCB1.CNT = VNH7040_PWM_TOP;
+	TCB2.CNT = VNH7040_PWM_TOP;
+	TCB3.CNT = VNH7040_PWM_TOP;
+#endif
+	
+	//Initialize the ADC as current sense of the drivers and battery voltage: ADC0_RESRDY_vect
+	init_adc();
+	
+	//Start of the PWM period triggers the ADC, and the single shot pulses of the four TCB
+	init_evsys();
 
 	//Initialize USART 3 as async UART 256.4Kb/s
 	init_uart( USART3 );
@@ -344,7 +361,7 @@ void init_mux( void )
 **  Function
 **  init_rtc |
 ****************************************************************************/
-//! @brief Initialize RTC timer as periodic interrupt
+//! @brief Initialize RTC timer as free running timestamp
 //! @details
 //! Interrupt vectors:
 //!		RTC_CNT_vect
@@ -417,8 +434,8 @@ void init_rtc( void )
 	//! RTC Periodic Interrupt period
 	//----------------------------------------------------------------
 
-	//! Enable Periodic Interrupt timer
-	SET_BIT( pitctrla_tmp, RTC_PITEN_bp );
+	//! Enable Periodic Interrupt timer. System tick is generated by TCA0
+	//SET_BIT( pitctrla_tmp, RTC_PITEN_bp );
 
 	//! Period for the periodic interrupt. Activate only one
 	//SET_MASKED_BIT( pitctrla_tmp, RTC_PERIOD_gm, RTC_PERIOD_OFF_gc );
@@ -446,7 +463,7 @@ void init_rtc( void )
 	//! Enable Compare Match interrupt
 	//SET_BIT( intctrl_tmp, RTC_CMP_bp );
 	//! Enable Periodic Interrupt timer
-	SET_BIT( pitintctrl_tmp, RTC_PI_bp );
+	//SET_BIT( pitintctrl_tmp, RTC_PI_bp );
 
 
 	//----------------------------------------------------------------
@@ -458,7 +475,8 @@ void init_rtc( void )
 
 	//Wait for the ***
 	//while (IS_BIT_ONE(RTC.STATUS, RTC_PERBUSY_bp));
-	RTC.PER = (uint16_t)0;
+	//Counter is free running
+	RTC.PER = (uint16_t)0xffff;
 	//Compare register for compare interrupt
 	RTC.CMP = (uint16_t)0;
 
@@ -478,53 +496,49 @@ void init_rtc( void )
 
 /****************************************************************************
 **  Function
-**  init_timer_a |
+**  init_timer0a |
 ****************************************************************************/
-//! @brief initialize timer type a in split mode as two 8bit timers with six compare channels
+//! @brief initialize timer type a in normal mode as system tick generator
 //! @details setup the only timer type A of the AT4809
-//!
-//!	Clock from event control is disabled in SPLIT mode
+//!	The timer counts CLK_TCA=CLK_PER/4=5MHz and overflows at the system tick rate
+//!	CLK_TCA is also the clock source of the four TCB PWM generators
+//!	Period is changed at runtime through the buffered period register PERBUF
+//!	Single shot PWM backend: overflows at the PWM rate and triggers the four TCB. Period is fixed
+//!	No waveform output is used
 //!
 //! Interrupt vectors available:
-//! TCA0_LUNF_vect
-//! TCA0_OVF_vect
-//! TCA0_HUNF_vect
-//! TCA0_LCMP0_vect
+//! TCA0_OVF_vect	| System tick
 //! TCA0_CMP0_vect
 //! TCA0_CMP1_vect
-//! TCA0_LCMP1_vect
-//! TCA0_LCMP2_vect
 //! TCA0_CMP2_vect
 /***************************************************************************/
 
-void init_timer0a_split( void )
+void init_timer0a( void )
 {
 	//----------------------------------------------------------------
 	//	VARS
 	//----------------------------------------------------------------
 
 	//Load temporary registers
-	uint8_t ctrla_tmp			= TCA0.SPLIT.CTRLA;
-	uint8_t ctrlb_tmp			= TCA0.SPLIT.CTRLB;
-	uint8_t ctrlc_tmp			= TCA0.SPLIT.CTRLC;
-	uint8_t ctrld_tmp			= TCA0.SPLIT.CTRLD;
-	uint8_t ctrle_tmp			= TCA0.SPLIT.CTRLESET;
-	uint8_t dbgctrl_tmp			= TCA0.SPLIT.DBGCTRL;
-	uint8_t port_mux_tca0_tmp	= PORTMUX.TCAROUTEA;
-	uint8_t intctrl_tmp			= TCA0.SPLIT.INTCTRL;
+	uint8_t ctrla_tmp			= TCA0.SINGLE.CTRLA;
+	uint8_t ctrlb_tmp			= TCA0.SINGLE.CTRLB;
+	uint8_t ctrlc_tmp			= TCA0.SINGLE.CTRLC;
+	uint8_t ctrld_tmp			= TCA0.SINGLE.CTRLD;
+	uint8_t dbgctrl_tmp			= TCA0.SINGLE.DBGCTRL;
+	uint8_t intctrl_tmp			= TCA0.SINGLE.INTCTRL;
 
 	//----------------------------------------------------------------
 	//	INIT
 	//----------------------------------------------------------------
 
 		//----------------------------------------------------------------
-		//! Enable Split Mode
+		//! Disable Split Mode
 		//----------------------------------------------------------------
 		//	Function of registers change according to the mode.
 		//	0 = 3x 16bit
 		//	1 = 6x 8bit
 
-	SET_BIT( ctrld_tmp, TCA_SPLIT_SPLITM_bp );
+	CLEAR_BIT( ctrld_tmp, TCA_SINGLE_SPLITM_bp );
 
 		//----------------------------------------------------------------
 		//! Enable TCA
@@ -532,71 +546,56 @@ void init_timer0a_split( void )
 		//	0 = disabled
 		//	1 = enabled
 
-	SET_BIT( ctrla_tmp, TCA_SPLIT_ENABLE_bp );
+	SET_BIT( ctrla_tmp, TCA_SINGLE_ENABLE_bp );
 
 		//----------------------------------------------------------------
 		//! TCA Clock Prescaler
 		//----------------------------------------------------------------
 		//	Set the clock prescaler of this TCA. Activate only one value
+		//	TCB PWM frequency depends on this setting
 
-	//SET_MASKED_BIT( ctrla_tmp, TCA_SPLIT_CLKSEL_gm , TCA_SPLIT_CLKSEL_DIV1_gc );
-	//SET_MASKED_BIT( ctrla_tmp, TCA_SPLIT_CLKSEL_gm , TCA_SPLIT_CLKSEL_DIV2_gc );
-	SET_MASKED_BIT( ctrla_tmp, TCA_SPLIT_CLKSEL_gm , TCA_SPLIT_CLKSEL_DIV4_gc );
-	//SET_MASKED_BIT( ctrla_tmp, TCA_SPLIT_CLKSEL_gm , TCA_SPLIT_CLKSEL_DIV8_gc );
-	//SET_MASKED_BIT( ctrla_tmp, TCA_SPLIT_CLKSEL_gm , TCA_SPLIT_CLKSEL_DIV16_gc );
-	//SET_MASKED_BIT( ctrla_tmp, TCA_SPLIT_CLKSEL_gm , TCA_SPLIT_CLKSEL_DIV64_gc );
-	//SET_MASKED_BIT( ctrla_tmp, TCA_SPLIT_CLKSEL_gm , TCA_SPLIT_CLKSEL_DIV256_gc );
-	//SET_MASKED_BIT( ctrla_tmp, TCA_SPLIT_CLKSEL_gm , TCA_SPLIT_CLKSEL_DIV1024_gc );
+	//SET_MASKED_BIT( ctrla_tmp, TCA_SINGLE_CLKSEL_gm , TCA_SINGLE_CLKSEL_DIV1_gc );
+	//SET_MASKED_BIT( ctrla_tmp, TCA_SINGLE_CLKSEL_gm , TCA_SINGLE_CLKSEL_DIV2_gc );
+	SET_MASKED_BIT( ctrla_tmp, TCA_SINGLE_CLKSEL_gm , TCA_SINGLE_CLKSEL_DIV4_gc );
+	//SET_MASKED_BIT( ctrla_tmp, TCA_SINGLE_CLKSEL_gm , TCA_SINGLE_CLKSEL_DIV8_gc );
+	//SET_MASKED_BIT( ctrla_tmp, TCA_SINGLE_CLKSEL_gm , TCA_SINGLE_CLKSEL_DIV16_gc );
+	//SET_MASKED_BIT( ctrla_tmp, TCA_SINGLE_CLKSEL_gm , TCA_SINGLE_CLKSEL_DIV64_gc );
+	//SET_MASKED_BIT( ctrla_tmp, TCA_SINGLE_CLKSEL_gm , TCA_SINGLE_CLKSEL_DIV256_gc );
+	//SET_MASKED_BIT( ctrla_tmp, TCA_SINGLE_CLKSEL_gm , TCA_SINGLE_CLKSEL_DIV1024_gc );
 
 		//----------------------------------------------------------------
-		//! TCA Enable compare output and waveform output pin override for each compare channel
+		//! TCA Waveform generation mode
 		//----------------------------------------------------------------
+		//	Normal mode. Counter counts from BOTTOM to PER then overflows
 
-	//SET_BIT( ctrlb_tmp, TCA_SPLIT_LCMP0EN_bp );
-	//SET_BIT( ctrlb_tmp, TCA_SPLIT_LCMP1EN_bp );
-	//SET_BIT( ctrlb_tmp, TCA_SPLIT_LCMP2EN_bp );
-	//SET_BIT( ctrlb_tmp, TCA_SPLIT_HCMP0EN_bp );
-	//SET_BIT( ctrlb_tmp, TCA_SPLIT_HCMP1EN_bp );
-	//SET_BIT( ctrlb_tmp, TCA_SPLIT_HCMP2EN_bp );
+	SET_MASKED_BIT( ctrlb_tmp, TCA_SINGLE_WGMODE_gm, TCA_SINGLE_WGMODE_NORMAL_gc );
+	//SET_MASKED_BIT( ctrlb_tmp, TCA_SINGLE_WGMODE_gm, TCA_SINGLE_WGMODE_FRQ_gc );
+	//SET_MASKED_BIT( ctrlb_tmp, TCA_SINGLE_WGMODE_gm, TCA_SINGLE_WGMODE_SINGLESLOPE_gc );
 
 		//----------------------------------------------------------------
-		//! TCA Enable timer commands
+		//! TCA Enable compare output and waveform output pin override for each compare channel
 		//----------------------------------------------------------------
 
-	//Disable force commands
-	SET_MASKED_BIT( ctrle_tmp, (uint8_t)0x03 , (uint8_t)0x00 );
-	//ENABLE force commands for both channels
-	//SET_MASKED_BIT( ctrle_tmp, (uint8_t)0x03 , (uint8_t)0x03 );
+	//SET_BIT( ctrlb_tmp, TCA_SINGLE_CMP0EN_bp );
+	//SET_BIT( ctrlb_tmp, TCA_SINGLE_CMP1EN_bp );
+	//SET_BIT( ctrlb_tmp, TCA_SINGLE_CMP2EN_bp );
 
 		//----------------------------------------------------------------
 		//! ENABLE TCA interrupts
 		//----------------------------------------------------------------
 
-	//Underflow of low counter
-	//SET_BIT( intctrl_tmp, TCA_SPLIT_LUNF_bp );
-	//Underflow of high counter
-	//SET_BIT( intctrl_tmp, TCA_SPLIT_HUNF_bp );
+	//Overflow. System tick
+	SET_BIT( intctrl_tmp, TCA_SINGLE_OVF_bp );
 	//Compare channel
-	//SET_BIT( intctrl_tmp, TCA_SPLIT_LCMP0_bp );
-	//SET_BIT( intctrl_tmp, TCA_SPLIT_LCMP1_bp );
-	//SET_BIT( intctrl_tmp, TCA_SPLIT_LCMP2_bp );
+	//SET_BIT( intctrl_tmp, TCA_SINGLE_CMP0_bp );
+	//SET_BIT( intctrl_tmp, TCA_SINGLE_CMP1_bp );
+	//SET_BIT( intctrl_tmp, TCA_SINGLE_CMP2_bp );
 
 		//----------------------------------------------------------------
 		//! ENABLE TCA debug
 		//----------------------------------------------------------------
 
-	SET_BIT( dbgctrl_tmp, TCA_SPLIT_DBGRUN_bp );
-
-		//----------------------------------------------------------------
-		//! Set TCA waveform outputs to a given port. You can activate only one port
-		//----------------------------------------------------------------
-
-	//SET_MASKED_BIT( port_mux_tca0_tmp, PORTMUX_TCA0_gm, PORTMUX_TCA0_PORTA_gc );	//default
-	SET_MASKED_BIT( port_mux_tca0_tmp, PORTMUX_TCA0_gm, PORTMUX_TCA0_PORTB_gc );
-	//SET_MASKED_BIT( port_mux_tca0_tmp, PORTMUX_TCA0_gm, PORTMUX_TCA0_PORTC_gc );
-	//SET_MASKED_BIT( port_mux_tca0_tmp, PORTMUX_TCA0_gm, PORTMUX_TCA0_PORTD_gc );
-	//SET_MASKED_BIT( port_mux_tca0_tmp, PORTMUX_TCA0_gm, PORTMUX_TCA0_PORTE_gc );
-	//SET_MASKED_BIT( port_mux_tca0_tmp, PORTMUX_TCA0_gm, PORTMUX_TCA0_PORTF_gc );
+	SET_BIT( dbgctrl_tmp, TCA_SINGLE_DBGRUN_bp );
 
 	//----------------------------------------------------------------
 	//	RETURN
@@ -604,30 +603,29 @@ void init_timer0a_split( void )
 
 	//! Register write back.
 	//Write back control registers
-	TCA0.SPLIT.CTRLB = ctrlb_tmp;
-	TCA0.SPLIT.CTRLC = ctrlc_tmp;
-	TCA0.SPLIT.CTRLD = ctrld_tmp;
-	TCA0.SPLIT.CTRLESET = ctrle_tmp;
-	TCA0.SPLIT.DBGCTRL = dbgctrl_tmp;
-	//Write back output waveform port selector
-	PORTMUX.TCAROUTEA = port_mux_tca0_tmp;
-
-	//Period registers for the High and Low 8bit counters
-	TCA0.SPLIT.LPER = (uint8_t)255;
-	TCA0.SPLIT.HPER = (uint8_t)255;
-	//Initial PWM settings for channels L0 to L2
-	TCA0.SPLIT.LCMP0 = (uint8_t)0x00;
-	TCA0.SPLIT.LCMP1 = (uint8_t)0x00;
-	TCA0.SPLIT.LCMP2 = (uint8_t)0x00;
-	//Initial PWM settings for channels H0 to H2
-	TCA0.SPLIT.HCMP0 = (uint8_t)0x00;
-	TCA0.SPLIT.HCMP1 = (uint8_t)0x00;
-	TCA0.SPLIT.HCMP2 = (uint8_t)0x0;
+	TCA0.SINGLE.CTRLB = ctrlb_tmp;
+	TCA0.SINGLE.CTRLC = ctrlc_tmp;
+	TCA0.SINGLE.CTRLD = ctrld_tmp;
+	TCA0.SINGLE.DBGCTRL = dbgctrl_tmp;
+
+#ifdef VNH7040_PWM_HIRES
+	//Period of the PWM. System tick is counted by the ISR. Start at the base rate
+	TCA0.SINGLE.PER = (uint16_t)VNH7040_PWM_TCA_TOP;
+	g_tick_div = (uint8_t)SYS_TICK_DIV( TICK_RATE_500HZ );
+#else
+	//Period of the system tick. Start at the base rate
+	TCA0.SINGLE.PER = (uint16_t)SYS_TICK_TCA_TOP( TICK_RATE_500HZ );
+#endif
+	//Clear counter
+	TCA0.SINGLE.CNT = (uint16_t)0;
+	//Initialize timestamp
+	g_timestamp_base = (uint16_t)0;
+	g_timestamp_top = TCA0.SINGLE.PER;
 
 	//Write back control A for last as it's the one that sets the clock and starts the timer
-	TCA0.SPLIT.CTRLA = ctrla_tmp;
+	TCA0.SINGLE.CTRLA = ctrla_tmp;
 	//Write back interrupt enable
-	TCA0.SPLIT.INTCTRL = intctrl_tmp;
+	TCA0.SINGLE.INTCTRL = intctrl_tmp;
 
 	return;
 }	//End: init_timer0a
@@ -639,6 +637,8 @@ void init_timer0a_split( void )
 //! @param timer | TCB_t: one of four timers type B TCB0,TCB1,TCB2,TCB3
 //! @brief initialize timer type B in PWM mode
 //! @details setup one of four timer type B of the AT4809 as PWM generator
+//!	8 bit PWM mode clocked by CLK_TCA. Period is 256 counts, 19.5KHz
+//!	Single shot PWM backend: counts CLK_PER, the pulse starts on the event input and ends on CCMP
 //!	Generates interrupts:
 //!	TCB0_INT_vect
 //!	TCB1_INT_vect
@@ -668,16 +668,22 @@ void init_timer_b( TCB_t &timer )
 	//! Enable this timer
 	SET_BIT( ctrla_tmp, TCB_ENABLE_bp );
 	
+#ifndef VNH7040_PWM_HIRES
 	//! This timer will reset whenever TC0 resets
 	SET_BIT( ctrla_tmp, TCB_SYNCUPD_bp );
+#endif
 	
 	//! Run in standby mode
 	//SET_BIT( ctrla_tmp, TCB_RUNSTDBY_bp );
 	
 	//! Select clock source
+#ifdef VNH7040_PWM_HIRES
+	SET_MASKED_BIT( ctrla_tmp, TCB_CLKSEL_gm, TCB_CLKSEL_CLKDIV1_gc );		// Clock
+#else
 	//SET_MASKED_BIT( ctrla_tmp, TCB_CLKSEL_gm, TCB_CLKSEL_CLKDIV1_gc );		// Clock
 	//SET_MASKED_BIT( ctrla_tmp, TCB_CLKSEL_gm, TCB_CLKSEL_CLKDIV2_gc );	// Clock/2
 	SET_MASKED_BIT( ctrla_tmp, TCB_CLKSEL_gm, TCB_CLKSEL_CLKTCA_gc );		// TCA Clock source
+#endif
 	
 	//! Select the mode of operation of this timer
 	//SET_MASKED_BIT( ctrlb_tmp, TCB_CNTMODE_gm, TCB_CNTMODE_INT_gc );		// PIT Periodic interrupt mode
@@ -686,8 +692,12 @@ void init_timer_b( TCB_t &timer )
 	//SET_MASKED_BIT( ctrlb_tmp, TCB_CNTMODE_gm, TCB_CNTMODE_FRQ_gc );		// Input Capture Frequency measurement
 	//SET_MASKED_BIT( ctrlb_tmp, TCB_CNTMODE_gm, TCB_CNTMODE_PW_gc );		// Input Capture Pulse-Width measurement
 	//SET_MASKED_BIT( ctrlb_tmp, TCB_CNTMODE_gm, TCB_CNTMODE_FRQPW_gc );	// Input Capture Frequency and Pulse-Width measurement
+#ifdef VNH7040_PWM_HIRES
+	SET_MASKED_BIT( ctrlb_tmp, TCB_CNTMODE_gm, TCB_CNTMODE_SINGLE_gc );	// Single Shot
+#else
 	//SET_MASKED_BIT( ctrlb_tmp, TCB_CNTMODE_gm, TCB_CNTMODE_SINGLE_gc );	// Single Shot
 	SET_MASKED_BIT( ctrlb_tmp, TCB_CNTMODE_gm, TCB_CNTMODE_PWM8_gc );		// 8bit PWM mode
+#endif
 	
 	//! Enable the waveform output signal
 	SET_BIT( ctrlb_tmp, TCB_CCMPEN_bp );
@@ -698,7 +708,7 @@ void init_timer_b( TCB_t &timer )
 	//! false=signal is updated at timer start in single shot | true=signal is updated as event arrives in single shot
 	//SET_BIT( ctrlb_tmp, TCB_ASYNC_bp );
 	
-	//! enable input capture
+	//! enable input capture. Single shot backend enables it with the first pulse
 	//SET_BIT( evctrl_tmp, TCB_CAPTEI_bp );
 	
 	//! event capture edge sensitivity. Dependent on mode of operation. Look datasheet for details
@@ -718,10 +728,15 @@ void init_timer_b( TCB_t &timer )
 	//	WRITE BACK
 	//----------------------------------------------------------------
 	
+#ifdef VNH7040_PWM_HIRES
+	//Pulse length in single shot mode. Motor off
+	timer.CCMP = (uint16_t)0;
+#else
 	//TOP in PWM 8-bit mode
-	timer.CCMPL = 255;
+	timer.CCMPL = VNH7040_PWM_TOP;
 	//PWM in PWM 8bit mode
 	timer.CCMPH = 127;
+#endif
 	
 	timer.CTRLB = ctrlb_tmp;
 	timer.EVCTRL = evctrl_tmp;
@@ -734,6 +749,171 @@ void init_timer_b( TCB_t &timer )
 	return;
 }
 
+/****************************************************************************
+**  Function
+**  init_evsys |
+****************************************************************************/
+//! @brief Route the start of the PWM period to the ADC and, in single shot mode, to the four TCB
+//! @details
+//!	8 bit PWM backend: event channel 0 carries the capture event of TCB0, raised when the 8 bit counter wraps
+//!	The four TCB restart in phase at each commit, so TCB0 marks the start of the on time of all of them
+//!	Single shot PWM backend: event channel 0 carries the overflow of TCA0. The four TCB use it as event input
+//!	and start their pulses on the same CLK_PER edge
+//!	The ADC starts a conversion on each event
+/***************************************************************************/
+
+void init_evsys( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+#ifdef VNH7040_PWM_HIRES
+	//Generator of channel 0 is the overflow of TCA0
+	EVSYS.CHANNEL0 = EVSYS_GENERATOR_TCA0_OVF_LUNF_gc;
+	//Four TCB listen to channel 0
+	EVSYS.USERTCB0 = EVSYS_CHANNEL_CHANNEL0_gc;
+	EVSYS.USERTCB1 = EVSYS_CHANNEL_CHANNEL0_gc;
+	EVSYS.USERTCB2 = EVSYS_CHANNEL_CHANNEL0_gc;
+	EVSYS.USERTCB3 = EVSYS_CHANNEL_CHANNEL0_gc;
+#else
+	//Generator of channel 0 is the period of TCB0
+	EVSYS.CHANNEL0 = EVSYS_GENERATOR_TCB0_CAPT_gc;
+#endif
+	//ADC listens to channel 0
+	EVSYS.USERADC0 = EVSYS_CHANNEL_CHANNEL0_gc;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End: init_evsys
+
+/****************************************************************************
+**  Function
+**  init_adc |
+****************************************************************************/
+//! @brief Initialize the ADC to sample the MultiSense outputs of the drivers
+//! @details
+//!	10 bit, CLK_ADC = CLK_PER/16 = 1.25MHz, internal 4.3V reference
+//!	A conversion is started by the event system at the start of each PWM period.
+//!	The sample is delayed by CURRENT_SENSE_SAMPDLY ADC clocks so that it falls inside the on time
+//!	PD0 to PD3 are AIN0 to AIN3, digital input buffer is disabled
+//!
+//! Interrupt vectors available:
+//! ADC0_RESRDY_vect	| Result ready. Accumulate the current
+//! ADC0_WCOMP_vect
+/***************************************************************************/
+
+void init_adc( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Load temporary registers
+	uint8_t ctrla_tmp			= ADC0.CTRLA;
+	uint8_t ctrlb_tmp			= ADC0.CTRLB;
+	uint8_t ctrlc_tmp			= ADC0.CTRLC;
+	uint8_t ctrld_tmp			= ADC0.CTRLD;
+	uint8_t evctrl_tmp			= ADC0.EVCTRL;
+	uint8_t intctrl_tmp			= ADC0.INTCTRL;
+	uint8_t vref_tmp			= VREF.CTRLA;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+		//----------------------------------------------------------------
+		//! Reference
+		//----------------------------------------------------------------
+		//	Must match CURRENT_SENSE_VREF_MV
+
+	SET_MASKED_BIT( vref_tmp, VREF_ADC0REFSEL_gm, VREF_ADC0REFSEL_4V34_gc );
+	SET_MASKED_BIT( ctrlc_tmp, ADC_REFSEL_gm, ADC_REFSEL_INTREF_gc );
+	//Reduced sampling capacitance for reference above 1V
+	SET_BIT( ctrlc_tmp, ADC_SAMPCAP_bp );
+
+		//----------------------------------------------------------------
+		//! ADC Clock Prescaler
+		//----------------------------------------------------------------
+		//	Maximum CLK_ADC is 1.5MHz for 10 bit resolution
+
+	SET_MASKED_BIT( ctrlc_tmp, ADC_PRESC_gm, ADC_PRESC_DIV16_gc );
+
+		//----------------------------------------------------------------
+		//! Resolution and accumulation
+		//----------------------------------------------------------------
+		//	Single sample. The ISR accumulates samples from different PWM periods
+
+	SET_MASKED_BIT( ctrla_tmp, ADC_RESSEL_gm, ADC_RESSEL_10BIT_gc );
+	SET_MASKED_BIT( ctrlb_tmp, ADC_SAMPNUM_gm, ADC_SAMPNUM_ACC1_gc );
+
+		//----------------------------------------------------------------
+		//! Delays
+		//----------------------------------------------------------------
+		//	Initial delay lets the reference settle. Sample delay moves the sample inside the on time
+
+	SET_MASKED_BIT( ctrld_tmp, ADC_INITDLY_gm, ADC_INITDLY_DLY64_gc );
+	SET_MASKED_BIT( ctrld_tmp, ADC_SAMPDLY_gm, CURRENT_SENSE_SAMPDLY << ADC_SAMPDLY_gp );
+
+		//----------------------------------------------------------------
+		//! Trigger
+		//----------------------------------------------------------------
+		//	Conversion is started by the event input. No free running
+
+	CLEAR_BIT( ctrla_tmp, ADC_FREERUN_bp );
+	SET_BIT( evctrl_tmp, ADC_STARTEI_bp );
+
+		//----------------------------------------------------------------
+		//! ENABLE ADC interrupts
+		//----------------------------------------------------------------
+
+	//Result ready. Current accumulation
+	SET_BIT( intctrl_tmp, ADC_RESRDY_bp );
+	//Window comparator
+	//SET_BIT( intctrl_tmp, ADC_WCMP_bp );
+
+	//Enable
+	SET_BIT( ctrla_tmp, ADC_ENABLE_bp );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	//Analog pins. Disable the digital input buffer
+	PORTD.PIN0CTRL = PORT_ISC_INPUT_DISABLE_gc;
+	PORTD.PIN1CTRL = PORT_ISC_INPUT_DISABLE_gc;
+	PORTD.PIN2CTRL = PORT_ISC_INPUT_DISABLE_gc;
+	PORTD.PIN3CTRL = PORT_ISC_INPUT_DISABLE_gc;
+	//Battery divider
+	PORTD.PIN4CTRL = PORT_ISC_INPUT_DISABLE_gc;
+
+	//! Register write back
+	VREF.CTRLA = vref_tmp;
+	//First conversion is the MultiSense of driver 0
+	ADC0.MUXPOS = ADC_MUXPOS_AIN0_gc;
+	ADC0.SAMPCTRL = (uint8_t)0;
+	ADC0.CTRLB = ctrlb_tmp;
+	ADC0.CTRLC = ctrlc_tmp;
+	ADC0.CTRLD = ctrld_tmp;
+	ADC0.EVCTRL = evctrl_tmp;
+	ADC0.INTCTRL = intctrl_tmp;
+	//Write back control A for last as it enables the ADC
+	ADC0.CTRLA = ctrla_tmp;
+
+	return;
+}	//End: init_adc
+
 /****************************************************************************
 **  Function
 **  init_uart |
@@ -3,11 +3,16 @@
 ****************************************************************************/
 
 #include "global.h"
+//Execution time statistics
+#include "profiler.h"
 
 /****************************************************************************
 **GLOBAL VARS
 ****************************************************************************/
 
+//Execution time statistics
+extern OrangeBot::Profiler g_prof[PROF_NUM];
+
 // Encoder LUT
 //
 // Bit 765 | unused, hold at zero
@@ -57,34 +62,87 @@ int8_t enc_lut[32] =
 ****************************************************************************/
 
 /****************************************************************************
-**	RTC Periodic Interrupt
+**	TCA0 Overflow Interrupt
 *****************************************************************************
-**	Periodic interrupt generated by the RTC from it's independent clock source
+**	System tick. Rate is selected at runtime by the period of TCA0
+**	Optionally executes the control step. Still a level 0 interrupt: it never preempts another ISR
+**	Single shot PWM backend: TCA0 overflows every PWM period. Committed motor settings
+**	are loaded here and the system tick is raised once every g_tick_div overflows
 ****************************************************************************/
 
-ISR( RTC_PIT_vect )
+ISR( TCA0_OVF_vect )
 {	
 	//----------------------------------------------------------------
 	//	VARS
 	//----------------------------------------------------------------
 
+	//Profiling
+	uint16_t timestamp;
+	//Overflows left before the system tick
+	static uint8_t tick_cnt = 1;
+
 	//----------------------------------------------------------------
 	//	INIT
 	//----------------------------------------------------------------
 	
+	//Start profiling
+	timestamp = GET_TIMESTAMP();
+	
 	//----------------------------------------------------------------
 	//	BODY
 	//----------------------------------------------------------------	
 	
-	//Set the System Tick
-	g_isr_flags.system_tick = true;
+	//Extend the timestamp by the period that just ended
+	g_timestamp_base += g_timestamp_top +1;
+	//Period that just started. PER has been loaded from PERBUF
+	g_timestamp_top = TCA0.SINGLE.PER;
+	//Manually clear the interrupt flag. Must be cleared together with the timestamp update
+	TCA0.SINGLE.INTFLAGS = TCA_SINGLE_OVF_bm;
+	//if: motor settings have been committed
+	if (g_f_vnh7040_load == true)
+	{
+		//Load them while the pulses of the new period have just started
+		load_vnh7040();
+	}
+	//if: not the overflow of a system tick
+	tick_cnt--;
+	if (tick_cnt > 0)
+	{
+		return;
+	}
+	tick_cnt = g_tick_div;
+	//Timestamp of the system tick
+	g_timestamp_tick = g_timestamp_base;
+	//Count the system tick
+	g_tick_num++;
+	//Count the System Tick for the main loop. Its own byte, not a bit of g_isr_flags
+	if (g_tick_pending < (uint8_t)0xff)
+	{
+		g_tick_pending++;
+	}
 	
 	//----------------------------------------------------------------
 	//	RETURN
 	//----------------------------------------------------------------
 	
-	//Manually clear the interrupt flag
-	RTC.PITINTFLAGS = RTC_PI_bm;
+	//Stop profiling. Own channel, control step is profiled on its own
+	g_prof[PROF_TICK].add( GET_TIMESTAMP() -timestamp );
+	
+	//if: control step is executed by the ISR
+	if (g_f_ctrl_isr == true)
+	{
+		timestamp = GET_TIMESTAMP();
+		//Execute one step of the motor control system
+		control_step();
+		//if: the step held the encoder and UART RX ISRs for too long
+		if ((uint16_t)(GET_TIMESTAMP() -timestamp) > (uint16_t)CTRL_ISR_MAX_TIME)
+		{
+			//Execute the next steps in the main loop
+			set_control_isr( false );
+			//Signal error
+			report_error( ERR_CODE_CONTROL_OVERRUN );
+		}
+	}
 }
 
 /****************************************************************************
@@ -101,11 +159,16 @@ ISR( USART3_RXC_vect )
 	
 	//Temp var
 	uint8_t rx_data_tmp;
+	//Profiling
+	uint16_t timestamp;
 	
 	//----------------------------------------------------------------
 	//	INIT
 	//----------------------------------------------------------------
 	
+	//Start profiling
+	timestamp = GET_TIMESTAMP();
+	
 	//----------------------------------------------------------------
 	//	BODY
 	//----------------------------------------------------------------
@@ -119,6 +182,120 @@ ISR( USART3_RXC_vect )
 	//	RETURN
 	//----------------------------------------------------------------	
 	
+	//Stop profiling
+	g_prof[PROF_ISR].add( GET_TIMESTAMP() -timestamp );
+}
+
+/****************************************************************************
+**	ADC0 Result Ready Interrupt
+*****************************************************************************
+**	A conversion is started by the event at the start of each PWM period
+**	and samples CURRENT_SENSE_SAMPDLY ADC clocks later, inside the on time
+**	One MultiSense output per period, round robin. Channel of the next
+**	conversion is selected here, well before the next trigger
+**	Sample is skipped when the on time is too short or the motor is braked,
+**	MultiSense only reports the current of the high side
+**	After CURRENT_SENSE_STALE_NUM skipped samples in a row the current is unknown and reads 0
+**	2^CURRENT_SENSE_DEC_SHIFT valid samples are averaged into mA
+**	Last slot of the round robin is the battery divider, low pass filtered
+****************************************************************************/
+
+ISR( ADC0_RESRDY_vect )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+	
+	//Profiling
+	uint16_t timestamp;
+	//Channel of the conversion that just ended
+	static uint8_t ch = 0;
+	//Sum of the valid samples of each channel
+	static uint16_t acc[DC_MOTOR_NUM] = { 0 };
+	//Number of valid samples of each channel
+	static uint8_t cnt[DC_MOTOR_NUM] = { 0 };
+	//Skipped samples in a row of each channel. Saturates at CURRENT_SENSE_STALE_NUM
+	static uint8_t skip[DC_MOTOR_NUM] = { 0 };
+	//Conversion result
+	uint16_t sample;
+	//Duty cycle of the motor
+	uint16_t duty;
+	//true = sample is a measure of the current
+	bool f_valid;
+	
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+	
+	//Start profiling
+	timestamp = GET_TIMESTAMP();
+	//Fetch the result and clear the interrupt flag
+	sample = ADC0.RES;
+	
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+	
+	//if: supply voltage
+	if (ch == VBAT_SENSE_CH)
+	{
+		//First order low pass. Fixed point VBAT_FILTER_FP
+		g_vbat_adc = g_vbat_adc +(((int16_t)(sample << VBAT_FILTER_FP) -(int16_t)g_vbat_adc) >> VBAT_FILTER_SHIFT);
+		//Next channel is the MultiSense of driver 0
+		ch = 0;
+		ADC0.MUXPOS = ADC_MUXPOS_AIN0_gc;
+		//Stop profiling
+		g_prof[PROF_ISR].add( GET_TIMESTAMP() -timestamp );
+		return;
+	}
+	duty = get_vnh7040_duty( ch );
+	//Sample is valid. Motor is off, or the sample falls inside the on time
+	f_valid = (is_vnh7040_brake( ch ) == false) && ((duty == 0) || (duty >= CURRENT_SENSE_MIN_PWM));
+	//Motor off. MultiSense is not driven
+	if (duty == 0)
+	{
+		sample = 0;
+	}
+	//Inner current loop. Runs for every sample
+	current_loop_step( ch, ((uint32_t)sample *CURRENT_SENSE_GAIN) >> 8, f_valid );
+	//if: sample is valid
+	if (f_valid == true)
+	{
+		skip[ch] = 0;
+		acc[ch] += sample;
+		cnt[ch]++;
+		//if: decimation is complete
+		if (cnt[ch] >= (1 << CURRENT_SENSE_DEC_SHIFT))
+		{
+			//Average and convert to mA
+			g_motor_current[ch] = ((uint32_t)acc[ch] *CURRENT_SENSE_GAIN) >> (8 +CURRENT_SENSE_DEC_SHIFT);
+			SET_BIT( g_motor_current_valid, ch );
+			acc[ch] = 0;
+			cnt[ch] = 0;
+		}
+	}
+	//if: skipped for too long. The last value is stale
+	else if (skip[ch] < CURRENT_SENSE_STALE_NUM)
+	{
+		skip[ch]++;
+		if (skip[ch] >= CURRENT_SENSE_STALE_NUM)
+		{
+			g_motor_current[ch] = 0;
+			CLEAR_BIT( g_motor_current_valid, ch );
+			acc[ch] = 0;
+			cnt[ch] = 0;
+		}
+	}
+	//Next channel. MultiSense on AIN0 to AIN3, then the battery on AIN4
+	ch = AT_TOP_INC( ch, VBAT_SENSE_CH );
+	ADC0.MUXPOS = ADC_MUXPOS_AIN0_gc +ch;
+	
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------	
+	
+	//Stop profiling
+	g_prof[PROF_ISR].add( GET_TIMESTAMP() -timestamp );
 }
 
 /****************************************************************************
@@ -188,7 +365,7 @@ void quad_encoder_decoder( uint8_t enc_in )
 	//temporary error counter
 	bool f_err = false;
 	//this flag is used to detect when a preventive overflow update is required
-	bool f_update;
+	bool f_update = false;
 
 	//----------------------------------------------------------------
 	//	INIT
@@ -232,7 +409,7 @@ void quad_encoder_decoder( uint8_t enc_in )
 
 	//! Write back ISR counters to global 32bit counters
 	//Only write back if main requests it, if at least one counter is above threshold. withhold if
-	if ((g_isr_flags.enc_sem == false) && ((g_isr_flags.enc_double_event == true) || (g_isr_flags.enc_updt == true)))
+	if ((g_isr_flags.enc_sem == false) && ((g_isr_flags.enc_double_event == true) || (g_isr_flags.enc_updt == true) || (f_update == true)))
 	{
 		//notify the main that sync happened
 		g_isr_flags.enc_updt = false;
@@ -269,6 +446,20 @@ void quad_encoder_decoder( uint8_t enc_in )
 
 ISR( PORTC_PORT_vect )
 {
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+	
+	//Profiling
+	uint16_t timestamp;
+	
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+	
+	//Start profiling
+	timestamp = GET_TIMESTAMP();
+	
 	//----------------------------------------------------------------
 	//	BODY
 	//----------------------------------------------------------------
@@ -282,7 +473,69 @@ ISR( PORTC_PORT_vect )
 	
 	//Clear the Interrupt Flags of PORTC
 	PORTC.INTFLAGS = (uint8_t)0xff;
+	//Stop profiling
+	g_prof[PROF_ISR].add( GET_TIMESTAMP() -timestamp );
 } //End ISR: PORTC_PORT_vect
 
+/****************************************************************************
+**  Function
+**  get_timestamp
+****************************************************************************/
+//! @return uint16_t | timestamp. 5MHz
+//! @brief Free running 16b timestamp
+//! @details
+//!	TCA0 counter restarts from zero at each system tick.
+//!	The timestamp at the last overflow is kept by the TCA0 overflow ISR
+//!	If an overflow is pending, the ISR hasn't updated the base yet and the
+//!	counter is read again since it might have been read before the overflow
+//!	Safe to call from ISRs and from the main loop
+/***************************************************************************/
+
+uint16_t get_timestamp( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+	
+	//Status register. Interrupt enable
+	uint8_t sreg_tmp;
+	//Timestamp at last overflow
+	uint16_t base;
+	//Counter
+	uint16_t cnt;
+	
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+	
+	//Save interrupt enable and disable interrupts
+	sreg_tmp = SREG;
+	cli();
+	
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+	
+	base = g_timestamp_base;
+	cnt = TCA0.SINGLE.CNT;
+	//if: overflow happened but it has not been served yet
+	if (IS_BIT_ONE( TCA0.SINGLE.INTFLAGS, TCA_SINGLE_OVF_bp ))
+	{
+		//Counter after the overflow
+		cnt = TCA0.SINGLE.CNT;
+		//Add the period that ended
+		base += g_timestamp_top +1;
+	}
+	
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+	
+	//Restore interrupt enable
+	SREG = sreg_tmp;
+	
+	return base +cnt;
+} //End function: get_timestamp
+
 
 
@@ -44,6 +44,39 @@
 **	
 **		2019-11-09
 **	Added Pid S16 class
+**		2019-11-12
+**	Main loop timing moved to a static table cooperative scheduler
+**	System tick moved from RTC PIT to TCA0 overflow. Rate selectable at runtime 500Hz, 1KHz, 2KHz
+**		2019-11-13
+**	Added CPU load and execution time profiling of main loop, control step and ISRs
+**	Added option to execute the control step inside the TCA0 overflow ISR
+**		2019-11-14
+**	Added CONTROL_POS. Absolute position target with on board trapezoidal profile
+**		2019-11-15
+**	Added CONTROL_QUEUE. Motion queue of speed and position segments with jerk limited S-curves
+**		2019-11-16
+**	Added forward and turn platform command and on board odometry integrated every tick
+**		2019-11-17
+**	Added linear and cubic interpolation of the speed setpoints sent by the host
+**	Added per wheel acceleration and deceleration limits on the speed reference. PWM slew rate only applies to open loop
+**	Direction reversal brakes the motor to ground instead of ramping down the PWM. Selectable coast or brake stop
+**	Motor settings are staged and committed together. PWM generators restart in phase at each commit
+**	Optional 20KHz single shot PWM backend with about 10 bit of resolution. PWM is 16 bit end to end
+**		2019-11-18
+**	Added current sensing. ADC samples the MultiSense outputs in sync with the PWM, the ISR decimates them to mA
+**	Current holds the acceleration of the speed reference and stops the platform on a stalled wheel
+**	Added optional inner current loop. PID output becomes a current reference, the ADC ISR regulates the duty
+**	Added battery voltage compensation. PWM commands are voltages, scaled by the filtered battery voltage
+**	Added hardware abstraction layer and CMake project. Firmware builds for the AVR and for a Linux host that emulates the peripherals
+**	Added simulated DC motors and encoders to the host build. Fixed the encoder counters wrapping above 7 edges per control tick
+**	Added control benchmark scenarios on the simulated plant, checked against a baseline of thresholds
+**	Added cycle benchmark of the hot paths for the AVR, and flash/RAM footprint report
+**	Added pseudo terminal link emulator of the RPI serial line for the host build
+**	Added record and replay of the RPI serial line sessions for the host build, system tick counter
+**	Added host side client library of the RPI protocol with pipelined commands, and its throughput benchmark
+**	Added telemetry stream subscriptions SUB with decimation, they replace the polled telemetry of the signals they carry
+**	Added triggered RAM capture of the control step signals with pre-trigger history, read back with LOGR
+**	Added compressed telemetry stream: deltas as zig-zag varints, periodic keyframes and sequence numbers, STREAM_DELTA
 ****************************************************************/
 
 /****************************************************************
@@ -57,6 +90,10 @@
 **	uC_PWM		|	PA2,B20	|	PA3,B21	|	PB4,B22	|	PB5,B23	|	PWM
 **	uC_CTRLA	|	PA4		|	PA6		|	PB2		|	PD6		|	INA, SEL0
 **	uC_CTRLB	|	PA5		|	PA7		|	PB3		|	PD7		|	INB
+**	uC_SENSE	|	PD0		|	PD1		|	PD2		|	PD3		|	MultiSense
+**
+**	BATTERY
+**	uC_VBAT		|	PD4		|	Divider VBAT_SENSE_R_HI, VBAT_SENSE_R_LO
 ****************************************************************/
 
 /****************************************************************
@@ -83,6 +120,26 @@
 #include "at_string.h"
 //PID S16 class
 #include "pid_s16.h"
+//Cooperative scheduler
+#include "scheduler.h"
+//Execution time statistics
+#include "profiler.h"
+//Trapezoidal position profile
+#include "trap_profile.h"
+//Moving average that turns trapezoids into S-curves
+#include "scurve_filter.h"
+//Queue of motion segments
+#include "motion_queue.h"
+//Differential drive odometry
+#include "odometry.h"
+//Interpolation of sparse setpoints
+#include "setpoint_interp.h"
+//Rate limiter of the speed reference
+#include "accel_limiter.h"
+//Inner current loop
+#include "current_loop.h"
+//RAM capture of the control step
+#include "data_logger.h"
 
 /****************************************************************
 ** FUNCTION PROTOTYPES
@@ -105,18 +162,84 @@ extern bool init_pid( OrangeBot::Pid_s16 *pid_vector );
 extern Dc_motor_pwm convert_s16_to_pwm( int16_t input, bool f_dir );
 //Set PWM of all motor channels applying slew rate limiting
 extern void update_pwm( void );
-//Compute speed. Unit of measure is Count/Tick.
-extern bool compute_speed( int16_t *enc_speed );
+//Load the duty cycle of a TCB in single shot mode. true = pulse in progress, try again next period
+extern bool load_tcb_duty( TCB_t &timer, uint16_t duty );
+//Apply the current limit and detect stalled wheels
+extern void update_current_monitor( int32_t *enc_cnt );
+//Command of a closed loop mode to a motor. PWM or current reference
+extern void set_motor_command( uint8_t index, int16_t cmd );
+//Write the duty of a VNH7040 controlled motor directly in its PWM generator
+extern void set_vnh7040_duty( uint8_t index, uint16_t duty );
+//Limits and gains of the PIDs for the tick rate and for the command in use
+extern void set_pid_gains( void );
+//true = PID gains would overflow or lose bits once scaled to a command and a tick rate
+extern bool check_pid_gains( bool f_current_loop, Tick_rate rate, int16_t kp, int16_t ki, int16_t kd );
+//Compute speed from the encoder counters of this step. Unit of measure is Count/Base Tick.
+extern void compute_speed( const int32_t *enc_cnt, int16_t *enc_speed );
+//Check the triggers and record the signals of the control step in the RAM capture
+extern void log_step( void );
 
 
 //Generate double sided reference for all four motors
 extern void generate_reference( Control_mode mode, uint16_t top );
 
+	///----------------------------------------------------------------------
+	///	ERRORS
+	///----------------------------------------------------------------------
+
+//Send an error message through UART
+extern void send_error( Error_code err_code );
+
+	///----------------------------------------------------------------------
+	///	TASKS
+	///----------------------------------------------------------------------
+
+//Execute one step of the motor control system from the main loop
+extern void control_task( void );
+//Update the communication timeout
+extern void timeout_task( void );
+//Blink the activity LED
+extern void led_task( void );
+//Send unsolicited telemetry
+extern void telemetry_task( void );
+//Send the frames of the telemetry stream
+extern void stream_task( void );
+//Send a value of a compressed frame of the telemetry stream
+extern void stream_push_varint( int32_t num );
+//Compute the battery voltage and the gain of the voltage compensation
+extern void vbat_task( void );
+
 /****************************************************************
 ** GLOBAL VARIABLES
 ****************************************************************/
 
 volatile Isr_flags g_isr_flags;
+//Cooperative scheduler of the periodic tasks
+OrangeBot::Scheduler g_scheduler;
+
+	///----------------------------------------------------------------------
+	///	PROFILING
+	///----------------------------------------------------------------------
+
+//Timestamp at the last TCA0 overflow
+volatile uint16_t g_timestamp_base;
+//TOP of TCA0 for the period in progress
+volatile uint16_t g_timestamp_top;
+//Timestamp at the TCA0 overflow that raised the last system tick
+volatile uint16_t g_timestamp_tick;
+//System ticks since reset
+volatile uint32_t g_tick_num = 0;
+//System ticks raised by the TCA0 ISR and not yet given to the scheduler
+volatile uint8_t g_tick_pending = 0;
+//Execution time statistics. One for each Prof_channel
+OrangeBot::Profiler g_prof[PROF_NUM];
+
+	///----------------------------------------------------------------------
+	///	ERRORS
+	///----------------------------------------------------------------------
+
+//Errors reported but not yet sent. Bit n is Error_code n
+volatile uint8_t g_err_pending = (uint8_t)0x00;
 
 	///----------------------------------------------------------------------
 	///	BUFFERS
@@ -140,8 +263,45 @@ uint8_t v1[ RPI_TX_BUF_SIZE ];
 Control_mode g_control_mode			= CONTROL_STOP;
 //Target motor control mode
 Control_mode g_control_mode_target	= CONTROL_STOP;
+//Rate of the system tick
+Tick_rate g_tick_rate				= TICK_RATE_500HZ;
+//true = control step is executed by the TCA0 overflow ISR | false = control step is executed by the scheduler
+volatile bool g_f_ctrl_isr			= false;
+//TCA0 overflows in one system tick. More than one only when TCA0 runs at the PWM rate
+volatile uint8_t g_tick_div			= 1;
 //Target for the position PID
 int32_t g_pid_pos_target[ENC_NUM];
+//Fraction of count left over when integrating the speed reference into the position target. Fixed point SETPOINT_INTERP_FRAC
+int16_t g_pid_pos_residual[ENC_NUM];
+//Shape the speed setpoints of the host into a smooth reference. Output is fixed point SETPOINT_INTERP_FRAC
+OrangeBot::Setpoint_interp g_spd_interp[ ENC_NUM ];
+//Acceleration limit of the interpolated speed reference
+OrangeBot::Accel_limiter g_spd_limiter[ ENC_NUM ];
+//Acceleration and deceleration limits of the speed reference. Counts per base tick squared. Fixed point POS_PROFILE_AMAX_FRAC
+int16_t g_spd_acc[ ENC_NUM ];
+int16_t g_spd_dec[ ENC_NUM ];
+//Each encoder has an associated PID controller
+OrangeBot::Pid_s16 g_vnh7040_pid[ ENC_NUM ];
+//Gains of the PIDs. Fixed point PID_GAIN_FP, before the scaling of set_pid_gains
+int16_t g_spd_pid_kp = SPD_PID_KP;
+int16_t g_spd_pid_ki = SPD_PID_KI;
+int16_t g_spd_pid_kd = SPD_PID_KD;
+//Position profile generator of the CONTROL_POS mode
+OrangeBot::Trap_profile g_pos_profile[ ENC_NUM ];
+//Maximum speed of the position profile. Counts per base tick
+int16_t g_pos_vmax[ ENC_NUM ];
+//Acceleration of the position profile. Counts per base tick squared. Fixed point POS_PROFILE_AMAX_FRAC
+int16_t g_pos_amax[ ENC_NUM ];
+//Motion queue of the CONTROL_QUEUE mode. Axis 0 is the right side, axis 1 is the left side
+OrangeBot::Motion_queue g_motion_queue;
+//Encoder counts at the origin of the motion queue
+int32_t g_queue_base[ ENC_NUM ];
+//Limits applied to the segments pushed in the motion queue. Same units as the position profile
+int16_t g_queue_vmax = MOTION_QUEUE_VMAX;
+int16_t g_queue_amax = MOTION_QUEUE_AMAX;
+int16_t g_queue_jerk = MOTION_QUEUE_JERK;
+//Pose of the platform integrated from the encoders every tick
+OrangeBot::Odometry g_odometry;
 
 	///--------------------------------------------------------------------------
 	///	MOTORS
@@ -151,6 +311,46 @@ int32_t g_pid_pos_target[ENC_NUM];
 Dc_motor_pwm g_dc_motor[DC_MOTOR_NUM];
 //Two DC Motor channels
 Dc_motor_pwm g_dc_motor_target[DC_MOTOR_NUM];
+//true = a motor with zero PWM is braked to ground | false = a motor with zero PWM coasts
+bool g_f_vnh7040_brake = false;
+//Staged direction pins of each motor inside its port. Applied by commit_vnh7040
+uint8_t g_vnh7040_stage_pin[DC_MOTOR_NUM];
+//Staged duty cycle of each motor. Applied by commit_vnh7040
+uint16_t g_vnh7040_stage_pwm[DC_MOTOR_NUM];
+//Settings committed to the TCA0 overflow ISR. Single shot PWM backend. Direction pins of PORTA, PORTB, PORTD
+volatile uint8_t g_vnh7040_load_pin[3];
+volatile uint16_t g_vnh7040_load_pwm[DC_MOTOR_NUM];
+//true = committed settings are waiting for the start of a PWM period
+volatile bool g_f_vnh7040_load = false;
+//INA and INB pins of each motor inside its port. Drivers 0,1 on PORTA, driver 2 on PORTB, driver 3 on PORTD
+const uint8_t g_vnh7040_ina[DC_MOTOR_NUM] = { 0x10, 0x40, 0x04, 0x40 };
+const uint8_t g_vnh7040_inb[DC_MOTOR_NUM] = { 0x20, 0x80, 0x08, 0x80 };
+//Port of the INA and INB pins of each motor
+PORT_t *const g_vnh7040_port[DC_MOTOR_NUM] = { &PORTA, &PORTA, &PORTB, &PORTD };
+//PWM generator of each motor
+TCB_t *const g_vnh7040_tcb[DC_MOTOR_NUM] = { &TCB0, &TCB1, &TCB2, &TCB3 };
+//Current of each motor from its MultiSense output. mA. Written by the ADC ISR
+volatile uint16_t g_motor_current[DC_MOTOR_NUM];
+//Bit of each motor: 1 = g_motor_current is measured | 0 = skipped samples for too long, unknown
+volatile uint8_t g_motor_current_valid = 0;
+//true = PID output is a current reference for the inner current loop | false = PID output is a PWM
+volatile bool g_f_current_loop = false;
+//true = a closed loop mode is driving the motors through the inner current loop
+volatile bool g_f_current_loop_run = false;
+//Inner current loop of each motor. Executed by the ADC ISR
+OrangeBot::Current_loop g_current_loop[DC_MOTOR_NUM];
+//Signed current reference of each motor. mA. Written by the control step
+volatile int16_t g_current_ref[DC_MOTOR_NUM];
+//Duty computed by the inner current loop of each motor. Written by the ADC ISR
+volatile uint16_t g_current_duty[DC_MOTOR_NUM];
+//Open loop command of each motor. Voltage, DC_MOTOR_MAX_PWM is VBAT_NOMINAL_MV
+int16_t g_pwm_cmd[DC_MOTOR_NUM];
+//Filtered ADC reading of the battery divider. Fixed point VBAT_FILTER_FP. Written by the ADC ISR
+volatile uint16_t g_vbat_adc = 0;
+//Battery voltage. mV
+uint16_t g_vbat_mv = 0;
+//From voltage command to PWM. VBAT_NOMINAL_MV /battery voltage. Fixed point VBAT_SCALE_FP
+volatile uint16_t g_vbat_scale = ((uint16_t)1 << VBAT_SCALE_FP);
 
 	///--------------------------------------------------------------------------
 	///	ENCODERS
@@ -165,6 +365,39 @@ int16_t g_enc_spd[ENC_NUM];
 //Encoder speed reference
 int16_t g_pid_spd_target[ENC_NUM];
 
+	///--------------------------------------------------------------------------
+	///	TELEMETRY STREAM
+	///--------------------------------------------------------------------------
+
+//Signals of the stream. STREAM_xxx bits. 0 = no stream
+uint8_t g_stream_mask = 0;
+//A frame is sent every this many base ticks
+uint16_t g_stream_decim = 1;
+//Longest frame of the subscribed signals, terminator included
+uint8_t g_stream_len = 0;
+//Frames skipped for lack of room in the TX buffer. Saturates
+uint16_t g_stream_skip = 0;
+//Sequence number of the next compressed frame. Multiple of STREAM_KEY_PERIOD = keyframe
+uint8_t g_stream_seq = 0;
+
+	///--------------------------------------------------------------------------
+	///	DATA LOGGER
+	///--------------------------------------------------------------------------
+
+//RAM capture of the control step
+OrangeBot::Data_logger g_data_logger;
+//Signals of a record for each logged wheel. LOG_SIG_xxx bits
+uint16_t g_log_sig = 0;
+//Wheels in a record. Bit 0 is wheel 0
+uint8_t g_log_wheel = 0;
+//Trigger sources. LOG_TRIG_xxx bits
+uint8_t g_log_trig = 0;
+//Smallest jump of the reference that triggers LOG_TRIG_STEP
+uint16_t g_log_step_th = 0;
+//Reference and feedback of the PID of each wheel in the last closed loop step
+int16_t g_ctrl_ref[ENC_NUM];
+int16_t g_ctrl_fb[ENC_NUM];
+
 /****************************************************************************
 **  Function
 **  main |
@@ -180,17 +413,18 @@ int main(void)
 	//	VARS
 	//----------------------------------------------------------------
 
-	//system tick prescaler
-	uint8_t pre = 0;
-	//activity LED prescaler
-	uint8_t pre_led = 0;
-	
-	//Blink speed of the LED. Start slow
-	uint8_t blink_speed = 99;
 	//Raspberry PI UART RX Parser
 	Orangebot::Uniparser rpi_rx_parser = Orangebot::Uniparser();
-	//Each encoder has an associated PID controller
-	OrangeBot::Pid_s16 vnh7040_pid[ ENC_NUM ];
+	//Timestamp at the start of the current and of the previous main loop iteration
+	uint16_t timestamp, timestamp_old;
+	//Execution time of the previous main loop iteration
+	uint16_t loop_time;
+	//true = previous main loop iteration did nothing
+	bool f_idle = false;
+	//System ticks raised by the TCA0 ISR since the last iteration
+	uint8_t tick_pending;
+	//counter
+	uint8_t t;
 	
 	//----------------------------------------------------------------
 	//	INIT
@@ -210,7 +444,14 @@ int main(void)
 	//! Initialize the static vars of the encoder decoding ISR
 	quad_encoder_decoder( PORTC.IN );
 	//! Initialize all PID controllers
-	init_pid( vnh7040_pid );
+	init_pid( g_vnh7040_pid );
+	//! Initialize profilers
+	g_prof[PROF_LOOP].set_hist_shift( PROF_LOOP_SHIFT );
+	g_prof[PROF_IDLE].set_hist_shift( PROF_IDLE_SHIFT );
+	g_prof[PROF_CTRL].set_hist_shift( PROF_CTRL_SHIFT );
+	g_prof[PROF_ISR].set_hist_shift( PROF_ISR_SHIFT );
+	g_prof[PROF_CTRL_LAT].set_hist_shift( PROF_CTRL_LAT_SHIFT );
+	g_prof[PROF_TICK].set_hist_shift( PROF_TICK_SHIFT );
 
 		//!	Initialize VNH7040
 	//Enable sense output
@@ -239,296 +480,188 @@ int main(void)
 	rpi_rx_parser.add_cmd( "ENC", (void *)&get_encoder_cnt_handler );
 	//Send encoder speed reading through UART
 	rpi_rx_parser.add_cmd( "ENCSPD", (void *)&get_encoder_spd_handler );
+	//Send execution time and overruns of a scheduler task through UART
+	rpi_rx_parser.add_cmd( "SCH%u", (void *)&get_scheduler_stats_handler );
+	//Set the system tick rate [Hz]
+	rpi_rx_parser.add_cmd( "TICK%U", (void *)&set_tick_rate_handler );
+	//Send CPU load through UART
+	rpi_rx_parser.add_cmd( "LOAD", (void *)&get_load_handler );
+	//Send execution time statistics of a profiling channel through UART
+	rpi_rx_parser.add_cmd( "PROF%u", (void *)&get_profiler_handler );
+	//Send execution time histogram of a profiling channel through UART
+	rpi_rx_parser.add_cmd( "HIST%u", (void *)&get_histogram_handler );
+	//Clear profiling and scheduler statistics
+	rpi_rx_parser.add_cmd( "PROFCLR", (void *)&clear_profiler_handler );
+	//Execute the control step inside the timer ISR (1) or inside the main loop (0)
+	rpi_rx_parser.add_cmd( "CISR%u", (void *)&set_control_isr_handler );
+	//Set the absolute position target of a wheel. Switch to position control
+	rpi_rx_parser.add_cmd( "POS%dT%d", (void *)&set_pos_target_handler );
+	//Set maximum speed and acceleration of the position profile of a wheel
+	rpi_rx_parser.add_cmd( "PLIM%SV%SA%S", (void *)&set_pos_limits_handler );
+	//Set speed, acceleration and jerk limits of the following motion segments
+	rpi_rx_parser.add_cmd( "QLIM%SA%SJ%S", (void *)&set_queue_limits_handler );
+	//Queue a speed segment. Right and left speed, duration in base ticks
+	rpi_rx_parser.add_cmd( "QVR%SL%ST%S", (void *)&queue_speed_handler );
+	//Queue a position segment. Right and left absolute positions
+	rpi_rx_parser.add_cmd( "QPR%dL%d", (void *)&queue_position_handler );
+	//Send depth and underruns of the motion queue through UART
+	rpi_rx_parser.add_cmd( "QSTAT", (void *)&get_queue_status_handler );
+	//Drop all segments and stop the platform
+	rpi_rx_parser.add_cmd( "QCLR", (void *)&abort_queue_handler );
+	//Set forward and angular speed of the platform. Speed PID
+	rpi_rx_parser.add_cmd( "FWD%STRN%S", (void *)&set_platform_turn_handler );
+	//Send the pose of the platform through UART
+	rpi_rx_parser.add_cmd( "ODOM", (void *)&get_odometry_handler );
+	//Move the origin of the odometry on the platform
+	rpi_rx_parser.add_cmd( "ODOMCLR", (void *)&clear_odometry_handler );
+	//Select the interpolation of the speed setpoints. 0=step 1=linear 2=cubic
+	rpi_rx_parser.add_cmd( "SINT%u", (void *)&set_spd_interp_handler );
+	//Set acceleration and deceleration limits of the speed reference of a wheel
+	rpi_rx_parser.add_cmd( "ALIM%SA%SD%S", (void *)&set_spd_limits_handler );
+	//Zero PWM coasts (0) or brakes to ground (1)
+	rpi_rx_parser.add_cmd( "BRK%u", (void *)&set_stop_mode_handler );
+	//Current of the four motors. mA
+	rpi_rx_parser.add_cmd( "CUR", (void *)&get_motor_current_handler );
+	//Battery voltage. mV
+	rpi_rx_parser.add_cmd( "VBAT", (void *)&get_vbat_handler );
+	//PID output is a PWM (0) or a current reference for the inner current loop (1). Feedforward, proportional and integral gains
+	rpi_rx_parser.add_cmd( "ILOOP%SF%SP%SI%S", (void *)&set_current_loop_handler );
+	//Proportional, integral and derivative gains of the speed and position PIDs
+	rpi_rx_parser.add_cmd( "GAINP%SI%SD%S", (void *)&set_pid_gains_handler );
+	//Subscribe to the telemetry stream. Signals STREAM_xxx and decimation in base ticks. SUB0D0 stops it
+	rpi_rx_parser.add_cmd( "SUB%UD%U", (void *)&set_stream_handler );
+	//Signals, decimation and skipped frames of the telemetry stream
+	rpi_rx_parser.add_cmd( "SUBSTAT", (void *)&get_stream_handler );
+	//Set up the RAM capture. Signals LOG_SIG_xxx, wheels, records before the trigger and decimation in control steps
+	rpi_rx_parser.add_cmd( "LOGS%UW%UP%UD%U", (void *)&set_log_handler );
+	//Arm the RAM capture. Trigger sources LOG_TRIG_xxx and threshold of the reference step
+	rpi_rx_parser.add_cmd( "LOGA%UH%U", (void *)&arm_log_handler );
+	//Trigger the RAM capture
+	rpi_rx_parser.add_cmd( "LOGT", (void *)&trigger_log_handler );
+	//State, records and pre-trigger records of the RAM capture
+	rpi_rx_parser.add_cmd( "LOGSTAT", (void *)&get_log_status_handler );
+	//Read a record of the RAM capture. 0 is the oldest
+	rpi_rx_parser.add_cmd( "LOGR%U", (void *)&read_log_handler );
+	
+		///----------------------------------------------------------------------
+		///	REGISTER PERIODIC TASKS
+		///----------------------------------------------------------------------
+		//	Tasks with the same period are given different phases so that they are executed on different ticks
+
+	//Motor control system. Executed every tick with highest priority
+	g_scheduler.add_task( SCHED_CTRL_PERIOD, SCHED_CTRL_PHASE, 0, (void *)&control_task );
+	//Communication timeout
+	g_scheduler.add_task( SCHED_TIMEOUT_PERIOD, SCHED_TIMEOUT_PHASE, 1, (void *)&timeout_task );
+	//Unsolicited telemetry
+	g_scheduler.add_task( SCHED_TELEMETRY_PERIOD, SCHED_TELEMETRY_PHASE, 2, (void *)&telemetry_task );
+	//Activity LED
+	g_scheduler.add_task( SCHED_LED_PERIOD, SCHED_LED_PHASE, 3, (void *)&led_task );
+	//Battery voltage compensation
+	g_scheduler.add_task( SCHED_VBAT_PERIOD, SCHED_VBAT_PHASE, 4, (void *)&vbat_task );
+	//Telemetry stream. Lowest priority, frames wait for the control
+	g_scheduler.add_task( SCHED_STREAM_PERIOD, SCHED_STREAM_PHASE, 5, (void *)&stream_task );
 	
 	//----------------------------------------------------------------
 	//	BODY
 	//----------------------------------------------------------------
 
+	//Default limits of the position profiles and of the speed references. They are converted to the tick rate by set_tick_rate
+	//For: each wheel
+	for (t = 0;t < ENC_NUM;t++)
+	{
+		g_pos_vmax[t] = POS_PROFILE_VMAX;
+		g_pos_amax[t] = POS_PROFILE_AMAX;
+		g_spd_acc[t] = SPD_LIMIT_ACC;
+		g_spd_dec[t] = SPD_LIMIT_DEC;
+	}
+	//Geometry of the platform
+	g_odometry.set_track( ODOM_TRACK_COUNTS );
+	//Start at the base tick rate
+	set_tick_rate( TICK_RATE_500HZ );
+	//Start profiling the main loop
+	timestamp_old = GET_TIMESTAMP();
+
 	//Main loop
 	for EVER
 	{
-		//If: System Tick 500Hz
-		if (g_isr_flags.system_tick == 1)
+		//Advance the emulated peripherals. Nothing on the target
+		HAL_POLL();
+
+		//----------------------------------------------------------------
+		//	PROFILING
+		//----------------------------------------------------------------
+		//	Iterations are measured back to back so that their sum is the elapsed time
+		
+		timestamp = GET_TIMESTAMP();
+		loop_time = timestamp -timestamp_old;
+		timestamp_old = timestamp;
+		//Previous iteration
+		g_prof[PROF_LOOP].add( loop_time );
+		//if: previous iteration did nothing
+		if (f_idle == true)
 		{
-			//Clear system tick
-			g_isr_flags.system_tick = 0;
-			//Execute speed PID
-			g_isr_flags.ctrl_updt = true;
-						
-			//----------------------------------------------------------------
-			//	SYSTEM PRESCALER SPEED CODE
-			//----------------------------------------------------------------
-				
-			//If prescaler has reset
-			if (pre == 0)
-			{		
-				//----------------------------------------------------------------
-				//	LED BLINK
-				//----------------------------------------------------------------
-				//		Two speeds
-				//	slow: not in timeout and commands can be executed
-				//	fast: in timeout, motor stopped
-				
-				if (pre_led == 0)
-				{
-					//Toggle PF5.
-					SET_BIT( PORTF.OUTTGL, 5 );	
-					//DEBUG: Generate reference ramp and send encoder speed message
-					//generate_reference( CONTROL_SPD, 15 );
-					//get_encoder_spd_handler();
-					get_encoder_cnt_handler();
-				}
-				//Increment with top
-				pre_led = AT_TOP_INC( pre_led, blink_speed );
-				
-				//----------------------------------------------------------------
-				//	PARSER TIMEOUT
-				//----------------------------------------------------------------
-				
-				//Update communication timeout counter
-				g_uart_timeout_cnt++;
-				//
-				if (g_uart_timeout_cnt >= RPI_COM_TIMEOUT)
-				{
-					//Clip timeout counter
-					g_uart_timeout_cnt = RPI_COM_TIMEOUT;
-					//If: it's the first time the communication timeout is detected
-					if (g_f_timeout_detected == false)
-					{						
-						//LED is blinking faster
-						blink_speed = 9;
-					}
-					//raise the timeout flag
-					g_f_timeout_detected = true;
-				}
-				else
-				{
-					//This is the only code allowed to reset the timeout flag
-					g_f_timeout_detected = false;
-					//LED is blinking slower
-					blink_speed = 99;
-				}		
-				
-				//DEBUG: Generate Reference PWM ramp
-				//generate_reference( CONTROL_PWM, 127 );
-			}
-			//Increment prescaler and reset if it exceeds the TOP.
-			pre = AT_TOP_INC( pre, 4);
-			
-		}	//End If: System Tick
+			g_prof[PROF_IDLE].add( loop_time );
+		}
+		//This iteration is idle unless it does something
+		f_idle = true;
+		
+		//Fetch and clear the pending system ticks
+		cli();
+		tick_pending = g_tick_pending;
+		g_tick_pending = (uint8_t)0;
+		sei();
+		//While: System Tick. An iteration longer than a tick leaves more than one
+		while (tick_pending > 0)
+		{
+			//Release the tasks that are due. A task released again before it runs counts as an overrun
+			g_scheduler.tick();
+			tick_pending--;
+			//Not idle
+			f_idle = false;
+		}	//End While: System Tick
 		
 		//----------------------------------------------------------------
-		//	MOTOR COTROL SYSTEM
-		//----------------------------------------------------------------		
+		//	PERIODIC TASKS
+		//----------------------------------------------------------------
+		//	One task at most is executed for each loop so that UART is served between tasks
 		
-		//If: Authorized to execute one step the PID speed controllers
-		if (g_isr_flags.ctrl_updt == 1)
+		//if: Execute the ready task with highest priority
+		if (g_scheduler.exe() == true)
 		{
-			//Clear flag
-			g_isr_flags.ctrl_updt = 0;
-				
-				//! Control switch to new control system
-			//If: communication timeout is detected
-			if (g_f_timeout_detected == true)
-			{
-				//if: control system is not STOP
-				if (g_control_mode != CONTROL_STOP)
-				{
-					//Set motors to full stop
-					g_control_mode = CONTROL_STOP;
-					//If, communication timeout was detected
-					report_error( ERR_CODE_COMMUNICATION_TIMEOUT );
-				}
-				//if: control is already STOP
-				else
-				{
-					//do nothing
-				}
-			}
-			//if: PID saturation error has been issued
-			else if (g_isr_flags.pid_sat_err == true)
-			{
-				//if: control system is not STOP
-				if (g_control_mode != CONTROL_STOP)
-				{
-					//Set motors to full stop
-					g_control_mode = CONTROL_STOP;
-					//Report the error
-					report_error( ERR_CODE_PID_UNLOCKED );
-				}
-				//if: control is already STOP
-				else
-				{
-					//do nothing
-				}
-			}
-			//otherwise
-			else
-			{
-					//! switch control mode. Initialize target if necessary.
-				//if: I'm switching between control modes
-				if (g_control_mode != g_control_mode_target)
-				{
-					//If: Hybrid speed-position mode
-					if (g_control_mode_target == CONTROL_SPD_POS)
-					{
-						//counter
-						uint8_t t;
-						//Currently accessing global encoder counters
-						g_isr_flags.enc_sem = true;
-						//For: Scan all encoders
-						for (t = 0;t < ENC_NUM;t++)
-						{
-							//Initialize position target
-							g_pid_pos_target[t] = g_enc_cnt[t];
-						}
-						//Unreserve
-						g_isr_flags.enc_sem = false;
-					}
-				}
-				
-				//Control mode is the one desired by the user
-				g_control_mode = g_control_mode_target;
-			}
-				//! Execute a step in the right control mode
-			//If: control system is in STOP state
-			if (g_control_mode == CONTROL_STOP)
-			{
-				//counter
-				uint8_t t;
-				//Scan all motors
-				for (t = 0;t < DC_MOTOR_NUM;t++)
-				{
-					//Set Target PWM to zero
-					g_dc_motor_target[ t ].f_dir	= false;
-					g_dc_motor_target[ t ].pwm		= 0;
-				}
-				//Update PWM of the motors while applying the slew rate limiter
-				update_pwm();
-			}	//End If: control system is in STOP state
-			//If: control system is open loop PWM
-			else if (g_control_mode == CONTROL_PWM)
-			{
-				//Update PWM of the motors while applying the slew rate limiter
-				update_pwm();
-			}	//End If: control system is open loop PWM
-			//If: control system is closed loop speed
-			else if (g_control_mode == CONTROL_SPD)
-			{
-				//----------------------------------------------------------------
-				//	COMPUTE SPEED
-				//----------------------------------------------------------------
-				//	Fetch encoder reading
-				//	Compute derivative
-				//	Update old encoder memory registers
-				
-				//temp flag
-				bool f_ret;
-				//temp speed
-				int16_t enc_spd[ ENC_NUM ];
-				//Compute speed
-				f_ret = compute_speed( enc_spd );
-				//if: failed to update
-				if (f_ret == true)
-				{
-					//Signal error
-					report_error( ERR_CODE_BAD_ENCODER_COUNTERS );
-				}
-				//if: update was success
-				else
-				{
-					//counter
-					uint8_t t = 0;
-					//command
-					int16_t cmd;
-					//motor target pwm
-					Dc_motor_pwm pwm;
-					//Scan all PID
-					for (t=0;t < ENC_NUM;t++)
-					{
-						//Process the speed and get the command
-						cmd = vnh7040_pid[t].exe( g_pid_spd_target[t], enc_spd[t] );
-						//Convert from S16 to PWM. Sign correction should not be applied here because it would change the sign of the feedback loop
-						pwm = convert_s16_to_pwm( cmd, false );
-						//Use the command as reference for the PWM
-						g_dc_motor_target[t] = pwm;
-					}
-				}	//end if: update was success
-				
-				//Update PWM of the motors while applying the slew rate limiter
-				update_pwm();
-			}	//End If: control system is closed loop speed
-			//If: control system is closed loop speed but with closing PID in position
-			else if (g_control_mode == CONTROL_SPD_POS)
+			//Not idle
+			f_idle = false;
+		}
+		
+		//----------------------------------------------------------------
+		//	ERROR REPORT
+		//----------------------------------------------------------------
+		//	Errors are latched by report_error and sent from here, since the control step might be running inside an ISR
+		
+		//if: errors are pending
+		if (g_err_pending != 0)
+		{
+			//counter
+			uint8_t t;
+			//Local copy of the pending errors
+			uint8_t err_pending;
+			//Fetch and clear
+			cli();
+			err_pending = g_err_pending;
+			g_err_pending = (uint8_t)0x00;
+			sei();
+			//For: each error code
+			for (t = 0;t < 8;t++)
 			{
-				//----------------------------------------------------------------
-				//	GET CURRENT POSITION
-				//----------------------------------------------------------------
-				
-				//temp flag
-				bool f_ret;
-				//temp encoder counters. G-enc_cnt are volatile globals shared by ISR
-				int32_t enc_cnt[ENC_NUM];
-				//Force update of encoder counters and fetch their value
-				f_ret = get_enc_cnt( enc_cnt );
-				//if: update was success
-				if (f_ret == false)
-				{
-					//Counter
-					uint8_t t;
-					int32_t enc_target;
-					//temp errors
-					int32_t err32;
-					int16_t err16;
-					//command
-					int16_t cmd;
-					//motor target pwm
-					Dc_motor_pwm pwm;
-					
-					//----------------------------------------------------------------
-					//	GENERATE POS REFERENCE | COMPUTE POSITION PID | GENERATE PWM REFERENCE
-					//----------------------------------------------------------------
-					//	This is an hybrid mode. User tell the speed, and the speed is used to update the position reference
-					
-					//Scan all encoders
-					for (t=0;t < ENC_NUM;t++)
-					{
-						enc_target = g_pid_pos_target[t];
-						//At each tick, integrate the user given speed to compute the target position
-						enc_target += g_pid_spd_target[t];
-						g_pid_pos_target[t] = enc_target;
-						//Compute position error
-						err32 = (int32_t)enc_target -(int32_t)enc_cnt[t];
-						//Clip to 16b for use in the PID controller
-						err16 = AT_SAT( err32, (int16_t)32767, (int16_t)-32767);
-						//Compute PID and command feeding it directly the error
-						cmd = vnh7040_pid[t].exe( err16 );
-						//Convert from S16 to PWM. Sign correction should not be applied here because it would change the sign of the feedback loop
-						pwm = convert_s16_to_pwm( cmd, false );
-						//Use the command as reference for the PWM
-						g_dc_motor_target[t] = pwm;
-					}
-				}
-				//if: update failed
-				else
+				//if: error is pending
+				if (IS_BIT_ONE( err_pending, t ))
 				{
-					//Signal error
-					report_error( ERR_CODE_BAD_ENCODER_COUNTERS );
+					//Send error message
+					send_error( (Error_code)t );
 				}
-				
-				//Update PWM of the motors while applying the slew rate limiter
-				update_pwm();
 			}
-			//if: undefined control system
-			else
-			{
-				//Signal error
-				report_error( ERR_CODE_UNDEFINED_CONTROL_SYSTEM );
-				//Reset control mode
-				g_control_mode = CONTROL_STOP;
-			}	//End if: undefined control system
-			
-		}	//End If: Authorized to execute one step the PID speed controllers
+			//Not idle
+			f_idle = false;
+		}	//End If: errors are pending
 		
 		//----------------------------------------------------------------
 		//	AT4809 --> RPI USART TX
@@ -544,6 +677,8 @@ int main(void)
 			AT_BUF_KICK( rpi_tx_buf );
 			//Send data through the UART3
 			USART3.TXDATAL = tx_tmp;
+			//Not idle
+			f_idle = false;
 		}	//End If: RPI TX
 		
 		//----------------------------------------------------------------
@@ -568,6 +703,8 @@ int main(void)
 				///Command parser
 			//feed the input RX byte to the parser
 			rpi_rx_parser.exe( rx_tmp );
+			//Not idle
+			f_idle = false;
 			
 		} //endif: RPI RX buffer is not empty
 
@@ -582,12 +719,14 @@ int main(void)
 
 /***************************************************************************/
 //!	@brief function
-//!	error | Error_code
+//!	report_error | Error_code
 /***************************************************************************/
 //! @param err_code | (Error_code) caller report the error code experienced by the system
 //! @return void |
 //! @details
 //!	Error code handler function
+//!	Latch the error. The main loop sends it. Safe to call from ISRs
+//!	The same error reported more than once before it's sent is sent once
 /***************************************************************************/
 
 void report_error( Error_code err_code )
@@ -596,6 +735,51 @@ void report_error( Error_code err_code )
 	//	VARS
 	//----------------------------------------------------------------
 
+	//Status register. Interrupt enable
+	uint8_t sreg_tmp;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Save interrupt enable and disable interrupts
+	sreg_tmp = SREG;
+	cli();
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Latch the error
+	SET_BIT( g_err_pending, (uint8_t)err_code );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	//Restore interrupt enable
+	SREG = sreg_tmp;
+	
+	return;
+}	//End Function: report_error | Error_code
+
+/***************************************************************************/
+//!	@brief function
+//!	send_error | Error_code
+/***************************************************************************/
+//! @param err_code | (Error_code) error code to be sent
+//! @return void |
+//! @details
+//!	Send an error message through UART. ERR<code>
+//!	Must be called by the main loop
+/***************************************************************************/
+
+void send_error( Error_code err_code )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
 	//counter
 	uint8_t t;
 	//length of number string
@@ -634,7 +818,7 @@ void report_error( Error_code err_code )
 	//----------------------------------------------------------------
 	
 	return;
-}	//End Function: error | Error_code
+}	//End Function: send_error | Error_code
 
 /****************************************************************************
 **  Function
@@ -679,6 +863,16 @@ void init_motors( void )
 		g_dc_motor_target[t].pwm = (uint8_t)0x00;
 	}
 	
+	//For: scan motors
+	for (t = 0;t < DC_MOTOR_NUM;t++)
+	{
+		//Inner current loop. Disabled until the host enables it
+		g_current_loop[t].set_gains( CURRENT_LOOP_KFF << DC_MOTOR_PWM_SHIFT, CURRENT_LOOP_KP << DC_MOTOR_PWM_SHIFT, CURRENT_LOOP_KI << DC_MOTOR_PWM_SHIFT );
+		g_current_loop[t].set_limit( DC_MOTOR_MAX_PWM );
+		g_current_ref[t] = 0;
+		g_current_duty[t] = 0;
+	}
+	
 	//----------------------------------------------------------------
 	//	RETURN
 	//----------------------------------------------------------------
@@ -721,9 +915,9 @@ bool init_pid( OrangeBot::Pid_s16 *pid_vector )
 		pid_vector[t].limit_cmd_max() = +DC_MOTOR_MAX_PWM;
 		pid_vector[t].limit_cmd_min() = -DC_MOTOR_MAX_PWM;
 		//Initialize PID Gain
-		pid_vector[t].gain_kp() = SPD_PID_KP;
-		pid_vector[t].gain_ki() = SPD_PID_KI;
-		pid_vector[t].gain_kd() = SPD_PID_KD;
+		pid_vector[t].gain_kp() = SPD_PID_KP << DC_MOTOR_PWM_SHIFT;
+		pid_vector[t].gain_ki() = SPD_PID_KI << DC_MOTOR_PWM_SHIFT;
+		pid_vector[t].gain_kd() = SPD_PID_KD << DC_MOTOR_PWM_SHIFT;
 	}
 
 	//----------------------------------------------------------------
@@ -741,12 +935,13 @@ bool init_pid( OrangeBot::Pid_s16 *pid_vector )
 //! @param index	| index of the motor to be controlled. 0 to 3
 //! @param f_dir	| direction of rotation of the motor
 //! @param speed	| Speed of the motor
-//! @brief Set direction and speed setting of the VNH7040 controlled motor
+//! @brief Stage direction and speed setting of the VNH7040 controlled motor
 //! @details 
-//!
+//!	Setting is applied to the hardware by commit_vnh7040 together with the other motors
+//!	Zero speed either coasts or brakes to ground depending on g_f_vnh7040_brake
 /***************************************************************************/
 
-void set_vnh7040_speed( uint8_t index, bool f_dir, uint8_t speed )
+void set_vnh7040_speed( uint8_t index, bool f_dir, uint16_t speed )
 {
 	//----------------------------------------------------------------
 	//	VARS
@@ -756,386 +951,2506 @@ void set_vnh7040_speed( uint8_t index, bool f_dir, uint8_t speed )
 	//	INIT
 	//----------------------------------------------------------------
 	
-	//----------------------------------------------------------------
-	//	BODY
-	//----------------------------------------------------------------
-
-	//Driver 0
-	if (index == 0)
-	{
-		//Set INA, INB and SEL0 to select the direction of rotation of the motor
-		if (f_dir == true)
-		{
-			SET_MASKED_BIT( PORTA.OUT, 0x30, 0x10);
-		}
-		else
-		{
-			SET_MASKED_BIT( PORTA.OUT, 0x30, 0x20);
-		}
-		//Set the PWM value of the right PWM channel of TCA0
-		TCB0.CCMPH = speed;	
-	}
-	//Driver 1
-	else if (index == 1)
-	{
-		//Set INA, INB and SEL0 to select the direction of rotation of the motor
-		if (f_dir == true)
-		{
-			SET_MASKED_BIT( PORTA.OUT, 0xc0, 0x40);
-		}
-		else
-		{
-			SET_MASKED_BIT( PORTA.OUT, 0xc0, 0x80);
-		}
-		//Set the PWM value of the right PWM channel of TCA0
-		TCB1.CCMPH = speed;
-	}
-	//Driver 2
-	else if (index == 2)
-	{
-		//Set INA, INB and SEL0 to select the direction of rotation of the motor
-		if (f_dir == true)
-		{
-			SET_MASKED_BIT( PORTB.OUT, 0x0c, 0x04);
-		}
-		else
-		{
-			SET_MASKED_BIT( PORTB.OUT, 0x0c, 0x08);
-		}
-		//Set the PWM value of the right PWM channel of TCA0
-		TCB2.CCMPH = speed;
-	}
-	//Driver 3
-	else if (index == 3)
+	//if: driver index not installed
+	if (index >= DC_MOTOR_NUM)
 	{
-		//Set INA, INB and SEL0 to select the direction of rotation of the motor
-		if (f_dir == true)
-		{
-			SET_MASKED_BIT( PORTD.OUT, 0xc0, 0x40);
-		}
-		else
-		{
-			SET_MASKED_BIT( PORTD.OUT, 0xc0, 0x80);
-		}
-		//Set the PWM value of the right PWM channel of TCA0
-		TCB3.CCMPH = speed;
+		//Do nothing
+		return;
 	}
-	//Default case
-	else
+	//if: stop mode is brake
+	if ((speed == 0) && (g_f_vnh7040_brake == true))
 	{
-		//Driver index not installed.
-		//Do nothing
+		//Short the motor
+		set_vnh7040_brake( index );
+		return;
 	}
 
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Set INA or INB to select the direction of rotation of the motor. INA is also SEL0
+	g_vnh7040_stage_pin[index] = (f_dir == true)?(g_vnh7040_ina[index]):(g_vnh7040_inb[index]);
+	//Duty cycle of the TCB of the motor. A single shot pulse must end before the next trigger
+	g_vnh7040_stage_pwm[index] = AT_SAT( speed, DC_MOTOR_MAX_PWM, 0 );
+
 	//----------------------------------------------------------------
 	//	RETURN
 	//----------------------------------------------------------------
 	
 	return;
-}	//End: 
+}	//End: set_vnh7040_speed
 
-/***************************************************************************/
-//!	@brief convert from a DC motor PWM structure to a speed number
-//!	convert_pwm_to_s16 | Dc_motor_pwm
-/***************************************************************************/
-//! @param input | Dc_motor_pwm	input PWM structure
-//! @param f_dir | bool			conversion between clockwise/counterclockwise to forward/backward
-//! @return int16_t |			speed number
+/****************************************************************************
+**  Function
+**  set_vnh7040_brake
+****************************************************************************/
+//! @return void |
+//! @param index	| index of the motor to be controlled. 0 to 3
+//! @brief Stage a brake to ground of the VNH7040 controlled motor
+//! @details 
+//!	INA and INB low connect both motor terminals to ground. Full PWM keeps the low side switches on
+//!	Setting is applied to the hardware by commit_vnh7040 together with the other motors
 /***************************************************************************/
 
-inline int16_t convert_pwm_to_s16( Dc_motor_pwm input, bool f_dir )
+void set_vnh7040_brake( uint8_t index )
 {
 	//----------------------------------------------------------------
 	//	VARS
 	//----------------------------------------------------------------
 
-	//temp return
-	int16_t ret;
-
 	//----------------------------------------------------------------
 	//	INIT
 	//----------------------------------------------------------------
+	
+	//if: driver index not installed
+	if (index >= DC_MOTOR_NUM)
+	{
+		//Do nothing
+		return;
+	}
 
 	//----------------------------------------------------------------
 	//	BODY
 	//----------------------------------------------------------------
 
-	//Extract PWM setting
-	ret = input.pwm;
-	//if: direction is backward
-	if (input.f_dir != f_dir)
-	{
-		//Correct sign
-		ret = -ret;
-	}
+	//Clear INA, INB
+	g_vnh7040_stage_pin[index] = (uint8_t)0x00;
+	g_vnh7040_stage_pwm[index] = DC_MOTOR_MAX_PWM;
 
 	//----------------------------------------------------------------
 	//	RETURN
 	//----------------------------------------------------------------
 	
-	return ret;
-}
+	return;
+}	//End: set_vnh7040_brake
 
-/***************************************************************************/
-//!	@brief convert from a speed number to a dc motor PWM structure
-//!	convert_s16_to_pwm | int16_t, bool
-/***************************************************************************/
-//! @param input | int16_t 		Input speed number
-//! @param f_dir | bool			conversion between clockwise/counterclockwise to forward/backward
-//! @return Dc_motor_pwm		PWM structure
+/****************************************************************************
+**  Function
+**  commit_vnh7040
+****************************************************************************/
+//! @return void |
+//! @brief Apply the staged settings of all VNH7040 motors at once
+//! @details 
+//!	Duty cycles are loaded first. A plain duty change is taken by the TCB at the end of the running period.
+//!	Only when a direction pin changes, braking included, the pins are written with one access per port,
+//!	drivers 0 and 1 share PORTA, and the four TCB are restarted back to back so that the new
+//!	direction falls on the boundary of a PWM period. The periods are aligned once by init
+//!	The TCB are clocked by CLK_TCA. Residual skew is the few CPU cycles between the counter writes
+//!	Single shot backend: TCB are already restarted together by TCA0. Settings are handed to the TCA0 ISR
+//!	and loaded by load_vnh7040 at the start of the next PWM period
+//!	Can be called with interrupts disabled
 /***************************************************************************/
 
-Dc_motor_pwm convert_s16_to_pwm( int16_t input, bool f_dir )
+void commit_vnh7040( void )
 {
 	//----------------------------------------------------------------
 	//	VARS
 	//----------------------------------------------------------------
 
-	//temp return
-	Dc_motor_pwm ret;
+	//Status register. Interrupt enable
+	uint8_t sreg_tmp;
+	//Direction pins of each port
+	uint8_t porta_tmp, portb_tmp, portd_tmp;
 
 	//----------------------------------------------------------------
 	//	INIT
 	//----------------------------------------------------------------
 
-	//Clip to valid PWM values
-	input = AT_SAT( input, DC_MOTOR_MAX_PWM, -DC_MOTOR_MAX_PWM);
+	//Compute the new port values before entering the critical section
+	porta_tmp = g_vnh7040_stage_pin[0] | g_vnh7040_stage_pin[1];
+	portb_tmp = g_vnh7040_stage_pin[2];
+	portd_tmp = g_vnh7040_stage_pin[3];
 
 	//----------------------------------------------------------------
 	//	BODY
 	//----------------------------------------------------------------
 
-	//For each DC motor channel
-	//If: right direction is backward
-	if (input < 0)
-	{
-		//Assign the pwm to the right temp channel
-		ret.pwm = -input;
-		ret.f_dir = !f_dir;
-	}
-	//If: right direction is forward
-	else
+	//Might be called by the control step inside an ISR or by a parser handler
+	sreg_tmp = SREG;
+	cli();
+#ifdef VNH7040_PWM_HIRES
+	//Direction pins of each port
+	g_vnh7040_load_pin[0] = porta_tmp;
+	g_vnh7040_load_pin[1] = portb_tmp;
+	g_vnh7040_load_pin[2] = portd_tmp;
+	//Duty cycles
+	g_vnh7040_load_pwm[0] = g_vnh7040_stage_pwm[0];
+	g_vnh7040_load_pwm[1] = g_vnh7040_stage_pwm[1];
+	g_vnh7040_load_pwm[2] = g_vnh7040_stage_pwm[2];
+	g_vnh7040_load_pwm[3] = g_vnh7040_stage_pwm[3];
+	//Load them at the next overflow of TCA0
+	g_f_vnh7040_load = true;
+#else
+	//Duty cycles
+	TCB0.CCMPH = g_vnh7040_stage_pwm[0];
+	TCB1.CCMPH = g_vnh7040_stage_pwm[1];
+	TCB2.CCMPH = g_vnh7040_stage_pwm[2];
+	TCB3.CCMPH = g_vnh7040_stage_pwm[3];
+	//if: a direction pin changes. Restarting the periods on every commit would cut them short at the tick rate
+	if (((PORTA.OUT & 0xf0) != (porta_tmp & 0xf0)) || ((PORTB.OUT & 0x0c) != (portb_tmp & 0x0c)) || ((PORTD.OUT & 0xc0) != (portd_tmp & 0xc0)))
 	{
-		//Assign the pwm to the right temp channel
-		ret.pwm = input;
-		ret.f_dir = f_dir;
+		//Direction pins
+		SET_MASKED_BIT( PORTA.OUT, 0xf0, porta_tmp );
+		SET_MASKED_BIT( PORTB.OUT, 0x0c, portb_tmp );
+		SET_MASKED_BIT( PORTD.OUT, 0xc0, portd_tmp );
+		//Counters at TOP. They overflow on the next CLK_TCA edge and start a new period
+		TCB0.CNT = VNH7040_PWM_TOP;
+		TCB1.CNT = VNH7040_PWM_TOP;
+		TCB2.CNT = VNH7040_PWM_TOP;
+		TCB3.CNT = VNH7040_PWM_TOP;
 	}
+#endif
+	//Restore interrupt enable
+	SREG = sreg_tmp;
 
 	//----------------------------------------------------------------
 	//	RETURN
 	//----------------------------------------------------------------
+	
+	return;
+}	//End: commit_vnh7040
 
-	return ret;
-}
-
-/***************************************************************************/
-//!	@brief update DC motor PWM
+/****************************************************************************
+**  Function
+**  load_vnh7040
+****************************************************************************/
+//! @return void |
+//! @brief Load the committed settings at the start of a PWM period
+//! @details 
+//!	Single shot backend. Called by the TCA0 overflow ISR when g_f_vnh7040_load is set.
+//!	TCA0 has just started the pulses of the new period, so direction pins change while they are short
+//!	A duty cycle that can't be loaded without losing the compare match is loaded on the next period
+/***************************************************************************/
+
+void load_vnh7040( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//true = at least one duty cycle has yet to be loaded
+	bool f_pending;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Direction pins
+	SET_MASKED_BIT( PORTA.OUT, 0xf0, g_vnh7040_load_pin[0] );
+	SET_MASKED_BIT( PORTB.OUT, 0x0c, g_vnh7040_load_pin[1] );
+	SET_MASKED_BIT( PORTD.OUT, 0xc0, g_vnh7040_load_pin[2] );
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Duty cycles
+	f_pending = load_tcb_duty( TCB0, g_vnh7040_load_pwm[0] );
+	f_pending |= load_tcb_duty( TCB1, g_vnh7040_load_pwm[1] );
+	f_pending |= load_tcb_duty( TCB2, g_vnh7040_load_pwm[2] );
+	f_pending |= load_tcb_duty( TCB3, g_vnh7040_load_pwm[3] );
+	//Done when all duty cycles have been loaded
+	g_f_vnh7040_load = f_pending;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+	
+	return;
+}	//End: load_vnh7040
+
+/****************************************************************************
+**  Function
+**  load_tcb_duty | TCB_t &, uint16_t
+****************************************************************************/
+//! @param timer	| TCB in single shot mode
+//! @param duty		| pulse length in TCB counts. 0 = no pulse
+//! @return bool	| false = loaded | true = pulse in progress, try again next period
+//! @brief Load the duty cycle of a TCB in single shot mode
+//! @details 
+//!	The compare register is not buffered in single shot mode. Moving it below the count of a running pulse
+//!	would miss the match and hold the output high until the counter wraps around
+//!	Zero duty disables the event input. A zero compare would also miss the match
+/***************************************************************************/
+
+bool load_tcb_duty( TCB_t &timer, uint16_t duty )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//if: no pulse
+	if (duty == 0)
+	{
+		//Pulse in progress ends on its compare. Next trigger is ignored
+		CLEAR_BIT( timer.EVCTRL, TCB_CAPTEI_bp );
+		return false;
+	}
+	//if: duty is already loaded
+	if (timer.CCMP == duty)
+	{
+		//Make sure the trigger is enabled
+		SET_BIT( timer.EVCTRL, TCB_CAPTEI_bp );
+		return false;
+	}
+	//if: pulse in progress already went past the new duty
+	if ((IS_BIT_ONE( timer.STATUS, TCB_RUN_bp )) && (duty <= timer.CNT +VNH7040_PWM_MARGIN))
+	{
+		//Pulse ends on the old compare
+		return true;
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//New pulse length
+	timer.CCMP = duty;
+	//Trigger from the overflow of TCA0
+	SET_BIT( timer.EVCTRL, TCB_CAPTEI_bp );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+	
+	return false;
+}	//End: load_tcb_duty
+
+/****************************************************************************
+**  Function
+**  get_vnh7040_duty | uint8_t
+****************************************************************************/
+//! @param index	| index of the motor. 0 to 3
+//! @return uint16_t | duty cycle loaded in the PWM generator. 0 = off
+//! @brief Duty cycle loaded in the PWM generator of the VNH7040 controlled motor
+//! @details 
+//!	Reads the hardware, so it's the setting in use even between stage and commit
+//!	Called by the ADC ISR
+/***************************************************************************/
+
+uint16_t get_vnh7040_duty( uint8_t index )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//PWM generator of the motor
+	TCB_t *timer;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//if: driver index not installed
+	if (index >= DC_MOTOR_NUM)
+	{
+		return 0;
+	}
+	timer = g_vnh7040_tcb[index];
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+#ifdef VNH7040_PWM_HIRES
+	//if: trigger is disabled. Zero duty
+	if (IS_BIT_ZERO( timer -> EVCTRL, TCB_CAPTEI_bp ))
+	{
+		return 0;
+	}
+	//Pulse length
+	return timer -> CCMP;
+#else
+	//Duty in 8 bit PWM mode
+	return timer -> CCMPH;
+#endif
+}	//End: get_vnh7040_duty
+
+/****************************************************************************
+**  Function
+**  set_vnh7040_duty | uint8_t, uint16_t
+****************************************************************************/
+//! @param index	| index of the motor. 0 to 3
+//! @param duty		| duty cycle
+//! @return void |
+//! @brief Write the duty of a VNH7040 controlled motor directly in its PWM generator
+//! @details 
+//!	Bypasses stage and commit. Direction pins are not changed
+//!	Called by the inner current loop inside the ADC ISR
+//!	Single shot PWM backend: a duty the pulse in progress already went past is skipped, the next sample tries again
+/***************************************************************************/
+
+void set_vnh7040_duty( uint8_t index, uint16_t duty )
+{
+	//if: driver index not installed
+	if (index >= DC_MOTOR_NUM)
+	{
+		return;
+	}
+	duty = AT_SAT( duty, DC_MOTOR_MAX_PWM, 0 );
+
+#ifdef VNH7040_PWM_HIRES
+	//Single shot pulse length
+	load_tcb_duty( *g_vnh7040_tcb[index], duty );
+#else
+	//Buffered duty in 8 bit PWM mode
+	g_vnh7040_tcb[index] -> CCMPH = (uint8_t)duty;
+#endif
+
+	return;
+}	//End: set_vnh7040_duty
+
+/****************************************************************************
+**  Function
+**  is_vnh7040_brake | uint8_t
+****************************************************************************/
+//! @param index	| index of the motor. 0 to 3
+//! @return bool	| true = motor is braked to ground
+//! @brief true = VNH7040 controlled motor is braked to ground
+//! @details 
+//!	INA and INB are both low. Reads the output register of the port
+/***************************************************************************/
+
+bool is_vnh7040_brake( uint8_t index )
+{
+	//if: driver index not installed
+	if (index >= DC_MOTOR_NUM)
+	{
+		return false;
+	}
+
+	return ((g_vnh7040_port[index] -> OUT & (g_vnh7040_ina[index] | g_vnh7040_inb[index])) == 0);
+}	//End: is_vnh7040_brake
+
+/****************************************************************************
+**  Function
+**  get_motor_current | uint16_t *
+****************************************************************************/
+//! @param current	| vector of DC_MOTOR_NUM elements. Current of each motor in mA
+//! @return uint8_t | bit of each motor. 1 = current is measured | 0 = unknown, current reads 0
+//! @brief Copy the current of all motors. mA
+//! @details 
+//!	Currents are written by the ADC ISR. Can be called with interrupts disabled
+//!	A motor whose on time is too short to sample for CURRENT_SENSE_STALE_NUM samples has an unknown current
+/***************************************************************************/
+
+uint8_t get_motor_current( uint16_t *current )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Status register. Interrupt enable
+	uint8_t sreg_tmp;
+	//counter
+	uint8_t t;
+	//Motors whose current is measured
+	uint8_t valid;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//16 bit values written by the ADC ISR
+	sreg_tmp = SREG;
+	cli();
+	for (t = 0;t < DC_MOTOR_NUM;t++)
+	{
+		current[t] = g_motor_current[t];
+	}
+	valid = g_motor_current_valid;
+	SREG = sreg_tmp;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+	
+	return valid;
+}	//End: get_motor_current
+
+/****************************************************************************
+**  Function
+**  update_current_monitor | int32_t *
+****************************************************************************/
+//! @param enc_cnt	| encoder counters fetched this tick
+//! @return void |
+//! @brief Apply the current limit and detect stalled wheels
+//! @details 
+//!	Current limit: while the current of a wheel is above CURRENT_LIMIT_MA its speed reference
+//!	can only move toward zero. Speed modes only, profiles of the position modes are not held
+//!	Stall: a wheel that moves at most CURRENT_STALL_SPD with a current above CURRENT_STALL_MA
+//!	for CURRENT_STALL_TIME base ticks raises the motor_stall flag. Control step stops the platform
+//!	A wheel whose current is unknown is neither limited nor checked for stall
+/***************************************************************************/
+
+void update_current_monitor( int32_t *enc_cnt )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//counter
+	uint8_t t;
+	//Current of each motor. mA
+	uint16_t current[DC_MOTOR_NUM];
+	//Encoder counters of the previous tick
+	static int32_t enc_old[ENC_NUM];
+	//System ticks each wheel has been stalled
+	static uint16_t stall_cnt[ENC_NUM] = { 0 };
+	//Speed of the wheel. Counts per base tick
+	int32_t spd;
+	//Wheels whose current is measured
+	uint8_t valid;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	valid = get_motor_current( current );
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//For: each wheel
+	for (t = 0;t < ENC_NUM;t++)
+	{
+		//Hold the acceleration of the speed reference above the current limit
+		g_spd_limiter[t].set_hold( (IS_BIT_ONE( valid, t )) && (current[t] > CURRENT_LIMIT_MA) );
+		//Speed of the wheel
+		spd = (enc_cnt[t] -enc_old[t]) << g_tick_rate;
+		enc_old[t] = enc_cnt[t];
+		//if: wheel doesn't turn with a measured stall current
+		if ((IS_BIT_ONE( valid, t )) && (current[t] > CURRENT_STALL_MA) && (spd <= CURRENT_STALL_SPD) && (spd >= -CURRENT_STALL_SPD))
+		{
+			stall_cnt[t]++;
+			//if: stalled for long enough
+			if (stall_cnt[t] >= ((uint16_t)CURRENT_STALL_TIME << g_tick_rate))
+			{
+				g_isr_flags.motor_stall = true;
+				stall_cnt[t] = 0;
+			}
+		}
+		else
+		{
+			stall_cnt[t] = 0;
+		}
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+	
+	return;
+}	//End: update_current_monitor
+
+/****************************************************************************
+**  Function
+**  set_motor_command | uint8_t, int16_t
+****************************************************************************/
+//! @param index	| index of the motor. 0 to 3
+//! @param cmd		| output of the PID. PWM, or current reference in mA when the inner current loop is enabled
+//! @return void |
+//! @brief Command of a closed loop mode to a motor
+//! @details 
+//!	Inner current loop: the sign of the reference selects the direction, the ADC ISR regulates the duty.
+//!	The target PWM is the last duty of the loop, so update_pwm and the reversal brake keep working.
+//!	A motor the loop is not driving yet starts from the feedforward duty
+/***************************************************************************/
+
+void set_motor_command( uint8_t index, int16_t cmd )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Save the interrupt status
+	uint8_t sreg;
+	//Duty of the inner current loop
+	uint16_t duty;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//if: driver index not installed
+	if (index >= DC_MOTOR_NUM)
+	{
+		return;
+	}
+	//if: command is a PWM
+	if (g_f_current_loop == false)
+	{
+		g_dc_motor_target[index] = convert_s16_to_pwm( cmd, false );
+		return;
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Reference and duty are shared with the ADC ISR
+	sreg = SREG;
+	cli();
+	g_current_ref[index] = cmd;
+	duty = g_current_duty[index];
+	//if: loop is not driving the motor. Start from the feedforward
+	if ((duty == 0) && (cmd != 0))
+	{
+		duty = g_current_loop[index].exe( (cmd < 0)?(-cmd):(cmd), 0, false );
+	}
+	SREG = sreg;
+	//Negative command is the same direction as convert_s16_to_pwm
+	g_dc_motor_target[index].f_dir = (cmd < 0);
+	g_dc_motor_target[index].pwm = duty;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+	
+	return;
+}	//End: set_motor_command
+
+/****************************************************************************
+**  Function
+**  current_loop_step | uint8_t, uint16_t, bool
+****************************************************************************/
+//! @param index	| index of the motor. 0 to 3
+//! @param current	| current of the motor from one sample. mA
+//! @param f_valid	| true = sample falls inside the on time | false = on time too short, current is unknown
+//! @return void |
+//! @brief Execute the inner current loop of a motor
+//! @details 
+//!	Called by the ADC ISR for each sample of the motor, one PWM period in VBAT_SENSE_CH +1.
+//!	MultiSense only sees the magnitude of the high side current. The loop only drives the motor
+//!	when the direction pins agree with the sign of the reference. Otherwise update_pwm is braking or reversing
+/***************************************************************************/
+
+void current_loop_step( uint8_t index, uint16_t current, bool f_valid )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Signed current reference. mA
+	int16_t ref;
+	//Duty computed by the loop
+	uint16_t duty;
+	//true = direction pins select a negative command
+	bool f_dir;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//if: driver index not installed
+	if (index >= DC_MOTOR_NUM)
+	{
+		return;
+	}
+	//if: no closed loop mode is driving the motors through the loop
+	if (g_f_current_loop_run == false)
+	{
+		g_current_loop[index].reset();
+		g_current_duty[index] = 0;
+		return;
+	}
+	ref = g_current_ref[index];
+	f_dir = ((g_vnh7040_port[index] -> OUT & g_vnh7040_ina[index]) != 0);
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//if: no reference, or the motor is braked, or the direction doesn't match the reference yet
+	if ((ref == 0) || (is_vnh7040_brake( index ) == true) || (f_dir != (ref < 0)))
+	{
+		//Restart from the feedforward. update_pwm drives the motor
+		g_current_loop[index].reset();
+		duty = 0;
+	}
+	else
+	{
+		//Regulate the magnitude of the current
+		duty = g_current_loop[index].exe( (ref < 0)?(-ref):(ref), current, f_valid );
+		//Apply now, without waiting for the next tick
+		set_vnh7040_duty( index, duty );
+	}
+	//Read by the control step
+	g_current_duty[index] = duty;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+	
+	return;
+}	//End: current_loop_step
+
+/***************************************************************************/
+//!	@brief convert from a DC motor PWM structure to a speed number
+//!	convert_pwm_to_s16 | Dc_motor_pwm
+/***************************************************************************/
+//! @param input | Dc_motor_pwm	input PWM structure
+//! @param f_dir | bool			conversion between clockwise/counterclockwise to forward/backward
+//! @return int16_t |			speed number
+/***************************************************************************/
+
+inline int16_t convert_pwm_to_s16( Dc_motor_pwm input, bool f_dir )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//temp return
+	int16_t ret;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Extract PWM setting
+	ret = input.pwm;
+	//if: direction is backward
+	if (input.f_dir != f_dir)
+	{
+		//Correct sign
+		ret = -ret;
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+	
+	return ret;
+}
+
+/***************************************************************************/
+//!	@brief convert from a speed number to a dc motor PWM structure
+//!	convert_s16_to_pwm | int16_t, bool
+/***************************************************************************/
+//! @param input | int16_t 		Input speed number. Full scale is DC_MOTOR_MAX_PWM of the PWM backend
+//! @param f_dir | bool			conversion between clockwise/counterclockwise to forward/backward
+//! @return Dc_motor_pwm		PWM structure
+/***************************************************************************/
+
+Dc_motor_pwm convert_s16_to_pwm( int16_t input, bool f_dir )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//temp return
+	Dc_motor_pwm ret;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Clip to valid PWM values
+	input = AT_SAT( input, DC_MOTOR_MAX_PWM, -DC_MOTOR_MAX_PWM);
+	//Input is a voltage. Scale by the battery so that the motor sees the same voltage over the whole charge
+	input = AT_SAT( ((int32_t)input *g_vbat_scale) >> VBAT_SCALE_FP, DC_MOTOR_MAX_PWM, -DC_MOTOR_MAX_PWM );
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//For each DC motor channel
+	//If: right direction is backward
+	if (input < 0)
+	{
+		//Assign the pwm to the right temp channel
+		ret.pwm = -input;
+		ret.f_dir = !f_dir;
+	}
+	//If: right direction is forward
+	else
+	{
+		//Assign the pwm to the right temp channel
+		ret.pwm = input;
+		ret.f_dir = f_dir;
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return ret;
+}
+
+/***************************************************************************/
+//!	@brief update DC motor PWM
 //!	update_pwm | void
 /***************************************************************************/
-//! @return void
-//!	@details
-//! Move PWM toward target PWM
-//! Apply slew rate limiter
+//! @return void
+//!	@details
+//! Move PWM toward target PWM
+//! Apply slew rate limiter
+//! A reversal brakes the motor to ground for a time proportional to the PWM, then drives in the new direction
+/***************************************************************************/
+
+void update_pwm( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//temp counter
+	uint8_t t;
+	//true if speed has changed
+	//bool f_change[DC_MOTOR_NUM];
+
+	Dc_motor_pwm target_speed, actual_speed;
+	//Slew rate prescaler. Slew rate is given per base tick
+	static uint8_t slew_pre = 0;
+	//Slew rate allowed in this tick
+	uint16_t slew_rate;
+	//System ticks of active brake left before a reversal
+	static uint8_t brake_cnt[DC_MOTOR_NUM] = { 0 };
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//if: closed loop. Acceleration is limited on the reference, a PWM limit would only add lag to the loop
+	if ((g_control_mode == CONTROL_SPD) || (g_control_mode == CONTROL_SPD_POS) || (g_control_mode == CONTROL_POS) || (g_control_mode == CONTROL_QUEUE))
+	{
+		slew_rate = DC_MOTOR_MAX_PWM;
+		//Inner current loop drives the motors, if enabled
+		g_f_current_loop_run = (g_f_current_loop == true) && (g_f_timeout_detected == false);
+	}
+	//if: open loop
+	else
+	{
+		//Allow a PWM change only on the first system tick of each base tick
+		slew_rate = (slew_pre == 0)?(DC_MOTOR_SLEW_RATE):(0);
+		//PWM comes from the host
+		g_f_current_loop_run = false;
+	}
+	//Increment prescaler. Number of system ticks in a base tick is a power of two
+	slew_pre = (slew_pre +1) & ((1 << g_tick_rate) -1);
+
+	//If the communication failed
+	if (g_f_timeout_detected == true)
+	{
+		//Counter
+		uint8_t t;
+		//For: scan motors
+		for (t = 0;t < DC_MOTOR_NUM;t++)
+		{
+			//Stop the motors
+			set_vnh7040_speed( (uint8_t)t, (uint8_t)false, (uint8_t)0x00 );
+			//Update actual PWM so tat slew rate limiter will do sensible things when restarting
+			g_dc_motor[t].pwm = (uint8_t)0x00;
+			brake_cnt[t] = (uint8_t)0;
+		}
+		//Apply to all motors at once
+		commit_vnh7040();
+		//
+		return;
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//For: each DC motor channel
+	for (t = 0;t < DC_MOTOR_NUM;t++)
+	{
+		//Fetch current settings
+		target_speed = g_dc_motor_target[t];
+		actual_speed = g_dc_motor[t];
+		
+		//If directions are different
+		if (target_speed.f_dir != actual_speed.f_dir)
+		{
+			//if: motor is driven hard enough to need an active brake
+			if ((brake_cnt[t] == 0) && ((actual_speed.pwm >> DC_MOTOR_BRAKE_SHIFT) > 0))
+			{
+				//Brake time is proportional to the PWM being reversed. Base ticks to system ticks
+				brake_cnt[t] = (actual_speed.pwm >> DC_MOTOR_BRAKE_SHIFT) << g_tick_rate;
+				//Drive is off. Slew rate limiter will restart from zero
+				actual_speed.pwm = 0;
+			}
+			//if: braking
+			if (brake_cnt[t] > 0)
+			{
+				brake_cnt[t]--;
+				//Stage a short of the motor to ground
+				set_vnh7040_brake( t );
+				//Write back setting
+				g_dc_motor[t] = actual_speed;
+				//Next motor
+				continue;
+			}
+			//Brake is over, or PWM was too low to need one. I'm authorized to change direction
+			actual_speed.pwm = 0;
+			actual_speed.f_dir = target_speed.f_dir;
+		}	//End If directions are different
+		//if direction is the same
+		else
+		{
+			//Target went back to the current direction. Abort the brake
+			brake_cnt[t] = (uint8_t)0;
+		}
+		
+		//Directions are the same. Move the PWM toward the target
+		//if pwm is above target
+		if (actual_speed.pwm > target_speed.pwm)
+		{
+			//if: target is more than a step away
+			if (actual_speed.pwm -target_speed.pwm > slew_rate)
+			{
+				//Decrease speed by PWM
+				actual_speed.pwm -= slew_rate;
+			}
+			else
+			{
+				//I reached the target
+				actual_speed.pwm = target_speed.pwm;
+			}
+		}
+		//if pwm is below target
+		else if (actual_speed.pwm < target_speed.pwm)
+		{
+			//if: target is more than a step away
+			if (target_speed.pwm -actual_speed.pwm > slew_rate)
+			{
+				//Increase speed by PWM
+				actual_speed.pwm += slew_rate;
+			}
+			else
+			{
+				//I reached the target
+				actual_speed.pwm = target_speed.pwm;
+			}
+		}
+		//if: I'm already at the right speed
+		else
+		{
+			//do nothing
+		}
+		
+		//Stage setting
+		set_vnh7040_speed( t, actual_speed.f_dir, actual_speed.pwm );
+		
+		//Write back setting
+		g_dc_motor[t] = actual_speed;
+	}	//End For: each DC motor channel
+	
+	//Apply the settings of all motors at once
+	commit_vnh7040();
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return; //OK
+}	//end handler: update_pwm | void
+
+/***************************************************************************/
+//!	function
+//!	get_enc_cnt
+/***************************************************************************/
+//! @param enc_cnt | int32_t vector. Function returns in this vector the value of the global encoder counters
+//! @return bool | false=OK | true=failed to update global counters
+//! @brief Force an update and save the 32b encoder counters in an input vector
+//! @details
+//!		Algorithm:
+//!	>disable interrupt
+//!	>raise sync flag
+//!	>manually execute encoder decoding routine
+//! >Transfer register value to local vars
+/***************************************************************************/
+
+bool get_enc_cnt( int32_t *enc_cnt )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Counter
+	uint8_t t;
+	//return flag
+	bool f_ret;
+	//Status register. Interrupt enable
+	uint8_t sreg_tmp;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Save interrupt enable and disable interrupts. Called by the control step, that might be running inside an ISR
+	sreg_tmp = SREG;
+	cli();
+	//Force update of 32b global counters
+	g_isr_flags.enc_updt = true;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Decode encoders and update 32b counters 
+	quad_encoder_decoder( PORTC.IN );
+	//Restore interrupt enable
+	SREG = sreg_tmp;
+	//If encoder routine failed to update global counters
+	f_ret = g_isr_flags.enc_updt;
+	//For: all encoder channels
+	for (t = 0;t < ENC_NUM;t++)
+	{
+		//Copy
+		enc_cnt[t] = g_enc_cnt[t];
+	}
+	
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+	
+	//false = OK | true = fail (global counters failed to update)
+	return f_ret;
+}
+
+/***************************************************************************/
+//!	function
+//!	function_template
+/***************************************************************************/
+//! @param enc_cnt | (int32_t*) encoder counters fetched by the control step with get_enc_cnt
+//! @param enc_speed | (int16_t*) writeback vector that will hold the result
+//! @return void
+//! @brief Compute speed. Unit of measure is Count/Base Tick.
+//! @details Speed is scaled by the number of system ticks in a base tick so that it doesn't depend on the tick rate
+//!	Counters are read once per control step, so speed, odometry and the current monitor see the same sample
+/***************************************************************************/
+
+void compute_speed( const int32_t *enc_cnt, int16_t *enc_speed )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//temp counter
+	uint8_t t;
+	//Speed before saturation
+	int32_t spd32;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Scan encoders
+	for (t = 0;t< ENC_NUM;t++)
+	{
+		//Counts per system tick
+		spd32 = enc_cnt[t] -g_old_enc_cnt[t];
+		//Counts per base tick
+		spd32 = spd32 *((int32_t)1 << g_tick_rate);
+		//Compute speed saturating to limit of the var
+		enc_speed[t] = AT_SAT( spd32, (int16_t)32767, (int16_t)-32767 );
+		//enc_speed[t] = enc_cnt[t] -g_old_enc_cnt[t];
+		//Save memories
+		g_old_enc_cnt[t] = enc_cnt[t];
+		g_enc_spd[t] = enc_speed[t];
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+	
+	return;
+}
+
+/***************************************************************************/
+//!	@brief function
+//!	generate_reference
+/***************************************************************************/
+//! @param top | U8 maximum command
+//! @return void |
+//! @details
+//! Generate double sided reference for all four motors
+/***************************************************************************/
+
+void generate_reference( Control_mode mode, uint16_t top )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//index of the motor under test
+	static uint8_t motor_index = 0;
+	//Speed ramp. false = accelerate | true = decelerate
+	static bool f_ramp = false;
+	//Direction. false =  clockwise | true = counterclockwise
+	static bool f_dir = false;
+	//Speed counter
+	static uint16_t speed = 0;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+		
+		//! Ramp generator
+	//If increase speed
+	if (f_ramp == false)
+	{
+		//increase speed
+		speed++;
+		//if: speed cap
+		if (speed >= top)
+		{
+			//now decrease speed
+			f_ramp = true;
+		}
+	}
+	//If decrease speed
+	else
+	{
+		//decrease speed
+		speed--;
+		//If: speed cap
+		if (speed <= (uint8_t)0x00)
+		{
+			//Now increase speed
+			f_ramp = false;
+			//Invert motor direction
+			f_dir = !f_dir;
+			//If I'm going forward again
+			if (f_dir == false)
+			{
+				//change motor under test
+				motor_index = AT_TOP_INC( motor_index, 3);
+			}
+		}
+	}
+		//! Command generator
+	//if: open loop PWM test ramp
+	if (mode == CONTROL_PWM)
+	{
+		//Assign command. Converted to PWM by the control step
+		g_pwm_cmd[ motor_index ] = (f_dir == true)?((int16_t)DC_MOTOR_HOST_PWM( speed )):(-(int16_t)DC_MOTOR_HOST_PWM( speed ));
+		//Reset communication timeout
+		g_uart_timeout_cnt = 0;
+		//Select Open loop PWM control system
+		g_control_mode_target = mode;
+	}
+	//if: speed PID control mode
+	else if (mode == CONTROL_SPD)
+	{
+		//temp command
+		int16_t command;
+		
+		if (f_dir == false)
+		{
+			command = speed;
+		}
+		else
+		{
+			command = -speed;
+		}
+		
+		//Assign command
+		g_pid_spd_target[ motor_index ] = command;
+		g_spd_interp[ motor_index ].set_target( command );
+		//Reset communication timeout
+		g_uart_timeout_cnt = 0;
+		//Select control mode
+		g_control_mode_target = mode;
+		
+		uint8_t t, len, msg[10];
+		
+		AT_BUF_PUSH( rpi_tx_buf, 'M' );
+		len = u8_to_str( motor_index, msg );
+		for (t = 0;t<len;t++)
+		{
+			AT_BUF_PUSH(rpi_tx_buf,msg[t]);
+		}
+		AT_BUF_PUSH( rpi_tx_buf, 'S' );
+		AT_BUF_PUSH( rpi_tx_buf, 'P' );
+		AT_BUF_PUSH( rpi_tx_buf, 'D' );
+		len = s16_to_str( g_pid_spd_target[ motor_index ], msg );
+		for (t = 0;t<len;t++)
+		{
+			AT_BUF_PUSH(rpi_tx_buf,msg[t]);
+		}
+		AT_BUF_PUSH( rpi_tx_buf, '\0' );
+		
+	}
+	//if: bad reference control mode
+	else
+	{
+		//
+		g_control_mode_target = CONTROL_STOP;
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+	
+	return;
+}	//End function: generate_reference
+
+/***************************************************************************/
+//!	@brief handler
+//!	pid_saturation_error_handler
+/***************************************************************************/
+//! @return void |
+//! @details
+//! This function is automatically called by a PID when it cannot lock quickly enough to the reference
+/***************************************************************************/
+
+void pid_saturation_error_handler( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//A PID wasn't able to lock quickly enough to the reference
+	g_isr_flags.pid_sat_err = true;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+	
+	return;
+}	//End function: pid_saturation_error_handler
+
+/***************************************************************************/
+//!	@brief function
+//!	set_tick_rate | Tick_rate
+/***************************************************************************/
+//! @param rate | new rate of the system tick
+//! @return bool | false = OK | true = fail
+//! @details
+//! Change the rate of the system tick and rescale everything that depends on it
+//!	Timer: the new TOP is written in the buffered period register and is loaded at the next overflow
+//!	PID: integral gain scales with the tick period and derivative gain with the tick rate
+//!	so that the controllers keep the same continuous time behaviour. Saturation threshold is kept constant in time.
+//!	A rate that would truncate the integral gain or overflow the derivative gain is refused
+//!	Speed: speeds are measured in counts per base tick by compute_speed, so the PID sees the same units
+//!	Scheduler: service tasks keep the same period in time. Control task runs every tick
+/***************************************************************************/
+
+bool set_tick_rate( Tick_rate rate )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//counter
+	uint8_t t;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//if: rate is not supported
+	if (rate > TICK_RATE_2KHZ)
+	{
+		return true;	//fail
+	}
+	//if: gains of the PIDs can't be scaled to the new rate
+	if (check_pid_gains( g_f_current_loop, rate, g_spd_pid_kp, g_spd_pid_ki, g_spd_pid_kd ) == true)
+	{
+		return true;	//fail
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Control step might be running inside the TCA0 ISR
+	cli();
+
+		//! Timer
+#ifdef VNH7040_PWM_HIRES
+	//TCA0 runs at the PWM rate. Count more or fewer overflows
+	g_tick_div = (uint8_t)SYS_TICK_DIV( rate );
+#else
+	//Buffered period. Avoid a missed compare when the new TOP is below the current count
+	TCA0.SINGLE.PERBUF = (uint16_t)SYS_TICK_TCA_TOP( rate );
+#endif
+
+		//! Scheduler
+	g_scheduler.set_period( SCHED_TASK_TIMEOUT, SCHED_TIMEOUT_PERIOD << rate );
+	g_scheduler.set_period( SCHED_TASK_TELEMETRY, SCHED_TELEMETRY_PERIOD << rate );
+	g_scheduler.set_period( SCHED_TASK_LED, SCHED_LED_PERIOD << rate );
+	g_scheduler.set_period( SCHED_TASK_VBAT, SCHED_VBAT_PERIOD << rate );
+	g_scheduler.set_period( SCHED_TASK_STREAM, SCHED_STREAM_PERIOD << rate );
+
+	//Save new rate. Used by speed computation and slew rate limiter
+	g_tick_rate = rate;
+
+		//! PID
+	set_pid_gains();
+
+		//! Position profile
+	//Scan all profiles
+	for (t = 0;t < ENC_NUM;t++)
+	{
+		//Convert the limits to the new tick
+		set_pos_limits( t, g_pos_vmax[t], g_pos_amax[t] );
+		set_spd_limits( t, g_spd_acc[t], g_spd_dec[t] );
+	}
+
+		//! Motion queue
+	//Queued segments are in system ticks. Drop them and stop
+	g_motion_queue.abort();
+
+		//! Setpoint interpolation
+	//Interval between setpoints is measured in system ticks. Jump on the setpoint and measure again
+	for (t = 0;t < ENC_NUM;t++)
+	{
+		g_spd_interp[t].reset( g_pid_spd_target[t] );
+	}
+
+	sei();
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+	
+	return false;	//OK
+}	//End function: set_tick_rate | Tick_rate
+
+/***************************************************************************/
+//!	@brief function
+//!	set_pid_gains | void
+/***************************************************************************/
+//! @return void |
+//! @details
+//! Limits and gains of the PIDs for the tick rate and for the command in use
+//!	PWM command: gains scale with the resolution of the PWM
+//!	Current command: gains scale to mA. One 8 bit PWM step is about 2^CURRENT_LOOP_PID_SHIFT mA of stall current
+//!	Call with interrupts disabled. Control step might be running inside the TCA0 ISR
+/***************************************************************************/
+
+void set_pid_gains( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//counter
+	uint8_t t;
+	//Scale of the gains
+	uint8_t shift;
+	//Maximum command
+	int16_t cmd_max;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//if: PID output is a current reference
+	if (g_f_current_loop == true)
+	{
+		shift = CURRENT_LOOP_PID_SHIFT;
+		cmd_max = CURRENT_LOOP_MAX_MA;
+	}
+	//if: PID output is a PWM
+	else
+	{
+		shift = DC_MOTOR_PWM_SHIFT;
+		cmd_max = DC_MOTOR_MAX_PWM;
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Scan all PID
+	for (t = 0;t < ENC_NUM;t++)
+	{
+		g_vnh7040_pid[t].limit_cmd_max() = +cmd_max;
+		g_vnh7040_pid[t].limit_cmd_min() = -cmd_max;
+		g_vnh7040_pid[t].gain_kp() = g_spd_pid_kp << shift;
+		g_vnh7040_pid[t].gain_ki() = (g_spd_pid_ki << shift) >> g_tick_rate;
+		g_vnh7040_pid[t].gain_kd() = g_spd_pid_kd << (shift +g_tick_rate);
+		g_vnh7040_pid[t].limit_sat_th() = POS_PID_SAT_TH << g_tick_rate;
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+	
+	return;
+}	//End function: set_pid_gains | void
+
+/***************************************************************************/
+//!	@brief function
+//!	check_pid_gains | bool, Tick_rate, int16_t, int16_t, int16_t
+/***************************************************************************/
+//! @param f_current_loop | true = PID output is a current reference | false = PID output is a PWM
+//! @param rate | rate of the system tick
+//! @param kp | proportional gain. Fixed point PID_GAIN_FP
+//! @param ki | integral gain. Fixed point PID_GAIN_FP
+//! @param kd | derivative gain. Fixed point PID_GAIN_FP
+//! @return bool | false = OK | true = gains can't be scaled
+//! @details
+//! Check the gains against the scaling of set_pid_gains before it's applied
+//!	Overflow: every scaled gain has to fit an int16_t. The derivative gain grows with the tick rate
+//!	Truncation: the integral gain is divided by the system ticks in a base tick. The bits shifted out
+//!	have to be zero, otherwise a small integral gain would shrink or vanish after a change of the tick rate
+/***************************************************************************/
+
+bool check_pid_gains( bool f_current_loop, Tick_rate rate, int16_t kp, int16_t ki, int16_t kd )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Scale of the gains
+	uint8_t shift;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Same scale as set_pid_gains
+	shift = (f_current_loop == true)?((uint8_t)CURRENT_LOOP_PID_SHIFT):((uint8_t)DC_MOTOR_PWM_SHIFT);
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//if: negative gains
+	if ((kp < 0) || (ki < 0) || (kd < 0))
+	{
+		return true;	//fail
+	}
+	//if: a scaled gain overflows
+	if ((((int32_t)kp << shift) > (int32_t)32767) || (((int32_t)ki << shift) > (int32_t)32767) || (((int32_t)kd << (shift +rate)) > (int32_t)32767))
+	{
+		return true;	//fail
+	}
+	//if: the integral gain loses bits
+	if ((((int32_t)ki << shift) & (((int32_t)1 << rate) -1)) != 0)
+	{
+		return true;	//fail
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return false;	//OK
+}	//End function: check_pid_gains | bool, Tick_rate, int16_t, int16_t, int16_t
+
+/***************************************************************************/
+//!	@brief function
+//!	set_current_loop | bool, int16_t, int16_t, int16_t
+/***************************************************************************/
+//! @param f_enable | true = PID output is a current reference for the inner current loop | false = PID output is a PWM
+//! @param kff | feedforward gain. 8 bit PWM per mA. Fixed point CURRENT_LOOP_FP
+//! @param kp | proportional gain. 8 bit PWM per mA. Fixed point CURRENT_LOOP_FP
+//! @param ki | integral gain. 8 bit PWM per mA per sample. Fixed point CURRENT_LOOP_FP
+//! @return bool | false = OK | true = FAIL
+//! @details
+//! Enable or disable the inner current loop and set its gains
+//!	PID gains and limits are converted to the new command. Switch with the platform at rest
+/***************************************************************************/
+
+bool set_current_loop( bool f_enable, int16_t kff, int16_t kp, int16_t ki )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//counter
+	uint8_t t;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//if: gains are negative or out of range once converted to the PWM resolution
+	if ((kff < 0) || (kp < 0) || (ki < 0) || (kff > (CURRENT_LOOP_MAX_GAIN >> DC_MOTOR_PWM_SHIFT)) || (kp > (CURRENT_LOOP_MAX_GAIN >> DC_MOTOR_PWM_SHIFT)) || (ki > (CURRENT_LOOP_MAX_GAIN >> DC_MOTOR_PWM_SHIFT)))
+	{
+		return true;	//fail
+	}
+	//if: gains of the PIDs can't be scaled to the new command
+	if (check_pid_gains( f_enable, g_tick_rate, g_spd_pid_kp, g_spd_pid_ki, g_spd_pid_kd ) == true)
+	{
+		return true;	//fail
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Loops are executed by the ADC ISR, PIDs might be executed by the TCA0 ISR
+	cli();
+
+	//For: scan motors
+	for (t = 0;t < DC_MOTOR_NUM;t++)
+	{
+		g_current_loop[t].set_gains( kff << DC_MOTOR_PWM_SHIFT, kp << DC_MOTOR_PWM_SHIFT, ki << DC_MOTOR_PWM_SHIFT );
+		g_current_loop[t].reset();
+		g_current_ref[t] = 0;
+		g_current_duty[t] = 0;
+	}
+	g_f_current_loop = f_enable;
+	//PID output changes unit of measure
+	set_pid_gains();
+
+	sei();
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+	
+	return false;	//OK
+}	//End function: set_current_loop | bool, int16_t, int16_t, int16_t
+
+/***************************************************************************/
+//!	@brief function
+//!	set_spd_pid_gains | int16_t, int16_t, int16_t
+/***************************************************************************/
+//! @param kp | proportional gain. Fixed point PID_GAIN_FP
+//! @param ki | integral gain. Fixed point PID_GAIN_FP
+//! @param kd | derivative gain. Fixed point PID_GAIN_FP
+//! @return bool | false = OK | true = FAIL
+//! @details
+//! Set the gains of the PIDs of all wheels. Same units as SPD_PID_KP, SPD_PID_KI and SPD_PID_KD
+//!	Gains are scaled to the command and the tick rate in use, and kept across changes of either
+/***************************************************************************/
+
+bool set_spd_pid_gains( int16_t kp, int16_t ki, int16_t kd )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//if: gains are negative, would overflow or lose bits once scaled to the command and the tick rate in use
+	if (check_pid_gains( g_f_current_loop, g_tick_rate, kp, ki, kd ) == true)
+	{
+		return true;	//fail
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//PIDs might be executed by the TCA0 ISR
+	cli();
+
+	g_spd_pid_kp = kp;
+	g_spd_pid_ki = ki;
+	g_spd_pid_kd = kd;
+	set_pid_gains();
+
+	sei();
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+	
+	return false;	//OK
+}	//End function: set_spd_pid_gains | int16_t, int16_t, int16_t
+
+/***************************************************************************/
+//!	@brief function
+//!	set_control_isr | bool
+/***************************************************************************/
+//! @param f_enable | true = control step is executed by the TCA0 overflow ISR | false = by the main loop
+//! @return void |
+//! @details
+//! Select where the control step is executed
+//!	ISR: control step is executed by the TCA0 overflow ISR. Sampling period of the controllers
+//!	doesn't depend on the main loop, which is left for communication.
+//!	TCA0 overflow stays at level 0 like every other ISR, so the step never preempts one of them:
+//!	the encoder decoder, the inner current loop and the profilers of the ISRs are not reentrant.
+//!	While the control step runs, the encoder and UART RX ISRs are delayed. The encoder LUT
+//!	recovers a double event, the UART RX hardware buffer holds two bytes.
+//!	The ISR enforces it: a step longer than CTRL_ISR_MAX_TIME comes back here to select the main loop
+//!	Main loop: control step is executed by the scheduler and is delayed by the UART parser
+//! Latency statistics are cleared so that they only refer to the new mode
+//!	Single shot PWM backend: TCA0 overflows every PWM period and can't wait for the control step. Main loop only
+//!	Safe to call from ISRs
+/***************************************************************************/
+
+void set_control_isr( bool f_enable )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Status register. Interrupt enable
+	uint8_t sreg_tmp;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+#ifdef VNH7040_PWM_HIRES
+	//Overflows would be lost while the control step runs
+	f_enable = false;
+#endif
+
+	//Save interrupt enable and disable interrupts
+	sreg_tmp = SREG;
+	cli();
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Save mode. TCA0 overflow is not promoted to level 1
+	g_f_ctrl_isr = f_enable;
+	//Start a new measurement
+	g_prof[PROF_CTRL_LAT].clear();
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	//Restore interrupt enable
+	SREG = sreg_tmp;
+	
+	return;
+}	//End function: set_control_isr | bool
+
+/***************************************************************************/
+//!	@brief function
+//!	set_pos_limits | uint8_t, int16_t, int16_t
+/***************************************************************************/
+//! @param index | index of the wheel
+//! @param vmax | maximum speed. Counts per base tick
+//! @param amax | acceleration. Counts per base tick squared. Fixed point POS_PROFILE_AMAX_FRAC
+//! @return false: OK | true: fail
+//! @details
+//! Save the limits of the position profile of a wheel and convert them to the current tick rate
+//!	Speed per system tick is vmax >> rate. Acceleration per system tick squared is amax >> 2*rate
+//!	The profile uses TRAP_PROFILE_FRAC fractional bits so the conversion is exact at all rates
+//! Can be called with interrupts disabled
+/***************************************************************************/
+
+bool set_pos_limits( uint8_t index, int16_t vmax, int16_t amax )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Status register. Interrupt enable
+	uint8_t sreg_tmp;
+	//return flag
+	bool f_ret;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//if: bad arguments
+	if ((index >= ENC_NUM) || (vmax <= 0) || (amax <= 0))
+	{
+		return true;	//fail
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Save limits in base tick units
+	g_pos_vmax[index] = vmax;
+	g_pos_amax[index] = amax;
+	//Profile is used by the control step, that might be running inside an ISR
+	sreg_tmp = SREG;
+	cli();
+	//Convert to system tick units
+	f_ret = g_pos_profile[index].set_limits( (uint32_t)vmax << (TRAP_PROFILE_FRAC -g_tick_rate), (uint32_t)amax << (TRAP_PROFILE_FRAC -POS_PROFILE_AMAX_FRAC -2*g_tick_rate) );
+	//Restore interrupt enable
+	SREG = sreg_tmp;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+	
+	return f_ret;
+}	//End function: set_pos_limits | uint8_t, int16_t, int16_t
+
+/***************************************************************************/
+//!	@brief function
+//!	set_spd_limits | uint8_t, int16_t, int16_t
+/***************************************************************************/
+//! @param index | index of the wheel
+//! @param acc | acceleration. Counts per base tick squared. Fixed point POS_PROFILE_AMAX_FRAC. 0 = no limit
+//! @param dec | deceleration. Counts per base tick squared. Fixed point POS_PROFILE_AMAX_FRAC. 0 = no limit
+//! @return false: OK | true: fail
+//! @details
+//! Save the limits of the speed reference of a wheel and convert them to the current tick rate
+//!	Speed is in counts per base tick, so the change per system tick is acc >> rate
+//! Can be called with interrupts disabled
+/***************************************************************************/
+
+bool set_spd_limits( uint8_t index, int16_t acc, int16_t dec )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Status register. Interrupt enable
+	uint8_t sreg_tmp;
+	//return flag
+	bool f_ret;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//if: bad arguments
+	if ((index >= ENC_NUM) || (acc < 0) || (dec < 0))
+	{
+		return true;	//fail
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Save limits in base tick units
+	g_spd_acc[index] = acc;
+	g_spd_dec[index] = dec;
+	//Limiter is used by the control step, that might be running inside an ISR
+	sreg_tmp = SREG;
+	cli();
+	//Convert to system tick units. Reference has SETPOINT_INTERP_FRAC fractional bits
+	f_ret = g_spd_limiter[index].set_limits( (uint32_t)acc << (SETPOINT_INTERP_FRAC +ACCEL_LIMITER_FRAC -POS_PROFILE_AMAX_FRAC -g_tick_rate), (uint32_t)dec << (SETPOINT_INTERP_FRAC +ACCEL_LIMITER_FRAC -POS_PROFILE_AMAX_FRAC -g_tick_rate) );
+	//Restore interrupt enable
+	SREG = sreg_tmp;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+	
+	return f_ret;
+}	//End function: set_spd_limits | uint8_t, int16_t, int16_t
+
+/***************************************************************************/
+//!	@brief function
+//!	push_motion_segment | uint8_t, int32_t, int32_t, uint16_t
+/***************************************************************************/
+//! @param type | Motion_seg_type
+//! @param right | VEL: speed of the right side, counts per base tick | POS: absolute position of the right side
+//! @param left | VEL: speed of the left side, counts per base tick | POS: absolute position of the left side
+//! @param duration | VEL: duration | POS: minimum duration. Base ticks
+//! @return false: OK | true: fail
+//! @details
+//! Build a segment with the current queue limits, convert it to system ticks and add it to the motion queue
+//!	The jerk limit is the length of the S-curve filter: amax/jerk base ticks, rounded up to a power of two system ticks
+//! When entering queue mode, stale segments are dropped and the origin of the queue is the current position
+/***************************************************************************/
+
+bool push_motion_segment( uint8_t type, int32_t right, int32_t left, uint16_t duration )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Segment to be pushed
+	OrangeBot::Motion_segment seg;
+	//Length of the S-curve filter in system ticks
+	uint32_t len;
+	//return flag
+	bool f_ret;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Common fields
+	seg.type		= type;
+	seg.vmax		= (uint32_t)g_queue_vmax << (TRAP_PROFILE_FRAC -g_tick_rate);
+	seg.amax		= (uint32_t)g_queue_amax << (TRAP_PROFILE_FRAC -POS_PROFILE_AMAX_FRAC -2*g_tick_rate);
+	seg.duration	= (uint32_t)duration << g_tick_rate;
+	seg.jerk_shift	= (uint8_t)0;
+	//if: jerk is limited
+	if (g_queue_jerk > 0)
+	{
+		//Ticks to ramp the acceleration
+		len = ((uint32_t)g_queue_amax / (uint32_t)g_queue_jerk) << g_tick_rate;
+		//Round up to a power of two
+		while ((seg.jerk_shift < SCURVE_FILTER_MAX_SHIFT) && (((uint32_t)1 << seg.jerk_shift) < len))
+		{
+			seg.jerk_shift++;
+		}
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//if: speed segment
+	if (type == OrangeBot::MOTION_SEG_VEL)
+	{
+		//Signed speed in counts per system tick. Fixed point
+		seg.target[0] = right << (TRAP_PROFILE_FRAC -g_tick_rate);
+		seg.target[1] = left << (TRAP_PROFILE_FRAC -g_tick_rate);
+	}
+	//if: position segment
+	else
+	{
+		seg.target[0] = right;
+		seg.target[1] = left;
+	}
+	//Queue is executed by the control step, that might be running inside an ISR
+	cli();
+	//if: entering queue mode
+	if (g_control_mode_target != CONTROL_QUEUE)
+	{
+		//Drop stale segments
+		g_motion_queue.reset();
+	}
+	f_ret = g_motion_queue.push( seg );
+	sei();
+	//if: segment has been queued
+	if (f_ret == false)
+	{
+		//Set desired control mode to motion queue
+		g_control_mode_target = CONTROL_QUEUE;
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+	
+	return f_ret;
+}	//End function: push_motion_segment | uint8_t, int32_t, int32_t, uint16_t
+
+/***************************************************************************/
+//!	@brief task
+//!	control_task
+/***************************************************************************/
+//! @return void |
+//! @details
+//! Periodic task. Execute one step of the motor control system
+//! Does nothing if the control step is executed by the TCA0 overflow ISR
 /***************************************************************************/
 
-void update_pwm( void )
+void control_task( void )
 {
 	//----------------------------------------------------------------
 	//	VARS
 	//----------------------------------------------------------------
 
-	//temp counter
-	uint8_t t;
-	//true if speed has changed
-	//bool f_change[DC_MOTOR_NUM];
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
 
-	Dc_motor_pwm target_speed, actual_speed;
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//if: control step is executed by the main loop
+	if (g_f_ctrl_isr == false)
+	{
+		control_step();
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+	
+	return;
+}	//End task: control_task
+
+/***************************************************************************/
+//!	@brief function
+//!	control_step
+/***************************************************************************/
+//! @return void |
+//! @details
+//! Execute one step of the motor control system
+//! Switch to the control mode requested by the user, or to STOP on error
+//! Called either by control_task from the main loop or by the TCA0 overflow ISR
+//! Latency from the system tick to the start of the step is profiled to measure sampling jitter
+/***************************************************************************/
+
+void control_step( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Profiling
+	uint16_t timestamp;
+	//Timestamp of the system tick
+	uint16_t timestamp_tick;
+	//temp encoder counters. G-enc_cnt are volatile globals shared by ISR
+	int32_t enc_cnt[ENC_NUM];
+	//true = failed to fetch the encoder counters
+	bool f_enc_fail;
+	//Status register. Interrupt enable
+	uint8_t sreg_tmp;
 
 	//----------------------------------------------------------------
 	//	INIT
 	//----------------------------------------------------------------
 
-	//If the communication failed
-	if (g_f_timeout_detected == true)
+	//Start profiling. Timestamp of the tick is saved by the TCA0 overflow ISR. Might be running inside it
+	sreg_tmp = SREG;
+	cli();
+	timestamp = GET_TIMESTAMP();
+	timestamp_tick = g_timestamp_tick;
+	SREG = sreg_tmp;
+	//Latency from the system tick
+	g_prof[PROF_CTRL_LAT].add( timestamp -timestamp_tick );
+	//Force update of encoder counters and fetch their value
+	f_enc_fail = get_enc_cnt( enc_cnt );
+	//if: encoder counters were fetched
+	if (f_enc_fail == false)
 	{
-		//Counter
-		uint8_t t;
-		//For: scan motors
-		for (t = 0;t < DC_MOTOR_NUM;t++)
-		{
-			//Stop the motors
-			set_vnh7040_speed( (uint8_t)t, (uint8_t)false, (uint8_t)0x00 );
-			//Update actual PWM so tat slew rate limiter will do sensible things when restarting
-			g_dc_motor[t].pwm = (uint8_t)0x00;
-		}
-		//
-		return;
+		//Integrate the pose. Side position is the average of its wheels. Motors 0,1 are on the right side and mounted reversed
+		g_odometry.update( (-(enc_cnt[0] +enc_cnt[1])) >> 1, (enc_cnt[2] +enc_cnt[3]) >> 1 );
+		//Current limit and stall detection
+		update_current_monitor( enc_cnt );
 	}
 
 	//----------------------------------------------------------------
 	//	BODY
 	//----------------------------------------------------------------
 
-	//For: each DC motor channel
-	for (t = 0;t < DC_MOTOR_NUM;t++)
+		//! Control switch to new control system
+	//If: communication timeout is detected
+	if (g_f_timeout_detected == true)
 	{
-		//Fetch current settings
-		target_speed = g_dc_motor_target[t];
-		actual_speed = g_dc_motor[t];
+		//if: control system is not STOP
+		if (g_control_mode != CONTROL_STOP)
+		{
+			//Set motors to full stop
+			g_control_mode = CONTROL_STOP;
+			//If, communication timeout was detected
+			report_error( ERR_CODE_COMMUNICATION_TIMEOUT );
+		}
+		//if: control is already STOP
+		else
+		{
+			//do nothing
+		}
+	}
+	//if: PID saturation error has been issued
+	else if (g_isr_flags.pid_sat_err == true)
+	{
+		//if: control system is not STOP
+		if (g_control_mode != CONTROL_STOP)
+		{
+			//Set motors to full stop
+			g_control_mode = CONTROL_STOP;
+			//Report the error
+			report_error( ERR_CODE_PID_UNLOCKED );
+		}
+		//if: control is already STOP
+		else
+		{
+			//do nothing
+		}
+	}
+	//if: a wheel has stalled
+	else if (g_isr_flags.motor_stall == true)
+	{
+		//if: control system is not STOP
+		if (g_control_mode != CONTROL_STOP)
+		{
+			//Set motors to full stop
+			g_control_mode = CONTROL_STOP;
+			//Report the error
+			report_error( ERR_CODE_MOTOR_STALL );
+		}
+		//Stay in STOP until the next command of the host selects a mode. The fault is cleared
+		g_control_mode_target = CONTROL_STOP;
+		g_isr_flags.motor_stall = false;
+	}
+	//otherwise
+	else
+	{
+			//! switch control mode. Initialize target if necessary.
+		//if: I'm switching between control modes
+		if (g_control_mode != g_control_mode_target)
+		{
+			//If: entering a speed mode from a mode that doesn't use the speed reference
+			if (((g_control_mode_target == CONTROL_SPD) || (g_control_mode_target == CONTROL_SPD_POS)) && (g_control_mode != CONTROL_SPD) && (g_control_mode != CONTROL_SPD_POS))
+			{
+				//counter
+				uint8_t t;
+				//For: Scan all wheels
+				for (t = 0;t < ENC_NUM;t++)
+				{
+					//Speed reference starts at rest and moves toward the setpoint
+					g_spd_interp[t].reset( 0 );
+					g_spd_interp[t].set_target( g_pid_spd_target[t] );
+					g_spd_limiter[t].reset( 0 );
+				}
+			}
+			//If: Hybrid speed-position mode
+			if (g_control_mode_target == CONTROL_SPD_POS)
+			{
+				//counter
+				uint8_t t;
+				//Currently accessing global encoder counters
+				g_isr_flags.enc_sem = true;
+				//For: Scan all encoders
+				for (t = 0;t < ENC_NUM;t++)
+				{
+					//Initialize position target
+					g_pid_pos_target[t] = g_enc_cnt[t];
+					//Clear the fraction of count of the speed integrator
+					g_pid_pos_residual[t] = 0;
+				}
+				//Unreserve
+				g_isr_flags.enc_sem = false;
+			}
+			//If: Position mode
+			else if (g_control_mode_target == CONTROL_POS)
+			{
+				//counter
+				uint8_t t;
+				//Currently accessing global encoder counters
+				g_isr_flags.enc_sem = true;
+				//For: Scan all encoders
+				for (t = 0;t < ENC_NUM;t++)
+				{
+					//Profile starts at rest from the current position. Target is kept
+					g_pos_profile[t].reset( g_enc_cnt[t] );
+				}
+				//Unreserve
+				g_isr_flags.enc_sem = false;
+			}
+			//If: Motion queue mode
+			else if (g_control_mode_target == CONTROL_QUEUE)
+			{
+				//counter
+				uint8_t t;
+				//Currently accessing global encoder counters
+				g_isr_flags.enc_sem = true;
+				//For: Scan all encoders
+				for (t = 0;t < ENC_NUM;t++)
+				{
+					//Origin of the queue is the current position
+					g_queue_base[t] = g_enc_cnt[t];
+				}
+				//Unreserve
+				g_isr_flags.enc_sem = false;
+				//Axes at rest at the origin. Waiting segments are kept
+				g_motion_queue.home();
+			}
+		}
 		
-		//If directions are different
-		if (target_speed.f_dir != actual_speed.f_dir)
+		//Control mode is the one desired by the user
+		g_control_mode = g_control_mode_target;
+	}
+		//! Execute a step in the right control mode
+	//If: control system is in STOP state
+	if (g_control_mode == CONTROL_STOP)
+	{
+		//counter
+		uint8_t t;
+		//Scan all motors
+		for (t = 0;t < DC_MOTOR_NUM;t++)
+		{
+			//Set Target PWM to zero
+			g_dc_motor_target[ t ].f_dir	= false;
+			g_dc_motor_target[ t ].pwm		= 0;
+		}
+		//Update PWM of the motors while applying the slew rate limiter
+		update_pwm();
+	}	//End If: control system is in STOP state
+	//If: control system is open loop PWM
+	else if (g_control_mode == CONTROL_PWM)
+	{
+		//counter
+		uint8_t t;
+		//For: each motor
+		for (t = 0;t < DC_MOTOR_NUM;t++)
 		{
-			//if pwm is above slew rate
-			if (actual_speed.pwm > DC_MOTOR_SLEW_RATE)
+			//From voltage to PWM with the battery compensation. Direction is already corrected by the host handler
+			g_dc_motor_target[ t ] = convert_s16_to_pwm( g_pwm_cmd[ t ], true );
+		}
+		//Update PWM of the motors while applying the slew rate limiter
+		update_pwm();
+	}	//End If: control system is open loop PWM
+	//If: control system is closed loop speed
+	else if (g_control_mode == CONTROL_SPD)
+	{
+		//----------------------------------------------------------------
+		//	COMPUTE SPEED
+		//----------------------------------------------------------------
+		//	Encoder counters were fetched at the start of the step
+		//	Compute derivative
+		//	Update old encoder memory registers
+		
+		//temp speed
+		int16_t enc_spd[ ENC_NUM ];
+		//if: failed to update
+		if (f_enc_fail == true)
+		{
+			//Signal error
+			report_error( ERR_CODE_BAD_ENCODER_COUNTERS );
+		}
+		//if: update was success
+		else
+		{
+			//Compute speed from the counters of this step
+			compute_speed( enc_cnt, enc_spd );
+			//counter
+			uint8_t t = 0;
+			//Speed reference. Counts per base tick
+			int16_t spd_ref;
+			//command
+			int16_t cmd;
+			//Scan all PID
+			for (t=0;t < ENC_NUM;t++)
 			{
-				//Slow down by the slew rate
-				actual_speed.pwm -= DC_MOTOR_SLEW_RATE;
+				//Interpolated and acceleration limited speed reference. Rounded to counts per base tick
+				spd_ref = (int16_t)((g_spd_limiter[t].exe( g_spd_interp[t].exe() ) +((int32_t)1 << (SETPOINT_INTERP_FRAC -1))) >> SETPOINT_INTERP_FRAC);
+				//Process the speed and get the command
+				cmd = g_vnh7040_pid[t].exe( spd_ref, enc_spd[t] );
+				g_ctrl_ref[t] = spd_ref;
+				g_ctrl_fb[t] = enc_spd[t];
+				//PWM, or current reference of the inner loop. Sign correction should not be applied here because it would change the sign of the feedback loop
+				set_motor_command( t, cmd );
 			}
-			//if pwm is below or at slew rate
-			else
+		}	//end if: update was success
+		
+		//Update PWM of the motors while applying the slew rate limiter
+		update_pwm();
+	}	//End If: control system is closed loop speed
+	//If: control system is closed loop speed but with closing PID in position
+	else if (g_control_mode == CONTROL_SPD_POS)
+	{
+		//if: encoder counters were fetched
+		if (f_enc_fail == false)
+		{
+			//Counter
+			uint8_t t;
+			int32_t enc_target;
+			//Speed reference plus residual. Counts per base tick, fixed point SETPOINT_INTERP_FRAC
+			int32_t spd_acc;
+			//Position increment of this tick
+			int32_t pos_inc;
+			//temp errors
+			int32_t err32;
+			int16_t err16;
+			//command
+			int16_t cmd;
+			
+			//----------------------------------------------------------------
+			//	GENERATE POS REFERENCE | COMPUTE POSITION PID | GENERATE PWM REFERENCE
+			//----------------------------------------------------------------
+			//	This is an hybrid mode. User tell the speed, and the speed is used to update the position reference
+			
+			//Scan all encoders
+			for (t=0;t < ENC_NUM;t++)
 			{
-				//Set neutral speed
-				actual_speed.pwm = 0;
+				enc_target = g_pid_pos_target[t];
+				//Interpolated and acceleration limited speed in counts per base tick. Add the fraction left over by the previous ticks
+				spd_acc = g_spd_limiter[t].exe( g_spd_interp[t].exe() ) +g_pid_pos_residual[t];
+				//Counts per system tick
+				pos_inc = spd_acc >> (SETPOINT_INTERP_FRAC +g_tick_rate);
+				//Save the fraction that couldn't be integrated this tick
+				g_pid_pos_residual[t] = spd_acc -(pos_inc << (SETPOINT_INTERP_FRAC +g_tick_rate));
+				//At each tick, integrate the user given speed to compute the target position
+				enc_target += pos_inc;
+				g_pid_pos_target[t] = enc_target;
+				//Compute position error
+				err32 = (int32_t)enc_target -(int32_t)enc_cnt[t];
+				//Clip to 16b for use in the PID controller
+				err16 = AT_SAT( err32, (int16_t)32767, (int16_t)-32767);
+				//Compute PID and command feeding it directly the error
+				cmd = g_vnh7040_pid[t].exe( err16 );
+				g_ctrl_ref[t] = (int16_t)enc_target;
+				g_ctrl_fb[t] = (int16_t)enc_cnt[t];
+				//PWM, or current reference of the inner loop. Sign correction should not be applied here because it would change the sign of the feedback loop
+				set_motor_command( t, cmd );
 			}
-			//if pwm is zero
-			if (actual_speed.pwm == 0)
+		}
+		//if: update failed
+		else
+		{
+			//Signal error
+			report_error( ERR_CODE_BAD_ENCODER_COUNTERS );
+		}
+		
+		//Update PWM of the motors while applying the slew rate limiter
+		update_pwm();
+	}
+	//If: control system is closed loop position with on board profile
+	else if (g_control_mode == CONTROL_POS)
+	{
+		//if: encoder counters were fetched
+		if (f_enc_fail == false)
+		{
+			//Counter
+			uint8_t t;
+			int32_t enc_target;
+			//temp errors
+			int32_t err32;
+			int16_t err16;
+			//command
+			int16_t cmd;
+			
+			//----------------------------------------------------------------
+			//	GENERATE POS REFERENCE | COMPUTE POSITION PID | GENERATE PWM REFERENCE
+			//----------------------------------------------------------------
+			//	User tell the target. The profile moves the position reference toward it
+			
+			//Scan all encoders
+			for (t=0;t < ENC_NUM;t++)
 			{
-				//I'm authorized to change direction
-				actual_speed.f_dir = target_speed.f_dir;
+				//Advance the trapezoidal profile by one tick
+				enc_target = g_pos_profile[t].exe();
+				g_pid_pos_target[t] = enc_target;
+				//Compute position error
+				err32 = (int32_t)enc_target -(int32_t)enc_cnt[t];
+				//Clip to 16b for use in the PID controller
+				err16 = AT_SAT( err32, (int16_t)32767, (int16_t)-32767);
+				//Compute PID and command feeding it directly the error
+				cmd = g_vnh7040_pid[t].exe( err16 );
+				g_ctrl_ref[t] = (int16_t)enc_target;
+				g_ctrl_fb[t] = (int16_t)enc_cnt[t];
+				//PWM, or current reference of the inner loop. Sign correction should not be applied here because it would change the sign of the feedback loop
+				set_motor_command( t, cmd );
 			}
-		}	//End If directions are different
-		//if direction is the same
+		}
+		//if: update failed
 		else
 		{
-			//if pwm is above target
-			if (actual_speed.pwm > target_speed.pwm)
+			//Signal error
+			report_error( ERR_CODE_BAD_ENCODER_COUNTERS );
+		}
+		
+		//Update PWM of the motors while applying the slew rate limiter
+		update_pwm();
+	}
+	//If: control system is closed loop position following the motion queue
+	else if (g_control_mode == CONTROL_QUEUE)
+	{
+		//if: encoder counters were fetched
+		if (f_enc_fail == false)
+		{
+			//Counter
+			uint8_t t;
+			int32_t enc_target;
+			//Position reference of the right and left side
+			int32_t side_pos[MOTION_AXIS_NUM];
+			//temp errors
+			int32_t err32;
+			int16_t err16;
+			//command
+			int16_t cmd;
+			
+			//----------------------------------------------------------------
+			//	GENERATE POS REFERENCE | COMPUTE POSITION PID | GENERATE PWM REFERENCE
+			//----------------------------------------------------------------
+			//	Queue generates the position of the two sides. Motors 0,1 are on the right side and mounted reversed
+			
+			//Advance the motion queue by one tick
+			g_motion_queue.exe( side_pos );
+			//Scan all encoders
+			for (t=0;t < ENC_NUM;t++)
 			{
-				//Decrease speed by PWM
-				actual_speed.pwm = AT_SAT_SUM( actual_speed.pwm, -DC_MOTOR_SLEW_RATE, DC_MOTOR_MAX_PWM, 0 );
-				//if: overshoot
-				if (actual_speed.pwm < target_speed.pwm)
-				{
-					//I reached the target
-					actual_speed.pwm = target_speed.pwm;
-				}
+				//Position of the wheel relative to the origin of the queue
+				enc_target = g_queue_base[t] +((t < 2)?(-side_pos[0]):(side_pos[1]));
+				g_pid_pos_target[t] = enc_target;
+				//Compute position error
+				err32 = (int32_t)enc_target -(int32_t)enc_cnt[t];
+				//Clip to 16b for use in the PID controller
+				err16 = AT_SAT( err32, (int16_t)32767, (int16_t)-32767);
+				//Compute PID and command feeding it directly the error
+				cmd = g_vnh7040_pid[t].exe( err16 );
+				g_ctrl_ref[t] = (int16_t)enc_target;
+				g_ctrl_fb[t] = (int16_t)enc_cnt[t];
+				//PWM, or current reference of the inner loop. Sign correction should not be applied here because it would change the sign of the feedback loop
+				set_motor_command( t, cmd );
 			}
-			//if pwm is below target
-			else if (actual_speed.pwm < target_speed.pwm)
+		}
+		//if: update failed
+		else
+		{
+			//Signal error
+			report_error( ERR_CODE_BAD_ENCODER_COUNTERS );
+		}
+		
+		//Update PWM of the motors while applying the slew rate limiter
+		update_pwm();
+	}
+	//if: undefined control system
+	else
+	{
+		//Signal error
+		report_error( ERR_CODE_UNDEFINED_CONTROL_SYSTEM );
+		//Reset control mode
+		g_control_mode = CONTROL_STOP;
+	}	//End if: undefined control system
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+	
+	//Record the step in the RAM capture
+	log_step();
+	//Stop profiling
+	g_prof[PROF_CTRL].add( GET_TIMESTAMP() -timestamp );
+	
+	return;
+}	//End function: control_step
+
+/***************************************************************************/
+//!	@brief function
+//!	log_step
+/***************************************************************************/
+//! @return void |
+//! @details
+//! Called at the end of each control step. While the RAM capture waits for the trigger,
+//!	check the trigger sources on the logged wheels. When a record is due, build it
+/***************************************************************************/
+
+void log_step( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Reference of the previous step
+	static int16_t old_ref[ENC_NUM];
+	//counters
+	uint8_t t, ts;
+	//Jump of the reference
+	int16_t step;
+	//Record
+	int16_t rec[LOG_REC_MAX];
+	uint8_t num = 0;
+	//Current of the motors
+	uint16_t current[DC_MOTOR_NUM];
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//if: waiting for the trigger
+	if ((g_data_logger.get_state() == OrangeBot::DATA_LOGGER_ARMED) && (g_log_trig != 0))
+	{
+		//For: each logged wheel
+		for (t = 0;t < ENC_NUM;t++)
+		{
+			if (IS_BIT_ONE( g_log_wheel, t ))
 			{
-				//Decrease speed by PWM
-				actual_speed.pwm = AT_SAT_SUM( actual_speed.pwm, +DC_MOTOR_SLEW_RATE, DC_MOTOR_MAX_PWM, 0 );
-				//if: overshoot
-				if (actual_speed.pwm > target_speed.pwm)
+				step = (int16_t)(g_ctrl_ref[t] -old_ref[t]);
+				step = (step < 0)?(-step):(step);
+				//if: step of the reference
+				if (((g_log_trig & LOG_TRIG_STEP) != 0) && ((uint16_t)step >= g_log_step_th))
+				{
+					g_data_logger.trigger();
+				}
+				//if: PID output at its limit
+				if (((g_log_trig & LOG_TRIG_SAT) != 0) && ((g_vnh7040_pid[t].get_cmd() >= g_vnh7040_pid[t].limit_cmd_max()) || (g_vnh7040_pid[t].get_cmd() <= g_vnh7040_pid[t].limit_cmd_min())))
 				{
-					//I reached the target
-					actual_speed.pwm = target_speed.pwm;
+					g_data_logger.trigger();
 				}
 			}
-			//if: I'm already at the right speed
-			else
+		}
+	}
+	//Memory of the reference is kept even when idle, so arming doesn't see a false step
+	for (t = 0;t < ENC_NUM;t++)
+	{
+		old_ref[t] = g_ctrl_ref[t];
+	}
+	//if: no record this step
+	if (g_data_logger.is_due() == false)
+	{
+		return;
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//if: current
+	if ((g_log_sig & LOG_SIG_CUR) != 0)
+	{
+		get_motor_current( current );
+	}
+	//For: each logged wheel
+	for (t = 0;t < ENC_NUM;t++)
+	{
+		if (IS_BIT_ONE( g_log_wheel, t ))
+		{
+			//For: each signal, in the order of the bits. The set up guarantees the record fits
+			for (ts = 0;ts < 9;ts++)
 			{
-				//do nothing
+				if (IS_BIT_ONE( g_log_sig, ts ))
+				{
+					switch ((uint16_t)1 << ts)
+					{
+						case LOG_SIG_REF:	rec[num] = g_ctrl_ref[t];						break;
+						case LOG_SIG_FB:	rec[num] = g_ctrl_fb[t];						break;
+						case LOG_SIG_ERR:	rec[num] = g_vnh7040_pid[t].get_err();			break;
+						case LOG_SIG_P:		rec[num] = g_vnh7040_pid[t].get_cmd_p();		break;
+						case LOG_SIG_I:		rec[num] = g_vnh7040_pid[t].get_cmd_i();		break;
+						case LOG_SIG_D:		rec[num] = g_vnh7040_pid[t].get_cmd_d();		break;
+						case LOG_SIG_CMD:	rec[num] = g_vnh7040_pid[t].get_cmd();			break;
+						case LOG_SIG_PWM:	rec[num] = (g_dc_motor[t].f_dir == false)?((int16_t)g_dc_motor[t].pwm):(-(int16_t)g_dc_motor[t].pwm);	break;
+						default:			rec[num] = (int16_t)AT_SAT( current[t], 32767, 0 );	break;
+					}
+					num++;
+				}
 			}
 		}
-		
-		//Apply setting
-		set_vnh7040_speed( t, actual_speed.f_dir, actual_speed.pwm );
-		
-		//Write back setting
-		g_dc_motor[t] = actual_speed;
-	}	//End For: each DC motor channel
+	}
+	g_data_logger.add( rec );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+	
+	return;
+}	//End function: log_step
+
+/***************************************************************************/
+//!	@brief task
+//!	timeout_task
+/***************************************************************************/
+//! @return void |
+//! @details
+//! Periodic task. Update the communication timeout counter
+//! Raise the timeout flag if the RPI has been silent for too long
+/***************************************************************************/
+
+void timeout_task( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//if: motion queue is carrying the platform
+	if ((g_control_mode == CONTROL_QUEUE) && (g_motion_queue.is_busy() == true))
+	{
+		//Segments were streamed ahead of time. Link hiccups don't stop the platform, an underrun does
+		g_uart_timeout_cnt = 0;
+	}
+	//Update communication timeout counter
+	g_uart_timeout_cnt++;
+	//if: communication timeout
+	if (g_uart_timeout_cnt >= RPI_COM_TIMEOUT)
+	{
+		//Clip timeout counter
+		g_uart_timeout_cnt = RPI_COM_TIMEOUT;
+		//raise the timeout flag
+		g_f_timeout_detected = true;
+	}
+	else
+	{
+		//This is the only code allowed to reset the timeout flag
+		g_f_timeout_detected = false;
+	}
 
 	//----------------------------------------------------------------
 	//	RETURN
 	//----------------------------------------------------------------
-
-	return; //OK
-}	//end handler: update_pwm | void
+	
+	return;
+}	//End task: timeout_task
 
 /***************************************************************************/
-//!	function
-//!	get_enc_cnt
+//!	@brief task
+//!	led_task
 /***************************************************************************/
-//! @param enc_cnt | int32_t vector. Function returns in this vector the value of the global encoder counters
-//! @return bool | false=OK | true=failed to update global counters
-//! @brief Force an update and save the 32b encoder counters in an input vector
+//! @return void |
 //! @details
-//!		Algorithm:
-//!	>disable interrupt
-//!	>raise sync flag
-//!	>manually execute encoder decoding routine
-//! >Transfer register value to local vars
+//! Periodic task. Blink the activity LED
+//!		Two speeds
+//!	slow: not in timeout and commands can be executed
+//!	fast: in timeout, motor stopped
 /***************************************************************************/
 
-bool get_enc_cnt( int32_t *enc_cnt )
+void led_task( void )
 {
 	//----------------------------------------------------------------
 	//	VARS
 	//----------------------------------------------------------------
 
-	//Counter
-	uint8_t t;
-	//return flag
-	bool f_ret;
+	//activity LED prescaler
+	static uint8_t pre_led = 0;
+	//Blink speed of the LED
+	uint8_t blink_speed;
 
 	//----------------------------------------------------------------
 	//	INIT
 	//----------------------------------------------------------------
 
-	//Disable interrupts
-	cli();
-	//Force update of 32b global counters
-	g_isr_flags.enc_updt = true;
+	//LED is blinking faster while in timeout
+	blink_speed = (g_f_timeout_detected == true)?(9):(99);
 
 	//----------------------------------------------------------------
 	//	BODY
 	//----------------------------------------------------------------
 
-	//Decode encoders and update 32b counters 
-	quad_encoder_decoder( PORTC.IN );
-	//Enable interrupts
-	sei();
-	//If encoder routine failed to update global counters
-	f_ret = g_isr_flags.enc_updt;
-	//For: all encoder channels
-	for (t = 0;t < ENC_NUM;t++)
+	//if: prescaler has reset
+	if (pre_led == 0)
 	{
-		//Copy
-		enc_cnt[t] = g_enc_cnt[t];
+		//Toggle PF5.
+		SET_BIT( PORTF.OUTTGL, 5 );
 	}
-	
+	//Increment with top
+	pre_led = AT_TOP_INC( pre_led, blink_speed );
+
 	//----------------------------------------------------------------
 	//	RETURN
 	//----------------------------------------------------------------
 	
-	//false = OK | true = fail (global counters failed to update)
-	return f_ret;
-}
+	return;
+}	//End task: led_task
 
 /***************************************************************************/
-//!	function
-//!	function_template
+//!	@brief task
+//!	telemetry_task
 /***************************************************************************/
-//! @param enc_speed | (int16_t*) writeback vector that will hold the result
-//! @return bool | false = success | true = fail
-//! @brief Compute speed. Unit of measure is Count/Tick.
+//! @return void |
 //! @details
+//! Periodic task. Send unsolicited telemetry messages to the RPI
 /***************************************************************************/
 
-bool compute_speed( int16_t *enc_speed )
+void telemetry_task( void )
 {
 	//----------------------------------------------------------------
 	//	VARS
 	//----------------------------------------------------------------
 
-	//temp counter
-	uint8_t t;
-	//Temp return flag
-	bool f_ret;
-	//Local encoder counters
-	int32_t enc_cnt[ ENC_NUM ];
-
 	//----------------------------------------------------------------
 	//	INIT
 	//----------------------------------------------------------------
@@ -1144,198 +3459,385 @@ bool compute_speed( int16_t *enc_speed )
 	//	BODY
 	//----------------------------------------------------------------
 
-	//Force update of the global encoder counter registers and fetch value of the registers
-	f_ret = get_enc_cnt( enc_cnt );
-	//if: fail
-	if (f_ret == true)
+	//DEBUG: Generate reference ramp and send encoder speed message
+	//generate_reference( CONTROL_SPD, 15 );
+	//get_encoder_spd_handler();
+	//if: counts are not in the stream
+	if ((g_stream_mask & STREAM_CNT) == 0)
 	{
-		AT_BUF_PUSH(rpi_tx_buf, 'E');
-		//fail
-		return true;
+		get_encoder_cnt_handler();
 	}
-	//Scan encoders
-	for (t = 0;t< ENC_NUM;t++)
+	//if: current of the motors is not in the stream
+	if ((g_stream_mask & STREAM_CUR) == 0)
 	{
-		//Compute speed saturating to limit of the var
-		enc_speed[t] = AT_SAT_SUM( enc_cnt[t], -g_old_enc_cnt[t], (int16_t)32767, (int16_t)-32767 );
-		//enc_speed[t] = enc_cnt[t] -g_old_enc_cnt[t];
-		//Save memories
-		g_old_enc_cnt[t] = enc_cnt[t];
-		g_enc_spd[t] = enc_speed[t];
+		get_motor_current_handler();
+	}
+	//if: battery voltage is not in the stream
+	if ((g_stream_mask & STREAM_VBAT) == 0)
+	{
+		get_vbat_handler();
+	}
+	//if: platform is following the motion queue
+	if (g_control_mode == CONTROL_QUEUE)
+	{
+		//Send queue depth and underruns
+		get_queue_status_handler();
 	}
 
 	//----------------------------------------------------------------
 	//	RETURN
 	//----------------------------------------------------------------
 	
-	return false; //OK
-}
+	return;
+}	//End task: telemetry_task
 
 /***************************************************************************/
-//!	@brief function
-//!	generate_reference
+//!	@brief task
+//!	stream_task
 /***************************************************************************/
-//! @param top | U8 maximum command
 //! @return void |
 //! @details
-//! Generate double sided reference for all four motors
+//! Periodic task. Send a frame of the subscribed signals every g_stream_decim base ticks.
+//!	The frame is skipped when the TX buffer doesn't have room for its longest size and for a reply.
+//!	Compressed frames send the change of each value since the last frame sent, and the whole values
+//!	every STREAM_KEY_PERIOD frames. A skipped frame doesn't advance the sequence number
 /***************************************************************************/
 
-void generate_reference( Control_mode mode, uint16_t top )
+void stream_task( void )
 {
 	//----------------------------------------------------------------
 	//	VARS
 	//----------------------------------------------------------------
 
-	//index of the motor under test
-	static uint8_t motor_index = 0;
-	//Speed ramp. false = accelerate | true = decelerate
-	static bool f_ramp = false;
-	//Direction. false =  clockwise | true = counterclockwise
-	static bool f_dir = false;
-	//Speed counter
-	static uint16_t speed = 0;
+	//Base ticks since the last frame
+	static uint16_t decim_cnt = 0;
+	//Signal of each group of 16b values
+	static const uint8_t val_signal[6] = { STREAM_SPD, STREAM_ERR, STREAM_PID, STREAM_PID, STREAM_PID, STREAM_PWM };
+	//Values of the last compressed frame sent. Counts, 16b signals, currents, battery
+	static int32_t old_val[ 7*ENC_NUM +DC_MOTOR_NUM +1 ];
+	//Values of the compressed frame, in the order of the frame
+	int32_t frame_val[ 7*ENC_NUM +DC_MOTOR_NUM +1 ];
+	//Values in the compressed frame
+	uint8_t frame_num;
+	//true = keyframe
+	bool f_key;
+	//counters
+	uint8_t t, ti, tj;
+	//Encoder counts
+	int32_t enc_cnt[ENC_NUM];
+	//16b signals in the order of the frame. Speed, error, PID terms, PWM
+	int16_t val[ 6*ENC_NUM ];
+	//Current of the motors
+	uint16_t current[DC_MOTOR_NUM];
+	//Temp message
+	uint8_t msg[15];
+	//temp return
+	uint8_t ret;
 
 	//----------------------------------------------------------------
 	//	INIT
 	//----------------------------------------------------------------
 
+	//if: no subscription
+	if (g_stream_mask == 0)
+	{
+		return;
+	}
+	decim_cnt++;
+	//if: not yet time for a frame
+	if (decim_cnt < g_stream_decim)
+	{
+		return;
+	}
+	decim_cnt = 0;
+	//if: the frame could take the room of a reply
+	if ((uint16_t)(RPI_TX_BUF_SIZE -1 -AT_BUF_NUMELEM( rpi_tx_buf )) < (uint16_t)g_stream_len +STREAM_TX_RESERVE)
+	{
+		g_stream_skip += (g_stream_skip < (uint16_t)0xFFFF)?(1):(0);
+		return;
+	}
+
 	//----------------------------------------------------------------
 	//	BODY
 	//----------------------------------------------------------------
-		
-		//! Ramp generator
-	//If increase speed
-	if (f_ramp == false)
+
+	//if: counts
+	if ((g_stream_mask & STREAM_CNT) != 0)
 	{
-		//increase speed
-		speed++;
-		//if: speed cap
-		if (speed >= top)
+		get_enc_cnt( enc_cnt );
+	}
+	//Snapshot of one control step. It might be running inside an ISR
+	cli();
+	//For: each signal and each channel
+	for (t = 0;t < ENC_NUM;t++)
+	{
+		//if: speed
+		if ((g_stream_mask & STREAM_SPD) != 0)
 		{
-			//now decrease speed
-			f_ramp = true;
+			val[ 0 *ENC_NUM +t ] = g_enc_spd[t];
+		}
+		//if: error
+		if ((g_stream_mask & STREAM_ERR) != 0)
+		{
+			val[ 1 *ENC_NUM +t ] = g_vnh7040_pid[t].get_err();
+		}
+		//if: PID terms
+		if ((g_stream_mask & STREAM_PID) != 0)
+		{
+			val[ 2 *ENC_NUM +t ] = g_vnh7040_pid[t].get_cmd_p();
+			val[ 3 *ENC_NUM +t ] = g_vnh7040_pid[t].get_cmd_i();
+			val[ 4 *ENC_NUM +t ] = g_vnh7040_pid[t].get_cmd_d();
+		}
+		//if: PWM
+		if ((g_stream_mask & STREAM_PWM) != 0)
+		{
+			val[ 5 *ENC_NUM +t ] = (g_dc_motor[t].f_dir == false)?((int16_t)g_dc_motor[t].pwm):(-(int16_t)g_dc_motor[t].pwm);
 		}
 	}
-	//If decrease speed
-	else
+	sei();
+	//if: current
+	if ((g_stream_mask & STREAM_CUR) != 0)
 	{
-		//decrease speed
-		speed--;
-		//If: speed cap
-		if (speed <= (uint8_t)0x00)
+		get_motor_current( current );
+	}
+	//if: compressed frame
+	if ((g_stream_mask & STREAM_DELTA) != 0)
+	{
+		frame_num = 0;
+		//if: counts
+		if ((g_stream_mask & STREAM_CNT) != 0)
 		{
-			//Now increase speed
-			f_ramp = false;
-			//Invert motor direction
-			f_dir = !f_dir;
-			//If I'm going forward again
-			if (f_dir == false)
+			for (t = 0;t < ENC_NUM;t++)
 			{
-				//change motor under test
-				motor_index = AT_TOP_INC( motor_index, 3);
+				frame_val[ frame_num++ ] = enc_cnt[t];
 			}
 		}
+		//For: each group of 16b values
+		for (t = 0;t < 6;t++)
+		{
+			//if: signal subscribed
+			if ((g_stream_mask & val_signal[t]) != 0)
+			{
+				for (tj = 0;tj < ENC_NUM;tj++)
+				{
+					frame_val[ frame_num++ ] = val[ t *ENC_NUM +tj ];
+				}
+			}
+		}
+		//if: current
+		if ((g_stream_mask & STREAM_CUR) != 0)
+		{
+			for (t = 0;t < DC_MOTOR_NUM;t++)
+			{
+				frame_val[ frame_num++ ] = current[t];
+			}
+		}
+		//if: battery
+		if ((g_stream_mask & STREAM_VBAT) != 0)
+		{
+			frame_val[ frame_num++ ] = g_vbat_mv;
+		}
+		f_key = ((g_stream_seq % STREAM_KEY_PERIOD) == 0);
+		//Preamble and header. Keyframes carry the signals
+		AT_BUF_PUSH( rpi_tx_buf, 'Z' );
+		AT_BUF_PUSH( rpi_tx_buf, ((f_key == true)?(0x80):(0x00)) | 0x40 | g_stream_seq );
+		if (f_key == true)
+		{
+			AT_BUF_PUSH( rpi_tx_buf, g_stream_mask );
+		}
+		//For: each value. Whole in keyframes, change from the last frame otherwise. Counts wrap
+		for (t = 0;t < frame_num;t++)
+		{
+			stream_push_varint( (f_key == true)?(frame_val[t]):((int32_t)((uint32_t)frame_val[t] -(uint32_t)old_val[t])) );
+			old_val[t] = frame_val[t];
+		}
+		//Termination
+		AT_BUF_PUSH( rpi_tx_buf, '\0' );
+		g_stream_seq = (g_stream_seq +1) % STREAM_SEQ_NUM;
+		return;
 	}
-		//! Command generator
-	//if: open loop PWM test ramp
-	if (mode == CONTROL_PWM)
+	//Preamble
+	AT_BUF_PUSH( rpi_tx_buf, 'T' );
+	ret = u8_to_str( g_stream_mask, msg );
+	for (ti = 0;ti < ret;ti++)
 	{
-		//Assign command
-		g_dc_motor_target[ motor_index ].f_dir = f_dir;
-		g_dc_motor_target[ motor_index ].pwm = speed;
-		//Reset communication timeout
-		g_uart_timeout_cnt = 0;
-		//Select Open loop PWM control system
-		g_control_mode_target = mode;
+		AT_BUF_PUSH( rpi_tx_buf, msg[ti] );
 	}
-	//if: speed PID control mode
-	else if (mode == CONTROL_SPD)
+	//if: counts
+	if ((g_stream_mask & STREAM_CNT) != 0)
 	{
-		//temp command
-		int16_t command;
-		
-		if (f_dir == false)
+		for (t = 0;t < ENC_NUM;t++)
 		{
-			command = speed;
+			ret = s32_to_str( enc_cnt[t], msg );
+			for (ti = 0;ti < ret;ti++)
+			{
+				AT_BUF_PUSH( rpi_tx_buf, msg[ti] );
+			}
 		}
-		else
+	}
+	//For: each group of 16b values
+	for (t = 0;t < 6;t++)
+	{
+		//if: signal subscribed
+		if ((g_stream_mask & val_signal[t]) != 0)
 		{
-			command = -speed;
+			for (tj = 0;tj < ENC_NUM;tj++)
+			{
+				ret = s16_to_str( val[ t *ENC_NUM +tj ], msg );
+				for (ti = 0;ti < ret;ti++)
+				{
+					AT_BUF_PUSH( rpi_tx_buf, msg[ti] );
+				}
+			}
 		}
-		
-		//Assign command
-		g_pid_spd_target[ motor_index ] = command;
-		//Reset communication timeout
-		g_uart_timeout_cnt = 0;
-		//Select control mode
-		g_control_mode_target = mode;
-		
-		uint8_t t, len, msg[10];
-		
-		AT_BUF_PUSH( rpi_tx_buf, 'M' );
-		len = u8_to_str( motor_index, msg );
-		for (t = 0;t<len;t++)
+	}
+	//if: current
+	if ((g_stream_mask & STREAM_CUR) != 0)
+	{
+		for (t = 0;t < DC_MOTOR_NUM;t++)
 		{
-			AT_BUF_PUSH(rpi_tx_buf,msg[t]);
+			AT_BUF_PUSH( rpi_tx_buf, '+' );
+			ret = u16_to_str( current[t], msg );
+			for (ti = 0;ti < ret;ti++)
+			{
+				AT_BUF_PUSH( rpi_tx_buf, msg[ti] );
+			}
 		}
-		AT_BUF_PUSH( rpi_tx_buf, 'S' );
-		AT_BUF_PUSH( rpi_tx_buf, 'P' );
-		AT_BUF_PUSH( rpi_tx_buf, 'D' );
-		len = s16_to_str( g_pid_spd_target[ motor_index ], msg );
-		for (t = 0;t<len;t++)
+	}
+	//if: battery
+	if ((g_stream_mask & STREAM_VBAT) != 0)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, '+' );
+		ret = u16_to_str( g_vbat_mv, msg );
+		for (ti = 0;ti < ret;ti++)
 		{
-			AT_BUF_PUSH(rpi_tx_buf,msg[t]);
+			AT_BUF_PUSH( rpi_tx_buf, msg[ti] );
 		}
-		AT_BUF_PUSH( rpi_tx_buf, '\0' );
-		
 	}
-	//if: bad reference control mode
-	else
+	//Termination
+	AT_BUF_PUSH( rpi_tx_buf, '\0' );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+	
+	return;
+}	//End task: stream_task
+
+/***************************************************************************/
+//!	@brief function
+//!	stream_push_varint | int32_t
+/***************************************************************************/
+//! @param num | value
+//! @return void |
+//! @details
+//! Zig-zag the value so that small changes of either sign take few bytes, add one, then send
+//!	seven bits per byte, least significant first, with bit 7 set on all but the last byte.
+//!	The last byte is never zero, so the terminator can't show up inside a frame.
+//!	Zig-zag plus one takes 33b: the carry of the addition becomes bit 32. One to five bytes
+/***************************************************************************/
+
+void stream_push_varint( int32_t num )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Zig-zag plus one, bits 0 to 31
+	uint32_t code;
+	//Bit 32 of the code
+	bool f_carry;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Zig-zag. 0, -1, +1, -2... become 0, 1, 2, 3...
+	code = ((uint32_t)num << 1) ^ ((num < 0)?((uint32_t)0xFFFFFFFF):((uint32_t)0));
+	code++;
+	f_carry = (code == 0);
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//While: more than seven bits left
+	while ((code >= 0x80) || (f_carry == true))
 	{
-		//
-		g_control_mode_target = CONTROL_STOP;
+		AT_BUF_PUSH( rpi_tx_buf, (uint8_t)(0x80 | (code & 0x7F)) );
+		code = (code >> 7) | ((f_carry == true)?((uint32_t)1 << 25):((uint32_t)0));
+		f_carry = false;
 	}
+	//Last byte
+	AT_BUF_PUSH( rpi_tx_buf, (uint8_t)code );
 
 	//----------------------------------------------------------------
 	//	RETURN
 	//----------------------------------------------------------------
-	
+
 	return;
-}	//End function: generate_reference
+}	//End function: stream_push_varint | int32_t
 
 /***************************************************************************/
-//!	@brief handler
-//!	pid_saturation_error_handler
+//!	@brief function
+//!	vbat_task | void
 /***************************************************************************/
 //! @return void |
 //! @details
-//! This function is automatically called by a PID when it cannot lock quickly enough to the reference
+//! Convert the filtered battery reading to mV and compute the gain of the voltage compensation
+//!	Division is done here at a low rate instead of in every control step
+//!	A supply below VBAT_MIN_MV is not the battery, for example the programmer. No compensation
 /***************************************************************************/
 
-void pid_saturation_error_handler( void )
+void vbat_task( void )
 {
 	//----------------------------------------------------------------
 	//	VARS
 	//----------------------------------------------------------------
 
+	//Filtered ADC reading
+	uint16_t adc;
+	//Battery voltage. mV
+	uint16_t vbat;
+	//Gain of the compensation. Fixed point VBAT_SCALE_FP
+	uint16_t scale;
+
 	//----------------------------------------------------------------
 	//	INIT
 	//----------------------------------------------------------------
 
+	//Written by the ADC ISR
+	cli();
+	adc = g_vbat_adc;
+	sei();
+
 	//----------------------------------------------------------------
 	//	BODY
 	//----------------------------------------------------------------
 
-	//A PID wasn't able to lock quickly enough to the reference
-	g_isr_flags.pid_sat_err = true;
+	vbat = ((uint32_t)adc *VBAT_SENSE_GAIN) >> (8 +VBAT_FILTER_FP);
+	//if: supply is not the battery
+	if (vbat < VBAT_MIN_MV)
+	{
+		scale = ((uint16_t)1 << VBAT_SCALE_FP);
+	}
+	else
+	{
+		scale = ((uint32_t)VBAT_NOMINAL_MV << VBAT_SCALE_FP) /vbat;
+		scale = AT_SAT( scale, VBAT_SCALE_MAX, 0 );
+	}
+	g_vbat_mv = vbat;
+	//Read by the control step, that might be running inside an ISR
+	cli();
+	g_vbat_scale = scale;
+	sei();
 
 	//----------------------------------------------------------------
 	//	RETURN
 	//----------------------------------------------------------------
 	
 	return;
-}	//End function: pid_saturation_error_handler
+}	//End task: vbat_task
 
 /***************************************************************************/
 //!	@brief function
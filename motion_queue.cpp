@@ -0,0 +1,668 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	MOTION QUEUE
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:		2019-11-15
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Queue of motion segments streamed by the host ahead of time
+**	Each tick the segment in execution generates a trapezoidal position
+**	reference for each axis:
+**		VEL: speed ramps toward the target with the segment acceleration
+**		POS: Trap_profile moves the axis to the target
+**	The reference is then filtered by a moving average (Scurve_filter)
+**	that limits the jerk. When a segment ends the next one starts from the
+**	same position and speed, so the path has no speed jumps.
+**	Segments are pushed by the main loop and executed by the control step.
+**	The caller has to protect push() from the control step.
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include "global.h"
+//Trapezoidal position profile
+#include "trap_profile.h"
+//Moving average that turns trapezoids into S-curves
+#include "scurve_filter.h"
+//Class Header
+#include "motion_queue.h"
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+namespace OrangeBot
+{
+
+/****************************************************************************
+**	GLOBAL VARIABILES
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	CONSTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Constructor
+//!	Motion_queue | void
+/***************************************************************************/
+// @param
+//! @return no return
+//!	@details
+//! Empty constructor. Queue is empty and axes are at rest at position 0
+/***************************************************************************/
+
+Motion_queue::Motion_queue( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Empty queue, axes at rest
+	this -> reset();
+	//Clear statistics
+	this -> clear_stats();
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end constructor:
+
+/****************************************************************************
+*****************************************************************************
+**	DESTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Destructor
+//!	Motion_queue | void
+/***************************************************************************/
+// @param
+//! @return no return
+//!	@details
+//! Empty destructor
+/***************************************************************************/
+
+Motion_queue::~Motion_queue( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end destructor:
+
+/****************************************************************************
+*****************************************************************************
+**	OPERATORS
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	SETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	push | Motion_segment &
+/***************************************************************************/
+//! @param seg | segment to be added at the end of the queue
+//! @return false: OK | true: fail
+//!	@details
+//! Validate a segment and add it at the end of the queue
+/***************************************************************************/
+
+bool Motion_queue::push( Motion_segment &seg )
+{
+	//Trace Enter
+	DENTER_ARG("type: %d, depth: %d\n", seg.type, this -> g_depth);
+
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Index of the new segment
+	uint8_t index;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//if: queue is full
+	if (this -> g_depth >= MOTION_QUEUE_SIZE)
+	{
+		//Trace Return
+		DRETURN_ARG("ERR: queue is full\n");
+		return true;	//fail
+	}
+	//if: bad segment
+	if ( (seg.amax == 0) || (seg.jerk_shift > SCURVE_FILTER_MAX_SHIFT) ||
+		 ((seg.type != MOTION_SEG_VEL) && (seg.type != MOTION_SEG_POS)) ||
+		 ((seg.type == MOTION_SEG_POS) && (seg.vmax == 0)) )
+	{
+		//Trace Return
+		DRETURN_ARG("ERR: bad segment\n");
+		return true;	//fail
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Slot after the last waiting segment
+	index = (this -> g_head +this -> g_depth) % MOTION_QUEUE_SIZE;
+	//Save segment
+	this -> g_seg[index] = seg;
+	//One more segment
+	this -> g_depth++;
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return false;	//OK
+}	//end method: push | Motion_segment &
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	abort | void
+/***************************************************************************/
+//! @return no return
+//!	@details
+//! Drop the waiting segments and the segment in execution.
+//! The axes ramp down to a stop with the acceleration of the segment in execution
+/***************************************************************************/
+
+void Motion_queue::abort( void )
+{
+	//if: a segment is in execution
+	if (this -> g_f_active == true)
+	{
+		//Stop with its acceleration
+		this -> g_stop_amax = this -> g_cur.amax;
+		this -> g_f_active = false;
+	}
+	//Empty queue
+	this -> g_head	= (uint8_t)0;
+	this -> g_depth	= (uint8_t)0;
+
+	return;	//OK
+}	//end method: abort | void
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	home | void
+/***************************************************************************/
+//! @return no return
+//!	@details
+//! Drop the segment in execution and put the axes at rest at position 0.
+//! Positions of the POS segments are relative to this origin. Waiting segments are kept
+/***************************************************************************/
+
+void Motion_queue::home( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	uint8_t t;
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//No segment in execution
+	this -> g_f_active	= false;
+	this -> g_tick_cnt	= (uint32_t)0;
+	this -> g_stop_amax	= (uint32_t)0;
+	//For: each axis
+	for (t = 0;t < MOTION_AXIS_NUM;t++)
+	{
+		//At rest at the origin
+		this -> g_pos[t]		= (int32_t)0;
+		this -> g_pos_frac[t]	= (uint16_t)0;
+		this -> g_spd[t]		= (int32_t)0;
+		this -> g_trap[t].reset( (int32_t)0 );
+		this -> g_trap[t].set_target( (int32_t)0 );
+		this -> g_filter[t].reset( (int32_t)0 );
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return;	//OK
+}	//end method: home | void
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	reset | void
+/***************************************************************************/
+//! @return no return
+//!	@details
+//! Drop all segments and put the axes at rest at position 0
+/***************************************************************************/
+
+void Motion_queue::reset( void )
+{
+	//Empty queue
+	this -> g_head	= (uint8_t)0;
+	this -> g_depth	= (uint8_t)0;
+	//Axes at rest at the origin
+	this -> home();
+
+	return;	//OK
+}	//end method: reset | void
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	clear_stats | void
+/***************************************************************************/
+//! @return no return
+//!	@details
+//! Clear underrun and segment counters
+/***************************************************************************/
+
+void Motion_queue::clear_stats( void )
+{
+	this -> g_underrun_cnt	= (uint16_t)0;
+	this -> g_seg_cnt		= (uint16_t)0;
+
+	return;	//OK
+}	//end method: clear_stats | void
+
+/****************************************************************************
+*****************************************************************************
+**	GETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_depth | void
+/***************************************************************************/
+//! @return uint8_t | number of segments waiting in the queue
+/***************************************************************************/
+
+uint8_t Motion_queue::get_depth( void )
+{
+	return this -> g_depth;
+}	//end getter: get_depth | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_underrun_cnt | void
+/***************************************************************************/
+//! @return uint16_t | number of underruns
+/***************************************************************************/
+
+uint16_t Motion_queue::get_underrun_cnt( void )
+{
+	return this -> g_underrun_cnt;
+}	//end getter: get_underrun_cnt | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_seg_cnt | void
+/***************************************************************************/
+//! @return uint16_t | number of completed segments
+/***************************************************************************/
+
+uint16_t Motion_queue::get_seg_cnt( void )
+{
+	return this -> g_seg_cnt;
+}	//end getter: get_seg_cnt | void
+
+/****************************************************************************
+*****************************************************************************
+**	REFERENCES
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	TESTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Tester
+//!	is_busy | void
+/***************************************************************************/
+//! @return bool | true = a segment is in execution or waiting, or an axis is still moving
+/***************************************************************************/
+
+bool Motion_queue::is_busy( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	uint8_t t;
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//if: segments to execute
+	if ((this -> g_f_active == true) || (this -> g_depth > 0))
+	{
+		return true;
+	}
+	//For: each axis
+	for (t = 0;t < MOTION_AXIS_NUM;t++)
+	{
+		//if: axis is still moving
+		if ((this -> g_spd[t] != 0) || (this -> g_filter[t].is_settled() == false))
+		{
+			return true;
+		}
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return false;
+}	//end tester: is_busy | void
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	exe | int32_t *
+/***************************************************************************/
+//! @param pos | (int32_t *) writeback vector of MOTION_AXIS_NUM position references
+//! @return no return
+//!	@details
+//! Advance by one system tick.
+//! Start the next segment if none is in execution, move the axes, filter the references
+//! and detect the end of the segment
+/***************************************************************************/
+
+void Motion_queue::exe( int32_t *pos )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	uint8_t t;
+	//Target speed of the ramp
+	int32_t spd_target;
+	//Acceleration of the ramp
+	int32_t amax;
+	//Position fraction plus the movement of this tick
+	int32_t pos_acc;
+	//true = segment in execution has ended
+	bool f_done;
+	//true = an axis is moving
+	bool f_moving;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//if: no segment in execution
+	if (this -> g_f_active == false)
+	{
+		//Start the next segment if any
+		this -> load_segment();
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+		//! Move the axes
+	//For: each axis
+	for (t = 0;t < MOTION_AXIS_NUM;t++)
+	{
+		//if: position segment
+		if ((this -> g_f_active == true) && (this -> g_cur.type == MOTION_SEG_POS))
+		{
+			//Advance the trapezoidal profile
+			this -> g_pos[t]		= this -> g_trap[t].exe();
+			this -> g_pos_frac[t]	= (uint16_t)0;
+			this -> g_spd[t]		= this -> g_trap[t].get_spd();
+		}
+		//if: speed segment or no segment
+		else
+		{
+			//if: speed segment
+			if (this -> g_f_active == true)
+			{
+				spd_target	= this -> g_cur.target[t];
+				amax		= (int32_t)this -> g_cur.amax;
+			}
+			//if: no segment
+			else
+			{
+				//Stop
+				spd_target	= (int32_t)0;
+				amax		= (int32_t)this -> g_stop_amax;
+			}
+			//Ramp the speed toward the target without overshooting it
+			if (this -> g_spd[t] < spd_target)
+			{
+				this -> g_spd[t] = AT_SAT( this -> g_spd[t] +amax, spd_target, this -> g_spd[t] );
+			}
+			else
+			{
+				this -> g_spd[t] = AT_SAT( this -> g_spd[t] -amax, this -> g_spd[t], spd_target );
+			}
+			//Add the movement of this tick to the fraction
+			pos_acc = (int32_t)this -> g_pos_frac[t] +this -> g_spd[t];
+			//Move the integer part
+			this -> g_pos[t] += (pos_acc >> TRAP_PROFILE_FRAC);
+			//Keep the fraction
+			this -> g_pos_frac[t] = (uint16_t)(pos_acc & (((int32_t)1 << TRAP_PROFILE_FRAC) -1));
+		}
+		//Limit the jerk
+		pos[t] = this -> g_filter[t].exe( this -> g_pos[t] );
+	}	//End For: each axis
+
+		//! Detect the end of the segment
+	//if: no segment in execution
+	if (this -> g_f_active == false)
+	{
+		return;	//OK
+	}
+	//One more tick
+	this -> g_tick_cnt++;
+	//if: segment is still in its duration
+	if (this -> g_tick_cnt < this -> g_cur.duration)
+	{
+		f_done = false;
+	}
+	//if: speed segment
+	else if (this -> g_cur.type == MOTION_SEG_VEL)
+	{
+		f_done = true;
+	}
+	//if: position segment
+	else
+	{
+		f_done = true;
+		//For: each axis
+		for (t = 0;t < MOTION_AXIS_NUM;t++)
+		{
+			//Position segments end when all axes rest on target
+			f_done &= this -> g_trap[t].is_done();
+		}
+	}
+	//if: segment ended
+	if (f_done == true)
+	{
+		//One more segment completed
+		this -> g_seg_cnt++;
+		//Stop with the acceleration of this segment if no other segment follows
+		this -> g_stop_amax = this -> g_cur.amax;
+		this -> g_f_active = false;
+		//Check if an axis is moving
+		f_moving = false;
+		for (t = 0;t < MOTION_AXIS_NUM;t++)
+		{
+			f_moving |= (this -> g_spd[t] != 0);
+		}
+		//if: platform is moving and there is nothing to do next
+		if ((f_moving == true) && (this -> g_depth == 0))
+		{
+			//Host didn't stream segments fast enough
+			this -> g_underrun_cnt++;
+		}
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return;	//OK
+}	//end method: exe | int32_t *
+
+/****************************************************************************
+*****************************************************************************
+**	PRIVATE METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Private Method
+//!	load_segment | void
+/***************************************************************************/
+//! @return false: a segment has been started | true: queue is empty
+//!	@details
+//! Pop the oldest segment and start it from the current position and speed of the axes.
+//! Position segments use a division to convert the speed to acceleration steps
+/***************************************************************************/
+
+bool Motion_queue::load_segment( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	uint8_t t;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//if: queue is empty
+	if (this -> g_depth == 0)
+	{
+		return true;	//nothing to do
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Pop the oldest segment
+	this -> g_cur = this -> g_seg[ this -> g_head ];
+	this -> g_head = (this -> g_head +1) % MOTION_QUEUE_SIZE;
+	this -> g_depth--;
+	//Start execution
+	this -> g_f_active = true;
+	this -> g_tick_cnt = (uint32_t)0;
+	//For: each axis
+	for (t = 0;t < MOTION_AXIS_NUM;t++)
+	{
+		//Jerk limit. Only applied if the axis has settled
+		this -> g_filter[t].set_shift( this -> g_cur.jerk_shift );
+		//if: position segment
+		if (this -> g_cur.type == MOTION_SEG_POS)
+		{
+			//Chain the profile after the current position and speed
+			this -> g_trap[t].set_limits( this -> g_cur.vmax, this -> g_cur.amax );
+			this -> g_trap[t].reset( this -> g_pos[t], this -> g_spd[t] );
+			this -> g_trap[t].set_target( this -> g_cur.target[t] );
+		}
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return false;	//OK
+}	//end method: load_segment | void
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+} //End Namespace
@@ -0,0 +1,245 @@
+/**********************************************************************************
+**	ENVIROMENT VARIABILE
+**********************************************************************************/
+
+#ifndef MOTION_QUEUE_H_
+	#define MOTION_QUEUE_H_
+
+/**********************************************************************************
+**	GLOBAL INCLUDES
+**********************************************************************************/
+
+//trap_profile.h and scurve_filter.h must be included before this header
+
+/**********************************************************************************
+**	DEFINES
+**********************************************************************************/
+
+//Maximum number of segments waiting in the queue
+#define MOTION_QUEUE_SIZE	16
+//Number of axes moved by a segment. Right and left side of the platform
+#define MOTION_AXIS_NUM		2
+
+/**********************************************************************************
+**	MACROS
+**********************************************************************************/
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+//! @namespace OrangeBot
+namespace OrangeBot
+{
+
+/**********************************************************************************
+**	TYPEDEFS
+**********************************************************************************/
+
+//Kind of segment
+typedef enum _Motion_seg_type
+{
+	MOTION_SEG_VEL	= 0,	//Ramp to a speed and hold it for a duration
+	MOTION_SEG_POS	= 1		//Move to an absolute position and stop
+} Motion_seg_type;
+
+//Segment of a motion. Units are system ticks. Speed and acceleration are fixed point TRAP_PROFILE_FRAC
+typedef struct _Motion_segment
+{
+	//Motion_seg_type
+	uint8_t type;
+	//VEL: signed speed, counts per tick | POS: absolute position in counts
+	int32_t target[MOTION_AXIS_NUM];
+	//Maximum speed. Counts per tick. POS only
+	uint32_t vmax;
+	//Acceleration. Counts per tick squared
+	uint32_t amax;
+	//log2 of the number of ticks the acceleration takes to ramp. Jerk is amax >> jerk_shift
+	uint8_t jerk_shift;
+	//VEL: duration in ticks | POS: minimum duration in ticks
+	uint32_t duration;
+} Motion_segment;
+
+/**********************************************************************************
+**	PROTOTYPE: STRUCTURES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: GLOBAL VARIABILES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: CLASS
+**********************************************************************************/
+
+/************************************************************************************/
+//! @class 		Motion_queue
+/************************************************************************************/
+//!	@author		Orso Eric
+//! @version	0.1 alpha
+//! @date		2019-11-15
+//! @brief		Queue of motion segments executed with S-curve profiles
+//! @details
+//!	The host streams segments ahead of time. The queue executes them back to back, one tick at a time \n
+//! FEATURES:	\n
+//!		Segments	\n
+//! VEL: ramp each axis to a speed with the given acceleration and hold it for a duration \n
+//! POS: move each axis to an absolute position with a trapezoidal profile and stop \n
+//! Segments are chained without speed jumps \n
+//!		S-curve	\n
+//! The trapezoidal reference of each axis is filtered by a moving average. Jerk is limited to amax / 2^jerk_shift \n
+//! The length of the filter can only change when the axis has settled \n
+//!		Underrun	\n
+//! When a VEL segment ends with a moving axis and no segment is waiting, the queue underruns.
+//! Underruns are counted and the axes ramp down to a stop with the acceleration of the last segment \n
+//! @pre		trap_profile.h and scurve_filter.h included before this header
+//! @bug		None
+//! @warning	Segments are expressed in system ticks. They must be flushed when the tick rate changes
+//! @copyright	License ?
+//! @todo		todo list
+/************************************************************************************/
+
+class Motion_queue
+{
+	//Visible to all
+	public:
+		//--------------------------------------------------------------------------
+		//	CONSTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//! Default constructor
+		Motion_queue( void );
+
+		//--------------------------------------------------------------------------
+		//	DESTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//!Default destructor
+		~Motion_queue( void );
+
+		//--------------------------------------------------------------------------
+		//	OPERATORS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	SETTERS
+		//--------------------------------------------------------------------------
+
+		//Add a segment at the end of the queue. false=OK
+		bool push( Motion_segment &seg );
+		//Drop the waiting segments and the segment in execution. Axes ramp down to a stop
+		void abort( void );
+		//Drop the segment in execution and put the axes at rest at position 0. Waiting segments are kept
+		void home( void );
+		//Drop all segments and put the axes at rest at position 0
+		void reset( void );
+		//Clear underrun and segment counters
+		void clear_stats( void );
+
+		//--------------------------------------------------------------------------
+		//	GETTERS
+		//--------------------------------------------------------------------------
+
+		//Number of segments waiting in the queue
+		uint8_t get_depth( void );
+		//Number of underruns
+		uint16_t get_underrun_cnt( void );
+		//Number of segments completed
+		uint16_t get_seg_cnt( void );
+
+		//--------------------------------------------------------------------------
+		//	REFERENCES
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	TESTERS
+		//--------------------------------------------------------------------------
+
+		//true = a segment is in execution or waiting, or an axis is still moving
+		bool is_busy( void );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC METHODS
+		//--------------------------------------------------------------------------
+
+		//Advance by one system tick and compute the position reference of each axis
+		void exe( int32_t *pos );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC STATIC METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC VARS
+		//--------------------------------------------------------------------------
+
+	//Visible to derived classes
+	protected:
+		//--------------------------------------------------------------------------
+		//	PROTECTED METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PROTECTED VARS
+		//--------------------------------------------------------------------------
+
+	//Visible only inside the class
+	private:
+		//--------------------------------------------------------------------------
+		//	PRIVATE METHODS
+		//--------------------------------------------------------------------------
+
+		//Pop the next segment and start its execution. false=a segment has been started
+		bool load_segment( void );
+
+		//--------------------------------------------------------------------------
+		//	PRIVATE VARS
+		//--------------------------------------------------------------------------
+
+			///Queue
+		//Circular buffer of the waiting segments
+		Motion_segment g_seg[MOTION_QUEUE_SIZE];
+		//Index of the oldest segment
+		uint8_t g_head;
+		//Number of waiting segments
+		uint8_t g_depth;
+
+			///Execution
+		//Segment in execution
+		Motion_segment g_cur;
+		//true = g_cur is in execution
+		bool g_f_active;
+		//Ticks since the start of the segment in execution
+		uint32_t g_tick_cnt;
+		//Acceleration used to stop when no segment is in execution
+		uint32_t g_stop_amax;
+
+			///Axes
+		//Position profile of the POS segments
+		Trap_profile g_trap[MOTION_AXIS_NUM];
+		//S-curve filter
+		Scurve_filter g_filter[MOTION_AXIS_NUM];
+		//Position reference before the S-curve filter. Integer part in counts
+		int32_t g_pos[MOTION_AXIS_NUM];
+		//Position reference before the S-curve filter. Fractional part
+		uint16_t g_pos_frac[MOTION_AXIS_NUM];
+		//Signed speed. Counts per tick. Fixed point
+		int32_t g_spd[MOTION_AXIS_NUM];
+
+			///Statistics
+		//Number of underruns
+		uint16_t g_underrun_cnt;
+		//Number of completed segments
+		uint16_t g_seg_cnt;
+
+};	//End Class: Motion_queue
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
+
+#else
+    #warning "Multiple inclusion of hader file"
+#endif
@@ -0,0 +1,487 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	ODOMETRY
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:		2019-11-16
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Differential drive odometry
+**	With dR, dL the movement of the right and left side in counts and T the
+**	track in counts:
+**		ds		= (dR + dL) / 2
+**		dtheta	= (dR - dL) / T						[rad]
+**		x		+= ds * cos( theta + dtheta/2 )
+**		y		+= ds * sin( theta + dtheta/2 )
+**	Heading is a 32b binary angle: 2^32 is a full turn and the counter wraps
+**	naturally. Only the upper 16b are used to compute sin and cos.
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include "global.h"
+//Class Header
+#include "odometry.h"
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+namespace OrangeBot
+{
+
+/****************************************************************************
+**	GLOBAL VARIABILES
+****************************************************************************/
+
+//Quarter wave sine table. Q15. sin( i * pi/2 / 64 )
+static const int16_t g_sin_lut[ (1 << ODOMETRY_LUT_SHIFT) +1 ] =
+{
+	    0,   804,  1608,  2410,  3212,  4011,  4808,  5602,
+	 6393,  7179,  7962,  8739,  9512, 10278, 11039, 11793,
+	12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+	18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+	23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+	27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+	30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+	32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+	32767
+};
+
+/****************************************************************************
+*****************************************************************************
+**	CONSTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Constructor
+//!	Odometry | void
+/***************************************************************************/
+// @param
+//! @return no return
+//!	@details
+//! Empty constructor. Pose is at the origin. Heading doesn't change until the track is set
+/***************************************************************************/
+
+Odometry::Odometry( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//No geometry
+	this -> g_angle_gain	= (uint32_t)0;
+	this -> g_turn_gain		= (uint32_t)0;
+	//Sides have never been read
+	this -> g_right_old		= (int32_t)0;
+	this -> g_left_old		= (int32_t)0;
+	this -> g_f_init		= false;
+	//Origin
+	this -> reset();
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end constructor:
+
+/****************************************************************************
+*****************************************************************************
+**	DESTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Destructor
+//!	Odometry | void
+/***************************************************************************/
+// @param
+//! @return no return
+//!	@details
+//! Empty destructor
+/***************************************************************************/
+
+Odometry::~Odometry( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end destructor:
+
+/****************************************************************************
+*****************************************************************************
+**	OPERATORS
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	SETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	set_track | uint32_t
+/***************************************************************************/
+//! @param track | distance between the right and left wheels expressed in encoder counts
+//! @return false: OK | true: fail
+//!	@details
+//! Compute the gains that depend on the geometry. Uses a division
+//!	angle gain = 2^32 / (2*pi*track)
+//!	turn gain = pi*track/2^16, fixed point 8 = track * 3217 / 2^18
+/***************************************************************************/
+
+bool Odometry::set_track( uint32_t track )
+{
+	//Trace Enter
+	DENTER_ARG("track: %d\n", track);
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//if: track is out of range
+	if ((track == 0) || (track > (uint32_t)1000000))
+	{
+		//Trace Return
+		DRETURN_ARG("ERR: bad track\n");
+		return true;	//fail
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//32b binary angle per count of difference between the sides. 2^32/(2*pi)
+	this -> g_angle_gain = (uint32_t)683565276 / track;
+	//Side speed per unit of angular speed. Fixed point 8
+	this -> g_turn_gain = (track * (uint32_t)3217) >> 18;
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return false;	//OK
+}	//end method: set_track | uint32_t
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	reset | void
+/***************************************************************************/
+//! @return no return
+//!	@details
+//! Set the pose to the origin. X axis is the current heading
+/***************************************************************************/
+
+void Odometry::reset( void )
+{
+	this -> g_x		= (int32_t)0;
+	this -> g_y		= (int32_t)0;
+	this -> g_theta	= (uint32_t)0;
+
+	return;	//OK
+}	//end method: reset | void
+
+/****************************************************************************
+*****************************************************************************
+**	GETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_x | void
+/***************************************************************************/
+//! @return int32_t | X position in counts
+/***************************************************************************/
+
+int32_t Odometry::get_x( void )
+{
+	return (this -> g_x >> 8);
+}	//end getter: get_x | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_y | void
+/***************************************************************************/
+//! @return int32_t | Y position in counts
+/***************************************************************************/
+
+int32_t Odometry::get_y( void )
+{
+	return (this -> g_y >> 8);
+}	//end getter: get_y | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_theta | void
+/***************************************************************************/
+//! @return uint16_t | heading. ODOMETRY_FULL_TURN is a full turn
+/***************************************************************************/
+
+uint16_t Odometry::get_theta( void )
+{
+	return (uint16_t)(this -> g_theta >> 16);
+}	//end getter: get_theta | void
+
+/****************************************************************************
+*****************************************************************************
+**	REFERENCES
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	TESTERS
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	update | int32_t, int32_t
+/***************************************************************************/
+//! @param right | position of the right side in counts. Forward is positive
+//! @param left | position of the left side in counts. Forward is positive
+//! @return no return
+//!	@details
+//! Integrate the movement of the two sides since the last update.
+//! The first update only latches the position of the sides
+/***************************************************************************/
+
+void Odometry::update( int32_t right, int32_t left )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Movement of the sides
+	int32_t d_right, d_left;
+	//Twice the movement of the center
+	int32_t ds2;
+	//Heading change. 32b binary angle
+	int32_t d_theta;
+	//Heading in the middle of the step. 16b angle
+	uint16_t theta_mid;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//if: first update
+	if (this -> g_f_init == false)
+	{
+		//Latch
+		this -> g_right_old	= right;
+		this -> g_left_old	= left;
+		this -> g_f_init	= true;
+		return;
+	}
+	//Movement of the sides
+	d_right	= right -this -> g_right_old;
+	d_left	= left -this -> g_left_old;
+	this -> g_right_old	= right;
+	this -> g_left_old	= left;
+	//if: platform didn't move
+	if ((d_right == 0) && (d_left == 0))
+	{
+		return;
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Heading change
+	d_theta = (d_right -d_left) * (int32_t)this -> g_angle_gain;
+	//Heading in the middle of the step
+	theta_mid = (uint16_t)((this -> g_theta +(uint32_t)(d_theta / 2)) >> 16);
+	//Movement of the center
+	ds2 = d_right +d_left;
+	//Project. Q15 * 2 -> fixed point 8 with rounding
+	this -> g_x += (ds2 * Odometry::cos_q15( theta_mid ) +((int32_t)1 << 7)) >> 8;
+	this -> g_y += (ds2 * Odometry::sin_q15( theta_mid ) +((int32_t)1 << 7)) >> 8;
+	//New heading. Wraps at a full turn
+	this -> g_theta += (uint32_t)d_theta;
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return;	//OK
+}	//end method: update | int32_t, int32_t
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	turn_to_spd | int16_t
+/***************************************************************************/
+//! @param turn | angular speed. ODOMETRY_FULL_TURN per tick is a full turn per tick. Counter clockwise is positive
+//! @return int32_t | speed in counts per tick to add to the right side and subtract from the left side
+/***************************************************************************/
+
+int32_t Odometry::turn_to_spd( int16_t turn )
+{
+	return ((int32_t)turn * (int32_t)this -> g_turn_gain) >> 8;
+}	//end method: turn_to_spd | int16_t
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC STATIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Static Method
+//!	sin_q15 | uint16_t
+/***************************************************************************/
+//! @param angle | 16b angle. 65536 is a full turn
+//! @return int16_t | sine. Q15
+//!	@details
+//! Quarter wave table with linear interpolation.
+//! Upper two bits are the quadrant. The angle is mirrored on odd quadrants and the sign flipped on the lower half plane
+/***************************************************************************/
+
+int16_t Odometry::sin_q15( uint16_t angle )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Angle inside the quadrant. 0x4000 is a quarter turn
+	uint16_t quarter;
+	//Index inside the table
+	uint8_t index;
+	//Fraction between two samples. 8 bit
+	uint8_t frac;
+	//Interpolated value
+	int16_t ret;
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Angle inside the quadrant
+	quarter = angle & (uint16_t)0x3fff;
+	//if: second or fourth quadrant
+	if ((angle & (uint16_t)0x4000) != 0)
+	{
+		//Mirror
+		quarter = (uint16_t)0x4000 -quarter;
+	}
+	//Table index and fraction
+	index	= (uint8_t)(quarter >> 8);
+	frac	= (uint8_t)(quarter & 0xff);
+	//Sample
+	ret = g_sin_lut[ index ];
+	//if: between two samples
+	if (frac != 0)
+	{
+		//Linear interpolation
+		ret += (int16_t)((((int32_t)g_sin_lut[ index +1 ] -ret) * frac) >> 8);
+	}
+	//if: third or fourth quadrant
+	if ((angle & (uint16_t)0x8000) != 0)
+	{
+		//Lower half plane
+		ret = -ret;
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return ret;
+}	//end method: sin_q15 | uint16_t
+
+/***************************************************************************/
+//!	@brief Public Static Method
+//!	cos_q15 | uint16_t
+/***************************************************************************/
+//! @param angle | 16b angle. 65536 is a full turn
+//! @return int16_t | cosine. Q15
+/***************************************************************************/
+
+int16_t Odometry::cos_q15( uint16_t angle )
+{
+	//cos(x) = sin(x + pi/2)
+	return Odometry::sin_q15( angle +(uint16_t)0x4000 );
+}	//end method: cos_q15 | uint16_t
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+} //End Namespace
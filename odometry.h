@@ -0,0 +1,195 @@
+/**********************************************************************************
+**	ENVIROMENT VARIABILE
+**********************************************************************************/
+
+#ifndef ODOMETRY_H_
+	#define ODOMETRY_H_
+
+/**********************************************************************************
+**	GLOBAL INCLUDES
+**********************************************************************************/
+
+/**********************************************************************************
+**	DEFINES
+**********************************************************************************/
+
+//Full circle in the 16b angle units
+#define ODOMETRY_FULL_TURN		65536
+//Log2 of the number of steps of the quarter wave sine table
+#define ODOMETRY_LUT_SHIFT		6
+
+/**********************************************************************************
+**	MACROS
+**********************************************************************************/
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+//! @namespace OrangeBot
+namespace OrangeBot
+{
+
+/**********************************************************************************
+**	TYPEDEFS
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: STRUCTURES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: GLOBAL VARIABILES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: CLASS
+**********************************************************************************/
+
+/************************************************************************************/
+//! @class 		Odometry
+/************************************************************************************/
+//!	@author		Orso Eric
+//! @version	0.1 alpha
+//! @date		2019-11-16
+//! @brief		Differential drive odometry in fixed point
+//! @details
+//!	Integrate the pose of the platform from the position of the right and left side \n
+//! FEATURES:	\n
+//!		Pose	\n
+//! X and Y are in counts with 8 fractional bits. Heading is a 32b binary angle, a full turn wraps the counter \n
+//! Heading of the middle of the step is used to project the movement \n
+//!		Fast sin/cos	\n
+//! Quarter wave table of 65 Q15 samples with linear interpolation. Error is below 5 LSB \n
+//!		Kinematics	\n
+//! Convert an angular speed into the speed offset of the two sides \n
+//! @pre		Track must be set before use
+//! @bug		None
+//! @warning	Fixed point X and Y wrap after 2^23 counts
+//! @copyright	License ?
+//! @todo		todo list
+/************************************************************************************/
+
+class Odometry
+{
+	//Visible to all
+	public:
+		//--------------------------------------------------------------------------
+		//	CONSTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//! Default constructor
+		Odometry( void );
+
+		//--------------------------------------------------------------------------
+		//	DESTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//!Default destructor
+		~Odometry( void );
+
+		//--------------------------------------------------------------------------
+		//	OPERATORS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	SETTERS
+		//--------------------------------------------------------------------------
+
+		//Set the distance between the right and left wheels in counts. false=OK
+		bool set_track( uint32_t track );
+		//Set the pose to the origin. X axis is the current heading
+		void reset( void );
+
+		//--------------------------------------------------------------------------
+		//	GETTERS
+		//--------------------------------------------------------------------------
+
+		//X position in counts
+		int32_t get_x( void );
+		//Y position in counts
+		int32_t get_y( void );
+		//Heading. ODOMETRY_FULL_TURN is a full turn. Counter clockwise is positive
+		uint16_t get_theta( void );
+
+		//--------------------------------------------------------------------------
+		//	REFERENCES
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	TESTERS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC METHODS
+		//--------------------------------------------------------------------------
+
+		//Integrate the movement of the two sides since the last update
+		void update( int32_t right, int32_t left );
+		//Speed to add to the right side and subtract from the left side to turn at a given angular speed
+		int32_t turn_to_spd( int16_t turn );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC STATIC METHODS
+		//--------------------------------------------------------------------------
+
+		//Sine of a 16b angle. Q15
+		static int16_t sin_q15( uint16_t angle );
+		//Cosine of a 16b angle. Q15
+		static int16_t cos_q15( uint16_t angle );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC VARS
+		//--------------------------------------------------------------------------
+
+	//Visible to derived classes
+	protected:
+		//--------------------------------------------------------------------------
+		//	PROTECTED METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PROTECTED VARS
+		//--------------------------------------------------------------------------
+
+	//Visible only inside the class
+	private:
+		//--------------------------------------------------------------------------
+		//	PRIVATE METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PRIVATE VARS
+		//--------------------------------------------------------------------------
+
+			///Geometry
+		//32b binary angle per count of difference between the two sides
+		uint32_t g_angle_gain;
+		//Side speed per unit of angular speed. Fixed point 8
+		uint32_t g_turn_gain;
+
+			///Pose
+		//Position in counts. Fixed point 8
+		int32_t g_x;
+		int32_t g_y;
+		//Heading. 32b binary angle
+		uint32_t g_theta;
+
+			///Input
+		//Position of the sides at the last update
+		int32_t g_right_old;
+		int32_t g_left_old;
+		//false = first update. Latch the sides without moving
+		bool g_f_init;
+
+};	//End Class: Odometry
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
+
+#else
+    #warning "Multiple inclusion of hader file"
+#endif
@@ -8,6 +8,22 @@
 //#include "uniparser.h"
 
 #include "at_string.h"
+//Cooperative scheduler
+#include "scheduler.h"
+//Execution time statistics
+#include "profiler.h"
+//Trapezoidal position profile
+#include "trap_profile.h"
+//Moving average that turns trapezoids into S-curves
+#include "scurve_filter.h"
+//Queue of motion segments
+#include "motion_queue.h"
+//Differential drive odometry
+#include "odometry.h"
+//Interpolation of sparse setpoints
+#include "setpoint_interp.h"
+//RAM capture of the control step
+#include "data_logger.h"
 
 /****************************************************************
 ** GLOBAL VARIABLES
@@ -24,6 +40,34 @@ U8 g_uart_timeout_cnt = 0;
 //Communication timeout has been detected
 bool g_f_timeout_detected = false;
 
+	///--------------------------------------------------------------------------
+	///	SCHEDULER
+	///--------------------------------------------------------------------------
+
+//Cooperative scheduler of the periodic tasks
+extern OrangeBot::Scheduler g_scheduler;
+//Execution time statistics
+extern OrangeBot::Profiler g_prof[PROF_NUM];
+
+	///--------------------------------------------------------------------------
+	///	CONTROL
+	///--------------------------------------------------------------------------
+
+//Position profile generator of the CONTROL_POS mode
+extern OrangeBot::Trap_profile g_pos_profile[ ENC_NUM ];
+//Motion queue of the CONTROL_QUEUE mode
+extern OrangeBot::Motion_queue g_motion_queue;
+//Limits applied to the segments pushed in the motion queue
+extern int16_t g_queue_vmax;
+extern int16_t g_queue_amax;
+extern int16_t g_queue_jerk;
+//Pose of the platform
+extern OrangeBot::Odometry g_odometry;
+//Interpolation of the speed setpoints
+extern OrangeBot::Setpoint_interp g_spd_interp[ ENC_NUM ];
+//RAM capture of the control step
+extern OrangeBot::Data_logger g_data_logger;
+
 /***************************************************************************/
 //!	@brief ping command handler
 //!	ping_handler | void
@@ -92,6 +136,7 @@ void signature_handler( void )
 	{
 		//Send the next signature byte
 		AT_BUF_PUSH(rpi_tx_buf, board_sign[t]);
+		t++;
 	}
 
 	//----------------------------------------------------------------
@@ -119,7 +164,7 @@ void set_speed_handler( int16_t motor_index, int16_t pwm )
 	//----------------------------------------------------------------
 
 	bool f_dir;
-	uint8_t tcb_pwm;
+	uint16_t tcb_pwm;
 
 	//----------------------------------------------------------------
 	//	INIT
@@ -142,10 +187,15 @@ void set_speed_handler( int16_t motor_index, int16_t pwm )
 		f_dir = false;
 	}
 	
-	tcb_pwm = pwm;
+	//Host PWM to PWM setting of the backend
+	tcb_pwm = DC_MOTOR_HOST_PWM( pwm );
 
+	//Motor settings are also staged by the control step, that might be running inside an ISR
+	cli();
 	//Set direction and speed setting of the VNH7040 controlled motor
 	set_vnh7040_speed( motor_index, f_dir, tcb_pwm );
+	commit_vnh7040();
+	sei();
 	
 	//----------------------------------------------------------------
 	//	RETURN
@@ -162,7 +212,7 @@ void set_speed_handler( int16_t motor_index, int16_t pwm )
 //! @param pwm_l | pwm for left side of platform
 //! @return false: OK | true: fail
 //!	@details
-//! Handler for the platform speed. Firmware handles logical configuration of the motors. TODO: evolve to forward and turn
+//! Handler for the platform speed. Firmware handles logical configuration of the motors. Forward and turn is set_platform_turn_handler
 //! Numeration is handled like an IC with dot on the back, viewing from the top
 //! Direction is corrected so that plus is forward
 //!			Left	Right
@@ -176,8 +226,8 @@ void set_platform_speed_handler(int16_t right, int16_t left )
 	//	VARS
 	//----------------------------------------------------------------
 
-	uint8_t f_dir_r, f_dir_l;
-	uint8_t tcb_pwm_l, tcb_pwm_r;
+	//Voltage command of each side. Sign matches convert_s16_to_pwm with f_dir = true
+	int16_t cmd_r, cmd_l;
 
 	//----------------------------------------------------------------
 	//	INIT
@@ -194,44 +244,43 @@ void set_platform_speed_handler(int16_t right, int16_t left )
 	//	MOTORS LAYOUT CORRECTIONS
 	//----------------------------------------------------------------
 
+	//Right side turns forward with f_dir = true
 	if (right < 0)
 	{
-		f_dir_r = false;
-		tcb_pwm_r = -right;
+		cmd_r = -(int16_t)DC_MOTOR_HOST_PWM( -right );
 	}
 	else
 	{
-		f_dir_r = true;
-		tcb_pwm_r = right;
+		cmd_r = (int16_t)DC_MOTOR_HOST_PWM( right );
 	}
 	
+	//Left side turns forward with f_dir = false
 	if (left < 0)
 	{
-		f_dir_l = true;
-		tcb_pwm_l = -left;
+		cmd_l = (int16_t)DC_MOTOR_HOST_PWM( -left );
 	}
 	else
 	{
-		f_dir_l = false;
-		tcb_pwm_l = left;
+		cmd_l = -(int16_t)DC_MOTOR_HOST_PWM( left );
 	}
 	
 	//----------------------------------------------------------------
-	//	UPDATE TARGET PWM AND DIRECTION
+	//	UPDATE TARGET COMMAND
 	//----------------------------------------------------------------
-	//	upgrade_pwm will take care of trying to reach the desired setting
+	//	Control step converts the voltage to PWM with the battery compensation, upgrade_pwm will take care of trying to reach the desired setting
+
+	//Control step might be running inside an ISR
+	cli();
 
 	//Set desired control mode to Speed PID
 	g_control_mode_target = CONTROL_PWM;
 
-	g_dc_motor_target[0].f_dir = 	f_dir_r;
-	g_dc_motor_target[0].pwm = 	tcb_pwm_r;
-	g_dc_motor_target[1].f_dir = 	f_dir_r;
-	g_dc_motor_target[1].pwm = 	tcb_pwm_r;
-	g_dc_motor_target[2].f_dir = 	f_dir_l;
-	g_dc_motor_target[2].pwm = 	tcb_pwm_l;
-	g_dc_motor_target[3].f_dir = 	f_dir_l;
-	g_dc_motor_target[3].pwm = 	tcb_pwm_l;
+	g_pwm_cmd[0] = 	cmd_r;
+	g_pwm_cmd[1] = 	cmd_r;
+	g_pwm_cmd[2] = 	cmd_l;
+	g_pwm_cmd[3] = 	cmd_l;
+	
+	sei();
 	
 	//----------------------------------------------------------------
 	//	RETURN
@@ -277,7 +326,12 @@ void set_pid_speed_handler( int16_t motor_index, int16_t spd )
 		return;
 	}
 	
+	//16b reference is read by the control step, that might be running inside an ISR
+	cli();
 	g_pid_spd_target[motor_index] = spd;
+	//Timestamp the setpoint and start moving the reference toward it
+	g_spd_interp[motor_index].set_target( spd );
+	sei();
 	
 	//----------------------------------------------------------------
 	//	RETURN
@@ -317,10 +371,18 @@ void set_platform_pid_speed_handler(int16_t right, int16_t left )
 	//	BODY
 	//----------------------------------------------------------------
 	
+	//16b references are read by the control step, that might be running inside an ISR
+	cli();
 	g_pid_spd_target[0] = -right;
 	g_pid_spd_target[1] = -right;
 	g_pid_spd_target[2] = left;
 	g_pid_spd_target[3] = left;
+	//Timestamp the setpoints and start moving the references toward them
+	g_spd_interp[0].set_target( -right );
+	g_spd_interp[1].set_target( -right );
+	g_spd_interp[2].set_target( left );
+	g_spd_interp[3].set_target( left );
+	sei();
 	
 	//----------------------------------------------------------------
 	//	RETURN
@@ -463,3 +525,1808 @@ void get_encoder_spd_handler( void )
 	
 	return;
 }	//End handler: get_encoder_spd_handler
+
+/***************************************************************************/
+//!	@brief handler
+//!	get_scheduler_stats_handler | uint8_t
+/***************************************************************************/
+//! @param index | index of the scheduler task
+//! @return void |
+//! @details
+//! Send execution time, maximum execution time and overrun count of a task
+//! SCH<index>T<exe time>M<max exe time>O<overruns>
+//! Times are in timestamp units
+/***************************************************************************/
+
+void get_scheduler_stats_handler( uint8_t index )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//counters
+	uint8_t t, ti;
+	//Temp message
+	uint8_t msg[MAX_DIGIT16 +1];
+	//temp return
+	uint8_t ret;
+	//Statistics to be sent
+	uint16_t stat[3];
+	//Identifier of each statistic
+	const uint8_t stat_id[3] = { 'T', 'M', 'O' };
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+	//if: task doesn't exist
+	if (index >= g_scheduler.get_num_task())
+	{
+		return;	//fail
+	}
+	//Fetch statistics
+	stat[0] = g_scheduler.get_exe_time( index );
+	stat[1] = g_scheduler.get_exe_time_max( index );
+	stat[2] = g_scheduler.get_overrun_cnt( index );
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Preamble
+	AT_BUF_PUSH( rpi_tx_buf, 'S' );
+	AT_BUF_PUSH( rpi_tx_buf, 'C' );
+	AT_BUF_PUSH( rpi_tx_buf, 'H' );
+	AT_BUF_PUSH( rpi_tx_buf, '0'+index );
+	//Scan each statistic
+	for (t = 0;t < 3;t++)
+	{
+		//Statistic identifier
+		AT_BUF_PUSH( rpi_tx_buf, stat_id[t] );
+		//Decode U16 into a string
+		ret = u16_to_str( stat[t], msg );
+		//Scan each byte inside the string
+		for (ti = 0;ti < ret;ti++)
+		{
+			//Send number
+			AT_BUF_PUSH( rpi_tx_buf, msg[ti] );
+		}
+	}
+	//Termination
+	AT_BUF_PUSH( rpi_tx_buf, '\0' );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: get_scheduler_stats_handler | uint8_t
+
+/***************************************************************************/
+//!	@brief handler
+//!	set_tick_rate_handler | uint16_t
+/***************************************************************************/
+//! @param freq | rate of the system tick [Hz]. 500, 1000 or 2000
+//! @return void |
+//! @details
+//! Handler for the set system tick rate message. Unsupported rates are ignored
+//!	Answer E if the gains of the PIDs can't be scaled to the new rate. Rate doesn't change
+/***************************************************************************/
+
+void set_tick_rate_handler( uint16_t freq )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//false = OK | true = rate refused
+	bool f_ret = false;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//if: base rate
+	if (freq == 500)
+	{
+		f_ret = set_tick_rate( TICK_RATE_500HZ );
+	}
+	else if (freq == 1000)
+	{
+		f_ret = set_tick_rate( TICK_RATE_1KHZ );
+	}
+	else if (freq == 2000)
+	{
+		f_ret = set_tick_rate( TICK_RATE_2KHZ );
+	}
+	//if: unsupported rate
+	else
+	{
+		//do nothing
+	}
+	//if: gains of the PIDs can't be scaled to the new rate
+	if (f_ret == true)
+	{
+		//FAIL
+		AT_BUF_PUSH(rpi_tx_buf,'E');
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: set_tick_rate_handler | uint16_t
+
+/***************************************************************************/
+//!	@brief handler
+//!	get_load_handler | void
+/***************************************************************************/
+//! @return void |
+//! @details
+//! Send the CPU load since the last profiler clear
+//! LOAD<load>I<idle iterations>
+//! Load is in permille and is the fraction of time the main loop wasn't idle
+/***************************************************************************/
+
+void get_load_handler( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//counter
+	uint8_t t;
+	//Temp message
+	uint8_t msg[MAX_DIGIT32 +1];
+	//temp return
+	uint8_t ret;
+	//Elapsed time and idle time
+	uint32_t loop_sum, idle_sum;
+	//CPU load in permille
+	uint16_t load;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+	//Main loop profilers are only written by the main loop
+	loop_sum = g_prof[PROF_LOOP].get_sum();
+	idle_sum = g_prof[PROF_IDLE].get_sum();
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//if: not enough samples
+	if (loop_sum < 1000)
+	{
+		load = 0;
+	}
+	else
+	{
+		//Scale elapsed time instead of idle time to avoid overflow
+		load = 1000 -(uint16_t)(idle_sum / (loop_sum / 1000));
+	}
+
+	//Preamble
+	AT_BUF_PUSH( rpi_tx_buf, 'L' );
+	AT_BUF_PUSH( rpi_tx_buf, 'O' );
+	AT_BUF_PUSH( rpi_tx_buf, 'A' );
+	AT_BUF_PUSH( rpi_tx_buf, 'D' );
+	//Load
+	ret = u16_to_str( load, msg );
+	for (t = 0;t < ret;t++)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, msg[t] );
+	}
+	//Number of idle iterations
+	AT_BUF_PUSH( rpi_tx_buf, 'I' );
+	ret = u32_to_str( g_prof[PROF_IDLE].get_cnt(), msg );
+	for (t = 0;t < ret;t++)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, msg[t] );
+	}
+	//Termination
+	AT_BUF_PUSH( rpi_tx_buf, '\0' );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: get_load_handler | void
+
+/***************************************************************************/
+//!	@brief handler
+//!	get_profiler_handler | uint8_t
+/***************************************************************************/
+//! @param index | profiling channel. Prof_channel
+//! @return void |
+//! @details
+//! Send the execution time statistics of a profiling channel
+//! PROF<index>N<samples>A<average>M<maximum>
+//! Times are in timestamp units
+/***************************************************************************/
+
+void get_profiler_handler( uint8_t index )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//counter
+	uint8_t t;
+	//Temp message
+	uint8_t msg[MAX_DIGIT32 +1];
+	//temp return
+	uint8_t ret;
+	//Local copy of the profiler
+	OrangeBot::Profiler prof;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+	//if: channel doesn't exist
+	if (index >= PROF_NUM)
+	{
+		return;	//fail
+	}
+	//Snapshot. ISR profiler is written by the ISRs. Division is done outside the critical section
+	cli();
+	prof = g_prof[index];
+	sei();
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Preamble
+	AT_BUF_PUSH( rpi_tx_buf, 'P' );
+	AT_BUF_PUSH( rpi_tx_buf, 'R' );
+	AT_BUF_PUSH( rpi_tx_buf, 'O' );
+	AT_BUF_PUSH( rpi_tx_buf, 'F' );
+	AT_BUF_PUSH( rpi_tx_buf, '0'+index );
+	//Number of samples
+	AT_BUF_PUSH( rpi_tx_buf, 'N' );
+	ret = u32_to_str( prof.get_cnt(), msg );
+	for (t = 0;t < ret;t++)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, msg[t] );
+	}
+	//Average
+	AT_BUF_PUSH( rpi_tx_buf, 'A' );
+	ret = u16_to_str( prof.get_avg(), msg );
+	for (t = 0;t < ret;t++)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, msg[t] );
+	}
+	//Maximum
+	AT_BUF_PUSH( rpi_tx_buf, 'M' );
+	ret = u16_to_str( prof.get_max(), msg );
+	for (t = 0;t < ret;t++)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, msg[t] );
+	}
+	//Termination
+	AT_BUF_PUSH( rpi_tx_buf, '\0' );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: get_profiler_handler | uint8_t
+
+/***************************************************************************/
+//!	@brief handler
+//!	get_histogram_handler | uint8_t
+/***************************************************************************/
+//! @param index | profiling channel. Prof_channel
+//! @return void |
+//! @details
+//! Send the execution time histogram of a profiling channel
+//! HIST<index>B<bin 0>B<bin 1>...B<bin 7>
+/***************************************************************************/
+
+void get_histogram_handler( uint8_t index )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//counters
+	uint8_t t, ti;
+	//Temp message
+	uint8_t msg[MAX_DIGIT16 +1];
+	//temp return
+	uint8_t ret;
+	//Local copy of the profiler
+	OrangeBot::Profiler prof;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+	//if: channel doesn't exist
+	if (index >= PROF_NUM)
+	{
+		return;	//fail
+	}
+	//Snapshot. ISR profiler is written by the ISRs
+	cli();
+	prof = g_prof[index];
+	sei();
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Preamble
+	AT_BUF_PUSH( rpi_tx_buf, 'H' );
+	AT_BUF_PUSH( rpi_tx_buf, 'I' );
+	AT_BUF_PUSH( rpi_tx_buf, 'S' );
+	AT_BUF_PUSH( rpi_tx_buf, 'T' );
+	AT_BUF_PUSH( rpi_tx_buf, '0'+index );
+	//Scan each bin
+	for (t = 0;t < PROF_HIST_SIZE;t++)
+	{
+		//Bin identifier
+		AT_BUF_PUSH( rpi_tx_buf, 'B' );
+		//Decode U16 into a string
+		ret = u16_to_str( prof.get_hist( t ), msg );
+		//Scan each byte inside the string
+		for (ti = 0;ti < ret;ti++)
+		{
+			//Send number
+			AT_BUF_PUSH( rpi_tx_buf, msg[ti] );
+		}
+	}
+	//Termination
+	AT_BUF_PUSH( rpi_tx_buf, '\0' );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: get_histogram_handler | uint8_t
+
+/***************************************************************************/
+//!	@brief handler
+//!	clear_profiler_handler | void
+/***************************************************************************/
+//! @return void |
+//! @details
+//! Clear all profiling channels and the scheduler statistics. Start a new measurement window
+/***************************************************************************/
+
+void clear_profiler_handler( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//counter
+	uint8_t t;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//For: each profiling channel
+	for (t = 0;t < PROF_NUM;t++)
+	{
+		//ISR profiler is written by the ISRs
+		cli();
+		g_prof[t].clear();
+		sei();
+	}
+	//Clear scheduler statistics
+	g_scheduler.clear_stats();
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: clear_profiler_handler | void
+
+/***************************************************************************/
+//!	@brief handler
+//!	set_control_isr_handler | uint8_t
+/***************************************************************************/
+//! @param f_enable | 1 = execute the control step inside the TCA0 overflow ISR | 0 = inside the main loop
+//! @return void |
+//! @details
+//! Handler for the control step execution context message
+//!	A step inside the ISR longer than CTRL_ISR_MAX_TIME goes back to the main loop and sends ERR_CODE_CONTROL_OVERRUN
+/***************************************************************************/
+
+void set_control_isr_handler( uint8_t f_enable )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Select the context of the control step
+	set_control_isr( f_enable != 0 );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: set_control_isr_handler | uint8_t
+
+/***************************************************************************/
+//!	@brief handler
+//!	set_pos_target_handler | int32_t, int32_t
+/***************************************************************************/
+//! @param index | index of the wheel
+//! @param target | absolute target position in encoder counts
+//! @return void |
+//! @details
+//! Handler for the absolute position target message. Switch to CONTROL_POS.
+//! The on board profile moves the wheel to the target, one message per move.
+//! When entering position mode, the targets of all wheels are set to their current position
+//! so that only the addressed wheel moves.
+//! The link still needs to be kept alive to avoid the communication timeout
+/***************************************************************************/
+
+void set_pos_target_handler( int32_t index, int32_t target )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//counter
+	uint8_t t;
+	//temp encoder counters
+	int32_t enc_cnt[ENC_NUM];
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+	//if: bad index
+	if ((index < 0) || (index >= ENC_NUM))
+	{
+		//FAIL
+		AT_BUF_PUSH(rpi_tx_buf,'E');
+		return;
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//if: entering position mode
+	if (g_control_mode_target != CONTROL_POS)
+	{
+		//if: failed to fetch encoder counters
+		if (get_enc_cnt( enc_cnt ) == true)
+		{
+			//FAIL
+			AT_BUF_PUSH(rpi_tx_buf,'E');
+			return;
+		}
+		//Profile is used by the control step, that might be running inside an ISR
+		cli();
+		//For: each wheel
+		for (t = 0;t < ENC_NUM;t++)
+		{
+			//Hold the current position
+			g_pos_profile[t].set_target( enc_cnt[t] );
+		}
+		sei();
+	}
+	//Set the target of the wheel
+	cli();
+	g_pos_profile[index].set_target( target );
+	sei();
+	//Set desired control mode to position
+	g_control_mode_target = CONTROL_POS;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: set_pos_target_handler | int32_t, int32_t
+
+/***************************************************************************/
+//!	@brief handler
+//!	set_pos_limits_handler | int16_t, int16_t, int16_t
+/***************************************************************************/
+//! @param index | index of the wheel
+//! @param vmax | maximum speed. Counts per base tick
+//! @param amax | acceleration. Counts per base tick squared. 256 = 1 count per base tick squared
+//! @return void |
+//! @details
+//! Handler for the position profile limits message. Can be sent while the wheel is moving
+/***************************************************************************/
+
+void set_pos_limits_handler( int16_t index, int16_t vmax, int16_t amax )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+	//if: bad index
+	if ((index < 0) || (index >= ENC_NUM))
+	{
+		//FAIL
+		AT_BUF_PUSH(rpi_tx_buf,'E');
+		return;
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//if: limits are invalid
+	if (set_pos_limits( (uint8_t)index, vmax, amax ) == true)
+	{
+		//FAIL
+		AT_BUF_PUSH(rpi_tx_buf,'E');
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: set_pos_limits_handler | int16_t, int16_t, int16_t
+
+/***************************************************************************/
+//!	@brief handler
+//!	set_queue_limits_handler | int16_t, int16_t, int16_t
+/***************************************************************************/
+//! @param vmax | maximum speed of position segments. Counts per base tick
+//! @param amax | acceleration. Counts per base tick squared. 256 = 1 count per base tick squared
+//! @param jerk | jerk. Counts per base tick cubed. 256 = 1 count per base tick cubed. 0 = no jerk limit
+//! @return void |
+//! @details
+//! Handler for the motion queue limits message. Limits apply to the segments queued afterward
+/***************************************************************************/
+
+void set_queue_limits_handler( int16_t vmax, int16_t amax, int16_t jerk )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+	//if: bad limits
+	if ((vmax <= 0) || (amax <= 0) || (jerk < 0))
+	{
+		//FAIL
+		AT_BUF_PUSH(rpi_tx_buf,'E');
+		return;
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Only used by the main loop when pushing segments
+	g_queue_vmax = vmax;
+	g_queue_amax = amax;
+	g_queue_jerk = jerk;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: set_queue_limits_handler | int16_t, int16_t, int16_t
+
+/***************************************************************************/
+//!	@brief handler
+//!	queue_speed_handler | int16_t, int16_t, int16_t
+/***************************************************************************/
+//! @param right | speed of the right side. Counts per base tick
+//! @param left | speed of the left side. Counts per base tick
+//! @param duration | duration of the segment, ramp included. Base ticks
+//! @return void |
+//! @details
+//! Handler for the queue speed segment message. Switch to CONTROL_QUEUE
+/***************************************************************************/
+
+void queue_speed_handler( int16_t right, int16_t left, int16_t duration )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+	//if: bad duration
+	if (duration <= 0)
+	{
+		//FAIL
+		AT_BUF_PUSH(rpi_tx_buf,'E');
+		return;
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//if: queue is full
+	if (push_motion_segment( OrangeBot::MOTION_SEG_VEL, right, left, (uint16_t)duration ) == true)
+	{
+		//FAIL
+		AT_BUF_PUSH(rpi_tx_buf,'E');
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: queue_speed_handler | int16_t, int16_t, int16_t
+
+/***************************************************************************/
+//!	@brief handler
+//!	queue_position_handler | int32_t, int32_t
+/***************************************************************************/
+//! @param right | absolute position of the right side. Counts from the origin of the queue
+//! @param left | absolute position of the left side. Counts from the origin of the queue
+//! @return void |
+//! @details
+//! Handler for the queue position segment message. Switch to CONTROL_QUEUE
+//! The segment ends when both sides rest on target
+/***************************************************************************/
+
+void queue_position_handler( int32_t right, int32_t left )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//if: queue is full
+	if (push_motion_segment( OrangeBot::MOTION_SEG_POS, right, left, (uint16_t)0 ) == true)
+	{
+		//FAIL
+		AT_BUF_PUSH(rpi_tx_buf,'E');
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: queue_position_handler | int32_t, int32_t
+
+/***************************************************************************/
+//!	@brief handler
+//!	get_queue_status_handler | void
+/***************************************************************************/
+//! @return void |
+//! @details
+//! Handler for the motion queue status message
+//!	Answer: QUEUE<depth>U<underruns>S<completed segments>
+//! Also sent by the telemetry task, so it doesn't reset the communication timeout
+/***************************************************************************/
+
+void get_queue_status_handler( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//counter
+	uint8_t t;
+	//Temp message
+	uint8_t msg[MAX_DIGIT32 +1];
+	//temp return
+	uint8_t ret;
+	//Snapshot of the queue status
+	uint8_t depth;
+	uint16_t underrun_cnt, seg_cnt;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Queue is executed by the control step, that might be running inside an ISR
+	cli();
+	depth			= g_motion_queue.get_depth();
+	underrun_cnt	= g_motion_queue.get_underrun_cnt();
+	seg_cnt			= g_motion_queue.get_seg_cnt();
+	sei();
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Preamble
+	AT_BUF_PUSH( rpi_tx_buf, 'Q' );
+	AT_BUF_PUSH( rpi_tx_buf, 'U' );
+	AT_BUF_PUSH( rpi_tx_buf, 'E' );
+	AT_BUF_PUSH( rpi_tx_buf, 'U' );
+	AT_BUF_PUSH( rpi_tx_buf, 'E' );
+	//Depth
+	ret = u8_to_str( depth, msg );
+	for (t = 0;t < ret;t++)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, msg[t] );
+	}
+	//Underruns
+	AT_BUF_PUSH( rpi_tx_buf, 'U' );
+	ret = u16_to_str( underrun_cnt, msg );
+	for (t = 0;t < ret;t++)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, msg[t] );
+	}
+	//Completed segments
+	AT_BUF_PUSH( rpi_tx_buf, 'S' );
+	ret = u16_to_str( seg_cnt, msg );
+	for (t = 0;t < ret;t++)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, msg[t] );
+	}
+	//Termination
+	AT_BUF_PUSH( rpi_tx_buf, '\0' );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: get_queue_status_handler | void
+
+/***************************************************************************/
+//!	@brief handler
+//!	abort_queue_handler | void
+/***************************************************************************/
+//! @return void |
+//! @details
+//! Handler for the abort motion queue message.
+//! Drop all segments. The platform ramps down to a stop and holds position
+/***************************************************************************/
+
+void abort_queue_handler( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Queue is executed by the control step, that might be running inside an ISR
+	cli();
+	g_motion_queue.abort();
+	sei();
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: abort_queue_handler | void
+
+/***************************************************************************/
+//!	@brief handler
+//!	set_platform_turn_handler | int16_t, int16_t
+/***************************************************************************/
+//! @param fwd | forward speed of the platform in encoder counts per base tick
+//! @param turn | angular speed of the platform. ODOMETRY_FULL_TURN per base tick is a full turn per base tick. Counter clockwise is positive
+//! @return void |
+//!	@details
+//! Handler for the platform forward and turn speed message
+//! Convert linear and angular speed into the speed of the two sides, then use the integrated speed controller
+/***************************************************************************/
+
+void set_platform_turn_handler( int16_t fwd, int16_t turn )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Speed offset of the sides required by the angular speed
+	int32_t turn_spd;
+	//Speed of the sides
+	int32_t right, left;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Right side is outside of a counter clockwise turn
+	turn_spd = g_odometry.turn_to_spd( turn );
+	right	= (int32_t)fwd +turn_spd;
+	left	= (int32_t)fwd -turn_spd;
+	//Clip to 16b. Resets the communication timeout and switches to the speed PID
+	set_platform_pid_speed_handler( AT_SAT( right, (int32_t)32767, (int32_t)-32767 ), AT_SAT( left, (int32_t)32767, (int32_t)-32767 ) );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: set_platform_turn_handler | int16_t, int16_t
+
+/***************************************************************************/
+//!	@brief handler
+//!	get_odometry_handler | void
+/***************************************************************************/
+//! @return void |
+//! @details
+//! Handler for the get odometry message
+//!	Answer: ODOMX<x>Y<y>T<theta>
+//! X and Y in encoder counts. Theta in 16b angle, ODOMETRY_FULL_TURN is a full turn
+/***************************************************************************/
+
+void get_odometry_handler( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//counter
+	uint8_t t;
+	//Temp message
+	uint8_t msg[MAX_DIGIT32 +2];
+	//temp return
+	uint8_t ret;
+	//Snapshot of the pose
+	int32_t x, y;
+	uint16_t theta;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+	//Pose is integrated by the control step, that might be running inside an ISR
+	cli();
+	x		= g_odometry.get_x();
+	y		= g_odometry.get_y();
+	theta	= g_odometry.get_theta();
+	sei();
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Preamble
+	AT_BUF_PUSH( rpi_tx_buf, 'O' );
+	AT_BUF_PUSH( rpi_tx_buf, 'D' );
+	AT_BUF_PUSH( rpi_tx_buf, 'O' );
+	AT_BUF_PUSH( rpi_tx_buf, 'M' );
+	//X
+	AT_BUF_PUSH( rpi_tx_buf, 'X' );
+	ret = s32_to_str( x, msg );
+	for (t = 0;t < ret;t++)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, msg[t] );
+	}
+	//Y
+	AT_BUF_PUSH( rpi_tx_buf, 'Y' );
+	ret = s32_to_str( y, msg );
+	for (t = 0;t < ret;t++)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, msg[t] );
+	}
+	//Heading
+	AT_BUF_PUSH( rpi_tx_buf, 'T' );
+	ret = u16_to_str( theta, msg );
+	for (t = 0;t < ret;t++)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, msg[t] );
+	}
+	//Termination
+	AT_BUF_PUSH( rpi_tx_buf, '\0' );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: get_odometry_handler | void
+
+/***************************************************************************/
+//!	@brief handler
+//!	clear_odometry_handler | void
+/***************************************************************************/
+//! @return void |
+//! @details
+//! Handler for the clear odometry message
+//! Origin moves on the platform. X axis is the current heading
+/***************************************************************************/
+
+void clear_odometry_handler( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Pose is integrated by the control step, that might be running inside an ISR
+	cli();
+	g_odometry.reset();
+	sei();
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: clear_odometry_handler | void
+
+/***************************************************************************/
+//!	@brief handler
+//!	set_spd_interp_handler | uint8_t
+/***************************************************************************/
+//! @param mode | 0 = step | 1 = linear | 2 = cubic
+//! @return void |
+//! @details
+//! Handler for the speed setpoint interpolation message
+//! Select how the speed reference of all wheels moves between the setpoints sent by the host
+/***************************************************************************/
+
+void set_spd_interp_handler( uint8_t mode )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//counter
+	uint8_t t;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Interpolators are executed by the control step, that might be running inside an ISR
+	cli();
+	//For: each wheel
+	for (t = 0;t < ENC_NUM;t++)
+	{
+		//Bad modes are rejected and leave the interpolation unchanged
+		g_spd_interp[t].set_mode( mode );
+	}
+	sei();
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: set_spd_interp_handler | uint8_t
+
+/***************************************************************************/
+//!	@brief handler
+//!	set_spd_limits_handler | int16_t, int16_t, int16_t
+/***************************************************************************/
+//! @param index | index of the wheel
+//! @param acc | acceleration. Counts per base tick squared. 256 = 1 count per base tick squared. 0 = no limit
+//! @param dec | deceleration. Counts per base tick squared. 256 = 1 count per base tick squared. 0 = no limit
+//! @return void |
+//! @details
+//! Handler for the speed reference limits message
+//! Limits apply to the speed reference of CONTROL_SPD and CONTROL_SPD_POS
+/***************************************************************************/
+
+void set_spd_limits_handler( int16_t index, int16_t acc, int16_t dec )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+	//if: bad index
+	if ((index < 0) || (index >= ENC_NUM))
+	{
+		//FAIL
+		AT_BUF_PUSH(rpi_tx_buf,'E');
+		return;
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//if: limits are invalid
+	if (set_spd_limits( (uint8_t)index, acc, dec ) == true)
+	{
+		//FAIL
+		AT_BUF_PUSH(rpi_tx_buf,'E');
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: set_spd_limits_handler | int16_t, int16_t, int16_t
+
+/***************************************************************************/
+//!	@brief handler
+//!	set_stop_mode_handler | uint8_t
+/***************************************************************************/
+//! @param f_brake | 0 = a motor with zero PWM coasts | 1 = a motor with zero PWM is braked to ground
+//! @return void |
+//! @details
+//! Handler for the stop mode message
+/***************************************************************************/
+
+void set_stop_mode_handler( uint8_t f_brake )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Read by the control step, that might be running inside an ISR. 8b write is atomic
+	g_f_vnh7040_brake = (f_brake != 0);
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: set_stop_mode_handler | uint8_t
+
+/***************************************************************************/
+//!	function
+//!	get_motor_current_handler
+/***************************************************************************/
+//! @return void |
+//! @brief Send the current of the four motors
+//! @details
+//!	CURI0N<mA>I1N<mA>I2N<mA>I3N<mA>
+//!	Current is measured on the high side. It reads 0 once the on time has been too short to sample for CURRENT_SENSE_STALE_NUM samples
+/***************************************************************************/
+
+void get_motor_current_handler( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//counters
+	uint8_t t, ti;
+	//Current of each motor. mA
+	uint16_t current[DC_MOTOR_NUM];
+	//Temp message
+	uint8_t msg[6];
+	//temp return
+	uint8_t ret;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Written by the ADC ISR
+	get_motor_current( current );
+
+	//Preamble
+	AT_BUF_PUSH( rpi_tx_buf, 'C' );
+	AT_BUF_PUSH( rpi_tx_buf, 'U' );
+	AT_BUF_PUSH( rpi_tx_buf, 'R' );
+
+	//Scan each motor
+	for (t = 0;t < DC_MOTOR_NUM;t++)
+	{
+		//Motor identifier
+		AT_BUF_PUSH( rpi_tx_buf, 'I' );
+		AT_BUF_PUSH( rpi_tx_buf, '0'+t );
+		AT_BUF_PUSH( rpi_tx_buf, 'N' );
+		//Decode U16 into a string
+		ret = u16_to_str( current[t], msg );
+		//Scan each byte inside the string
+		for (ti = 0;ti < ret;ti++)
+		{
+			//Send number
+			AT_BUF_PUSH( rpi_tx_buf, msg[ti] );
+		}
+	}
+	//Termination
+	AT_BUF_PUSH( rpi_tx_buf, '\0' );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: get_motor_current_handler
+
+/***************************************************************************/
+//!	@brief handler
+//!	set_current_loop_handler | int16_t, int16_t, int16_t, int16_t
+/***************************************************************************/
+//! @param f_enable | 0 = PID output is a PWM | 1 = PID output is a current reference in mA. 16b, the parser only takes arguments of the same type
+//! @param kff | feedforward gain. 8 bit PWM per mA. Fixed point CURRENT_LOOP_FP
+//! @param kp | proportional gain. 8 bit PWM per mA. Fixed point CURRENT_LOOP_FP
+//! @param ki | integral gain. 8 bit PWM per mA per sample. Fixed point CURRENT_LOOP_FP
+//! @return void |
+//! @details
+//! Handler for the inner current loop message
+//!	ILOOP1F128P64I4 enables the loop with the default gains
+/***************************************************************************/
+
+void set_current_loop_handler( int16_t f_enable, int16_t kff, int16_t kp, int16_t ki )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//if: gains are invalid
+	if (set_current_loop( (f_enable != 0), kff, kp, ki ) == true)
+	{
+		//FAIL
+		AT_BUF_PUSH(rpi_tx_buf,'E');
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: set_current_loop_handler | int16_t, int16_t, int16_t, int16_t
+
+/***************************************************************************/
+//!	@brief handler
+//!	set_pid_gains_handler | int16_t, int16_t, int16_t
+/***************************************************************************/
+//! @param kp | proportional gain. Fixed point PID_GAIN_FP
+//! @param ki | integral gain. Fixed point PID_GAIN_FP
+//! @param kd | derivative gain. Fixed point PID_GAIN_FP
+//! @return void |
+//! @details
+//! Handler for the PID gains message
+//!	GAINP16I0D0 restores the default gains. Answer E if a gain is negative, overflows once scaled to the command
+//!	and the tick rate in use, or the integral gain loses bits when divided by the system ticks in a base tick
+/***************************************************************************/
+
+void set_pid_gains_handler( int16_t kp, int16_t ki, int16_t kd )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//if: gains are invalid
+	if (set_spd_pid_gains( kp, ki, kd ) == true)
+	{
+		//FAIL
+		AT_BUF_PUSH(rpi_tx_buf,'E');
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: set_pid_gains_handler | int16_t, int16_t, int16_t
+
+/***************************************************************************/
+//!	function
+//!	get_vbat_handler
+/***************************************************************************/
+//! @return void |
+//! @brief Send the battery voltage
+//! @details
+//!	VBATN<mV>
+/***************************************************************************/
+
+void get_vbat_handler( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//counter
+	uint8_t t;
+	//Temp message
+	uint8_t msg[6];
+	//temp return
+	uint8_t ret;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Preamble
+	AT_BUF_PUSH( rpi_tx_buf, 'V' );
+	AT_BUF_PUSH( rpi_tx_buf, 'B' );
+	AT_BUF_PUSH( rpi_tx_buf, 'A' );
+	AT_BUF_PUSH( rpi_tx_buf, 'T' );
+	AT_BUF_PUSH( rpi_tx_buf, 'N' );
+	//Decode U16 into a string. Updated by the battery task in the main loop
+	ret = u16_to_str( g_vbat_mv, msg );
+	//Scan each byte inside the string
+	for (t = 0;t < ret;t++)
+	{
+		//Send number
+		AT_BUF_PUSH( rpi_tx_buf, msg[t] );
+	}
+	//Termination
+	AT_BUF_PUSH( rpi_tx_buf, '\0' );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: get_vbat_handler
+
+/***************************************************************************/
+//!	@brief handler
+//!	set_stream_handler | uint16_t, uint16_t
+/***************************************************************************/
+//! @param mask | signals to stream. STREAM_xxx bits. STREAM_DELTA for compressed frames. 0 = stop the stream
+//! @param decim | a frame every this many base ticks
+//! @return void
+//!	@details
+//! Sends 'E' if a signal is unknown, compressed frames have no signal, the decimation is zero,
+//!	or the longest frame doesn't fit the TX buffer with room for a reply. The stream doesn't change then.
+//!	The next compressed frame is a keyframe
+/***************************************************************************/
+
+void set_stream_handler( uint16_t mask, uint16_t decim )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//Longest frame. Preamble, mask and terminator
+	uint16_t len = 5;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//if: compressed. Preamble, header, mask and terminator
+	if ((mask & STREAM_DELTA) != 0)
+	{
+		//Longest varint is five bytes for 32b, three bytes for 16b
+		len += ((mask & STREAM_CNT) != 0)?(5 *ENC_NUM):(0);
+		len += ((mask & STREAM_SPD) != 0)?(3 *ENC_NUM):(0);
+		len += ((mask & STREAM_ERR) != 0)?(3 *ENC_NUM):(0);
+		len += ((mask & STREAM_PID) != 0)?(3 *3 *ENC_NUM):(0);
+		len += ((mask & STREAM_PWM) != 0)?(3 *ENC_NUM):(0);
+		len += ((mask & STREAM_CUR) != 0)?(3 *DC_MOTOR_NUM):(0);
+		len += ((mask & STREAM_VBAT) != 0)?(3):(0);
+	}
+	else
+	{
+		//Longest value is a sign and ten digits for 32b, a sign and five digits for 16b
+		len += ((mask & STREAM_CNT) != 0)?(11 *ENC_NUM):(0);
+		len += ((mask & STREAM_SPD) != 0)?(6 *ENC_NUM):(0);
+		len += ((mask & STREAM_ERR) != 0)?(6 *ENC_NUM):(0);
+		len += ((mask & STREAM_PID) != 0)?(3 *6 *ENC_NUM):(0);
+		len += ((mask & STREAM_PWM) != 0)?(6 *ENC_NUM):(0);
+		len += ((mask & STREAM_CUR) != 0)?(6 *DC_MOTOR_NUM):(0);
+		len += ((mask & STREAM_VBAT) != 0)?(6):(0);
+	}
+	//if: unknown signal, compressed nothing, no decimation or frame too long
+	if (((mask & ~(STREAM_ALL | STREAM_DELTA)) != 0) || (mask == STREAM_DELTA) || ((mask != 0) && (decim == 0)) || (len +STREAM_TX_RESERVE > RPI_TX_BUF_SIZE -1))
+	{
+		//FAIL
+		AT_BUF_PUSH(rpi_tx_buf,'E');
+		return;
+	}
+	g_stream_mask = (uint8_t)mask;
+	g_stream_decim = decim;
+	g_stream_len = (uint8_t)len;
+	g_stream_skip = 0;
+	g_stream_seq = 0;
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: set_stream_handler | uint16_t, uint16_t
+
+/***************************************************************************/
+//!	@brief handler
+//!	get_stream_handler | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//!	SUB<mask>D<decimation>K<skipped frames>
+/***************************************************************************/
+
+void get_stream_handler( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//counter
+	uint8_t t;
+	//Temp message
+	uint8_t msg[6];
+	//temp return
+	uint8_t ret;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Preamble
+	AT_BUF_PUSH( rpi_tx_buf, 'S' );
+	AT_BUF_PUSH( rpi_tx_buf, 'U' );
+	AT_BUF_PUSH( rpi_tx_buf, 'B' );
+	//Signals
+	ret = u8_to_str( g_stream_mask, msg );
+	for (t = 0;t < ret;t++)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, msg[t] );
+	}
+	//Decimation
+	AT_BUF_PUSH( rpi_tx_buf, 'D' );
+	ret = u16_to_str( g_stream_decim, msg );
+	for (t = 0;t < ret;t++)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, msg[t] );
+	}
+	//Skipped frames
+	AT_BUF_PUSH( rpi_tx_buf, 'K' );
+	ret = u16_to_str( g_stream_skip, msg );
+	for (t = 0;t < ret;t++)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, msg[t] );
+	}
+	//Termination
+	AT_BUF_PUSH( rpi_tx_buf, '\0' );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: get_stream_handler | void
+
+/***************************************************************************/
+//!	@brief handler
+//!	set_log_handler | uint16_t, uint16_t, uint16_t, uint16_t
+/***************************************************************************/
+//! @param sig | signals of each wheel. LOG_SIG_xxx bits
+//! @param wheel | wheels in a record. Bit 0 is wheel 0
+//! @param pre | records kept before the trigger
+//! @param decim | a record every this many control steps
+//! @return void
+//!	@details
+//! Stops the capture and drops its records. Sends 'E' if a signal or a wheel is unknown,
+//!	the record is longer than LOG_REC_MAX or the pre-trigger records don't leave room for the trigger record
+/***************************************************************************/
+
+void set_log_handler( uint16_t sig, uint16_t wheel, uint16_t pre, uint16_t decim )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//counter
+	uint8_t t;
+	//Signals and wheels set
+	uint8_t sig_num = 0;
+	uint8_t wheel_num = 0;
+	//temp return
+	bool f_ret = true;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	for (t = 0;t < 16;t++)
+	{
+		sig_num += (IS_BIT_ONE( sig, t ))?(1):(0);
+		wheel_num += (IS_BIT_ONE( wheel, t ))?(1):(0);
+	}
+	//if: signals and wheels exist and the record can be read back
+	if ((sig != 0) && ((sig & ~LOG_SIG_ALL) == 0) && (wheel != 0) && (wheel < ((uint16_t)1 << ENC_NUM)) && (sig_num *wheel_num <= LOG_REC_MAX))
+	{
+		//Capture is written by the control step, that might be running inside an ISR
+		cli();
+		f_ret = g_data_logger.setup( sig_num *wheel_num, pre, decim );
+		g_log_sig = sig;
+		g_log_wheel = (uint8_t)wheel;
+		sei();
+	}
+	//if: bad configuration
+	if (f_ret == true)
+	{
+		//FAIL
+		AT_BUF_PUSH(rpi_tx_buf,'E');
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: set_log_handler | uint16_t, uint16_t, uint16_t, uint16_t
+
+/***************************************************************************/
+//!	@brief handler
+//!	arm_log_handler | uint16_t, uint16_t
+/***************************************************************************/
+//! @param trig | trigger sources. LOG_TRIG_xxx bits. 0 = only LOGT
+//! @param step_th | smallest jump of the reference in one control step that triggers LOG_TRIG_STEP
+//! @return void
+//!	@details
+//! Drops the records and starts recording the history. Sends 'E' if a source is unknown or the capture isn't set up
+/***************************************************************************/
+
+void arm_log_handler( uint16_t trig, uint16_t step_th )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//temp return
+	bool f_ret = true;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//if: known sources
+	if ((trig & ~LOG_TRIG_ALL) == 0)
+	{
+		cli();
+		g_log_trig = (uint8_t)trig;
+		g_log_step_th = step_th;
+		f_ret = g_data_logger.arm();
+		sei();
+	}
+	//if: can't arm
+	if (f_ret == true)
+	{
+		//FAIL
+		AT_BUF_PUSH(rpi_tx_buf,'E');
+	}
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: arm_log_handler | uint16_t, uint16_t
+
+/***************************************************************************/
+//!	@brief handler
+//!	trigger_log_handler | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//! The next record of an armed capture is the trigger record. Ignored otherwise
+/***************************************************************************/
+
+void trigger_log_handler( void )
+{
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+	//Single flag read by the control step
+	g_data_logger.trigger();
+
+	return;
+}	//End handler: trigger_log_handler | void
+
+/***************************************************************************/
+//!	@brief handler
+//!	get_log_status_handler | void
+/***************************************************************************/
+//! @return void
+//!	@details
+//!	LOG<state>N<records>P<records before the trigger>
+//!	state: 0 idle | 1 armed | 2 triggered | 3 done, the records can be read
+/***************************************************************************/
+
+void get_log_status_handler( void )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//counter
+	uint8_t t;
+	//Temp message
+	uint8_t msg[6];
+	//temp return
+	uint8_t ret;
+	//Snapshot of the capture
+	uint8_t state;
+	uint16_t num, pre;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+	//Capture is written by the control step, that might be running inside an ISR
+	cli();
+	state	= g_data_logger.get_state();
+	num		= g_data_logger.get_num();
+	pre		= g_data_logger.get_pre();
+	sei();
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Preamble
+	AT_BUF_PUSH( rpi_tx_buf, 'L' );
+	AT_BUF_PUSH( rpi_tx_buf, 'O' );
+	AT_BUF_PUSH( rpi_tx_buf, 'G' );
+	AT_BUF_PUSH( rpi_tx_buf, '0' +state );
+	//Records
+	AT_BUF_PUSH( rpi_tx_buf, 'N' );
+	ret = u16_to_str( num, msg );
+	for (t = 0;t < ret;t++)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, msg[t] );
+	}
+	//Records before the trigger
+	AT_BUF_PUSH( rpi_tx_buf, 'P' );
+	ret = u16_to_str( pre, msg );
+	for (t = 0;t < ret;t++)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, msg[t] );
+	}
+	//Termination
+	AT_BUF_PUSH( rpi_tx_buf, '\0' );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: get_log_status_handler | void
+
+/***************************************************************************/
+//!	@brief handler
+//!	read_log_handler | uint16_t
+/***************************************************************************/
+//! @param index | record. 0 is the oldest
+//! @return void
+//!	@details
+//!	LOGR<index> followed by the values of the record, each starting with its sign.
+//!	Sends 'E' if the capture isn't done, there is no such record, or the TX buffer has no room
+//!	for the reply. A telemetry stream might be using it
+/***************************************************************************/
+
+void read_log_handler( uint16_t index )
+{
+	//----------------------------------------------------------------
+	//	VARS
+	//----------------------------------------------------------------
+
+	//counters
+	uint8_t t, ti;
+	//Temp message
+	uint8_t msg[7];
+	//temp return
+	uint8_t ret;
+	//Record
+	int16_t rec[LOG_REC_MAX];
+	uint8_t rec_len;
+	bool f_ret;
+
+	//----------------------------------------------------------------
+	//	INIT
+	//----------------------------------------------------------------
+
+	//Reset communication timeout handler
+	g_uart_timeout_cnt = 0;
+	//A done capture is no longer written by the control step
+	cli();
+	f_ret = g_data_logger.read( index, rec );
+	rec_len = g_data_logger.get_rec_len();
+	sei();
+	//if: no record, or the longest reply doesn't fit
+	if ((f_ret == true) || ((uint16_t)(RPI_TX_BUF_SIZE -1 -AT_BUF_NUMELEM( rpi_tx_buf )) < (uint16_t)(4 +5 +6*rec_len +1)))
+	{
+		//FAIL
+		AT_BUF_PUSH(rpi_tx_buf,'E');
+		return;
+	}
+
+	//----------------------------------------------------------------
+	//	BODY
+	//----------------------------------------------------------------
+
+	//Preamble
+	AT_BUF_PUSH( rpi_tx_buf, 'L' );
+	AT_BUF_PUSH( rpi_tx_buf, 'O' );
+	AT_BUF_PUSH( rpi_tx_buf, 'G' );
+	AT_BUF_PUSH( rpi_tx_buf, 'R' );
+	ret = u16_to_str( index, msg );
+	for (ti = 0;ti < ret;ti++)
+	{
+		AT_BUF_PUSH( rpi_tx_buf, msg[ti] );
+	}
+	//Values
+	for (t = 0;t < rec_len;t++)
+	{
+		ret = s16_to_str( rec[t], msg );
+		for (ti = 0;ti < ret;ti++)
+		{
+			AT_BUF_PUSH( rpi_tx_buf, msg[ti] );
+		}
+	}
+	//Termination
+	AT_BUF_PUSH( rpi_tx_buf, '\0' );
+
+	//----------------------------------------------------------------
+	//	RETURN
+	//----------------------------------------------------------------
+
+	return;
+}	//End handler: read_log_handler | uint16_t
@@ -43,7 +43,7 @@
 
 #include "global.h"
 //Class Header
-#include "Pid_s16.h"
+#include "pid_s16.h"
 
 /****************************************************************************
 **	NAMESPACES
@@ -96,6 +96,10 @@ Pid_s16::Pid_s16( void )
 	this -> g_acc		= (int16_t)0;
 	this -> g_old_err	= (int16_t)0;
 	this -> g_sat_cnt	= (int16_t)0;
+	this -> g_cmd_p		= (int16_t)0;
+	this -> g_cmd_i		= (int16_t)0;
+	this -> g_cmd_d		= (int16_t)0;
+	this -> g_cmd		= (int16_t)0;
 
 	//Initialize PID parameters
 	this -> g_cmd_max	= (int16_t)32767;
@@ -220,6 +224,66 @@ bool Pid_s16::register_error_handler( uint16_t sat_th, void *handler )
 *****************************************************************************
 ****************************************************************************/
 
+/***************************************************************************/
+//!	@brief Getter
+//!	get_err | void
+/***************************************************************************/
+//! @return int16_t | error of the last step
+/***************************************************************************/
+
+int16_t Pid_s16::get_err( void )
+{
+	return this -> g_old_err;
+}	//end getter: get_err | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_cmd_p | void
+/***************************************************************************/
+//! @return int16_t | proportional contribution to the last command
+/***************************************************************************/
+
+int16_t Pid_s16::get_cmd_p( void )
+{
+	return this -> g_cmd_p;
+}	//end getter: get_cmd_p | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_cmd_i | void
+/***************************************************************************/
+//! @return int16_t | integral contribution to the last command
+/***************************************************************************/
+
+int16_t Pid_s16::get_cmd_i( void )
+{
+	return this -> g_cmd_i;
+}	//end getter: get_cmd_i | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_cmd_d | void
+/***************************************************************************/
+//! @return int16_t | derivative contribution to the last command
+/***************************************************************************/
+
+int16_t Pid_s16::get_cmd_d( void )
+{
+	return this -> g_cmd_d;
+}	//end getter: get_cmd_d | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_cmd | void
+/***************************************************************************/
+//! @return int16_t | last command, after the saturation
+/***************************************************************************/
+
+int16_t Pid_s16::get_cmd( void )
+{
+	return this -> g_cmd;
+}	//end getter: get_cmd | void
+
 /****************************************************************************
 *****************************************************************************
 **	REFERENCES
@@ -235,7 +299,7 @@ bool Pid_s16::register_error_handler( uint16_t sat_th, void *handler )
 //!	Set the gain of the gain of the PID
 /***************************************************************************/
 
-inline int16_t &Pid_s16::limit_cmd_max( void )
+int16_t &Pid_s16::limit_cmd_max( void )
 {
 	//--------------------------------------------------------------------------
 	//	RETURN
@@ -253,7 +317,7 @@ inline int16_t &Pid_s16::limit_cmd_max( void )
 //!	Set the gain of the gain of the PID
 /***************************************************************************/
 
-inline int16_t &Pid_s16::limit_cmd_min( void )
+int16_t &Pid_s16::limit_cmd_min( void )
 {
 	//--------------------------------------------------------------------------
 	//	RETURN
@@ -271,7 +335,7 @@ inline int16_t &Pid_s16::limit_cmd_min( void )
 //!	Set the gain of the gain of the PID
 /***************************************************************************/
 
-inline uint16_t &Pid_s16::limit_sat_th( void )
+uint16_t &Pid_s16::limit_sat_th( void )
 {
 	//--------------------------------------------------------------------------
 	//	RETURN
@@ -289,7 +353,7 @@ inline uint16_t &Pid_s16::limit_sat_th( void )
 //!	Set the gain of the gain of the PID
 /***************************************************************************/
 
-inline int16_t &Pid_s16::gain_kp( void )
+int16_t &Pid_s16::gain_kp( void )
 {
 	//--------------------------------------------------------------------------
 	//	RETURN
@@ -307,7 +371,7 @@ inline int16_t &Pid_s16::gain_kp( void )
 //!	Set the gain of the gain of the PID
 /***************************************************************************/
 
-inline int16_t &Pid_s16::gain_kd( void )
+int16_t &Pid_s16::gain_kd( void )
 {
 	//--------------------------------------------------------------------------
 	//	RETURN
@@ -325,7 +389,7 @@ inline int16_t &Pid_s16::gain_kd( void )
 //!	Set the gain of the gain of the PID
 /***************************************************************************/
 
-inline int16_t &Pid_s16::gain_ki( void )
+int16_t &Pid_s16::gain_ki( void )
 {
 	//--------------------------------------------------------------------------
 	//	RETURN
@@ -489,6 +553,11 @@ int16_t Pid_s16::exe( int16_t reference, int16_t feedback )
 
 	//Update derivative register
 	this -> g_old_err = err;
+	//Contributions to the command, for the telemetry
+	this -> g_cmd_p = cmd_p;
+	this -> g_cmd_i = cmd_i;
+	this -> g_cmd_d = cmd_d;
+	this -> g_cmd = cmd;
 	//Authorize update of integrative register only if update would push a reduction of the command from saturation
 	if ((f_sat == false) || (AT_ABS(err_i) < AT_ABS(this -> g_acc)))
 	{
@@ -651,6 +720,11 @@ int16_t Pid_s16::exe( int16_t err )
 
 	//Update derivative register
 	this -> g_old_err = err;
+	//Contributions to the command, for the telemetry
+	this -> g_cmd_p = cmd_p;
+	this -> g_cmd_i = cmd_i;
+	this -> g_cmd_d = cmd_d;
+	this -> g_cmd = cmd;
 	//Authorize update of integrative register only if update would push a reduction of the command from saturation
 	if ((f_sat == false) || (AT_ABS(err_i) < AT_ABS(this -> g_acc)))
 	{
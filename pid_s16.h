@@ -98,6 +98,15 @@ class Pid_s16
 		//	GETTERS
 		//--------------------------------------------------------------------------
 
+		//Error of the last step
+		int16_t get_err( void );
+		//Contributions of the proportional, integral and derivative terms to the last command
+		int16_t get_cmd_p( void );
+		int16_t get_cmd_i( void );
+		int16_t get_cmd_d( void );
+		//Last command
+		int16_t get_cmd( void );
+
 		//--------------------------------------------------------------------------
 		//	REFERENCES
 		//--------------------------------------------------------------------------
@@ -172,6 +181,9 @@ class Pid_s16
 		int16_t g_acc;
 		//PID derivative memory buffer
 		int16_t g_old_err;
+		//Contributions of the terms to the last command, and the command
+		int16_t g_cmd_p, g_cmd_i, g_cmd_d;
+		int16_t g_cmd;
 		//Counter that stores the number of consecutive execution in which command is saturated
 		uint16_t g_sat_cnt;
 
@@ -0,0 +1,388 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	PROFILER
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:		2019-11-13
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Execution time statistics
+**	add() is meant to be fast so that it can be called from ISRs
+**	Divisions are only done by the getters
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include "global.h"
+//Class Header
+#include "profiler.h"
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+namespace OrangeBot
+{
+
+/****************************************************************************
+**	GLOBAL VARIABILES
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	CONSTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Constructor
+//!	Profiler | void
+/***************************************************************************/
+// @param
+//! @return no return
+//!	@details
+//! Empty constructor
+/***************************************************************************/
+
+Profiler::Profiler( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//First bin is one timestamp unit wide
+	this -> g_shift = (uint8_t)0;
+	//Clear statistics
+	this -> clear();
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end constructor:
+
+/****************************************************************************
+*****************************************************************************
+**	DESTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Destructor
+//!	Profiler | void
+/***************************************************************************/
+// @param
+//! @return no return
+//!	@details
+//! Empty destructor
+/***************************************************************************/
+
+Profiler::~Profiler( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end destructor:
+
+/****************************************************************************
+*****************************************************************************
+**	OPERATORS
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	SETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	set_hist_shift | uint8_t
+/***************************************************************************/
+//! @param shift | width of the first bin of the histogram is 1<<shift
+//! @return no return
+//!	@details
+//! Configure the histogram. Clear the histogram since old bins have a different meaning
+/***************************************************************************/
+
+void Profiler::set_hist_shift( uint8_t shift )
+{
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Save configuration
+	this -> g_shift = shift;
+	//Clear statistics
+	this -> clear();
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return;	//OK
+}	//end method: set_hist_shift | uint8_t
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	clear | void
+/***************************************************************************/
+//! @return no return
+//!	@details
+//! Clear all statistics
+/***************************************************************************/
+
+void Profiler::clear( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	uint8_t t;
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	this -> g_cnt	= (uint32_t)0;
+	this -> g_sum	= (uint32_t)0;
+	this -> g_max	= (uint16_t)0;
+	//For: each bin
+	for (t = 0;t < PROF_HIST_SIZE;t++)
+	{
+		this -> g_hist[t] = (uint16_t)0;
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return;	//OK
+}	//end method: clear | void
+
+/****************************************************************************
+*****************************************************************************
+**	GETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_cnt | void
+/***************************************************************************/
+//! @return uint32_t | number of samples
+/***************************************************************************/
+
+uint32_t Profiler::get_cnt( void )
+{
+	return this -> g_cnt;
+}	//end getter: get_cnt | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_sum | void
+/***************************************************************************/
+//! @return uint32_t | sum of all samples. Saturates
+/***************************************************************************/
+
+uint32_t Profiler::get_sum( void )
+{
+	return this -> g_sum;
+}	//end getter: get_sum | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_avg | void
+/***************************************************************************/
+//! @return uint16_t | average of all samples. 0 if there are no samples
+/***************************************************************************/
+
+uint16_t Profiler::get_avg( void )
+{
+	return (this -> g_cnt > 0)?((uint16_t)(this -> g_sum / this -> g_cnt)):((uint16_t)0);
+}	//end getter: get_avg | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_max | void
+/***************************************************************************/
+//! @return uint16_t | maximum sample
+/***************************************************************************/
+
+uint16_t Profiler::get_max( void )
+{
+	return this -> g_max;
+}	//end getter: get_max | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_hist | uint8_t
+/***************************************************************************/
+//! @param index | index of the bin
+//! @return uint16_t | number of samples inside the bin. 0 if index is invalid
+/***************************************************************************/
+
+uint16_t Profiler::get_hist( uint8_t index )
+{
+	return (index < PROF_HIST_SIZE)?(this -> g_hist[index]):((uint16_t)0);
+}	//end getter: get_hist | uint8_t
+
+/****************************************************************************
+*****************************************************************************
+**	REFERENCES
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	TESTERS
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	add | uint16_t
+/***************************************************************************/
+//! @param sample | time sample in timestamp units
+//! @return no return
+//!	@details
+//! Add a sample to the statistics. Counters saturate instead of wrapping around
+/***************************************************************************/
+
+void Profiler::add( uint16_t sample )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Index of the bin
+	uint8_t bin;
+	//Sample scaled to the width of the first bin
+	uint16_t scaled;
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+		//! Statistics
+	//if: sum won't saturate
+	if (this -> g_sum <= (uint32_t)0xffffffff -sample)
+	{
+		this -> g_cnt++;
+		this -> g_sum += sample;
+	}
+	//if: new maximum
+	if (sample > this -> g_max)
+	{
+		this -> g_max = sample;
+	}
+
+		//! Histogram
+	scaled = sample >> this -> g_shift;
+	bin = 0;
+	//While: sample is beyond the current bin and there are bins left
+	while ((scaled > 0) && (bin < PROF_HIST_SIZE -1))
+	{
+		scaled = scaled >> 1;
+		bin++;
+	}
+	//if: bin won't saturate
+	if (this -> g_hist[bin] < (uint16_t)0xffff)
+	{
+		this -> g_hist[bin]++;
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return;	//OK
+}	//end method: add | uint16_t
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC STATIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	PRIVATE METHODS
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+} //End Namespace
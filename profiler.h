@@ -0,0 +1,182 @@
+/**********************************************************************************
+**	ENVIROMENT VARIABILE
+**********************************************************************************/
+
+#ifndef PROFILER_H_
+	#define PROFILER_H_
+
+/**********************************************************************************
+**	GLOBAL INCLUDES
+**********************************************************************************/
+
+/**********************************************************************************
+**	DEFINES
+**********************************************************************************/
+
+//Number of bins of the histogram. Each bin is twice as wide as the previous one
+#define PROF_HIST_SIZE		8
+
+/**********************************************************************************
+**	MACROS
+**********************************************************************************/
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+//! @namespace OrangeBot
+namespace OrangeBot
+{
+
+/**********************************************************************************
+**	TYPEDEFS
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: STRUCTURES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: GLOBAL VARIABILES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: CLASS
+**********************************************************************************/
+
+/************************************************************************************/
+//! @class 		Profiler
+/************************************************************************************/
+//!	@author		Orso Eric
+//! @version	0.1 alpha
+//! @date		2019-11-13
+//! @brief		Execution time statistics
+//! @details
+//!	Accumulate statistics of a stream of time samples \n
+//! FEATURES:	\n
+//!		Statistics	\n
+//! Number of samples, sum, maximum and average \n
+//!		Histogram	\n
+//! Logarithmic histogram. Bin 0 holds samples below 1<<shift, each following bin is twice as wide \n
+//! Last bin holds all the samples beyond \n
+//! @pre		Samples are in timestamp units
+//! @bug		None
+//! @warning	If the profiler is fed by an ISR, the main loop must disable interrupts while reading it
+//! @copyright	License ?
+//! @todo		todo list
+/************************************************************************************/
+
+class Profiler
+{
+	//Visible to all
+	public:
+		//--------------------------------------------------------------------------
+		//	CONSTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//! Default constructor
+		Profiler( void );
+
+		//--------------------------------------------------------------------------
+		//	DESTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//!Default destructor
+		~Profiler( void );
+
+		//--------------------------------------------------------------------------
+		//	OPERATORS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	SETTERS
+		//--------------------------------------------------------------------------
+
+		//Set the width of the first bin of the histogram as 1<<shift
+		void set_hist_shift( uint8_t shift );
+		//Clear all statistics
+		void clear( void );
+
+		//--------------------------------------------------------------------------
+		//	GETTERS
+		//--------------------------------------------------------------------------
+
+		//Number of samples
+		uint32_t get_cnt( void );
+		//Sum of all samples
+		uint32_t get_sum( void );
+		//Average of all samples
+		uint16_t get_avg( void );
+		//Maximum sample
+		uint16_t get_max( void );
+		//Number of samples inside a bin of the histogram
+		uint16_t get_hist( uint8_t index );
+
+		//--------------------------------------------------------------------------
+		//	REFERENCES
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	TESTERS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC METHODS
+		//--------------------------------------------------------------------------
+
+		//Add a sample to the statistics
+		void add( uint16_t sample );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC STATIC METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC VARS
+		//--------------------------------------------------------------------------
+
+	//Visible to derived classes
+	protected:
+		//--------------------------------------------------------------------------
+		//	PROTECTED METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PROTECTED VARS
+		//--------------------------------------------------------------------------
+
+	//Visible only inside the class
+	private:
+		//--------------------------------------------------------------------------
+		//	PRIVATE METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PRIVATE VARS
+		//--------------------------------------------------------------------------
+
+			///Configuration
+		//Width of the first bin of the histogram is 1<<g_shift
+		uint8_t g_shift;
+
+			///Statistics
+		//Number of samples
+		uint32_t g_cnt;
+		//Sum of samples. Saturates
+		uint32_t g_sum;
+		//Maximum sample
+		uint16_t g_max;
+		//Logarithmic histogram. Saturates
+		uint16_t g_hist[PROF_HIST_SIZE];
+
+};	//End Class: Profiler
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
+
+#else
+    #warning "Multiple inclusion of hader file"
+#endif
@@ -0,0 +1,552 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	SCHEDULER
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:		2019-11-12
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Static table cooperative scheduler
+**	The main loop calls tick() once per system tick and exe() on every
+**	iteration. exe() executes at most one ready task, the one with the lowest
+**	priority number, so that communication is served between tasks
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include "global.h"
+//Class Header
+#include "scheduler.h"
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+namespace OrangeBot
+{
+
+/****************************************************************************
+**	GLOBAL VARIABILES
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	CONSTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Constructor
+//!	Scheduler | void
+/***************************************************************************/
+// @param
+//! @return no return
+//!	@details
+//! Empty constructor
+/***************************************************************************/
+
+Scheduler::Scheduler( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	uint8_t t;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Empty task table
+	this -> g_num_task	= (uint8_t)0;
+	this -> g_ready		= (uint8_t)0x00;
+	//For: each task slot
+	for (t = 0;t < SCHED_MAX_TASK;t++)
+	{
+		//Clear task
+		this -> g_task_handler[t]	= nullptr;
+		this -> g_task_period[t]	= (uint16_t)0;
+		this -> g_task_cnt[t]		= (uint16_t)0;
+		this -> g_task_priority[t]	= (uint8_t)0;
+	}
+	//Clear statistics
+	this -> clear_stats();
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end constructor:
+
+/****************************************************************************
+*****************************************************************************
+**	DESTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Destructor
+//!	Scheduler | void
+/***************************************************************************/
+// @param
+//! @return no return
+//!	@details
+//! Empty destructor
+/***************************************************************************/
+
+Scheduler::~Scheduler( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end destructor:
+
+/****************************************************************************
+*****************************************************************************
+**	OPERATORS
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	SETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	add_task | uint16_t, uint16_t, uint8_t, void *
+/***************************************************************************/
+//! @param period | period of the task in system ticks. Must be at least 1
+//! @param phase | tick of the first release. Must be smaller than period
+//! @param priority | 0 is the highest priority
+//! @param handler | void->void function executed when the task is released
+//! @return false: OK | true: fail
+//!	@details
+//! Add a periodic task to the static task table
+/***************************************************************************/
+
+bool Scheduler::add_task( uint16_t period, uint16_t phase, uint8_t priority, void *handler )
+{
+	//Trace Enter
+	DENTER_ARG("period: %d, phase: %d, priority: %d\n", period, phase, priority);
+
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Index of the new task
+	uint8_t index = this -> g_num_task;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//if: table is full or arguments are invalid
+	if ((index >= SCHED_MAX_TASK) || (period == 0) || (phase >= period) || (handler == nullptr))
+	{
+		//Trace Return
+		DRETURN_ARG("ERR: task can't be added\n");
+		return true;	//fail
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Register the task
+	this -> g_task_handler[index]	= handler;
+	this -> g_task_period[index]	= period;
+	this -> g_task_priority[index]	= priority;
+	//First release happens after phase ticks
+	this -> g_task_cnt[index]		= phase;
+	//One more task
+	this -> g_num_task++;
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return false;	//OK
+}	//end method: add_task | uint16_t, uint16_t, uint8_t, void *
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	set_period | uint8_t, uint16_t
+/***************************************************************************/
+//! @param index | index of the task
+//! @param period | new period of the task in system ticks. Must be at least 1
+//! @return false: OK | true: fail
+//!	@details
+//! Change the period of a registered task. Used when the system tick rate changes.
+//! The next release is clipped so that it happens within the new period
+/***************************************************************************/
+
+bool Scheduler::set_period( uint8_t index, uint16_t period )
+{
+	//Trace Enter
+	DENTER_ARG("index: %d, period: %d\n", index, period);
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//if: task doesn't exist or period is invalid
+	if ((index >= this -> g_num_task) || (period == 0))
+	{
+		//Trace Return
+		DRETURN_ARG("ERR: bad arguments\n");
+		return true;	//fail
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Save new period
+	this -> g_task_period[index] = period;
+	//if: next release would be beyond the new period
+	if (this -> g_task_cnt[index] >= period)
+	{
+		//Clip
+		this -> g_task_cnt[index] = period -1;
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return false;	//OK
+}	//end method: set_period | uint8_t, uint16_t
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	clear_stats | void
+/***************************************************************************/
+//! @return no return
+//!	@details
+//! Clear execution time and overrun statistics of all tasks
+/***************************************************************************/
+
+void Scheduler::clear_stats( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	uint8_t t;
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//For: each task slot
+	for (t = 0;t < SCHED_MAX_TASK;t++)
+	{
+		this -> g_exe_time[t]		= (uint16_t)0;
+		this -> g_exe_time_max[t]	= (uint16_t)0;
+		this -> g_overrun_cnt[t]	= (uint16_t)0;
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return;	//OK
+}	//end method: clear_stats | void
+
+/****************************************************************************
+*****************************************************************************
+**	GETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_num_task | void
+/***************************************************************************/
+//! @return uint8_t | number of registered tasks
+/***************************************************************************/
+
+uint8_t Scheduler::get_num_task( void )
+{
+	return this -> g_num_task;
+}	//end getter: get_num_task | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_exe_time | uint8_t
+/***************************************************************************/
+//! @param index | index of the task
+//! @return uint16_t | execution time of the last execution. 0 if index is invalid
+/***************************************************************************/
+
+uint16_t Scheduler::get_exe_time( uint8_t index )
+{
+	return (index < this -> g_num_task)?(this -> g_exe_time[index]):((uint16_t)0);
+}	//end getter: get_exe_time | uint8_t
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_exe_time_max | uint8_t
+/***************************************************************************/
+//! @param index | index of the task
+//! @return uint16_t | maximum execution time. 0 if index is invalid
+/***************************************************************************/
+
+uint16_t Scheduler::get_exe_time_max( uint8_t index )
+{
+	return (index < this -> g_num_task)?(this -> g_exe_time_max[index]):((uint16_t)0);
+}	//end getter: get_exe_time_max | uint8_t
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_overrun_cnt | uint8_t
+/***************************************************************************/
+//! @param index | index of the task
+//! @return uint16_t | number of deadline overruns. 0 if index is invalid
+/***************************************************************************/
+
+uint16_t Scheduler::get_overrun_cnt( uint8_t index )
+{
+	return (index < this -> g_num_task)?(this -> g_overrun_cnt[index]):((uint16_t)0);
+}	//end getter: get_overrun_cnt | uint8_t
+
+/****************************************************************************
+*****************************************************************************
+**	REFERENCES
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	TESTERS
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	tick | void
+/***************************************************************************/
+//! @return no return
+//!	@details
+//! Advance the scheduler by one system tick and release the tasks that are due
+//! The deadline of a task is its next release. If a task is released while
+//! it's still waiting to be executed, it missed the deadline and an overrun is counted.
+//! The two releases are merged into one execution.
+/***************************************************************************/
+
+void Scheduler::tick( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	uint8_t t;
+	//Mask of the task being processed
+	uint8_t mask;
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//For: each registered task
+	for (t = 0;t < this -> g_num_task;t++)
+	{
+		//if: task is due
+		if (this -> g_task_cnt[t] == 0)
+		{
+			//Reload tick counter
+			this -> g_task_cnt[t] = this -> g_task_period[t] -1;
+			//Build mask
+			mask = MASK( t );
+			//if: task still waiting from the previous release
+			if ((this -> g_ready & mask) != 0)
+			{
+				//Deadline missed
+				this -> g_overrun_cnt[t]++;
+			}
+			//Release the task
+			this -> g_ready |= mask;
+		}
+		//if: task is not due
+		else
+		{
+			this -> g_task_cnt[t]--;
+		}
+	}	//End For: each registered task
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return;	//OK
+}	//end method: tick | void
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	exe | void
+/***************************************************************************/
+//! @return bool | true: a task has been executed | false: no task was ready
+//!	@details
+//! Execute the ready task with highest priority and measure its execution time.
+//! On equal priority, the task registered first wins.
+/***************************************************************************/
+
+bool Scheduler::exe( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	uint8_t t;
+	//Index of the task to be executed
+	uint8_t index;
+	//Timestamp at the start of the task
+	uint16_t timestamp;
+	//Execution time
+	uint16_t exe_time;
+	//Handler of the task
+	void (*my_function_ptr)(void);
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//if: no task is ready
+	if (this -> g_ready == 0)
+	{
+		return false;	//nothing to do
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+		//! Find the ready task with highest priority
+	index = SCHED_MAX_TASK;
+	//For: each registered task
+	for (t = 0;t < this -> g_num_task;t++)
+	{
+		//if: task is ready and it's the first or has higher priority than the candidate
+		if ( ((this -> g_ready & MASK( t )) != 0) && ((index == SCHED_MAX_TASK) || (this -> g_task_priority[t] < this -> g_task_priority[index])) )
+		{
+			index = t;
+		}
+	}
+
+		//! Execute the task
+	//Task is no longer ready
+	this -> g_ready &= (uint8_t)INV_MASK( index );
+	//promote the pointer to the right kind
+	my_function_ptr = (void(*)(void))this -> g_task_handler[index];
+	//Start profiling
+	timestamp = GET_TIMESTAMP();
+	//Execute handler
+	(*my_function_ptr)();
+	//Stop profiling
+	exe_time = GET_TIMESTAMP() -timestamp;
+
+		//! Update statistics
+	this -> g_exe_time[index] = exe_time;
+	//if: new maximum
+	if (exe_time > this -> g_exe_time_max[index])
+	{
+		this -> g_exe_time_max[index] = exe_time;
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return true;	//a task has been executed
+}	//end method: exe | void
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC STATIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	PRIVATE METHODS
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+} //End Namespace
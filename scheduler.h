@@ -0,0 +1,196 @@
+/**********************************************************************************
+**	ENVIROMENT VARIABILE
+**********************************************************************************/
+
+#ifndef SCHEDULER_H_
+	#define SCHEDULER_H_
+
+/**********************************************************************************
+**	GLOBAL INCLUDES
+**********************************************************************************/
+
+/**********************************************************************************
+**	DEFINES
+**********************************************************************************/
+
+//Maximum number of periodic tasks that can be registered. Ready flags are stored in a single byte
+#define SCHED_MAX_TASK		8
+
+/**********************************************************************************
+**	MACROS
+**********************************************************************************/
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+//! @namespace OrangeBot
+namespace OrangeBot
+{
+
+/**********************************************************************************
+**	TYPEDEFS
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: STRUCTURES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: GLOBAL VARIABILES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: CLASS
+**********************************************************************************/
+
+/************************************************************************************/
+//! @class 		Scheduler
+/************************************************************************************/
+//!	@author		Orso Eric
+//! @version	0.1 alpha
+//! @date		2019-11-12
+//! @brief		Static table cooperative scheduler
+//! @details
+//!	Cooperative scheduler of periodic tasks \n
+//! FEATURES:	\n
+//!		Static task table	\n
+//! Each task has a period and a phase in system ticks, a priority and a void->void handler \n
+//! Phase spreads tasks with the same period over different ticks \n
+//!		Priority	\n
+//! When more tasks are ready, the one with the lowest priority number is executed first \n
+//! Only one task is executed per call, so the main loop can serve communication between tasks \n
+//!		Profiling	\n
+//! Execution time of each task is measured with the free running timestamp \n
+//! A task that is released again before it has been executed missed its deadline and counts as an overrun \n
+//! @pre		GET_TIMESTAMP() must return a free running 16b counter
+//! @bug		None
+//! @warning	Tasks are not preemptive. A long task delays all others
+//! @copyright	License ?
+//! @todo		todo list
+/************************************************************************************/
+
+class Scheduler
+{
+	//Visible to all
+	public:
+		//--------------------------------------------------------------------------
+		//	CONSTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//! Default constructor
+		Scheduler( void );
+
+		//--------------------------------------------------------------------------
+		//	DESTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//!Default destructor
+		~Scheduler( void );
+
+		//--------------------------------------------------------------------------
+		//	OPERATORS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	SETTERS
+		//--------------------------------------------------------------------------
+
+		//Add a periodic task to the table. false=task added successfully
+		bool add_task( uint16_t period, uint16_t phase, uint8_t priority, void *handler );
+		//Change the period of a registered task. false=OK
+		bool set_period( uint8_t index, uint16_t period );
+		//Clear execution time and overrun statistics
+		void clear_stats( void );
+
+		//--------------------------------------------------------------------------
+		//	GETTERS
+		//--------------------------------------------------------------------------
+
+		//Number of registered tasks
+		uint8_t get_num_task( void );
+		//Execution time of the last execution of a task. Timestamp units
+		uint16_t get_exe_time( uint8_t index );
+		//Maximum execution time of a task. Timestamp units
+		uint16_t get_exe_time_max( uint8_t index );
+		//Number of deadline overruns of a task
+		uint16_t get_overrun_cnt( uint8_t index );
+
+		//--------------------------------------------------------------------------
+		//	REFERENCES
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	TESTERS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC METHODS
+		//--------------------------------------------------------------------------
+
+		//Advance the scheduler by one system tick and release the tasks that are due
+		void tick( void );
+		//Execute the ready task with highest priority. true=a task has been executed
+		bool exe( void );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC STATIC METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC VARS
+		//--------------------------------------------------------------------------
+
+	//Visible to derived classes
+	protected:
+		//--------------------------------------------------------------------------
+		//	PROTECTED METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PROTECTED VARS
+		//--------------------------------------------------------------------------
+
+	//Visible only inside the class
+	private:
+		//--------------------------------------------------------------------------
+		//	PRIVATE METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PRIVATE VARS
+		//--------------------------------------------------------------------------
+
+			///Task table
+		//Number of tasks currently registered inside the scheduler
+		uint8_t g_num_task;
+		//Handler executed when the task is released
+		void *g_task_handler[SCHED_MAX_TASK];
+		//Period of the task in system ticks
+		uint16_t g_task_period[SCHED_MAX_TASK];
+		//Ticks left before the next release of the task
+		uint16_t g_task_cnt[SCHED_MAX_TASK];
+		//Priority of the task. 0 is the highest priority
+		uint8_t g_task_priority[SCHED_MAX_TASK];
+		//Ready flags. Bit t is true if task t has been released and is waiting to be executed
+		uint8_t g_ready;
+
+			///Statistics
+		//Execution time of the last execution
+		uint16_t g_exe_time[SCHED_MAX_TASK];
+		//Maximum execution time
+		uint16_t g_exe_time_max[SCHED_MAX_TASK];
+		//Number of times the task was released while still waiting to be executed
+		uint16_t g_overrun_cnt[SCHED_MAX_TASK];
+
+};	//End Class: Scheduler
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
+
+#else
+    #warning "Multiple inclusion of hader file"
+#endif
@@ -0,0 +1,406 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	S-CURVE FILTER
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:		2019-11-15
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Moving average of the last N=2^shift samples of a position reference
+**	A box filter of N ticks applied to a trapezoidal speed profile ramps the
+**	acceleration linearly over N ticks. The result is an S-curve with
+**	jerk = acceleration / N. The filter preserves the integral of the speed,
+**	so the position lands on the same target, N-1 ticks later.
+**
+**	Output is P[n] - D[n]/N with
+**		D[n] = sum over i=0..N-1 of ( P[n] - P[n-i] )
+**	With d the new increment and S[n] the sum of the last N-1 increments
+**		D[n+1] = D[n] + (N-1)*d - S[n]
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include "global.h"
+//Class Header
+#include "scurve_filter.h"
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+namespace OrangeBot
+{
+
+/****************************************************************************
+**	GLOBAL VARIABILES
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	CONSTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Constructor
+//!	Scurve_filter | void
+/***************************************************************************/
+// @param
+//! @return no return
+//!	@details
+//! Empty constructor. Filter is disabled, output is the input
+/***************************************************************************/
+
+Scurve_filter::Scurve_filter( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Length 1
+	this -> g_shift = (uint8_t)0;
+	//Settle on 0
+	this -> reset( (int32_t)0 );
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end constructor:
+
+/****************************************************************************
+*****************************************************************************
+**	DESTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Destructor
+//!	Scurve_filter | void
+/***************************************************************************/
+// @param
+//! @return no return
+//!	@details
+//! Empty destructor
+/***************************************************************************/
+
+Scurve_filter::~Scurve_filter( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end destructor:
+
+/****************************************************************************
+*****************************************************************************
+**	OPERATORS
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	SETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	set_shift | uint8_t
+/***************************************************************************/
+//! @param shift | log2 of the length of the moving average. 0 disables the filter
+//! @return false: OK | true: fail
+//!	@details
+//! Change the length of the moving average.
+//! Changing length while moving would make the output jump, so it fails unless the filter has settled
+/***************************************************************************/
+
+bool Scurve_filter::set_shift( uint8_t shift )
+{
+	//Trace Enter
+	DENTER_ARG("shift: %d\n", shift);
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//if: length is not supported
+	if (shift > SCURVE_FILTER_MAX_SHIFT)
+	{
+		//Trace Return
+		DRETURN_ARG("ERR: bad shift\n");
+		return true;	//fail
+	}
+	//if: nothing to do
+	if (shift == this -> g_shift)
+	{
+		//Trace Return
+		DRETURN();
+		return false;	//OK
+	}
+	//if: filter is still moving
+	if (this -> is_settled() == false)
+	{
+		//Trace Return
+		DRETURN_ARG("ERR: filter is moving\n");
+		return true;	//fail
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//New length
+	this -> g_shift = shift;
+	//Settle with the new length
+	this -> reset( this -> g_pos );
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return false;	//OK
+}	//end method: set_shift | uint8_t
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	reset | int32_t
+/***************************************************************************/
+//! @param pos | position the filter settles on
+//! @return no return
+//!	@details
+//! Clear the increment history. The output jumps on the given position
+/***************************************************************************/
+
+void Scurve_filter::reset( int32_t pos )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	uint8_t t;
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//For: each increment
+	for (t = 0;t < SCURVE_FILTER_SIZE;t++)
+	{
+		this -> g_inc[t] = (int16_t)0;
+	}
+	this -> g_index	= (uint8_t)0;
+	this -> g_pos	= pos;
+	this -> g_sum	= (int32_t)0;
+	this -> g_lag	= (int32_t)0;
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return;	//OK
+}	//end method: reset | int32_t
+
+/****************************************************************************
+*****************************************************************************
+**	GETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_shift | void
+/***************************************************************************/
+//! @return uint8_t | log2 of the length of the moving average
+/***************************************************************************/
+
+uint8_t Scurve_filter::get_shift( void )
+{
+	return this -> g_shift;
+}	//end getter: get_shift | void
+
+/****************************************************************************
+*****************************************************************************
+**	REFERENCES
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	TESTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Tester
+//!	is_settled | void
+/***************************************************************************/
+//! @return bool | true = all increments inside the window are zero
+/***************************************************************************/
+
+bool Scurve_filter::is_settled( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	uint8_t t;
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//if: the output lags the input
+	if (this -> g_lag != 0)
+	{
+		return false;
+	}
+	//For: each increment inside the window
+	for (t = 0;t < ((uint8_t)1 << this -> g_shift);t++)
+	{
+		//if: input moved
+		if (this -> g_inc[t] != 0)
+		{
+			return false;
+		}
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return true;
+}	//end tester: is_settled | void
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	exe | int32_t
+/***************************************************************************/
+//! @param pos | new sample of the position reference
+//! @return int32_t | average of the last N samples
+/***************************************************************************/
+
+int32_t Scurve_filter::exe( int32_t pos )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Increment of the input
+	int32_t inc;
+	//Oldest increment inside the window
+	int16_t inc_old;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//Increment of this tick
+	inc = pos -this -> g_pos;
+	inc = AT_SAT( inc, (int32_t)32767, (int32_t)-32767 );
+	//Save input
+	this -> g_pos += inc;
+	//if: filter is disabled
+	if (this -> g_shift == 0)
+	{
+		return this -> g_pos;
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Fetch the increment leaving the window
+	inc_old = this -> g_inc[ this -> g_index ];
+	//Update the lag. g_sum -inc_old is the sum of the last N-1 increments
+	this -> g_lag += (inc << this -> g_shift) -inc -(this -> g_sum -inc_old);
+	//Update the sum of the increments inside the window
+	this -> g_sum += inc -inc_old;
+	//Save the new increment in place of the oldest
+	this -> g_inc[ this -> g_index ] = (int16_t)inc;
+	//Advance to the next oldest increment
+	this -> g_index = (this -> g_index +1) & (((uint8_t)1 << this -> g_shift) -1);
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return this -> g_pos -(this -> g_lag >> this -> g_shift);
+}	//end method: exe | int32_t
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+} //End Namespace
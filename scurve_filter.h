@@ -0,0 +1,180 @@
+/**********************************************************************************
+**	ENVIROMENT VARIABILE
+**********************************************************************************/
+
+#ifndef SCURVE_FILTER_H_
+	#define SCURVE_FILTER_H_
+
+/**********************************************************************************
+**	GLOBAL INCLUDES
+**********************************************************************************/
+
+/**********************************************************************************
+**	DEFINES
+**********************************************************************************/
+
+//Maximum log2 of the length of the moving average
+#define SCURVE_FILTER_MAX_SHIFT		7
+//Size of the increment history. Maximum length of the moving average
+#define SCURVE_FILTER_SIZE			(1 << SCURVE_FILTER_MAX_SHIFT)
+
+/**********************************************************************************
+**	MACROS
+**********************************************************************************/
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+//! @namespace OrangeBot
+namespace OrangeBot
+{
+
+/**********************************************************************************
+**	TYPEDEFS
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: STRUCTURES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: GLOBAL VARIABILES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: CLASS
+**********************************************************************************/
+
+/************************************************************************************/
+//! @class 		Scurve_filter
+/************************************************************************************/
+//!	@author		Orso Eric
+//! @version	0.1 alpha
+//! @date		2019-11-15
+//! @brief		Moving average of a position reference. Turns a trapezoidal speed profile into an S-curve
+//! @details
+//!	A trapezoidal speed profile filtered by a moving average of N ticks becomes an S-curve \n
+//! FEATURES:	\n
+//!		Jerk limit	\n
+//! Acceleration ramps over N ticks instead of stepping. Jerk is acceleration / N \n
+//!		Exact	\n
+//! The filter has unity gain. When the input is at rest, the output is exactly on the input \n
+//!		Fixed point	\n
+//! N is a power of two. Only the increments of the input are stored, the average is computed
+//! as the input minus the lag, and the lag is updated incrementally. No multiplications, no divisions \n
+//! @pre		Input must move by less than 32767 counts per tick
+//! @bug		None
+//! @warning	Length can only change when the filter has settled
+//! @copyright	License ?
+//! @todo		todo list
+/************************************************************************************/
+
+class Scurve_filter
+{
+	//Visible to all
+	public:
+		//--------------------------------------------------------------------------
+		//	CONSTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//! Default constructor
+		Scurve_filter( void );
+
+		//--------------------------------------------------------------------------
+		//	DESTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//!Default destructor
+		~Scurve_filter( void );
+
+		//--------------------------------------------------------------------------
+		//	OPERATORS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	SETTERS
+		//--------------------------------------------------------------------------
+
+		//Set the length of the moving average as log2. false=OK
+		bool set_shift( uint8_t shift );
+		//Settle the filter on a given position
+		void reset( int32_t pos );
+
+		//--------------------------------------------------------------------------
+		//	GETTERS
+		//--------------------------------------------------------------------------
+
+		//log2 of the length of the moving average
+		uint8_t get_shift( void );
+
+		//--------------------------------------------------------------------------
+		//	REFERENCES
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	TESTERS
+		//--------------------------------------------------------------------------
+
+		//true = all increments inside the window are zero. Output is on the input
+		bool is_settled( void );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC METHODS
+		//--------------------------------------------------------------------------
+
+		//Filter one sample of the position reference
+		int32_t exe( int32_t pos );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC STATIC METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC VARS
+		//--------------------------------------------------------------------------
+
+	//Visible to derived classes
+	protected:
+		//--------------------------------------------------------------------------
+		//	PROTECTED METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PROTECTED VARS
+		//--------------------------------------------------------------------------
+
+	//Visible only inside the class
+	private:
+		//--------------------------------------------------------------------------
+		//	PRIVATE METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PRIVATE VARS
+		//--------------------------------------------------------------------------
+
+		//log2 of the length of the moving average
+		uint8_t g_shift;
+		//Index of the oldest increment
+		uint8_t g_index;
+		//Increments of the input over the last N ticks
+		int16_t g_inc[SCURVE_FILTER_SIZE];
+		//Last input
+		int32_t g_pos;
+		//Sum of the increments inside the window
+		int32_t g_sum;
+		//Sum of the distances of the last N inputs from the last input. Lag is g_lag / N
+		int32_t g_lag;
+
+};	//End Class: Scurve_filter
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
+
+#else
+    #warning "Multiple inclusion of hader file"
+#endif
@@ -0,0 +1,551 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	SETPOINT INTERPOLATION
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:		2019-11-17
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	When a setpoint arrives, a segment of L ticks starts from the current
+**	reference p0 and ends on the setpoint p1. L is the estimated interval
+**	between setpoints. With u=k/L the normalized time:
+**		LINEAR	p(u) = p0 + u*(p1-p0)
+**		CUBIC	Hermite with start slope M0 and end slope M1 over u
+**			p(u) = p0 + u*M0 + u^2*(3(p1-p0) -2M0 -M1) + u^3*(2(p0-p1) +M0 +M1)
+**	M0 is the slope of the reference when the setpoint arrives.
+**	M1 is the slope of the host stream, the difference between the last two
+**	setpoints divided by the measured interval.
+**	After the segment, the reference continues with the slope of the stream
+**	for L/2 ticks, then holds.
+**	Divisions are only executed when a setpoint arrives.
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include "global.h"
+//Class Header
+#include "setpoint_interp.h"
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+namespace OrangeBot
+{
+
+/****************************************************************************
+**	GLOBAL VARIABILES
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	CONSTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Constructor
+//!	Setpoint_interp | void
+/***************************************************************************/
+// @param
+//! @return no return
+//!	@details
+//! Empty constructor. Linear interpolation, reference at rest on 0
+/***************************************************************************/
+
+Setpoint_interp::Setpoint_interp( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	this -> g_mode = SETPOINT_INTERP_LINEAR;
+	//Settle on 0
+	this -> reset( (int16_t)0 );
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end constructor:
+
+/****************************************************************************
+*****************************************************************************
+**	DESTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Destructor
+//!	Setpoint_interp | void
+/***************************************************************************/
+// @param
+//! @return no return
+//!	@details
+//! Empty destructor
+/***************************************************************************/
+
+Setpoint_interp::~Setpoint_interp( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end destructor:
+
+/****************************************************************************
+*****************************************************************************
+**	OPERATORS
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	SETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	set_mode | uint8_t
+/***************************************************************************/
+//! @param mode | Setpoint_interp_mode
+//! @return false: OK | true: fail
+//!	@details
+//! Change the shape of the reference. The reference jumps on the last setpoint
+/***************************************************************************/
+
+bool Setpoint_interp::set_mode( uint8_t mode )
+{
+	//Trace Enter
+	DENTER_ARG("mode: %d\n", mode);
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//if: mode is not supported
+	if (mode > SETPOINT_INTERP_CUBIC)
+	{
+		//Trace Return
+		DRETURN_ARG("ERR: bad mode\n");
+		return true;	//fail
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	this -> g_mode = mode;
+	//Coefficients of the segment in execution belong to the old mode. Hold the setpoint
+	this -> g_ref	= this -> g_p1;
+	this -> g_m1	= (int32_t)0;
+	this -> g_tick	= (uint16_t)0xffff;
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return false;	//OK
+}	//end method: set_mode | uint8_t
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	set_target | int16_t
+/***************************************************************************/
+//! @param target | new setpoint
+//! @return no return
+//!	@details
+//! Timestamp the setpoint, update the estimated interval and start a segment toward the setpoint
+/***************************************************************************/
+
+void Setpoint_interp::set_target( int16_t target )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//New setpoint. Fixed point
+	int32_t p1;
+	//Distance to cover
+	int32_t dist;
+	//Slope at the start and at the end of the segment over the normalized time
+	int32_t m0_seg, m1_seg;
+	//true = setpoint belongs to a stream
+	bool f_stream;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	p1 = AT_SAT( target, (int16_t)SETPOINT_INTERP_MAX_IN, (int16_t)-SETPOINT_INTERP_MAX_IN );
+	p1 = p1 << SETPOINT_INTERP_FRAC;
+	//if: interpolation is disabled
+	if (this -> g_mode == SETPOINT_INTERP_STEP)
+	{
+		this -> g_p1	= p1;
+		this -> g_ref	= p1;
+		return;
+	}
+	//if: previous setpoint is recent enough to measure the interval
+	f_stream = ((this -> g_since > 0) && (this -> g_since <= SETPOINT_INTERP_MAX_LEN));
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+		//! Interval
+	//if: measure is valid
+	if (f_stream == true)
+	{
+		//Moving average of the interval. Fixed point 4
+		this -> g_len_est += (int16_t)(((int16_t)this -> g_since << 4) -(int16_t)this -> g_len_est) >> 2;
+		//Slope of the host stream over the measured interval
+		this -> g_m1 = ((p1 -this -> g_p1) << 8) / (int32_t)this -> g_since;
+		this -> g_m1 = AT_SAT( this -> g_m1, SETPOINT_INTERP_MAX_SLOPE, -SETPOINT_INTERP_MAX_SLOPE );
+	}
+	//if: first setpoint of a stream
+	else
+	{
+		//The host is not moving the setpoint
+		this -> g_m1 = (int32_t)0;
+	}
+	this -> g_since = (uint16_t)0;
+	//Length of the new segment. Rounded
+	this -> g_len = (uint8_t)AT_SAT( (this -> g_len_est +8) >> 4, (uint16_t)SETPOINT_INTERP_MAX_LEN, (uint16_t)1 );
+
+		//! Segment
+	//Start from the current reference
+	this -> g_p0 = this -> g_ref;
+	this -> g_p1 = p1;
+	dist = p1 -this -> g_p0;
+	//if: linear
+	if (this -> g_mode == SETPOINT_INTERP_LINEAR)
+	{
+		this -> g_c1 = dist;
+		this -> g_c2 = (int32_t)0;
+		this -> g_c3 = (int32_t)0;
+	}
+	//if: cubic
+	else
+	{
+		//Slopes over the normalized time of the new segment
+		m0_seg = (this -> get_slope() * (int32_t)this -> g_len) >> 8;
+		m1_seg = (this -> g_m1 * (int32_t)this -> g_len) >> 8;
+		//Hermite coefficients
+		this -> g_c1 = m0_seg;
+		this -> g_c2 = 3*dist -2*m0_seg -m1_seg;
+		this -> g_c3 = -2*dist +m0_seg +m1_seg;
+	}
+	//Restart the normalized time
+	this -> g_tick	= (uint16_t)0;
+	this -> g_u		= (uint32_t)0;
+	this -> g_du	= ((uint32_t)1 << 16) / this -> g_len;
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return;	//OK
+}	//end method: set_target | int16_t
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	reset | int16_t
+/***************************************************************************/
+//! @param target | setpoint the reference settles on
+//! @return no return
+//!	@details
+//! Reference jumps on the setpoint and holds. Interval goes back to the default
+/***************************************************************************/
+
+void Setpoint_interp::reset( int16_t target )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	int32_t p;
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	p = AT_SAT( target, (int16_t)SETPOINT_INTERP_MAX_IN, (int16_t)-SETPOINT_INTERP_MAX_IN );
+	p = p << SETPOINT_INTERP_FRAC;
+	//No stream
+	this -> g_since		= (uint16_t)0xffff;
+	this -> g_len_est	= (uint16_t)SETPOINT_INTERP_DEFAULT_LEN << 4;
+	this -> g_len		= (uint8_t)SETPOINT_INTERP_DEFAULT_LEN;
+	//Hold
+	this -> g_tick		= (uint16_t)0xffff;
+	this -> g_u			= (uint32_t)0;
+	this -> g_du		= (uint32_t)0;
+	this -> g_p0		= p;
+	this -> g_p1		= p;
+	this -> g_m1		= (int32_t)0;
+	this -> g_c1		= (int32_t)0;
+	this -> g_c2		= (int32_t)0;
+	this -> g_c3		= (int32_t)0;
+	this -> g_ref		= p;
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return;	//OK
+}	//end method: reset | int16_t
+
+/****************************************************************************
+*****************************************************************************
+**	GETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_mode | void
+/***************************************************************************/
+//! @return uint8_t | Setpoint_interp_mode
+/***************************************************************************/
+
+uint8_t Setpoint_interp::get_mode( void )
+{
+	return this -> g_mode;
+}	//end getter: get_mode | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_len | void
+/***************************************************************************/
+//! @return uint8_t | estimated interval between setpoints. Ticks
+/***************************************************************************/
+
+uint8_t Setpoint_interp::get_len( void )
+{
+	return this -> g_len;
+}	//end getter: get_len | void
+
+/****************************************************************************
+*****************************************************************************
+**	REFERENCES
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	TESTERS
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	exe | void
+/***************************************************************************/
+//! @return int32_t | reference. Fixed point SETPOINT_INTERP_FRAC
+//!	@details
+//! Advance by one tick. Inside the segment evaluate the polynomial,
+//! after the segment extrapolate for a while, then hold
+/***************************************************************************/
+
+int32_t Setpoint_interp::exe( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Normalized time. Fixed point 8
+	int32_t u;
+	//Horner accumulator
+	int32_t acc;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//Timestamp of the setpoints
+	if (this -> g_since < (uint16_t)0xffff)
+	{
+		this -> g_since++;
+	}
+	//if: interpolation is disabled
+	if (this -> g_mode == SETPOINT_INTERP_STEP)
+	{
+		return this -> g_ref;
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//if: inside the segment
+	if (this -> g_tick < this -> g_len)
+	{
+		this -> g_tick++;
+		//if: end of the segment
+		if (this -> g_tick >= this -> g_len)
+		{
+			//Land exactly on the setpoint
+			this -> g_ref = this -> g_p1;
+		}
+		else
+		{
+			//Advance the normalized time
+			this -> g_u += this -> g_du;
+			u = (int32_t)(this -> g_u >> 8);
+			//p0 + u*(c1 + u*(c2 + u*c3))
+			acc = this -> g_c2 +((u * this -> g_c3) >> 8);
+			acc = this -> g_c1 +((u * acc) >> 8);
+			this -> g_ref = this -> g_p0 +((u * acc +((int32_t)1 << 7)) >> 8);
+		}
+	}
+	//if: setpoint is late. Extrapolate with the slope of the stream
+	else if (this -> g_tick < (uint16_t)this -> g_len +(this -> g_len >> SETPOINT_INTERP_EXTRAP_SHIFT))
+	{
+		this -> g_tick++;
+		this -> g_ref = this -> g_p1 +((this -> g_m1 * (int32_t)(this -> g_tick -this -> g_len)) >> 8);
+	}
+	//if: setpoint is too late
+	else
+	{
+		//Hold
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return this -> g_ref;
+}	//end method: exe | void
+
+/****************************************************************************
+*****************************************************************************
+**	PRIVATE METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Private Method
+//!	get_slope | void
+/***************************************************************************/
+//! @return int32_t | slope of the reference. Fixed point SETPOINT_INTERP_FRAC +8 per tick
+//!	@details
+//! Derivative of the polynomial over the normalized time, scaled by the length of the segment
+/***************************************************************************/
+
+int32_t Setpoint_interp::get_slope( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Normalized time. Fixed point 8
+	int32_t u;
+	//Derivative over the normalized time
+	int32_t acc;
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//if: inside the segment
+	if (this -> g_tick < this -> g_len)
+	{
+		u = (int32_t)(this -> g_u >> 8);
+		//c1 + u*(2*c2 + 3*u*c3). Inner term is scaled down to stay inside 32b
+		acc = 2*this -> g_c2 +3*((u * this -> g_c3) >> 8);
+		acc = this -> g_c1 +(((acc >> 2) * u) >> 6);
+		//Per tick
+		acc = ((acc << 4) / (int32_t)this -> g_len) << 4;
+		return AT_SAT( acc, SETPOINT_INTERP_MAX_SLOPE, -SETPOINT_INTERP_MAX_SLOPE );
+	}
+	//if: extrapolating
+	else if (this -> g_tick < (uint16_t)this -> g_len +(this -> g_len >> SETPOINT_INTERP_EXTRAP_SHIFT))
+	{
+		return this -> g_m1;
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Holding
+	return (int32_t)0;
+}	//end method: get_slope | void
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+} //End Namespace
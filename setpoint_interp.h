@@ -0,0 +1,220 @@
+/**********************************************************************************
+**	ENVIROMENT VARIABILE
+**********************************************************************************/
+
+#ifndef SETPOINT_INTERP_H_
+	#define SETPOINT_INTERP_H_
+
+/**********************************************************************************
+**	GLOBAL INCLUDES
+**********************************************************************************/
+
+/**********************************************************************************
+**	DEFINES
+**********************************************************************************/
+
+//Fractional bits of the output reference
+#define SETPOINT_INTERP_FRAC		4
+//Setpoints are saturated to this magnitude
+#define SETPOINT_INTERP_MAX_IN		8191
+//Maximum slope. Fixed point SETPOINT_INTERP_FRAC +8 per tick
+#define SETPOINT_INTERP_MAX_SLOPE	((int32_t)1 << 20)
+//Setpoints further apart than this many ticks are not part of a stream
+#define SETPOINT_INTERP_MAX_LEN		255
+//Interval assumed before it has been measured. Ticks
+#define SETPOINT_INTERP_DEFAULT_LEN	16
+//Extrapolate for at most interval >> SHIFT ticks after the expected setpoint
+#define SETPOINT_INTERP_EXTRAP_SHIFT	1
+
+/**********************************************************************************
+**	MACROS
+**********************************************************************************/
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+//! @namespace OrangeBot
+namespace OrangeBot
+{
+
+/**********************************************************************************
+**	TYPEDEFS
+**********************************************************************************/
+
+//Shape of the reference between two setpoints
+typedef enum _Setpoint_interp_mode
+{
+	SETPOINT_INTERP_STEP	= 0,	//Output jumps on the setpoint
+	SETPOINT_INTERP_LINEAR	= 1,	//Ramp to the setpoint
+	SETPOINT_INTERP_CUBIC	= 2		//Hermite cubic. Slope is continuous
+} Setpoint_interp_mode;
+
+/**********************************************************************************
+**	PROTOTYPE: STRUCTURES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: GLOBAL VARIABILES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: CLASS
+**********************************************************************************/
+
+/************************************************************************************/
+//! @class 		Setpoint_interp
+/************************************************************************************/
+//!	@author		Orso Eric
+//! @version	0.1 alpha
+//! @date		2019-11-17
+//! @brief		Interpolate a reference between setpoints that arrive at a low rate
+//! @details
+//!	The host sends setpoints at a fraction of the tick rate. Instead of stepping, the reference
+//! moves to each new setpoint over the interval expected before the next one \n
+//! FEATURES:	\n
+//!		Interval	\n
+//! Setpoints are timestamped by counting ticks. The interval is a moving average of the measured intervals \n
+//!		Linear	\n
+//! Reference ramps from its current value to the setpoint \n
+//!		Cubic	\n
+//! Hermite cubic from the current value and slope to the setpoint and the slope of the host stream \n
+//!		Extrapolation	\n
+//! When the next setpoint is late, the reference follows the slope of the host stream for half an interval, then holds \n
+//! @pre		None
+//! @bug		None
+//! @warning	Interval is measured in ticks. Reset when the tick rate changes
+//! @copyright	License ?
+//! @todo		todo list
+/************************************************************************************/
+
+class Setpoint_interp
+{
+	//Visible to all
+	public:
+		//--------------------------------------------------------------------------
+		//	CONSTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//! Default constructor
+		Setpoint_interp( void );
+
+		//--------------------------------------------------------------------------
+		//	DESTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//!Default destructor
+		~Setpoint_interp( void );
+
+		//--------------------------------------------------------------------------
+		//	OPERATORS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	SETTERS
+		//--------------------------------------------------------------------------
+
+		//Select the shape of the reference. false=OK
+		bool set_mode( uint8_t mode );
+		//New setpoint from the host
+		void set_target( int16_t target );
+		//Output jumps on the given setpoint. Interval estimation restarts
+		void reset( int16_t target );
+
+		//--------------------------------------------------------------------------
+		//	GETTERS
+		//--------------------------------------------------------------------------
+
+		//Shape of the reference
+		uint8_t get_mode( void );
+		//Estimated interval between setpoints. Ticks
+		uint8_t get_len( void );
+
+		//--------------------------------------------------------------------------
+		//	REFERENCES
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	TESTERS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC METHODS
+		//--------------------------------------------------------------------------
+
+		//Advance by one tick. Return the reference, fixed point SETPOINT_INTERP_FRAC
+		int32_t exe( void );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC STATIC METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC VARS
+		//--------------------------------------------------------------------------
+
+	//Visible to derived classes
+	protected:
+		//--------------------------------------------------------------------------
+		//	PROTECTED METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PROTECTED VARS
+		//--------------------------------------------------------------------------
+
+	//Visible only inside the class
+	private:
+		//--------------------------------------------------------------------------
+		//	PRIVATE METHODS
+		//--------------------------------------------------------------------------
+
+		//Slope of the reference at the current tick
+		int32_t get_slope( void );
+
+		//--------------------------------------------------------------------------
+		//	PRIVATE VARS
+		//--------------------------------------------------------------------------
+
+		//Setpoint_interp_mode
+		uint8_t g_mode;
+
+			///Timing
+		//Ticks since the last setpoint. Saturates
+		uint16_t g_since;
+		//Estimated interval between setpoints. Ticks, fixed point 4
+		uint16_t g_len_est;
+		//Length of the segment in execution. Ticks
+		uint8_t g_len;
+		//Ticks since the start of the segment. Saturates
+		uint16_t g_tick;
+		//Normalized time inside the segment. Fixed point 16, 1.0 is the end of the segment
+		uint32_t g_u;
+		//Normalized time increment per tick
+		uint32_t g_du;
+
+			///Segment. Fixed point SETPOINT_INTERP_FRAC
+		//Reference at the start of the segment
+		int32_t g_p0;
+		//Setpoint at the end of the segment
+		int32_t g_p1;
+		//Slope of the host stream. Fixed point SETPOINT_INTERP_FRAC +8 per tick
+		int32_t g_m1;
+		//Cubic coefficients over the normalized time. p(u) = p0 + u*(c1 + u*(c2 + u*c3))
+		int32_t g_c1;
+		int32_t g_c2;
+		int32_t g_c3;
+		//Reference
+		int32_t g_ref;
+
+};	//End Class: Setpoint_interp
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
+
+#else
+    #warning "Multiple inclusion of hader file"
+#endif
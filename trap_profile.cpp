@@ -0,0 +1,557 @@
+/****************************************************************************
+**	OrangeBot Project
+*****************************************************************************
+**        /
+**       /
+**      /
+** ______ \
+**         \
+**          \
+*****************************************************************************
+**	TRAPEZOIDAL PROFILE
+*****************************************************************************
+**	Author: 			Orso Eric
+**	Creation Date:		2019-11-14
+**	Last Edit Date:
+**	Revision:			1
+**	Version:			0.1 ALFA
+****************************************************************************/
+
+/****************************************************************************
+**	HYSTORY VERSION
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	DESCRIPTION
+*****************************************************************************
+**	Fixed point trapezoidal position profile generator
+**	The speed is an integer number N of acceleration steps A.
+**	At each tick the speed can go up one step, stay or go down one step.
+**	Stopping from N steps takes a distance of A*N*(N+1)/2, including the
+**	movement of the current tick. The generator picks the highest speed
+**	whose stopping distance still fits in the distance left to the target.
+**	The stopping distance is updated incrementally:
+**		N+1: D += A*(N+1)
+**		N-1: D -= A*N
+**	When the speed is back to zero the position is less than one
+**	acceleration step away from the target, and it's snapped on the target.
+****************************************************************************/
+
+/****************************************************************************
+**	KNOWN BUG
+*****************************************************************************
+**
+****************************************************************************/
+
+/****************************************************************************
+**	INCLUDES
+****************************************************************************/
+
+#include "global.h"
+//Class Header
+#include "trap_profile.h"
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+namespace OrangeBot
+{
+
+/****************************************************************************
+**	GLOBAL VARIABILES
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	CONSTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Constructor
+//!	Trap_profile | void
+/***************************************************************************/
+// @param
+//! @return no return
+//!	@details
+//! Empty constructor. The profile holds position 0 until limits are set
+/***************************************************************************/
+
+Trap_profile::Trap_profile( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//No limits. The profile can't move
+	this -> g_amax		= (uint32_t)0;
+	this -> g_step_max	= (uint16_t)0;
+	//Target
+	this -> g_target	= (int32_t)0;
+	//Start from position 0 at rest
+	this -> reset( (int32_t)0 );
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end constructor:
+
+/****************************************************************************
+*****************************************************************************
+**	DESTRUCTORS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Empty Destructor
+//!	Trap_profile | void
+/***************************************************************************/
+// @param
+//! @return no return
+//!	@details
+//! Empty destructor
+/***************************************************************************/
+
+Trap_profile::~Trap_profile( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//Trace Enter
+	DENTER();
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return;	//OK
+}	//end destructor:
+
+/****************************************************************************
+*****************************************************************************
+**	OPERATORS
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	SETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	set_limits | uint32_t, uint32_t
+/***************************************************************************/
+//! @param vmax | maximum speed. Fixed point, counts per system tick
+//! @param amax | acceleration. Fixed point, counts per system tick squared
+//! @return false: OK | true: fail
+//!	@details
+//! Set the limits of the profile. Can be called while the profile is moving.
+//! The current speed is converted to the new acceleration step, rounded down.
+//! If the current speed is above the new maximum speed, the profile slows down with the new acceleration.
+//! Uses a division, it's not meant to be called every tick
+/***************************************************************************/
+
+bool Trap_profile::set_limits( uint32_t vmax, uint32_t amax )
+{
+	//Trace Enter
+	DENTER_ARG("vmax: %d, amax: %d\n", vmax, amax);
+
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Number of steps
+	uint32_t step;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+	//if: limits are invalid
+	if ((vmax == 0) || (amax == 0) || (vmax > (uint32_t)TRAP_PROFILE_MAX_DIST) || (amax > (uint32_t)TRAP_PROFILE_MAX_DIST))
+	{
+		//Trace Return
+		DRETURN_ARG("ERR: bad limits\n");
+		return true;	//fail
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+		//! Maximum number of acceleration steps
+	step = vmax / amax;
+	//Clip
+	step = AT_SAT( step, (uint32_t)TRAP_PROFILE_MAX_STEP, (uint32_t)1 );
+	this -> g_step_max = (uint16_t)step;
+
+		//! Convert the current speed to the new acceleration step
+	step = this -> g_spd / amax;
+	this -> g_amax = amax;
+	this -> set_step( step );
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	//Trace Return
+	DRETURN();
+
+	return false;	//OK
+}	//end method: set_limits | uint32_t, uint32_t
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	set_target | int32_t
+/***************************************************************************/
+//! @param target | absolute target position in counts
+//! @return no return
+//!	@details
+//! Set the target. Can be changed while moving. If the new target is behind,
+//! the profile stops and then moves back
+/***************************************************************************/
+
+void Trap_profile::set_target( int32_t target )
+{
+	this -> g_target = target;
+	return;	//OK
+}	//end method: set_target | int32_t
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	reset | int32_t
+/***************************************************************************/
+//! @param pos | position of the profile in counts
+//! @return no return
+//!	@details
+//! Restart the profile from a given position with zero speed. Target and limits are kept
+/***************************************************************************/
+
+void Trap_profile::reset( int32_t pos )
+{
+	//Position
+	this -> g_pos		= pos;
+	this -> g_pos_frac	= (uint16_t)0;
+	//At rest
+	this -> g_step		= (uint16_t)0;
+	this -> g_spd		= (uint32_t)0;
+	this -> g_stop_dist	= (uint32_t)0;
+	this -> g_f_fwd		= true;
+
+	return;	//OK
+}	//end method: reset | int32_t
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	reset | int32_t, int32_t
+/***************************************************************************/
+//! @param pos | position of the profile in counts
+//! @param spd | signed speed. Fixed point, counts per system tick
+//! @return no return
+//!	@details
+//! Restart the profile from a given position and speed. Target and limits are kept.
+//! Used to chain a profile after another speed source without a speed jump.
+//! The speed is rounded down to an acceleration step. Uses a division
+/***************************************************************************/
+
+void Trap_profile::reset( int32_t pos, int32_t spd )
+{
+	//Start at rest
+	this -> reset( pos );
+	//if: limits are not set
+	if (this -> g_amax == 0)
+	{
+		return;	//can't move
+	}
+	//Direction
+	this -> g_f_fwd = (spd >= 0);
+	//Absolute speed in acceleration steps
+	this -> set_step( ((spd < 0)?((uint32_t)-spd):((uint32_t)spd)) / this -> g_amax );
+
+	return;	//OK
+}	//end method: reset | int32_t, int32_t
+
+/****************************************************************************
+*****************************************************************************
+**	GETTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_pos | void
+/***************************************************************************/
+//! @return int32_t | position reference in counts
+/***************************************************************************/
+
+int32_t Trap_profile::get_pos( void )
+{
+	return this -> g_pos;
+}	//end getter: get_pos | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_target | void
+/***************************************************************************/
+//! @return int32_t | target position in counts
+/***************************************************************************/
+
+int32_t Trap_profile::get_target( void )
+{
+	return this -> g_target;
+}	//end getter: get_target | void
+
+/***************************************************************************/
+//!	@brief Getter
+//!	get_spd | void
+/***************************************************************************/
+//! @return int32_t | signed speed reference. Fixed point, counts per system tick
+/***************************************************************************/
+
+int32_t Trap_profile::get_spd( void )
+{
+	return (this -> g_f_fwd)?((int32_t)this -> g_spd):(-(int32_t)this -> g_spd);
+}	//end getter: get_spd | void
+
+/****************************************************************************
+*****************************************************************************
+**	REFERENCES
+*****************************************************************************
+****************************************************************************/
+
+/****************************************************************************
+*****************************************************************************
+**	TESTERS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Tester
+//!	is_done | void
+/***************************************************************************/
+//! @return bool | true = profile is at rest on the target
+/***************************************************************************/
+
+bool Trap_profile::is_done( void )
+{
+	return ((this -> g_step == 0) && (this -> g_pos == this -> g_target) && (this -> g_pos_frac == 0));
+}	//end tester: is_done | void
+
+/****************************************************************************
+*****************************************************************************
+**	PUBLIC METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Public Method
+//!	exe | void
+/***************************************************************************/
+//! @return int32_t | position reference in counts
+//!	@details
+//! Advance the profile by one system tick.
+//! Accelerate if the stopping distance from the higher speed fits in the distance left,
+//! hold the speed if the current stopping distance fits, slow down otherwise.
+/***************************************************************************/
+
+int32_t Trap_profile::exe( void )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Distance to target in counts
+	int32_t diff;
+	//Distance to target. Fixed point
+	int32_t dist;
+	//Absolute distance to target. Fixed point
+	uint32_t dist_abs;
+	//true = moving toward the target
+	bool f_toward;
+	//Position fraction plus the movement of this tick
+	int32_t pos_acc;
+
+	///--------------------------------------------------------------------------
+	///	INIT
+	///--------------------------------------------------------------------------
+
+		//! Distance left to the target
+	diff = this -> g_target -this -> g_pos;
+	//if: too far forward
+	if (diff >= (TRAP_PROFILE_MAX_DIST >> TRAP_PROFILE_FRAC))
+	{
+		dist = TRAP_PROFILE_MAX_DIST;
+	}
+	//if: too far backward
+	else if (diff <= -(TRAP_PROFILE_MAX_DIST >> TRAP_PROFILE_FRAC))
+	{
+		dist = -TRAP_PROFILE_MAX_DIST;
+	}
+	//if: distance fits in fixed point
+	else
+	{
+		dist = (diff << TRAP_PROFILE_FRAC) -(int32_t)this -> g_pos_frac;
+	}
+	//Absolute value
+	dist_abs = (dist < 0)?((uint32_t)-dist):((uint32_t)dist);
+	//if: at rest
+	if (this -> g_step == 0)
+	{
+		//if: not on target
+		if (dist != 0)
+		{
+			//Move toward the target
+			this -> g_f_fwd = (dist > 0);
+		}
+		f_toward = true;
+	}
+	//if: moving
+	else
+	{
+		f_toward = ((dist != 0) && ((dist > 0) == this -> g_f_fwd));
+	}
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+		//! Pick the speed
+	//if: moving toward the target, one more step still allows to stop on target
+	if ((f_toward == true) && (this -> g_step < this -> g_step_max) && (this -> g_stop_dist +this -> g_spd +this -> g_amax <= dist_abs))
+	{
+		//Accelerate
+		this -> g_step++;
+		this -> g_spd += this -> g_amax;
+		this -> g_stop_dist += this -> g_spd;
+	}
+	//if: moving toward the target, current speed still allows to stop on target
+	else if ((f_toward == true) && (this -> g_step <= this -> g_step_max) && (this -> g_stop_dist <= dist_abs))
+	{
+		//Cruise
+	}
+	//if: moving away from the target, too fast or too close to the target
+	else if (this -> g_step > 0)
+	{
+		//Decelerate
+		this -> g_stop_dist -= this -> g_spd;
+		this -> g_spd -= this -> g_amax;
+		this -> g_step--;
+	}
+
+		//! Integrate the speed
+	//if: at rest and less than one step away from the target
+	if ((this -> g_step == 0) && (dist_abs < this -> g_amax))
+	{
+		//Snap on target
+		this -> g_pos		= this -> g_target;
+		this -> g_pos_frac	= (uint16_t)0;
+	}
+	//if: moving
+	else
+	{
+		//Add the movement of this tick to the fraction
+		pos_acc = (int32_t)this -> g_pos_frac +((this -> g_f_fwd)?((int32_t)this -> g_spd):(-(int32_t)this -> g_spd));
+		//Move the integer part
+		this -> g_pos += (pos_acc >> TRAP_PROFILE_FRAC);
+		//Keep the fraction
+		this -> g_pos_frac = (uint16_t)(pos_acc & (((int32_t)1 << TRAP_PROFILE_FRAC) -1));
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return this -> g_pos;
+}	//end method: exe | void
+
+/****************************************************************************
+*****************************************************************************
+**	PRIVATE METHODS
+*****************************************************************************
+****************************************************************************/
+
+/***************************************************************************/
+//!	@brief Private Method
+//!	set_step | uint32_t
+/***************************************************************************/
+//! @param step | speed in acceleration steps
+//! @return no return
+//!	@details
+//! Set the speed and recompute the stopping distance from scratch. Uses a division
+/***************************************************************************/
+
+void Trap_profile::set_step( uint32_t step )
+{
+	///--------------------------------------------------------------------------
+	///	VARS
+	///--------------------------------------------------------------------------
+
+	//Triangular number of the steps
+	uint32_t tri;
+
+	///--------------------------------------------------------------------------
+	///	BODY
+	///--------------------------------------------------------------------------
+
+	//Clip. Unsigned, only the upper bound
+	step = (step > (uint32_t)TRAP_PROFILE_MAX_STEP)?((uint32_t)TRAP_PROFILE_MAX_STEP):(step);
+	this -> g_step = (uint16_t)step;
+	this -> g_spd = step * this -> g_amax;
+		//! Recompute the stopping distance
+	tri = (step * (step +1)) / 2;
+	//if: stopping distance doesn't fit
+	if ((tri != 0) && (this -> g_amax > ((uint32_t)2 * (uint32_t)TRAP_PROFILE_MAX_DIST) / tri))
+	{
+		//Saturate above the maximum distance. The profile slows down until the distance is accurate again
+		this -> g_stop_dist = (uint32_t)2 * (uint32_t)TRAP_PROFILE_MAX_DIST;
+	}
+	else
+	{
+		this -> g_stop_dist = this -> g_amax * tri;
+	}
+
+	///--------------------------------------------------------------------------
+	///	RETURN
+	///--------------------------------------------------------------------------
+
+	return;	//OK
+}	//end method: set_step | uint32_t
+
+/****************************************************************************
+**	NAMESPACES
+****************************************************************************/
+
+} //End Namespace
@@ -0,0 +1,203 @@
+/**********************************************************************************
+**	ENVIROMENT VARIABILE
+**********************************************************************************/
+
+#ifndef TRAP_PROFILE_H_
+	#define TRAP_PROFILE_H_
+
+/**********************************************************************************
+**	GLOBAL INCLUDES
+**********************************************************************************/
+
+/**********************************************************************************
+**	DEFINES
+**********************************************************************************/
+
+//Number of fractional bits of speed, acceleration and position fraction
+#define TRAP_PROFILE_FRAC		12
+//Maximum number of acceleration steps. Caps the speed at TRAP_PROFILE_MAX_STEP * acceleration
+#define TRAP_PROFILE_MAX_STEP	65534
+//Remaining distance is saturated to this value. Fixed point. About 262144 counts
+#define TRAP_PROFILE_MAX_DIST	((int32_t)0x40000000)
+
+/**********************************************************************************
+**	MACROS
+**********************************************************************************/
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+//! @namespace OrangeBot
+namespace OrangeBot
+{
+
+/**********************************************************************************
+**	TYPEDEFS
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: STRUCTURES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: GLOBAL VARIABILES
+**********************************************************************************/
+
+/**********************************************************************************
+**	PROTOTYPE: CLASS
+**********************************************************************************/
+
+/************************************************************************************/
+//! @class 		Trap_profile
+/************************************************************************************/
+//!	@author		Orso Eric
+//! @version	0.1 alpha
+//! @date		2019-11-14
+//! @brief		Fixed point trapezoidal position profile generator
+//! @details
+//!	Generate a position reference that moves toward an absolute target \n
+//! FEATURES:	\n
+//!		Trapezoidal speed profile	\n
+//! Speed ramps up with the maximum acceleration, cruises at the maximum speed and ramps down to stop on the target \n
+//!		Online	\n
+//! The target and the limits can be changed while the profile is moving. Speed is never changed abruptly \n
+//!		Fixed point	\n
+//! Speed is always an integer number of acceleration steps. The distance needed to stop is updated incrementally
+//! so that a step only costs a few 32b additions, no multiplications and no divisions \n
+//! Units are counts and system ticks. Speed, acceleration and position fraction have TRAP_PROFILE_FRAC fractional bits \n
+//! @pre		None
+//! @bug		None
+//! @warning	Speed is limited to TRAP_PROFILE_MAX_STEP acceleration steps
+//! @copyright	License ?
+//! @todo		todo list
+/************************************************************************************/
+
+class Trap_profile
+{
+	//Visible to all
+	public:
+		//--------------------------------------------------------------------------
+		//	CONSTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//! Default constructor
+		Trap_profile( void );
+
+		//--------------------------------------------------------------------------
+		//	DESTRUCTORS
+		//--------------------------------------------------------------------------
+
+		//!Default destructor
+		~Trap_profile( void );
+
+		//--------------------------------------------------------------------------
+		//	OPERATORS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	SETTERS
+		//--------------------------------------------------------------------------
+
+		//Set maximum speed and acceleration. Fixed point, per system tick. false=OK
+		bool set_limits( uint32_t vmax, uint32_t amax );
+		//Set the absolute target position in counts
+		void set_target( int32_t target );
+		//Restart the profile from a given position with zero speed. The target is kept
+		void reset( int32_t pos );
+		//Restart the profile from a given position and speed. The target is kept
+		void reset( int32_t pos, int32_t spd );
+
+		//--------------------------------------------------------------------------
+		//	GETTERS
+		//--------------------------------------------------------------------------
+
+		//Position reference in counts
+		int32_t get_pos( void );
+		//Target position in counts
+		int32_t get_target( void );
+		//Signed speed reference. Fixed point, per system tick
+		int32_t get_spd( void );
+
+		//--------------------------------------------------------------------------
+		//	REFERENCES
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	TESTERS
+		//--------------------------------------------------------------------------
+
+		//true = profile is at rest on the target
+		bool is_done( void );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC METHODS
+		//--------------------------------------------------------------------------
+
+		//Advance the profile by one system tick and return the position reference
+		int32_t exe( void );
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC STATIC METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PUBLIC VARS
+		//--------------------------------------------------------------------------
+
+	//Visible to derived classes
+	protected:
+		//--------------------------------------------------------------------------
+		//	PROTECTED METHODS
+		//--------------------------------------------------------------------------
+
+		//--------------------------------------------------------------------------
+		//	PROTECTED VARS
+		//--------------------------------------------------------------------------
+
+	//Visible only inside the class
+	private:
+		//--------------------------------------------------------------------------
+		//	PRIVATE METHODS
+		//--------------------------------------------------------------------------
+
+		//Set the speed as a number of acceleration steps and recompute the stopping distance
+		void set_step( uint32_t step );
+
+		//--------------------------------------------------------------------------
+		//	PRIVATE VARS
+		//--------------------------------------------------------------------------
+
+			///Limits
+		//Acceleration. Fixed point, per system tick squared
+		uint32_t g_amax;
+		//Maximum number of acceleration steps of the speed
+		uint16_t g_step_max;
+
+			///Profile state
+		//Absolute target position in counts
+		int32_t g_target;
+		//Position reference. Integer part in counts
+		int32_t g_pos;
+		//Position reference. Fractional part
+		uint16_t g_pos_frac;
+		//Speed expressed as number of acceleration steps
+		uint16_t g_step;
+		//Absolute speed. g_step * g_amax
+		uint32_t g_spd;
+		//Distance needed to stop from the current speed. g_amax * g_step * (g_step+1) / 2
+		uint32_t g_stop_dist;
+		//Direction of movement. true = counts increase
+		bool g_f_fwd;
+
+};	//End Class: Trap_profile
+
+/**********************************************************************************
+**	NAMESPACE
+**********************************************************************************/
+
+} //End Namespace
+
+#else
+    #warning "Multiple inclusion of hader file"
+#endif
@@ -260,7 +260,7 @@ bool Uniparser::add_cmd( const char *cmd, void *handler )
 		return true;	//fail
 	}
 	//If: num command is invalid
-	if ((UNIPARSER_PENDANTIC_CHECKS) && ((this -> g_num_cmd < 0) || (this->g_num_cmd >= UNIPARSER_MAX_CMD)) )
+	if ((UNIPARSER_PENDANTIC_CHECKS) && (this->g_num_cmd >= UNIPARSER_MAX_CMD) )
 	{
 		this -> g_err = ERR_GENERIC;
 		DRETURN_ARG("ERR%d: ERR_GENERIC in line: %d\n", this -> g_err, __LINE__ );
@@ -339,7 +339,7 @@ bool Uniparser::add_cmd( const char *cmd, void *handler, Cmd_syntax_error &err_c
 		return true;	//fail
 	}
 	//If: num command is invalid
-	if ((UNIPARSER_PENDANTIC_CHECKS) && ((this->g_num_cmd < 0) || (this->g_num_cmd >= UNIPARSER_MAX_CMD)) )
+	if ((UNIPARSER_PENDANTIC_CHECKS) && (this->g_num_cmd >= UNIPARSER_MAX_CMD) )
 	{
 		this -> g_err = ERR_GENERIC;
 		DRETURN_ARG("ERR%d: ERR_GENERIC in line: %d\n", this -> g_err, __LINE__ );
@@ -1108,6 +1108,9 @@ Cmd_syntax_error Uniparser::chk_cmd( const uint8_t *cmd )
 	//	INIT
 	//----------------------------------------------------------------
 
+	//Only read by the trace. Not a warning when the trace is compiled out
+	(void)str;
+
 	if (cmd == nullptr)
 	{
 		err = Cmd_syntax_error::SYNTAX_BAD_POINTER;
@@ -73,7 +73,7 @@
 //!redudant checks meant for debug only
 #define UNIPARSER_PENDANTIC_CHECKS	true
 //!Maximum number of commands that can be registered
-#define UNIPARSER_MAX_CMD			16
+#define UNIPARSER_MAX_CMD			40
 //!Commands can have at most two arguments
 #define UNIPARSER_MAX_ARGS			4
 //!Size of argument vector. one byte for each identifier plus bytes for the raw data